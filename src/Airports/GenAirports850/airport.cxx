@@ -23,12 +23,14 @@
 
 #include "airport.hxx"
 #include "beznode.hxx"
+#include "build_cache.hxx"
 #include "debug.hxx"
 #include "elevations.hxx"
 #include "global.hxx"
 #include "helipad.hxx"
 #include "runway.hxx"
 #include "output.hxx"
+#include "profile.hxx"
 
 Airport::Airport( int c, char* def)
 {
@@ -40,6 +42,8 @@ Airport::Airport( int c, char* def)
         lf_ig[i] = NULL;
     }
     rm_ig = NULL;
+    elev_bounds_set = false;
+    profile = NULL;
     
     code = c;
 
@@ -270,6 +274,75 @@ bool Airport::isDebugFeature( int feat )
     return dbg;
 }
 
+// runs one BuildBtg task on its own thread, logging under the airport's prefix.
+// An exception can't leave the thread - it is kept, and thrown again by
+// CheckError() once the task is joined
+class AirportBuildThread : public SGThread
+{
+public:
+    AirportBuildThread( Airport* a, Airport::BuildTask t, const std::string& n ) :
+        ap( a ), task( t ), name( n ), prefix( DebugGetPrefix() ), failed( false )
+    {
+    }
+
+    virtual void run()
+    {
+        SGTimeStamp task_start;
+
+        DebugRegisterPrefix( prefix );
+
+        task_start.stamp();
+        try {
+            ap->RunBuildTask( task );
+        } catch ( sg_exception& e ) {
+            error  = e;
+            failed = true;
+        } catch ( std::exception& e ) {
+            error  = sg_exception( e.what() );
+            failed = true;
+        }
+
+        if ( failed ) {
+            TG_LOG(SG_GENERAL, SG_ALERT, "Task " << name << " failed: " << error.getFormattedMessage() );
+        } else {
+            TG_LOG(SG_GENERAL, SG_ALERT, "Task " << name << " time " << SGTimeStamp::now() - task_start );
+        }
+    }
+
+    // call after join()
+    void CheckError( void ) const
+    {
+        if ( failed ) {
+            throw error;
+        }
+    }
+
+private:
+    Airport*            ap;
+    Airport::BuildTask  task;
+    std::string         name;
+    std::string         prefix;
+
+    bool                failed;
+    sg_exception        error;
+};
+
+// time one build step, log it under the current task, and add it to the
+// airport's profile
+#define RUN_BUILD_STEP( task, name, step )                                      \
+    do {                                                                        \
+        SGTimeStamp step_start;                                                 \
+        long        step_rss = profile ? AirportProfile::GetRSS() : 0;          \
+        step_start.stamp();                                                     \
+        TG_LOG(SG_GENERAL, SG_INFO, name );                                     \
+        step;                                                                   \
+        SGTimeStamp step_time = SGTimeStamp::now() - step_start;                \
+        TG_LOG(SG_GENERAL, SG_INFO, name << " time " << step_time );            \
+        if ( profile ) {                                                        \
+            ProfileStep( task, name, step_time, step_rss );                     \
+        }                                                                       \
+    } while(0)
+
 void Airport::BuildBtg(const std::string& root, const string_list& elev_src )
 {
     TG_LOG(SG_GENERAL, SG_ALERT, "BUILDBTG");
@@ -327,96 +400,169 @@ void Airport::BuildBtg(const std::string& root, const string_list& elev_src )
     TG_LOG(SG_GENERAL, SG_INFO, "Parse Complete - Runways: " << runways.size() << " Pavements: " << pavements.size() << " Features: " << features.size() << " Taxiways: " << taxiways.size() );
 
     // Airport building Steps
-    // 1: Build the base polygons
-    BuildBase();
-
-    TG_LOG(SG_GENERAL, SG_INFO, "ClipBase" );
-
-    // 2: Clip the polys in priority order
-    ClipBase();
-
-    TG_LOG(SG_GENERAL, SG_INFO, "spacialquery" );
-
-    // 3: Clean the polys
-    base_nodes.init_spacial_query();
-
-    TG_LOG(SG_GENERAL, SG_INFO, "CleanBase" );
+    // 1: Build the base polygons - this also generates the runway markings
+    //    into the intersection generators, so it must finish before the
+    //    feature task starts
+    SGTimeStamp build_start;
+    build_start.stamp();
+
+    // the object files written before a failure are deleted again - nothing
+    // of a failed airport stays in the scenery
+    try {
+        RUN_BUILD_STEP( TASK_BASE, "BuildBase", BuildBase() );
+
+        build_root     = root;
+        build_elev_src = elev_src;
+        build_bucket   = b;
+
+        if ( serial_build ) {
+            RunBuildTask( TASK_BASE );
+            RunBuildTask( TASK_FEATURES );
+            RunBuildTask( TASK_FEATURE_MESH );
+            RunBuildTask( TASK_LIGHTS );
+        } else {
+            // 2: the base mesh doesn't depend on the linear features - build
+            //    them side by side
+            AirportBuildThread base_task( this, TASK_BASE, "Base" );
+            AirportBuildThread feat_task( this, TASK_FEATURES, "Features" );
+
+            base_task.start();
+            feat_task.start();
+            base_task.join();
+            feat_task.join();
+            base_task.CheckError();
+            feat_task.CheckError();
+
+            // 3: the features are draped over the base mesh, and lights and
+            //    objects only need the base surface - build those side by
+            //    side as well
+            AirportBuildThread feat_mesh_task( this, TASK_FEATURE_MESH, "FeatureMesh" );
+            AirportBuildThread light_task( this, TASK_LIGHTS, "Lights" );
+
+            feat_mesh_task.start();
+            light_task.start();
+            feat_mesh_task.join();
+            light_task.join();
+            feat_mesh_task.CheckError();
+            light_task.CheckError();
+        }
 
-    CleanBase();
+        // append all object references to the index files at once - base and
+        // features first, then lights and objects, as when built sequentially
+        if ( !obj_index.Flush() || !light_index.Flush() ) {
+            throw sg_exception( "error writing the object index files of " + icao );
+        }
+    } catch ( ... ) {
+        obj_index.Discard();
+        light_index.Discard();
+        throw;
+    }
 
-    TG_LOG(SG_GENERAL, SG_INFO, "TesselateBase" );
+    TG_LOG(SG_GENERAL, SG_ALERT, "BuildBtg time " << SGTimeStamp::now() - build_start );
+}
 
-    // 4: Teseelate Base polys
-    TesselateBase();
+void Airport::RunBuildTask( BuildTask task )
+{
+    switch( task ) {
+        case TASK_BASE:
+            RUN_BUILD_STEP( TASK_BASE, "ClipBase", ClipBase() );
+            RUN_BUILD_STEP( TASK_BASE, "spacialquery", base_nodes.init_spacial_query() );
+            RUN_BUILD_STEP( TASK_BASE, "CleanBase", CleanBase() );
+            RUN_BUILD_STEP( TASK_BASE, "TesselateBase", TesselateBase() );
+            RUN_BUILD_STEP( TASK_BASE, "LookupBaseIndexes", LookupBaseIndexes() );
+            RUN_BUILD_STEP( TASK_BASE, "TextureBase", TextureBase() );
+            RUN_BUILD_STEP( TASK_BASE, "CalcBaseElevations", CalcBaseElevations( build_root, build_elev_src ) );
+            RUN_BUILD_STEP( TASK_BASE, "Write Base", WriteBaseOutput( build_root, build_bucket ) );
+            break;
+
+        case TASK_FEATURES:
+            RUN_BUILD_STEP( TASK_FEATURES, "Build Features", BuildFeatures() );
+            RUN_BUILD_STEP( TASK_FEATURES, "Clip Features", ClipFeatures() );
+            break;
+
+        case TASK_FEATURE_MESH:
+            // we need to add nodes that intersect with the
+            // base we will drape with
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "IntersectFeaturesWithBase", IntersectFeaturesWithBase() );
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "TesselateFeatures", TesselateFeatures() );
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "LookupFeatureIndexes", LookupFeatureIndexes() );
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "TextureFeatures", TextureFeatures() );
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "CalcFeatureElevations", CalcFeatureElevations() );
+            RUN_BUILD_STEP( TASK_FEATURE_MESH, "Write Features", WriteFeatureOutput( build_root, build_bucket ) );
+            break;
+
+        case TASK_LIGHTS:
+            RUN_BUILD_STEP( TASK_LIGHTS, "Build Lights", BuildLights() );
+            RUN_BUILD_STEP( TASK_LIGHTS, "Write Lights", WriteLightsOutput( build_root, build_bucket ) );
+            RUN_BUILD_STEP( TASK_LIGHTS, "Write Objects", WriteObjects( build_root, build_bucket ) );
+            break;
+    }
+}
 
-    TG_LOG(SG_GENERAL, SG_INFO, "LookupIndexes" );
+// add up the polys of the given areas - the clipped ones once there are
+static void CountAreaPolys( const tgAreas& built, const tgAreas& clipped,
+                            unsigned int first, unsigned int last, ProfilePhase& phase )
+{
+    const tgAreas* areas = &built;
 
-    LookupBaseIndexes();
+    for ( unsigned int area = first; area <= last; area++ ) {
+        if ( clipped.area_size( area ) ) {
+            areas = &clipped;
+        }
+    }
 
-    TG_LOG(SG_GENERAL, SG_INFO, "TextureBase" );
+    for ( unsigned int area = first; area <= last; area++ ) {
+        for ( unsigned int p = 0; p < areas->area_size( area ); p++ ) {
+            const tgPolygon& poly = areas->get_poly( area, p );
 
-    // 5: Texture Base polys
-    TextureBase();
+            phase.polys++;
+            phase.verts += poly.TotalNodes();
+            phase.tris  += poly.Triangles();
+        }
+    }
+}
 
-    TG_LOG(SG_GENERAL, SG_INFO, "CalcElevations" );
+void Airport::ProfileStep( BuildTask task, const std::string& name, const SGTimeStamp& wall, long rss_start )
+{
+    // same names as the build threads
+    static const char* task_names[] = { "Base", "Features", "FeatureMesh", "Lights" };
+    ProfilePhase phase;
+
+    phase.task   = task_names[task];
+    phase.name   = name;
+    phase.wall   = wall.toSecs();
+    phase.rss_kb = AirportProfile::GetRSS() - rss_start;
+
+    // only look at the data of this task - the others are still running
+    switch( task ) {
+        case TASK_BASE:
+            CountAreaPolys( polys_built, polys_clipped, 0, AIRPORT_AREA_OUTER_BASE, phase );
+            break;
+
+        case TASK_FEATURES:
+        case TASK_FEATURE_MESH:
+            CountAreaPolys( polys_built, polys_clipped, AIRPORT_AREA_RWY_FEATURES, AIRPORT_AREA_TAXI_FEATURES, phase );
+            break;
+
+        case TASK_LIGHTS:
+            phase.polys = lights.size();
+            for ( unsigned int i = 0; i < lights.size(); i++ ) {
+                phase.verts += lights[i].ContourSize();
+            }
+            break;
+    }
 
-    // 6: calculate height
-    CalcBaseElevations(root, elev_src);
+    profile->AddPhase( phase );
+}
 
-    // save Base
-    TG_LOG(SG_GENERAL, SG_INFO, "Write Base" );
-    WriteBaseOutput( root, b );
-    
-    // 9: Build the linear feature polygons
-    TG_LOG(SG_GENERAL, SG_INFO, "Build Features" );
-    BuildFeatures();
+void Airport::GetCacheEntry( BuildCacheEntry& entry )
+{
+    if ( elev_bounds_set ) {
+        BuildCache::GetElevationFiles( build_root, build_elev_src, elev_bounds, entry.elevation );
+    }
 
-    TG_LOG(SG_GENERAL, SG_INFO, "Clip Features" );
-    ClipFeatures();
-    
-    // 3: Clean the polys
-    //feat_nodes.init_spacial_query();
-    
-    //TG_LOG(SG_GENERAL, SG_INFO, "CleanFeatures" );
-    
-    //CleanFeatures();
-    
-    TG_LOG(SG_GENERAL, SG_INFO, "IntersectFeaturesWithBase" );
-    // we need to add nodes that intersect with the 
-    // base we will drape with
-    IntersectFeaturesWithBase();
-    
-    // 4: Teseelate Base polys
-    TG_LOG(SG_GENERAL, SG_INFO, "TesselateFeatures" );
-    TesselateFeatures();
-    
-    TG_LOG(SG_GENERAL, SG_INFO, "LookupIndexes" );
-    
-    LookupFeatureIndexes();
-    
-    TG_LOG(SG_GENERAL, SG_INFO, "TextureFeatures" );
-    
-    // 5: Texture Base polys
-    TextureFeatures();
-        
-    TG_LOG(SG_GENERAL, SG_INFO, "CalcElevations" );
-    // 6: calculate height
-    CalcFeatureElevations();
-    
-    // save Base
-    TG_LOG(SG_GENERAL, SG_INFO, "Write Features" );
-    WriteFeatureOutput( root, b );
-    
-    // Build Lights
-    TG_LOG(SG_GENERAL, SG_INFO, "Build Lights" );
-    BuildLights();
-    
-    TG_LOG(SG_GENERAL, SG_INFO, "Write Lights" );
-    WriteLightsOutput( root, b );
-    
-    // Generate Objects
-    TG_LOG(SG_GENERAL, SG_INFO, "Write Objects" );    
-    WriteObjects( root, b );
+    obj_index.GetWritten( entry.index_records, entry.outputs );
+    light_index.GetWritten( entry.index_records, entry.outputs );
 }
 
 void Airport::WriteObjects( const std::string& root, const SGBucket& b )
@@ -430,66 +576,90 @@ void Airport::WriteObjects( const std::string& root, const SGBucket& b )
     // write out tower references
     for ( i = 0; i < (int)tower_nodes.size(); ++i )
     {
-        write_index_shared( objpath, b, tower_nodes[i],
-                            "Models/Airport/tower.xml",
-                            0.0 );
+        light_index.AddObjectShared( objpath, b, tower_nodes[i],
+                                     "Models/Airport/tower.xml",
+                                     0.0 );
     }
 #endif
 
-    // calc elevations and write out windsock references
-    TG_LOG(SG_GENERAL, SG_INFO, "Computing elevations for " << windsocks.size() << " windsocks"); 
+    // the elevations of all the objects, from one batched surface query
+    std::vector<SGGeod> locations;
+    std::vector<double> elevations;
+
     for ( unsigned int i = 0; i < windsocks.size(); ++i )
     {
-        ref_geod = windsocks[i]->GetLoc();
-        ref_geod.setElevationM( base_surf.query( ref_geod ) );
+        locations.push_back( windsocks[i]->GetLoc() );
+    }
+    for ( unsigned int i = 0; i < beacons.size(); ++i )
+    {
+        locations.push_back( beacons[i]->GetLoc() );
+    }
+    for ( unsigned int i = 0; i < signs.size(); ++i )
+    {
+        locations.push_back( signs[i]->GetLoc() );
+    }
+    for ( unsigned int i = 0; i < waterrunways.size(); ++i )
+    {
+        tgContour buoys = waterrunways[i]->GetBuoys();
+
+        for ( unsigned int j = 0; j < buoys.GetSize(); ++j )
+        {
+            locations.push_back( buoys.GetNode(j) );
+        }
+    }
+
+    TG_LOG(SG_GENERAL, SG_INFO, "Computing elevations for " << locations.size() << " windsocks, beacons, signs and buoys");
+    base_surf.query( locations, elevations );
+
+    unsigned int cur = 0;
+
+    // write out windsock references
+    for ( unsigned int i = 0; i < windsocks.size(); ++i, ++cur )
+    {
+        ref_geod = locations[cur];
+        ref_geod.setElevationM( elevations[cur] );
         
         if ( windsocks[i]->IsLit() )
         {
-            write_index_shared( objpath, b, ref_geod,
-                                "Models/Airport/windsock_lit.xml", 0.0 );
+            light_index.AddObjectShared( objpath, b, ref_geod,
+                                         "Models/Airport/windsock_lit.xml", 0.0 );
         }
         else
         {
-            write_index_shared( objpath, b, ref_geod,
-                                "Models/Airport/windsock.xml", 0.0 );
+            light_index.AddObjectShared( objpath, b, ref_geod,
+                                         "Models/Airport/windsock.xml", 0.0 );
         }
     }
     
     // write out beacon references
-    for ( unsigned int i = 0; i < beacons.size(); ++i )
+    for ( unsigned int i = 0; i < beacons.size(); ++i, ++cur )
     {
-        ref_geod = beacons[i]->GetLoc();
-        ref_geod.setElevationM( base_surf.query( ref_geod ) );
+        ref_geod = locations[cur];
+        ref_geod.setElevationM( elevations[cur] );
         
-        write_index_shared( objpath, b, ref_geod,
-                            "Models/Airport/beacon.xml",
-                            0.0 );
+        light_index.AddObjectShared( objpath, b, ref_geod,
+                                     "Models/Airport/beacon.xml",
+                                     0.0 );
     }
     
     // write out taxiway signs references
-    TG_LOG(SG_GENERAL, SG_INFO, "Computing elevations for " << signs.size() << " signs"); 
-    for ( unsigned int i = 0; i < signs.size(); ++i )
+    for ( unsigned int i = 0; i < signs.size(); ++i, ++cur )
     {
-        ref_geod = signs[i]->GetLoc();
-        ref_geod.setElevationM( base_surf.query( ref_geod ) );
-        write_object_sign( objpath, b, ref_geod,
-                           signs[i]->GetDefinition(),
-                           signs[i]->GetHeading(),
-                           signs[i]->GetSize() );
+        ref_geod = locations[cur];
+        ref_geod.setElevationM( elevations[cur] );
+        light_index.AddObjectSign( objpath, b, ref_geod,
+                                   signs[i]->GetDefinition(),
+                                   signs[i]->GetHeading(),
+                                   signs[i]->GetSize() );
     }
     
     // write out water buoys
-    for ( unsigned int i = 0; i < waterrunways.size(); ++i )
+    for ( ; cur < locations.size(); ++cur )
     {
-        tgContour buoys = waterrunways[i]->GetBuoys();
-        
-        for ( unsigned int j = 0; j < buoys.GetSize(); ++j )
-        {
-            ref_geod = buoys.GetNode(j);
-            ref_geod.setElevationM( base_surf.query( ref_geod ) );
-            write_index_shared( objpath, b, ref_geod,
-                                "Models/Airport/water_rw_buoy.xml",
-                                0.0 );
-        }
+        ref_geod = locations[cur];
+        ref_geod.setElevationM( elevations[cur] );
+        light_index.AddObjectShared( objpath, b, ref_geod,
+                                     "Models/Airport/water_rw_buoy.xml",
+                                     0.0 );
     }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <terragear/tg_array.hxx>
 #include <terragear/tg_areas.hxx>
 #include <terragear/tg_nodes.hxx>
+#include <terragear/tg_rectangle.hxx>
 
 #include "runway.hxx"
 #include "object.hxx"
@@ -17,6 +18,10 @@
 #include "linearfeature.hxx"
 #include "linked_objects.hxx"
 #include "debug.hxx"
+#include "output.hxx"
+
+class BuildCacheEntry;
+class AirportProfile;
 
 // Airport areas are hardcoded - no priority config to deal with
 #define AIRPORT_AREA_RUNWAY             (0)
@@ -199,8 +204,16 @@ public:
     // break into stages
     void BuildBtg( const std::string& root, const string_list& elev_src );
 
+    // what the last BuildBtg read and wrote, for the build cache
+    void GetCacheEntry( BuildCacheEntry& entry );
+
     void DumpStats( void );
 
+    // record the time and size of each build step - NULL to disable
+    void set_profile( AirportProfile* p ) {
+        profile = p;
+    }
+
     void set_debug( std::string& path,
                     debug_map& dbg_runways, 
                     debug_map& dbg_pavements,
@@ -219,6 +232,19 @@ public:
     bool isDebugFeature ( int i );
 
 private:
+    // BuildBtg runs the stages below as a small task graph - base and feature
+    // construction overlap, and so do feature meshing and the lights
+    enum BuildTask {
+        TASK_BASE,              // clip, clean, tesselate, elevate and write the base
+        TASK_FEATURES,          // build and clip the linear feature polys
+        TASK_FEATURE_MESH,      // drape, tesselate and write the linear features
+        TASK_LIGHTS             // build and write the lights and objects
+    };
+
+    friend class AirportBuildThread;
+    void RunBuildTask( BuildTask task );
+    void ProfileStep( BuildTask task, const std::string& name, const SGTimeStamp& wall, long rss_start );
+
     // The airport building stages....
     
     // Build the base (base_construct)
@@ -286,6 +312,8 @@ private:
 
     // Elevation data
     tgArray array;
+    tgRectangle elev_bounds;
+    bool        elev_bounds_set;
 
     // the smoothing surface for generating the base
     tgSurface       base_surf;
@@ -306,12 +334,23 @@ private:
     
     // Light Nodes
     TGNodes light_nodes;
+
+    // object references for the index files - lights and objects are kept
+    // separately, as they are written concurrently with the feature mesh
+    ObjectIndexWriter obj_index;
+    ObjectIndexWriter light_index;
+
+    // BuildBtg arguments, for the build tasks
+    std::string build_root;
+    string_list build_elev_src;
+    SGBucket    build_bucket;
     
     
     // stats
     SGTimeStamp build_time;
     SGTimeStamp cleanup_time;
     SGTimeStamp triangulation_time;
+    AirportProfile* profile;
 
     // debug
     std::vector<std::string>    area_names;
@@ -191,7 +191,7 @@ void Airport::ClipBase()
     }
     
     // create the inner base poly as the union of all innerbase polys
-    inner_base = tgPolygon::Union( polys_built.get_polys(AIRPORT_AREA_INNER_BASE) );    
+    inner_base = tgPolygon::UnionAll( polys_built.get_polys(AIRPORT_AREA_INNER_BASE) );    
 
     // now break into max segment size
     for (unsigned int area = 0; area <= AIRPORT_MAX_BASE; area++) {
@@ -356,6 +356,10 @@ void Airport::CalcBaseElevations( const std::string& root, const string_list& el
         return;
     }
 
+    // remember the area, for the build cache
+    elev_bounds     = bounds;
+    elev_bounds_set = true;
+
     double average = tgAverageElevation( root, elev_src, geods );
 
     // then generate the surface
@@ -519,7 +523,7 @@ void Airport::WriteBaseOutput( const std::string& root, const SGBucket& b )
         }
 
         // write out airport object reference
-        write_index( objpath, b, name );
+        obj_index.AddObject( objpath, b, name );
 
 
         //
@@ -529,7 +533,7 @@ void Airport::WriteBaseOutput( const std::string& root, const SGBucket& b )
         std::string holepath = root + "/AirportArea";
         tgChopper chopper( holepath );
 
-        tgPolygon outer_base = tgPolygon::Union( polys_built.get_polys(AIRPORT_AREA_OUTER_BASE) );
+        tgPolygon outer_base = tgPolygon::UnionAll( polys_built.get_polys(AIRPORT_AREA_OUTER_BASE) );
 
         /* need to polulate the elevations in inner base */
         inner_base.SetElevations( base_nodes );
@@ -30,6 +30,25 @@
 #include "runway.hxx"
 #include "output.hxx"
 
+// executes one intersection generator on its own thread
+class IntersectionThread : public SGThread
+{
+public:
+    IntersectionThread( tgIntersectionGenerator* g ) : ig( g ), prefix( DebugGetPrefix() )
+    {
+    }
+
+    virtual void run()
+    {
+        DebugRegisterPrefix( prefix );
+        ig->Execute();
+    }
+
+private:
+    tgIntersectionGenerator* ig;
+    std::string              prefix;
+};
+
 void Airport::BuildFeatures( void )
 {
     tgpolygon_list polys;
@@ -93,9 +112,36 @@ void Airport::BuildFeatures( void )
         }
     }
 #else
+    // the marking types don't intersect each other - run all the generators
+    // at once, then collect their edges in type order
+    std::vector<tgIntersectionGenerator*> igs;
+    for ( unsigned int i=0; i<8; i++ ) {
+        if ( lf_ig[i] ) {
+            igs.push_back( lf_ig[i] );
+        }
+    }
+    if ( rm_ig ) {
+        igs.push_back( rm_ig );
+    }
+
+    if ( serial_build ) {
+        for ( unsigned int i=0; i<igs.size(); i++ ) {
+            igs[i]->Execute();
+        }
+    } else {
+        std::vector<IntersectionThread*> ig_tasks;
+        for ( unsigned int i=0; i<igs.size(); i++ ) {
+            ig_tasks.push_back( new IntersectionThread( igs[i] ) );
+            ig_tasks.back()->start();
+        }
+        for ( unsigned int i=0; i<ig_tasks.size(); i++ ) {
+            ig_tasks[i]->join();
+            delete ig_tasks[i];
+        }
+    }
+
     for ( unsigned int i=0; i<8; i++ ) {
         if (lf_ig[i] ) {
-            lf_ig[i]->Execute();
             for ( tgintersectionedge_it it=lf_ig[i]->edges_begin(); it != lf_ig[i]->edges_end(); it++ ) {
                 tgPolygon poly = (*it)->GetPoly("complete");
                 polys_built.get_polys(AIRPORT_AREA_TAXI_FEATURES).push_back(poly);
@@ -105,7 +151,6 @@ void Airport::BuildFeatures( void )
 
     if ( rm_ig ) {
         // don't clean runway features - we know what we're doing here :)
-        rm_ig->Execute();
         for ( tgintersectionedge_it it=rm_ig->edges_begin(); it != rm_ig->edges_end(); it++ ) {
             tgPolygon poly = (*it)->GetPoly("complete");
             polys_built.get_polys(AIRPORT_AREA_RWY_FEATURES).push_back(poly);
@@ -717,6 +762,6 @@ void Airport::WriteFeatureOutput( const std::string& root, const SGBucket& b )
         }
         
         // write out airport object reference
-        write_index_lines( objpath, b, name );
+        obj_index.AddObjectLines( objpath, b, name );
     }        
 }
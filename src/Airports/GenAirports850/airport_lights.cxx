@@ -85,34 +85,15 @@ void Airport::WriteLightsOutput( const std::string& root, const SGBucket& b )
         std::string name = icao + "_lights.btg";
                 
         SGBinObject obj;        
-        // add light points        
-        SGBinObjectPoint sgboPt;
-        
-        for ( unsigned int i = 0; i < lights.size(); ++i ) {
-            if ( lights[i].ContourSize() ) {            
-                sgboPt.clear();
-                sgboPt.material = lights[i].GetType();
-            
-                for ( unsigned int j = 0; j < lights[i].ContourSize(); ++j )
-                {
-                    int index;
-                
-                    SGGeod pos = lights[i].GetPosition(j);
-                    index = light_nodes.unique_add( pos, TG_NODE_SMOOTHED );
-                    sgboPt.v_list.push_back( index );
-                
-                    index = light_normals.add( lights[i].GetNormal(j) );
-                    sgboPt.n_list.push_back( index );
-                }
-            
-                obj.add_point( sgboPt );
-            } else {
-                TG_LOG(SG_GENERAL, SG_ALERT, "light contour for mat " << sgboPt.material << " HAS NO LIGHTS " );
-            }
+
+        // one point group per light contour - the light nodes are added in
+        // one batch, and their elevations come from the base surface in one
+        // batched query
+        std::vector<SGBinObjectPoint> groups;
+        tgBuildLightGroups( lights, base_surf, light_nodes, light_normals, groups );
+        for ( unsigned int i = 0; i < groups.size(); ++i ) {
+            obj.add_point( groups[i] );
         }
-        
-        // reuse the base surface to calc elevation
-        light_nodes.CalcElevations( TG_NODE_SMOOTHED, base_surf );
 
         SGVec3d gbs_center = SGVec3d::fromGeod( b.get_center() );
         double dist_squared, radius_squared = 0;
@@ -155,6 +136,6 @@ void Airport::WriteLightsOutput( const std::string& root, const SGBucket& b )
         }
         
         // write out airport object reference
-        write_index( objpath, b, name );
+        light_index.AddObject( objpath, b, name );
     }
 }
\ No newline at end of file
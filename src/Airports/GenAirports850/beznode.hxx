@@ -5,6 +5,7 @@
 #include <string.h>
 #include <float.h>
 
+#include <simgear/constants.h>
 #include <simgear/debug/logstream.hxx>
 #include <simgear/math/SGMath.hxx>
 
@@ -75,6 +76,114 @@ inline SGGeod CalculateCubicLocation( const SGGeod& p0, const SGGeod& cp0, const
     return SGGeod::fromDeg( result.x(), result.y() );
 }
 
+#define CURVE_NONE                      (0)
+#define CURVE_LINEAR                    (1)
+#define CURVE_QUADRATIC                 (2)
+#define CURVE_CUBIC                     (3)
+
+// Adaptive flattening of quadratic and cubic curves : the curve is split in
+// half ( de Casteljau ) until each piece is within max_dev meters of its chord,
+// and no longer than BEZIER_MAX_SEGMENT meters.  The control points are in
+// meters, in a local east / north frame - see CalculateBezierNodes()
+#define BEZIER_MAX_SEGMENT  (100.0)
+#define BEZIER_MAX_DEPTH    (8)
+
+inline void FlattenBezier( const SGVec2d* cp, int degree, double max_dev, int depth, std::vector<SGVec2d>& nodes )
+{
+    SGVec2d chord = cp[degree] - cp[0];
+    double  len   = norm( chord );
+    double  dist  = 0.0;
+    bool    inside = true;
+
+    // distance of the inner control points from the chord
+    for ( int i = 1; i < degree; i++ ) {
+        SGVec2d d = cp[i] - cp[0];
+        double  cur;
+
+        if ( len > SG_EPSILON ) {
+            double t = ( d.x() * chord.x() + d.y() * chord.y() ) / ( len * len );
+            if ( t < 0.0 || t > 1.0 ) {
+                inside = false;
+                t = SGMiscd::clip( t, 0.0, 1.0 );
+            }
+            cur = norm( d - chord * t );
+        } else {
+            inside = false;
+            cur = norm( d );
+        }
+        if ( cur > dist ) {
+            dist = cur;
+        }
+    }
+
+    // the curve lies in the hull of its control points.  If they all project
+    // onto the chord, the curve is at most 1/2 ( quadratic ) or 3/4 ( cubic )
+    // of that distance away
+    double dev = dist;
+    if ( inside ) {
+        dev *= ( degree == 2 ) ? 0.5 : 0.75;
+    }
+
+    if ( ( depth >= BEZIER_MAX_DEPTH ) || ( dev <= max_dev && len <= BEZIER_MAX_SEGMENT ) ) {
+        nodes.push_back( cp[0] );
+        return;
+    }
+
+    SGVec2d tmp[4], left[4], right[4];
+    for ( int i = 0; i <= degree; i++ ) {
+        tmp[i] = cp[i];
+    }
+    for ( int k = 0; k <= degree; k++ ) {
+        left[k]         = tmp[0];
+        right[degree-k] = tmp[degree-k];
+        for ( int i = 0; i < degree-k; i++ ) {
+            tmp[i] = ( tmp[i] + tmp[i+1] ) * 0.5;
+        }
+    }
+
+    FlattenBezier( left,  degree, max_dev, depth+1, nodes );
+    FlattenBezier( right, degree, max_dev, depth+1, nodes );
+}
+
+// Returns the start of the curve, and all intermediate nodes ( not p1 ).
+// For a quadratic curve, cp1 is ignored.
+inline void CalculateBezierNodes( int curve_type, const SGGeod& p0, const SGGeod& cp0, const SGGeod& cp1, const SGGeod& p1, double max_dev, std::vector<SGGeod>& nodes )
+{
+    // local east / north frame at p0 - the curves are evaluated linearly in
+    // lon / lat, so they map to the same curve in this frame
+    double lon0 = p0.getLongitudeDeg();
+    double lat0 = p0.getLatitudeDeg();
+    double m_per_deg_lat = SG_DEGREES_TO_RADIANS * SG_EQUATORIAL_RADIUS_M;
+    double m_per_deg_lon = m_per_deg_lat * cos( lat0 * SG_DEGREES_TO_RADIANS );
+
+    SGGeod  src[4];
+    SGVec2d cp[4];
+    int     degree;
+
+    if ( curve_type == CURVE_QUADRATIC ) {
+        degree = 2;
+        src[0] = p0; src[1] = cp0; src[2] = p1;
+    } else {
+        degree = 3;
+        src[0] = p0; src[1] = cp0; src[2] = cp1; src[3] = p1;
+    }
+
+    for ( int i = 0; i <= degree; i++ ) {
+        cp[i] = SGVec2d( ( src[i].getLongitudeDeg() - lon0 ) * m_per_deg_lon,
+                         ( src[i].getLatitudeDeg()  - lat0 ) * m_per_deg_lat );
+    }
+
+    std::vector<SGVec2d> local;
+    FlattenBezier( cp, degree, max_dev, 0, local );
+
+    nodes.clear();
+    nodes.push_back( p0 );
+    for ( unsigned int i = 1; i < local.size(); i++ ) {
+        nodes.push_back( SGGeod::fromDeg( lon0 + local[i].x() / m_per_deg_lon,
+                                          lat0 + local[i].y() / m_per_deg_lat ) );
+    }
+}
+
 inline double CalculateTheta( const SGGeod& p0, const SGGeod& p1, const SGGeod& p2 )
 {
     SGVec2d v0, v1, v2;
@@ -106,15 +215,9 @@ inline double CalculateTheta( const SGVec3d& dirCur, const SGVec3d& dirNext, con
 }
 
 
-#define BEZIER_DETAIL   (8)
 #define LINE_WIDTH      (0.75)
 #define WIREFRAME       (1)
 
-#define CURVE_NONE                      (0)
-#define CURVE_LINEAR                    (1)
-#define CURVE_QUADRATIC                 (2)
-#define CURVE_CUBIC                     (3)
-
 
 class BezNode 
 {
@@ -0,0 +1,415 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/bucket/newbucket.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include "build_cache.hxx"
+#include "parser.hxx"
+
+// parser threads append to the manifest as they finish airports
+static SGMutex manifest_lock;
+
+// split a manifest line into at most num fields - the last one takes the rest
+static string_list SplitFields( const std::string& line, unsigned int num )
+{
+    string_list fields;
+    std::string::size_type start = 0, end;
+
+    while ( fields.size() + 1 < num && (end = line.find( '\t', start )) != std::string::npos ) {
+        fields.push_back( line.substr( start, end - start ) );
+        start = end + 1;
+    }
+    fields.push_back( line.substr( start ) );
+
+    return fields;
+}
+
+static long GetModTime( const std::string& path )
+{
+    SGPath p( path );
+
+    if ( p.exists() ) {
+        return (long)p.modTime();
+    }
+    return 0;
+}
+
+static std::string EntryToString( const BuildCacheEntry& entry )
+{
+    std::ostringstream os;
+
+    os << "AIRPORT\t" << entry.icao << "\t" << entry.record_hash << "\t" << entry.build_key << "\n";
+
+    for ( unsigned int i = 0; i < entry.elevation.size(); i++ ) {
+        os << "DEM\t" << entry.elevation[i].mtime << "\t" << entry.elevation[i].path << "\n";
+    }
+
+    for ( unsigned int i = 0; i < entry.outputs.size(); i++ ) {
+        os << "OUTPUT\t" << entry.outputs[i] << "\n";
+    }
+
+    std::map<std::string, std::string>::const_iterator it;
+    for ( it = entry.index_records.begin(); it != entry.index_records.end(); it++ ) {
+        std::istringstream records( it->second );
+        std::string        record;
+
+        while ( std::getline( records, record ) ) {
+            os << "INDEX\t" << it->first << "\t" << record << "\n";
+        }
+    }
+
+    os << "END\n";
+
+    return os.str();
+}
+
+BuildCache::BuildCache( const std::string& file, const std::string& key )
+{
+    manifest  = file;
+    build_key = key;
+    failed    = false;
+}
+
+bool BuildCache::Load( void )
+{
+    std::ifstream   in( manifest.c_str() );
+    std::string     line;
+    BuildCacheEntry entry;
+    bool            in_entry = false;
+
+    entries.clear();
+    failed = false;
+
+    if ( !in.is_open() ) {
+        if ( SGPath( manifest ).exists() ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: cannot read build cache manifest " << manifest );
+            return false;
+        }
+        SG_LOG( SG_GENERAL, SG_INFO, "No build cache manifest " << manifest << " - building all airports" );
+        return true;
+    }
+
+    while ( std::getline( in, line ) ) {
+        if ( line.find( "AIRPORT\t" ) == 0 ) {
+            string_list fields = SplitFields( line, 4 );
+
+            entry = BuildCacheEntry();
+            in_entry = ( fields.size() == 4 );
+            if ( in_entry ) {
+                entry.icao        = fields[1];
+                entry.record_hash = fields[2];
+                entry.build_key   = fields[3];
+            }
+        } else if ( !in_entry ) {
+            continue;
+        } else if ( line.find( "DEM\t" ) == 0 ) {
+            string_list fields = SplitFields( line, 3 );
+
+            if ( fields.size() == 3 ) {
+                BuildCacheFile f;
+                f.mtime = atol( fields[1].c_str() );
+                f.path  = fields[2];
+                entry.elevation.push_back( f );
+            }
+        } else if ( line.find( "OUTPUT\t" ) == 0 ) {
+            entry.outputs.push_back( line.substr( 7 ) );
+        } else if ( line.find( "INDEX\t" ) == 0 ) {
+            string_list fields = SplitFields( line, 3 );
+
+            if ( fields.size() == 3 ) {
+                entry.index_records[fields[1]] += fields[2] + "\n";
+            }
+        } else if ( line == "END" ) {
+            // only complete entries count - a worker may have died mid write
+            entries[entry.icao] = entry;
+            in_entry = false;
+        }
+    }
+
+    // keep the entries read so far - Drop() still removes their outputs
+    if ( in.bad() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: reading build cache manifest " << manifest );
+        return false;
+    }
+
+    SG_LOG( SG_GENERAL, SG_INFO, "Read " << entries.size() << " airports from build cache manifest " << manifest );
+
+    return true;
+}
+
+bool BuildCache::Save( void )
+{
+    std::string tmp = manifest + ".new";
+
+    SGPath sgp( manifest );
+    sgp.create_dir( 0755 );
+
+    FILE* fp;
+    if ( (fp = fopen( tmp.c_str(), "w" )) == NULL ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << tmp << " for writing!" );
+        return false;
+    }
+
+    bool ok = true;
+    std::map<std::string, BuildCacheEntry>::const_iterator it;
+    for ( it = entries.begin(); ok && it != entries.end(); it++ ) {
+        std::string data = EntryToString( it->second );
+        ok = ( fwrite( data.c_str(), 1, data.size(), fp ) == data.size() );
+    }
+    ok = ( fclose( fp ) == 0 ) && ok;
+    if ( !ok ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: writing " << tmp );
+        remove( tmp.c_str() );
+        return false;
+    }
+
+#ifdef _MSC_VER
+    // rename doesn't replace an existing file here
+    remove( manifest.c_str() );
+#endif
+    if ( rename( tmp.c_str(), manifest.c_str() ) != 0 ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: cannot replace " << manifest );
+        remove( tmp.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+bool BuildCache::IsUpToDate( std::ifstream& in, const std::string& icao, long pos )
+{
+    std::map<std::string, BuildCacheEntry>::iterator it = entries.find( icao );
+
+    if ( it == entries.end() ) {
+        return false;
+    }
+
+    const BuildCacheEntry& entry = it->second;
+    bool up_to_date = true;
+
+    if ( entry.build_key != build_key ) {
+        SG_LOG( SG_GENERAL, SG_DEBUG, icao << ": build options changed" );
+        up_to_date = false;
+    } else if ( entry.record_hash != HashRecord( in, pos ) ) {
+        SG_LOG( SG_GENERAL, SG_DEBUG, icao << ": apt.dat record changed" );
+        up_to_date = false;
+    }
+
+    for ( unsigned int i = 0; up_to_date && i < entry.elevation.size(); i++ ) {
+        if ( GetModTime( entry.elevation[i].path ) != entry.elevation[i].mtime ) {
+            SG_LOG( SG_GENERAL, SG_DEBUG, icao << ": elevation data " << entry.elevation[i].path << " changed" );
+            up_to_date = false;
+        }
+    }
+
+    for ( unsigned int i = 0; up_to_date && i < entry.outputs.size(); i++ ) {
+        if ( !SGPath( entry.outputs[i] ).exists() ) {
+            SG_LOG( SG_GENERAL, SG_DEBUG, icao << ": output " << entry.outputs[i] << " is missing" );
+            up_to_date = false;
+        }
+    }
+
+    if ( !up_to_date ) {
+        if ( !RemoveOutputs( entry ) ) {
+            failed = true;
+        }
+        entries.erase( it );
+    }
+
+    return up_to_date;
+}
+
+void BuildCache::RemoveMissing( const std::set<std::string>& icaos )
+{
+    std::map<std::string, BuildCacheEntry>::iterator it = entries.begin();
+
+    while ( it != entries.end() ) {
+        if ( icaos.find( it->first ) != icaos.end() ) {
+            it++;
+            continue;
+        }
+
+        SG_LOG( SG_GENERAL, SG_INFO, it->first << " is no longer in apt.dat - removing its outputs" );
+        if ( !RemoveOutputs( it->second ) ) {
+            failed = true;
+        }
+        entries.erase( it++ );
+    }
+}
+
+void BuildCache::Drop( void )
+{
+    SG_LOG( SG_GENERAL, SG_ALERT, "Dropping build cache manifest " << manifest << " - building all airports" );
+
+    std::map<std::string, BuildCacheEntry>::const_iterator it;
+    for ( it = entries.begin(); it != entries.end(); it++ ) {
+        RemoveOutputs( it->second );
+    }
+    entries.clear();
+
+    // if it stays, the next run drops it again
+    if ( remove( manifest.c_str() ) != 0 && errno != ENOENT ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: cannot remove " << manifest );
+    }
+}
+
+// returns false if an output or index record may have been left behind
+bool BuildCache::RemoveOutputs( const BuildCacheEntry& entry )
+{
+    bool ok = true;
+
+    for ( unsigned int i = 0; i < entry.outputs.size(); i++ ) {
+        SG_LOG( SG_GENERAL, SG_DEBUG, "Removing stale output " << entry.outputs[i] );
+        if ( remove( entry.outputs[i].c_str() ) != 0 && errno != ENOENT ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: removing " << entry.outputs[i] );
+            ok = false;
+        }
+    }
+
+    // take this airport's records out of the index files it appended to
+    std::map<std::string, std::string>::const_iterator it;
+    for ( it = entry.index_records.begin(); it != entry.index_records.end(); it++ ) {
+        std::multiset<std::string> stale;
+        std::istringstream         records( it->second );
+        std::string                line;
+        std::string                keep;
+
+        while ( std::getline( records, line ) ) {
+            stale.insert( line );
+        }
+
+        std::ifstream in( it->first.c_str() );
+        if ( !in.is_open() ) {
+            continue;
+        }
+        while ( std::getline( in, line ) ) {
+            std::multiset<std::string>::iterator s = stale.find( line );
+            if ( s != stale.end() ) {
+                stale.erase( s );
+            } else {
+                keep += line + "\n";
+            }
+        }
+        if ( in.bad() ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: reading " << it->first );
+            ok = false;
+            continue;
+        }
+        in.close();
+
+        if ( keep.empty() ) {
+            if ( remove( it->first.c_str() ) != 0 ) {
+                SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: removing " << it->first );
+                ok = false;
+            }
+        } else {
+            FILE* fp;
+            if ( (fp = fopen( it->first.c_str(), "w" )) == NULL ) {
+                SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << it->first << " for writing!" );
+                ok = false;
+                continue;
+            }
+            bool written = ( fwrite( keep.c_str(), 1, keep.size(), fp ) == keep.size() );
+            if ( ( fclose( fp ) != 0 ) || !written ) {
+                SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: writing " << it->first );
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+void BuildCache::Record( const BuildCacheEntry& entry )
+{
+    std::string data = EntryToString( entry );
+
+    SGGuard<SGMutex> g( manifest_lock );
+
+    // without its entry, the next run builds the airport again, but can't
+    // take out the index records of this build first
+    FILE* fp;
+    if ( (fp = fopen( manifest.c_str(), "a" )) == NULL ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << manifest << " for writing! " << entry.icao << " isn't cached" );
+        return;
+    }
+
+    // one append per entry - worker processes ( --processes ) don't share
+    // manifest_lock
+    setvbuf( fp, NULL, _IOFBF, data.size() + 1 );
+    bool ok = ( fwrite( data.c_str(), 1, data.size(), fp ) == data.size() );
+    if ( ( fclose( fp ) != 0 ) || !ok ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: writing " << manifest << " - " << entry.icao << " isn't cached" );
+    }
+}
+
+std::string BuildCache::HashRecord( std::ifstream& in, long pos )
+{
+    // 64 bit FNV-1a over the record lines, up to the next airport
+    unsigned long long hash = 14695981039346656037ULL;
+    std::string        line;
+    bool               first = true;
+    char               hash_string[32];
+
+    in.clear();
+    in.seekg( pos, std::ios::beg );
+
+    while ( std::getline( in, line ) ) {
+        int code = atoi( line.c_str() );
+
+        if ( !first && ( code == LAND_AIRPORT_CODE || code == SEA_AIRPORT_CODE ||
+                         code == HELIPORT_CODE || code == END_OF_FILE ) ) {
+            break;
+        }
+        first = false;
+
+        line += "\n";
+        for ( unsigned int i = 0; i < line.size(); i++ ) {
+            hash ^= (unsigned char)line[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    in.clear();
+
+    sprintf( hash_string, "%016llx", hash );
+
+    return hash_string;
+}
+
+void BuildCache::GetElevationFiles( const std::string& root, const string_list& elev_src,
+                                    const tgRectangle& bounds, std::vector<BuildCacheFile>& files )
+{
+    std::vector<SGBucket> buckets;
+
+    sgGetBuckets( bounds.getMin(), bounds.getMax(), buckets );
+
+    for ( unsigned int i = 0; i < buckets.size(); i++ ) {
+        std::string base = buckets[i].gen_base_path() + "/" + buckets[i].gen_index_str();
+
+        // same search order as tgAverageElevation and tgSurface
+        for ( unsigned int j = 0; j < elev_src.size(); j++ ) {
+            BuildCacheFile array;
+
+            array.path  = root + "/" + elev_src[j] + "/" + base + ".arr.gz";
+            array.mtime = GetModTime( array.path );
+            files.push_back( array );
+
+            if ( array.mtime ) {
+                // the fitted data is read along with the array
+                BuildCacheFile fitted;
+
+                fitted.path  = root + "/" + elev_src[j] + "/" + base + ".fit.gz";
+                fitted.mtime = GetModTime( fitted.path );
+                files.push_back( fitted );
+                break;
+            }
+        }
+    }
+}
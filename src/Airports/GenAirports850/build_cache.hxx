@@ -0,0 +1,95 @@
+#ifndef __BUILD_CACHE_HXX__
+#define __BUILD_CACHE_HXX__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <simgear/compiler.h>
+#include <simgear/math/sg_types.hxx>
+#include <terragear/tg_rectangle.hxx>
+
+// a file an airport build read, and its modification time at the time -
+// 0 if it didn't exist, in which case it must still not exist
+struct BuildCacheFile
+{
+    std::string path;
+    long        mtime;
+};
+
+// what an airport was built from, and what it produced
+class BuildCacheEntry
+{
+public:
+    std::string                         icao;
+    std::string                         record_hash;    // of the raw apt.dat record
+    std::string                         build_key;      // tool version and build options
+    std::vector<BuildCacheFile>         elevation;      // DEM arrays under the airport
+    string_list                         outputs;        // btg files written
+
+    // index file -> the records this airport appended to it
+    std::map<std::string, std::string>  index_records;
+};
+
+// The build cache manifest ( --incremental ) keeps one entry per airport.
+// Airports whose record, elevation data and build key are unchanged, and
+// whose outputs still exist, are skipped.  Changed airports have their old
+// outputs and index records removed before they are rebuilt, as do airports
+// no longer in apt.dat.
+//
+// If the manifest, or the outputs it lists, can't be read or written, the
+// cache is dropped and every airport built again - see Drop().
+class BuildCache
+{
+public:
+    BuildCache( const std::string& file, const std::string& key );
+
+    const std::string& GetBuildKey( void ) const { return build_key; }
+
+    // read the manifest - a later entry for an airport replaces an earlier
+    // one.  Returns false if it exists but can't be read
+    bool Load( void );
+
+    // rewrite the manifest with the remaining entries - false on an I/O error
+    bool Save( void );
+
+    // true if the airport record at pos is unchanged since it was last
+    // built.  If not, the outputs of the previous build are removed.
+    bool IsUpToDate( std::ifstream& in, const std::string& icao, long pos );
+
+    // remove the outputs and entries of the airports not in icaos - the
+    // ones taken out of apt.dat
+    void RemoveMissing( const std::set<std::string>& icaos );
+
+    // true once the outputs of an entry couldn't be removed
+    bool HasFailed( void ) const { return failed; }
+
+    // give up on the manifest : remove the outputs of every airport in it,
+    // as far as possible, and the manifest itself.  Airports built from
+    // now on are recorded in a new one.
+    void Drop( void );
+
+    // append the entry of a freshly built airport - safe to call from the
+    // parser threads and worker processes
+    void Record( const BuildCacheEntry& entry );
+
+    // hash of the raw bytes of the airport record starting at pos
+    static std::string HashRecord( std::ifstream& in, long pos );
+
+    // the DEM arrays the elevation lookups read for the given area - the
+    // first existing array of each bucket, and the missing ones before it
+    static void GetElevationFiles( const std::string& root, const string_list& elev_src,
+                                   const tgRectangle& bounds, std::vector<BuildCacheFile>& files );
+
+private:
+    bool RemoveOutputs( const BuildCacheEntry& entry );
+
+    std::string                             manifest;
+    std::string                             build_key;
+    std::map<std::string, BuildCacheEntry>  entries;
+    bool                                    failed;
+};
+
+#endif
@@ -152,7 +152,7 @@ void ClosedPoly::ConvertContour( BezContour* src, tgContour& dst )
 
     int       curve_type = CURVE_LINEAR;
     double    total_dist;
-    int       num_segs = BEZIER_DETAIL;
+    int       num_segs = 1;
 
     TG_LOG(SG_GENERAL, SG_DEBUG, "Creating a contour with " << src->size() << " nodes");
 
@@ -213,35 +213,13 @@ void ClosedPoly::ConvertContour( BezContour* src, tgContour& dst )
             }
         }
 
-        if (total_dist < 8.0f)
+        // curves are flattened adaptively, below
+        if (curve_type == CURVE_LINEAR)
         {
-            if (curve_type != CURVE_LINEAR)
-            {
-                // If total distance is < 4 meters, then we need to modify num Segments so that each segment >= 2 meters
-                num_segs = ((int)total_dist + 1);
-                TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-                TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " ( < 16.0) so num_segs is " << num_segs );
-            }
-            else
+            if (total_dist < 8.0f)
             {
                 num_segs = 1;
             }
-        }
-        else if (total_dist > 800.0f)
-        {
-            // If total distance is > 800 meters, then we need to modify num Segments so that each segment <= 100 meters
-            num_segs = total_dist / 100.0f + 1;
-            TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-            TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " ( > 100.0) so num_segs is " << num_segs );
-        }
-        else
-        {
-            if (curve_type != CURVE_LINEAR)
-            {
-                num_segs = 8;
-                TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-                TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " (OK) so num_segs is " << num_segs );
-            }
             else
             {
                 // make sure linear segments don't got over 100m
@@ -250,34 +228,25 @@ void ClosedPoly::ConvertContour( BezContour* src, tgContour& dst )
         }
 
 #if NO_BEZIER
+        curve_type = CURVE_LINEAR;
         num_segs = 1;
 #endif
 
-        // if only one segment, revert to linear
-        if (num_segs == 1)
-        {
-            curve_type = CURVE_LINEAR;
-        }
-
         // initialize current location
         curLoc = curNode->GetLoc();
         if (curve_type != CURVE_LINEAR)
         {
-            for (int p=0; p<num_segs; p++)
+            std::vector<SGGeod> curve;
+            CalculateBezierNodes( curve_type, curNode->GetLoc(), cp1, cp2, nextNode->GetLoc(), bezier_max_dev, curve );
+
+            TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
+            TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " so num_segs is " << curve.size() );
+
+            for (unsigned int p=0; p<curve.size(); p++)
             {
-                // calculate next location
-                if (curve_type == CURVE_QUADRATIC)
-                {
-                    nextLoc = CalculateQuadraticLocation( curNode->GetLoc(), cp1, nextNode->GetLoc(), (1.0f/num_segs) * (p+1) );
-                }
-                else
-                {
-                    nextLoc = CalculateCubicLocation( curNode->GetLoc(), cp1, cp2, nextNode->GetLoc(), (1.0f/num_segs) * (p+1) );
-                }
+                curLoc = curve[p];
 
                 // add the pavement vertex
-                // convert from lat/lon to geo
-                // (maybe later) - check some simgear objects...
                 dst.AddNode( curLoc );
 
                 if (p==0)
@@ -288,10 +257,10 @@ void ClosedPoly::ConvertContour( BezContour* src, tgContour& dst )
                 {
                     TG_LOG(SG_GENERAL, SG_DEBUG, "   add bezier node (type  " << curve_type << ") at " << curLoc );
                 }
-
-                // now set set cur location for the next iteration
-                curLoc = nextLoc;
             }
+
+            // now set set cur location for the next iteration
+            curLoc = nextNode->GetLoc();
         }
         else
         {
@@ -1,12 +1,27 @@
 #include <ctime>
+#include <simgear/threads/SGGuard.hxx>
+
 #include "debug.hxx"
 
-std::map<long, std::string> thread_prefix_map;
+/* This map maps thread IDs to ICAO prefixes */
+static std::map<long, std::string> thread_prefix_map;
+static SGMutex thread_prefix_lock;
 
 void DebugRegisterPrefix( const std::string& prefix ) {
+    SGGuard<SGMutex> g( thread_prefix_lock );
     thread_prefix_map[SGThread::current()] = prefix;
 }
 
+std::string DebugGetPrefix( void ) {
+    SGGuard<SGMutex> g( thread_prefix_lock );
+    std::map<long, std::string>::const_iterator it = thread_prefix_map.find( SGThread::current() );
+
+    if ( it != thread_prefix_map.end() ) {
+        return it->second;
+    }
+    return std::string();
+}
+
 std::string DebugTimeToString(time_t& tt)
 {
     char buf[256];
@@ -14,16 +14,16 @@ typedef std::map<std::string, std::vector<int>, std::less<std::string> > debug_m
 typedef debug_map::iterator debug_map_iterator;
 typedef debug_map::const_iterator debug_map_const_iterator;
 
-/* This map maps thread IDs to ICAO prefixes */
-extern std::map<long, std::string> thread_prefix_map;
-
+/* thread IDs are mapped to ICAO prefixes - the map is shared by the parser
+ * threads and the airport build tasks, so it is only accessed through these */
 extern void DebugRegisterPrefix( const std::string& prefix );
+extern std::string DebugGetPrefix( void );
 extern std::string DebugTimeToString(time_t& tt);
 
 #define TG_LOG(C,P,M)  do {                                         \
     if(sglog().would_log(C,P)) {                                    \
         std::ostringstream os;                                      \
-        os << thread_prefix_map[SGThread::current()] << ":" << M;   \
+        os << DebugGetPrefix() << ":" << M;                         \
         sglog().log(C, P, __FILE__, __LINE__, os.str());            \
     }                                                               \
 } while(0)
@@ -34,4 +34,11 @@ extern double gSnap;
 extern double slope_max;
 extern double slope_eps;
 
+// Maximum distance (in meters) of a flattened bezier curve from the true curve
+extern double bezier_max_dev;
+
+// Build the stages of each airport one after the other, instead of as a
+// task graph ( --serial-build )
+extern bool serial_build;
+
 #endif
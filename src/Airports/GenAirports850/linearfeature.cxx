@@ -23,7 +23,7 @@ void LinearFeature::ConvertContour( BezContour* src, bool closed )
     int       curve_type = CURVE_LINEAR;
     double    total_dist;
     double    theta1, theta2;
-    int       num_segs = BEZIER_DETAIL;
+    int       num_segs = 1;
     
     Marking*  cur_mark = NULL;
     Lighting* cur_light = NULL;
@@ -222,34 +222,15 @@ void LinearFeature::ConvertContour( BezContour* src, bool closed )
             }
         }
 
-        if (total_dist < 4.0f)
+        // curves are flattened adaptively, below
+        if (curve_type == CURVE_LINEAR)
         {
-            if (curve_type != CURVE_LINEAR)
+            if (total_dist > 800.0f)
             {
-                // If total distance is < 4 meters, then we need to modify num Segments so that each segment >= 1/2 meter
-                num_segs = ((int)total_dist + 1) * 2;
+                // If total distance is > 800 meters, then we need to modify num Segments so that each segment <= 100 meters
+                num_segs = total_dist / 100.0f + 1;
                 TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-                TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " ( < 4.0) so num_segs is " << num_segs );
-            }
-            else
-            {
-                num_segs = 1;
-            }
-        }
-        else if (total_dist > 800.0f)
-        {
-            // If total distance is > 800 meters, then we need to modify num Segments so that each segment <= 100 meters
-            num_segs = total_dist / 100.0f + 1;
-            TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-            TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " ( > 100.0) so num_segs is " << num_segs );
-        }
-        else
-        {
-            if (curve_type != CURVE_LINEAR)
-            {
-                num_segs = 8;
-                TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
-                TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " (OK) so num_segs is " << num_segs );
+                TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " ( > 100.0) so num_segs is " << num_segs );
             }
             else
             {
@@ -257,27 +238,19 @@ void LinearFeature::ConvertContour( BezContour* src, bool closed )
             }
         }
 
-        // if only one segment, revert to linear
-        if (num_segs == 1)
-        {
-            curve_type = CURVE_LINEAR;
-        }
-
         // initialize current location
         curLoc = curNode->GetLoc();
         if (curve_type != CURVE_LINEAR)
         {
-            for (int p=0; p<num_segs; p++)
+            std::vector<SGGeod> curve;
+            CalculateBezierNodes( curve_type, curNode->GetLoc(), cp1, cp2, nextNode->GetLoc(), bezier_max_dev, curve );
+
+            TG_LOG(SG_GENERAL, SG_DEBUG, "Segment from " << curNode->GetLoc() << " to " << nextNode->GetLoc() );
+            TG_LOG(SG_GENERAL, SG_DEBUG, "        Distance is " << total_dist << " so num_segs is " << curve.size() );
+
+            for (unsigned int p=0; p<curve.size(); p++)
             {
-                // calculate next location
-                if (curve_type == CURVE_QUADRATIC)
-                {
-                    nextLoc = CalculateQuadraticLocation( curNode->GetLoc(), cp1, nextNode->GetLoc(), (1.0f/num_segs) * (p+1) );
-                }
-                else
-                {
-                    nextLoc = CalculateCubicLocation( curNode->GetLoc(), cp1, cp2, nextNode->GetLoc(), (1.0f/num_segs) * (p+1) );
-                }
+                curLoc = curve[p];
 
                 // add the feature vertex
                 points.AddNode(curLoc);
@@ -290,10 +263,10 @@ void LinearFeature::ConvertContour( BezContour* src, bool closed )
                 {
                     TG_LOG(SG_GENERAL, SG_DEBUG, "   add bezier node (type  " << curve_type << ") at " << curLoc );
                 }
-
-                // now set set prev and cur locations for the next iteration
-                curLoc = nextLoc;
             }
+
+            // now set set prev and cur locations for the next iteration
+            curLoc = nextNode->GetLoc();
         }
         else
         {
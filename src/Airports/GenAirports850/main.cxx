@@ -14,7 +14,9 @@
 
 
 #include <string>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <boost/thread.hpp>
 
@@ -23,6 +25,8 @@
 #include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/strutils.hxx>
 
+#include <terragear/tg_debug_sink.hxx>
+#include <terragear/tg_local_frame.hxx>
 #include <Include/version.h>
 
 #include "scheduler.hxx"
@@ -39,7 +43,9 @@ static void usage( int argc, char **argv ) {
     TG_LOG(SG_GENERAL, SG_ALERT, "Usage: " << argv[0] << "\n--input=<apt_file>"
     << "\n--work=<work_dir>\n[ --start-id=abcd ] [ --restart-id=abcd ] [ --nudge=n ] "
     << "[--min-lon=<deg>] [--max-lon=<deg>] [--min-lat=<deg>] [--max-lat=<deg>] "
-    << "[ --airport=abcd ] [--max-slope=<decimal>] [--tile=<tile>] [--threads] [--threads=x]"
+    << "[ --airport=abcd ] [--max-slope=<decimal>] [--bezier-max-dev=<m>] [--tile=<tile>] [--threads] [--threads=x] "
+    << "[--processes] [--processes=x] [--max-time=<sec>] [--max-rss=<MB>] [--incremental] [--profile=<csv_file>] "
+    << "[--debug-sink=<checkpoint,...|all>] [--debug-sink-scope=<icao,...>] [--geodesy-tolerance=<m>] [--serial-build] "
     << "[--chunk=<chunk>] [--dem-path=<path>] [--verbose] [--help]");
 }
 
@@ -65,6 +71,17 @@ static void help( int argc, char **argv, const string_list& elev_src ) {
     cout << "start-id are done.  This is convienient when re-starting after a previous error.  \n";
     cout << "If you want to restart with the airport after a problam icao, use --restart-id=abcd, as this works the same as\n";
     cout << " with the exception that the airport abcd is skipped \n";
+    cout << "With --incremental, airports whose apt.dat record, elevation data and build options are unchanged \n";
+    cout << "since they were last built into the work directory are skipped, and the outputs of airports \n";
+    cout << "no longer in the input file are removed.  If the build cache can't be read or written, all airports are built.  \n";
+    cout << "With --profile=<csv_file>, the time, memory growth and poly, vertex and triangle counts of each \n";
+    cout << "build phase of each airport are written to csv_file, and the slowest airports to csv_file_slowest.csv.  \n";
+    cout << "With --debug-sink=<checkpoint,...>, the named debug shapefile dumps (eg segnet_input, segnet_clustered) \n";
+    cout << "are written - all of them with --debug-sink=all.  --debug-sink-scope=<icao,...> limits them to these airports.  \n";
+    cout << "--geodesy-tolerance=<m> is the error allowed for the local geodesic calculations in texturing (default 0.001m). \n";
+    cout << "Pairs of points further apart than this allows are solved exactly.  0 always solves exactly.  \n";
+    cout << "--serial-build builds the base, features and lights of each airport one after the other, \n";
+    cout << "on the parser thread, rather than side by side.  The output is the same.  \n";
     cout << "\nAn input area may be specified by lat and lon extent using min and max lat and lon.  \n";
     cout << "Alternatively, you may specify a chunk (10 x 10 degrees) or tile (1 x 1 degree) using a string \n";
     cout << "such as eg. w080n40, e000s27.  \n";
@@ -88,6 +105,8 @@ int nudge = 10;
 double gSnap = 0.00000001;      // approx 1 mm
 double slope_max = 0.02;
 double slope_eps = 0.00001;
+double bezier_max_dev = 0.25;
+bool serial_build = false;
 
 int main(int argc, char **argv)
 {
@@ -117,6 +136,13 @@ int main(int argc, char **argv)
     std::string airport_id = "";
     std::string last_apt_file = "./last_apt.txt";
     int         num_threads    =  1;
+    int         num_processes  =  0;
+    int         max_time       =  P_WORKER_MAX_TIME;
+    int         max_rss        =  0;
+    int         worker_job_fd  = -1;
+    int         worker_result_fd = -1;
+    bool        incremental    =  false;
+    std::string profile_file   =  "";
 
     int arg_pos;
     for (arg_pos = 1; arg_pos < argc; arg_pos++)
@@ -182,6 +208,39 @@ int main(int argc, char **argv)
         {
             slope_max = atof( arg.substr(12).c_str() );
         }
+        else if ( (arg.find("--bezier-max-dev=") == 0) ) 
+        {
+            bezier_max_dev = atof( arg.substr(17).c_str() );
+        }
+        else if ( (arg.find("--processes=") == 0) )
+        {
+            num_processes = atoi( arg.substr(12).c_str() );
+        }
+        else if ( (arg.find("--processes") == 0) )
+        {
+            num_processes = boost::thread::hardware_concurrency();
+        }
+        else if ( (arg.find("--max-time=") == 0) )
+        {
+            max_time = atoi( arg.substr(11).c_str() );
+        }
+        else if ( (arg.find("--max-rss=") == 0) )
+        {
+            max_rss = atoi( arg.substr(10).c_str() );
+        }
+        else if ( (arg.find("--worker=") == 0) )
+        {
+            // added by the parent of a worker process - see WorkerPool
+            sscanf( arg.substr(9).c_str(), "%d,%d", &worker_job_fd, &worker_result_fd );
+        }
+        else if ( (arg.find("--incremental") == 0) )
+        {
+            incremental = true;
+        }
+        else if ( (arg.find("--profile=") == 0) )
+        {
+            profile_file = arg.substr(10);
+        }
         else if ( (arg.find("--threads=") == 0) )
         {
             num_threads = atoi( arg.substr(10).c_str() );
@@ -211,6 +270,22 @@ int main(int argc, char **argv)
         {
             debug_feature_defs.push_back( arg.substr(17) );
         }
+        else if (arg.find("--debug-sink=") == 0)
+        {
+            tgDebugSink::EnableCheckpoints( arg.substr(13) );
+        }
+        else if (arg.find("--debug-sink-scope=") == 0)
+        {
+            tgDebugSink::EnableScopes( arg.substr(19) );
+        }
+        else if (arg.find("--serial-build") == 0)
+        {
+            serial_build = true;
+        }
+        else if (arg.find("--geodesy-tolerance=") == 0)
+        {
+            tgLocalFrame::SetTolerance( atof( arg.substr(20).c_str() ) );
+        }
         else if ( (arg.find("--help") == 0) || (arg.find("-h") == 0) )
         {
             help( argc, argv, elev_src );
@@ -298,6 +373,42 @@ int main(int argc, char **argv)
     // Add any debug 
     scheduler->set_debug( debug_dir, debug_runway_defs, debug_pavement_defs, debug_taxiway_defs, debug_feature_defs );
 
+    // build in worker processes, rather than threads
+    if ( num_processes > 0 )
+    {
+        string_list command( argv, argv + argc );
+        scheduler->set_processes( num_processes, max_time, max_rss, command );
+    }
+
+    // skip the airports that haven't changed since the last build
+    if ( incremental )
+    {
+        std::ostringstream build_key;
+
+        build_key << std::setprecision(12) << "genapts850 " << getTGVersion()
+                  << " nudge=" << nudge << " snap=" << gSnap
+                  << " max-slope=" << slope_max << " slope-eps=" << slope_eps
+                  << " bezier-max-dev=" << bezier_max_dev
+                  << " geodesy-tolerance=" << tgLocalFrame::GetTolerance();
+        for ( unsigned int i = 0; i < elev_src.size(); ++i ) {
+            build_key << " dem-path=" << elev_src[i];
+        }
+
+        scheduler->set_incremental( build_key.str() );
+    }
+
+    // report the time and size of each build phase
+    if ( profile_file != "" )
+    {
+        scheduler->set_profile( profile_file );
+    }
+
+    // a worker process builds the airports its parent sends it
+    if ( worker_job_fd >= 0 )
+    {
+        scheduler->RunWorker( worker_job_fd, worker_result_fd );
+    }
+
     // just one airport 
     if ( airport_id != "" )
     {
@@ -26,101 +26,170 @@
 
 #include <stdio.h>
 #include <cstdlib>
+#include <iomanip>
+#include <set>
+#include <sstream>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/bucket/newbucket.hxx>
 #include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include "output.hxx"
 
 using std::string;
 
+// all parser threads append to the same index files
+static SGMutex index_lock;
+
+// directories already created ( guarded by index_lock )
+static std::set<string> index_dirs;
+
+string ObjectIndexWriter::IndexFile( const string& base, const SGBucket& b ) const
+{
+    return base + "/" + b.gen_base_path() + "/" + b.gen_index_str() + ".ind";
+}
+
 // update index file (list of objects to be included in final scenery build)
-void write_index( const string& base, const SGBucket& b, const string& name )
+void ObjectIndexWriter::AddObject( const string& base, const SGBucket& b, const string& name )
 {
-    string dir = base + "/" + b.gen_base_path();
-    SGPath sgp( dir );
-    sgp.append( "dummy" );
-    sgp.create_dir( 0755 );
-
-    string file = dir + "/" + b.gen_index_str() + ".ind";
-    SG_LOG( SG_GENERAL, SG_DEBUG, "Writing object to " << file );
-
-    FILE *fp;
-    if ( (fp = fopen( file.c_str(), "a" )) == NULL ) {
-        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << file << " for writing!" );
-        exit(-1);
-    }
+    SG_LOG( SG_GENERAL, SG_DEBUG, "Adding object " << name << " to index of " << b.gen_index_str() );
+
+    string file = IndexFile( base, b );
 
-    fprintf( fp, "OBJECT %s\n", name.c_str() );
-    fclose( fp );
+    records[file] += "OBJECT " + name + "\n";
+    pending_files[file].push_back( base + "/" + b.gen_base_path() + "/" + name + ".gz" );
 }
 
-void write_index_lines( const string& base, const SGBucket& b, const string& name )
+void ObjectIndexWriter::AddObjectLines( const string& base, const SGBucket& b, const string& name )
 {
-    string dir = base + "/" + b.gen_base_path();
-    SGPath sgp( dir );
-    sgp.append( "dummy" );
-    sgp.create_dir( 0755 );
-    
-    string file = dir + "/" + b.gen_index_str() + ".ind";
-    SG_LOG( SG_GENERAL, SG_DEBUG, "Writing object to " << file );
-    
-    FILE *fp;
-    if ( (fp = fopen( file.c_str(), "a" )) == NULL ) {
-        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << file << " for writing!" );
-        exit(-1);
-    }
-    
-//    fprintf( fp, "OBJECT_LINES %s\n", name.c_str() );
-    fprintf( fp, "OBJECT %s\n", name.c_str() );
-    fclose( fp );
+    SG_LOG( SG_GENERAL, SG_DEBUG, "Adding object " << name << " to index of " << b.gen_index_str() );
+
+    string file = IndexFile( base, b );
+
+//    records[file] += "OBJECT_LINES " + name + "\n";
+    records[file] += "OBJECT " + name + "\n";
+    pending_files[file].push_back( base + "/" + b.gen_base_path() + "/" + name + ".gz" );
 }
 
 // update index file (list of shared objects to be included in final
 // scenery build)
-void write_index_shared( const string &base, const SGBucket &b,
-                         const SGGeod &p, const string& name,
-                         const double &heading )
+void ObjectIndexWriter::AddObjectShared( const string &base, const SGBucket &b,
+                                         const SGGeod &p, const string& name,
+                                         const double &heading )
+{
+    std::ostringstream line;
+
+    SG_LOG( SG_GENERAL, SG_DEBUG, "Adding shared object " << name << " to index of " << b.gen_index_str() );
+
+    line << std::fixed << "OBJECT_SHARED " << name << " "
+         << std::setprecision(6) << p.getLongitudeDeg() << " " << p.getLatitudeDeg() << " "
+         << std::setprecision(1) << p.getElevationM() << " "
+         << std::setprecision(2) << heading << "\n";
+
+    records[ IndexFile( base, b ) ] += line.str();
+}
+
+void ObjectIndexWriter::AddObjectSign( const string &base, const SGBucket &b,
+                                       const SGGeod &p, const string& sign,
+                                       const double &heading, const int &size)
+{
+    std::ostringstream line;
+
+    SG_LOG( SG_GENERAL, SG_DEBUG, "Adding sign to index of " << b.gen_index_str() );
+
+    line << std::fixed << "OBJECT_SIGN " << sign << " "
+         << std::setprecision(6) << p.getLongitudeDeg() << " " << p.getLatitudeDeg() << " "
+         << std::setprecision(1) << p.getElevationM() << " "
+         << std::setprecision(2) << heading << " "
+         << (unsigned int)size << "\n";
+
+    records[ IndexFile( base, b ) ] += line.str();
+}
+
+ObjectIndexWriter::~ObjectIndexWriter()
+{
+    // too late to report a failure to anyone - Flush() before this
+    if ( !records.empty() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ObjectIndexWriter: dropping the records of " << records.size() << " unwritten index files" );
+    }
+}
+
+// append the buffered records - one write per index file
+bool ObjectIndexWriter::Flush( void )
+{
+    if ( records.empty() ) {
+        return true;
+    }
+
+    SGGuard<SGMutex> g( index_lock );
+
+    std::map<string, string>::iterator it = records.begin();
+    while ( it != records.end() ) {
+        string const& file = it->first;
+        string const& data = it->second;
+
+        SGPath sgp( file );
+        string dir = sgp.dir();
+        if ( index_dirs.find( dir ) == index_dirs.end() ) {
+            sgp.create_dir( 0755 );
+            index_dirs.insert( dir );
+        }
+
+        SG_LOG( SG_GENERAL, SG_DEBUG, "Writing objects to " << file );
+
+        FILE *fp;
+        if ( (fp = fopen( file.c_str(), "a" )) == NULL ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << file << " for writing!" );
+            return false;
+        }
+
+        // buffer it all, so it goes out in one append - worker processes
+        // ( --processes ) don't share index_lock
+        setvbuf( fp, NULL, _IOFBF, data.size() + 1 );
+        bool ok = ( fwrite( data.c_str(), 1, data.size(), fp ) == data.size() );
+        ok = ( fclose( fp ) == 0 ) && ok;
+        if ( !ok ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: writing " << file );
+            return false;
+        }
+
+        written[file] += data;
+
+        string_list& files = pending_files[file];
+        written_files.insert( written_files.end(), files.begin(), files.end() );
+        pending_files.erase( file );
+        records.erase( it++ );
+    }
+
+    return true;
+}
+
+void ObjectIndexWriter::Discard( void )
 {
-    string dir = base + "/" + b.gen_base_path();
-    SGPath sgp( dir );
-    sgp.append( "dummy" );
-    sgp.create_dir( 0755 );
-
-    string file = dir + "/" + b.gen_index_str() + ".ind";
-    SG_LOG( SG_GENERAL, SG_DEBUG, "Writing shared object to " << file );
-
-    FILE *fp;
-    if ( (fp = fopen( file.c_str(), "a" )) == NULL ) {
-        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << file << " for writing!" );
-        exit(-1);
+    std::map<string, string_list>::const_iterator it;
+    for ( it = pending_files.begin(); it != pending_files.end(); it++ ) {
+        for ( unsigned int i = 0; i < it->second.size(); i++ ) {
+            string const& file = it->second[i];
+
+            SG_LOG( SG_GENERAL, SG_ALERT, "Removing " << file << " - it won't be in " << it->first );
+            if ( remove( file.c_str() ) != 0 ) {
+                SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: removing " << file );
+            }
+        }
     }
 
-    fprintf( fp, "OBJECT_SHARED %s %.6f %.6f %.1f %.2f\n", name.c_str(),
-             p.getLongitudeDeg(), p.getLatitudeDeg(), p.getElevationM(), heading );
-    fclose( fp );
+    pending_files.clear();
+    records.clear();
 }
 
-void write_object_sign( const string &base, const SGBucket &b,
-                        const SGGeod &p, const string& sign,
-                        const double &heading, const int &size)
+void ObjectIndexWriter::GetWritten( std::map<string, string>& index_records, string_list& files ) const
 {
-    string dir = base + "/" + b.gen_base_path();
-    SGPath sgp( dir );
-    sgp.append( "dummy" );
-    sgp.create_dir( 0755 );
-
-    string file = dir + "/" + b.gen_index_str() + ".ind";
-    SG_LOG( SG_GENERAL, SG_DEBUG, "Writing sign to " << file );
-
-    FILE *fp;
-    if ( (fp = fopen( file.c_str(), "a" )) == NULL ) {
-        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << file << " for writing!" );
-        exit(-1);
+    std::map<string, string>::const_iterator it;
+    for ( it = written.begin(); it != written.end(); it++ ) {
+        index_records[it->first] += it->second;
     }
 
-    fprintf( fp, "OBJECT_SIGN %s %.6f %.6f %.1f %.2f %u\n", sign.c_str(),
-             p.getLongitudeDeg(), p.getLatitudeDeg(), p.getElevationM(), heading, size );
-    fclose( fp );
+    files.insert( files.end(), written_files.begin(), written_files.end() );
 }
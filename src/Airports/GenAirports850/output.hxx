@@ -27,25 +27,58 @@
 #include <config.h>
 #endif
 
+#include <map>
 #include <string>
 
-// update index file (list of objects to be included in final scenery build)
-void write_index( const std::string& base, const SGBucket& b, const std::string& name );
+#include <simgear/bucket/newbucket.hxx>
+#include <simgear/math/sg_types.hxx>
 
-// btg contains line data only - draped on top of base
-// lower LOD levels don't load this.
-void write_index_lines( const std::string& base, const SGBucket& b, const std::string& name );
+// Collects the index file records (list of objects to be included in final
+// scenery build) of one airport in memory, by index file.  Flush() appends
+// each file's records with a single write, serialized between the parser
+// threads, so records from different airports never interleave.  When the
+// airport fails, Discard() drops the records not flushed yet and deletes the
+// object files they name, so no btg is left without its index line.
+class ObjectIndexWriter
+{
+public:
+    ObjectIndexWriter() {}
+    ~ObjectIndexWriter();
 
-// update index file (list of shared objects to be included in final
-// scenery build)
-void write_index_shared( const std::string &base, const SGBucket &b,
-                         const SGGeod &p, const std::string& name,
-                         const double &heading );
+    void AddObject( const std::string& base, const SGBucket& b, const std::string& name );
 
-// update index file (list of shared objects to be included in final
-// scenery build)
-void write_object_sign( const std::string &base, const SGBucket &b,
+    // btg contains line data only - draped on top of base
+    // lower LOD levels don't load this.
+    void AddObjectLines( const std::string& base, const SGBucket& b, const std::string& name );
+
+    void AddObjectShared( const std::string &base, const SGBucket &b,
+                          const SGGeod &p, const std::string& name,
+                          const double &heading );
+
+    void AddObjectSign( const std::string &base, const SGBucket &b,
                         const SGGeod &p, const std::string& sign,
                         const double &heading, const int &size );
 
+    // false if an index file couldn't be written - its records, and those
+    // of the files after it, are kept
+    bool Flush( void );
+
+    // drop the records not flushed, and delete the object files they name
+    void Discard( void );
+
+    // the records flushed so far, by index file, and the btg files they name
+    void GetWritten( std::map<std::string, std::string>& index_records, string_list& files ) const;
+
+private:
+    std::string IndexFile( const std::string& base, const SGBucket& b ) const;
+
+    // index file name -> buffered records, and the object files they name
+    std::map<std::string, std::string> records;
+    std::map<std::string, string_list> pending_files;
+
+    // index file name -> flushed records, and the object files referenced
+    std::map<std::string, std::string> written;
+    string_list                        written_files;
+};
+
 #endif
@@ -4,7 +4,9 @@
 #include <simgear/misc/sgstream.hxx>
 #include <simgear/timing/timestamp.hxx>
 
+#include "build_cache.hxx"
 #include "parser.hxx"
+#include "profile.hxx"
 
 bool Parser::GetAirportDefinition( char* line, std::string& icao )
 {
@@ -168,6 +170,23 @@ void Parser::set_debug( std::string path, std::vector<std::string> runway_defs,
 }
 
 void Parser::run()
+{
+    std::ifstream in( filename.c_str() );
+    if ( !in.is_open() ) 
+    {
+        TG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << filename );
+        exit(-1);
+    }
+
+    // as long as we have airports to parse, do so
+    while (!global_workQueue.empty()) {
+        AirportInfo ai = global_workQueue.pop();
+
+        BuildAirport( in, ai );
+    }
+}
+
+void Parser::BuildAirport( std::ifstream& in, AirportInfo& ai )
 {
     char line[2048];
     std::string icao;
@@ -181,74 +200,100 @@ void Parser::run()
     time_t      log_time;
     long        pos;
 
-    std::ifstream in( filename.c_str() );
-    if ( !in.is_open() ) 
-    {
-        TG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << filename );
-        exit(-1);
+    if ( ai.GetIcao() == "NZSP" ) {
+        return;
     }
 
-    // as long as we have airports to parse, do so
-    while (!global_workQueue.empty()) {
-        AirportInfo ai = global_workQueue.pop();
+    DebugRegisterPrefix( ai.GetIcao() );
+    pos = ai.GetPos();
+    in.clear();
+    in.seekg(pos, std::ios::beg);
 
-        if ( ai.GetIcao() == "NZSP" ) {
-            continue;
-        }
+    // get a line
+    in.getline(line, 2048);
 
-        DebugRegisterPrefix( ai.GetIcao() );
-        pos = ai.GetPos();
-        in.seekg(pos, std::ios::beg);
+    // Verify this is and airport definition and get the icao
+    if( GetAirportDefinition( line, icao ) ) {
+        TG_LOG( SG_GENERAL, SG_INFO, "Found airport " << icao << " at " << pos );
 
-        // get a line
-        in.getline(line, 2048);
+        // Start parse at pos
+        SetState(STATE_NONE);
+        in.clear();
 
-        // Verify this is and airport definition and get the icao
-        if( GetAirportDefinition( line, icao ) ) {
-            TG_LOG( SG_GENERAL, SG_INFO, "Found airport " << icao << " at " << pos );
+        parse_start.stamp();
+        log_time = time(0);
+        TG_LOG( SG_GENERAL, SG_ALERT, "\n*******************************************************************" );
+        TG_LOG( SG_GENERAL, SG_ALERT, "Start airport " << icao << " at " << pos << ": start time " << ctime(&log_time) );
 
-            // Start parse at pos
-            SetState(STATE_NONE);
-            in.clear();
+        in.seekg(pos, std::ios::beg);
+        while ( !in.eof() && (cur_state != STATE_DONE ) ) {
+            in.getline(line, 2048);
 
-            parse_start.stamp();
-            log_time = time(0);
-            TG_LOG( SG_GENERAL, SG_ALERT, "\n*******************************************************************" );
-            TG_LOG( SG_GENERAL, SG_ALERT, "Start airport " << icao << " at " << pos << ": start time " << ctime(&log_time) );
+            // Parse the line
+            ParseLine(line);
+        }
+
+        parse_end.stamp();
+        parse_time = parse_end - parse_start;
 
-            in.seekg(pos, std::ios::beg);
-            while ( !in.eof() && (cur_state != STATE_DONE ) ) {
-                in.getline(line, 2048);
+        // write the airport BTG
+        if (cur_airport) {
+            AirportProfile  airport_profile( icao );
+            SGTimeStamp     btg_start;
+            ProfilePhase    phase;
 
-                // Parse the line
-                ParseLine(line);
+            cur_airport->set_debug( debug_path, debug_runways, debug_pavements, debug_taxiways, debug_features );
+            if ( profile ) {
+                cur_airport->set_profile( &airport_profile );
             }
+            TG_LOG( SG_GENERAL, SG_ALERT, "Build Airport " << icao );
+
+            btg_start.stamp();
+            cur_airport->BuildBtg( work_dir, elevation );
+
+            if ( profile ) {
+                phase.task = "Airport";
+                phase.name = "Parse";
+                phase.wall = parse_time.toSecs();
+                airport_profile.AddPhase( phase );
 
-            parse_end.stamp();
-            parse_time = parse_end - parse_start;
+                phase.name = "BuildBtg";
+                phase.wall = ( SGTimeStamp::now() - btg_start ).toSecs();
+                airport_profile.AddPhase( phase );
 
-            // write the airport BTG
-            if (cur_airport) {
-                cur_airport->set_debug( debug_path, debug_runways, debug_pavements, debug_taxiways, debug_features );
-                TG_LOG( SG_GENERAL, SG_ALERT, "Build Airport " << icao );
+                profile->Record( airport_profile );
+            }
+
+            cur_airport->GetBuildTime( build_time );
+            cur_airport->GetCleanupTime( clean_time );
+            cur_airport->GetTriangulationTime( triangulation_time );
 
-                cur_airport->BuildBtg( work_dir, elevation );
+            if ( cache ) {
+                BuildCacheEntry entry;
 
-                cur_airport->GetBuildTime( build_time );
-                cur_airport->GetCleanupTime( clean_time );
-                cur_airport->GetTriangulationTime( triangulation_time );
+                entry.icao        = icao;
+                entry.record_hash = BuildCache::HashRecord( in, pos );
+                entry.build_key   = cache->GetBuildKey();
+                cur_airport->GetCacheEntry( entry );
 
-                delete cur_airport;
-                cur_airport = NULL;
+                cache->Record( entry );
             }
 
-            log_time = time(0);
-            TG_LOG( SG_GENERAL, SG_ALERT, "Finished airport " << icao << 
-                " : parse " << parse_time << " : build " << build_time << 
-                " : clean " << clean_time << " : tesselate " << triangulation_time );
-        } else {
-            TG_LOG( SG_GENERAL, SG_INFO, "Not an airport at pos " << pos << " line is: " << line );  
+            delete cur_airport;
+            cur_airport = NULL;
         }
+
+        ai.SetParseTime( parse_time );
+        ai.SetBuildTime( build_time );
+        ai.SetCleanTime( clean_time );
+        ai.SetTessTime( triangulation_time );
+
+        log_time = time(0);
+        TG_LOG( SG_GENERAL, SG_ALERT, "Finished airport " << icao << 
+            " : parse " << parse_time << " : build " << build_time << 
+            " : clean " << clean_time << " : tesselate " << triangulation_time );
+    } else {
+        TG_LOG( SG_GENERAL, SG_INFO, "Not an airport at pos " << pos << " line is: " << line );  
     }
 }
 
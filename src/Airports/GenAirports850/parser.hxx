@@ -84,6 +84,8 @@ public:
         cur_sign        = NULL;
         prev_node       = NULL;
         cur_state       = STATE_NONE;
+        cache           = NULL;
+        profile         = NULL;
     }
 
     // Debug
@@ -92,6 +94,15 @@ public:
                                                  std::vector<std::string> taxiway_defs,
                                                  std::vector<std::string> feature_defs );
 
+    // parse and build one airport from the open datafile - fills in the times in ai
+    void            BuildAirport( std::ifstream& in, AirportInfo& ai );
+
+    // record each built airport in the build cache manifest
+    void            set_cache( BuildCache* c )  { cache = c; }
+
+    // record the build phases of each airport in the profile report
+    void            set_profile( ProfileReport* p ) { profile = p; }
+
 private:
     virtual void    run();
 
@@ -112,6 +123,8 @@ private:
     std::string     filename;
     string_list     elevation;
     std::string     work_dir;
+    BuildCache*     cache;
+    ProfileReport*  profile;
 
     // a polygon conists of an array of contours 
     // (first is outside boundry, remaining are holes)
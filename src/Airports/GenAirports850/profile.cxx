@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include "profile.hxx"
+
+// parser threads append to the report as they finish airports
+static SGMutex report_lock;
+
+void AirportProfile::AddPhase( const ProfilePhase& phase )
+{
+    SGGuard<SGMutex> g( lock );
+
+    phases.push_back( phase );
+}
+
+long AirportProfile::GetRSS( void )
+{
+    long resident = 0;
+
+#ifndef _MSC_VER
+    long  size;
+    FILE* fp;
+
+    if ( (fp = fopen( "/proc/self/statm", "r" )) != NULL ) {
+        if ( fscanf( fp, "%ld %ld", &size, &resident ) != 2 ) {
+            resident = 0;
+        }
+        fclose( fp );
+    }
+    resident *= sysconf( _SC_PAGESIZE ) / 1024;
+#endif
+
+    return resident;
+}
+
+ProfileReport::ProfileReport( const std::string& file )
+{
+    report = file;
+}
+
+void ProfileReport::Start( void )
+{
+    SGPath sgp( report );
+    sgp.create_dir( 0755 );
+
+    std::ofstream out( report.c_str(), std::ios_base::out | std::ios_base::trunc );
+    if ( !out.is_open() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << report << " for writing!" );
+        exit(-1);
+    }
+
+    out << "icao,task,phase,wall_s,rss_kb,polys,verts,tris" << std::endl;
+}
+
+void ProfileReport::Record( const AirportProfile& profile )
+{
+    const std::vector<ProfilePhase>& phases = profile.GetPhases();
+    std::ostringstream os;
+
+    for ( unsigned int i = 0; i < phases.size(); i++ ) {
+        os << profile.GetIcao() << "," << phases[i].task << "," << phases[i].name << ","
+           << phases[i].wall << "," << phases[i].rss_kb << "," << phases[i].polys << ","
+           << phases[i].verts << "," << phases[i].tris << "\n";
+    }
+
+    std::string data = os.str();
+
+    SGGuard<SGMutex> g( report_lock );
+
+    FILE* fp;
+    if ( (fp = fopen( report.c_str(), "a" )) == NULL ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << report << " for writing!" );
+        exit(-1);
+    }
+
+    // one append per airport - worker processes ( --processes ) don't share
+    // report_lock
+    setvbuf( fp, NULL, _IOFBF, data.size() + 1 );
+    fwrite( data.c_str(), 1, data.size(), fp );
+    fclose( fp );
+}
+
+// what the summary keeps of each airport
+struct ProfileTotal
+{
+    ProfileTotal() : parse(0.0), build(0.0), slowest(0.0), tris(0) {}
+
+    std::string     icao;
+    double          parse;
+    double          build;
+    std::string     slowest_phase;
+    double          slowest;
+    unsigned int    tris;
+
+    double Total( void ) const { return parse + build; }
+
+    bool operator<( const ProfileTotal& other ) const {
+        return Total() > other.Total();
+    }
+};
+
+void ProfileReport::WriteSummary( unsigned int num )
+{
+    std::map<std::string, ProfileTotal> totals;
+    std::ifstream in( report.c_str() );
+    std::string   line;
+
+    if ( !in.is_open() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open profile report " << report );
+        return;
+    }
+
+    // skip the header
+    std::getline( in, line );
+
+    while ( std::getline( in, line ) ) {
+        std::istringstream fields( line );
+        std::string icao, task, name, value;
+        double      wall;
+        unsigned int tris;
+
+        std::getline( fields, icao, ',' );
+        std::getline( fields, task, ',' );
+        std::getline( fields, name, ',' );
+        std::getline( fields, value, ',' );
+        wall = atof( value.c_str() );
+        std::getline( fields, value, ',' );     // rss
+        std::getline( fields, value, ',' );     // polys
+        std::getline( fields, value, ',' );     // verts
+        std::getline( fields, value, ',' );
+        tris = atoi( value.c_str() );
+
+        ProfileTotal& t = totals[icao];
+        t.icao = icao;
+
+        if ( task == "Airport" ) {
+            // a retried airport is reported again - keep the last try
+            if ( name == "Parse" ) {
+                t.parse = wall;
+            } else if ( name == "BuildBtg" ) {
+                t.build = wall;
+            }
+        } else {
+            if ( wall > t.slowest ) {
+                t.slowest       = wall;
+                t.slowest_phase = task + "/" + name;
+            }
+            if ( tris > t.tris ) {
+                t.tris = tris;
+            }
+        }
+    }
+    in.close();
+
+    std::vector<ProfileTotal> sorted;
+    for ( std::map<std::string, ProfileTotal>::const_iterator it = totals.begin(); it != totals.end(); it++ ) {
+        sorted.push_back( it->second );
+    }
+    std::stable_sort( sorted.begin(), sorted.end() );
+    if ( sorted.size() > num ) {
+        sorted.resize( num );
+    }
+
+    SGPath sgp( report );
+    std::string summary = sgp.file_base() + "_slowest.csv";
+    if ( !sgp.dir().empty() ) {
+        summary = sgp.dir() + "/" + summary;
+    }
+
+    std::ofstream out( summary.c_str(), std::ios_base::out | std::ios_base::trunc );
+    if ( !out.is_open() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "ERROR: opening " << summary << " for writing!" );
+        return;
+    }
+
+    out << "rank,icao,total_s,parse_s,build_s,slowest_phase,slowest_phase_s,tris" << std::endl;
+    for ( unsigned int i = 0; i < sorted.size(); i++ ) {
+        out << i + 1 << "," << sorted[i].icao << "," << sorted[i].Total() << ","
+            << sorted[i].parse << "," << sorted[i].build << ","
+            << sorted[i].slowest_phase << "," << sorted[i].slowest << ","
+            << sorted[i].tris << std::endl;
+    }
+
+    SG_LOG( SG_GENERAL, SG_ALERT, "Profiled " << totals.size() << " airports - see " << report << " and " << summary );
+    for ( unsigned int i = 0; i < sorted.size() && i < 10; i++ ) {
+        SG_LOG( SG_GENERAL, SG_INFO, "  " << sorted[i].icao << " : " << sorted[i].Total() << " s, slowest phase " << sorted[i].slowest_phase << " " << sorted[i].slowest << " s" );
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef __PROFILE_HXX__
+#define __PROFILE_HXX__
+
+#include <string>
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/threads/SGThread.hxx>
+
+// one timed phase of an airport build
+struct ProfilePhase
+{
+    ProfilePhase() : wall(0.0), rss_kb(0), polys(0), verts(0), tris(0) {}
+
+    std::string     task;       // the BuildBtg task it ran in, or "Airport"
+    std::string     name;
+    double          wall;       // seconds
+    long            rss_kb;     // growth of the process resident set - shared
+                                // by the tasks running at the same time
+    unsigned int    polys;      // sizes of the data the task works on,
+    unsigned int    verts;      // after the phase
+    unsigned int    tris;
+};
+
+// the phases of one airport - the BuildBtg tasks add to it concurrently
+class AirportProfile
+{
+public:
+    AirportProfile( const std::string& id ) : icao( id ) {}
+
+    void AddPhase( const ProfilePhase& phase );
+
+    const std::string& GetIcao( void ) const { return icao; }
+    const std::vector<ProfilePhase>& GetPhases( void ) const { return phases; }
+
+    // resident set size of this process in KB - 0 if unknown
+    static long GetRSS( void );
+
+private:
+    std::string                 icao;
+    std::vector<ProfilePhase>   phases;
+    SGMutex                     lock;
+};
+
+// The per phase report ( --profile ).  Each airport appends its phases to a
+// CSV file as it finishes, and at the end of the run the slowest airports
+// are summarized in a second file next to it.
+class ProfileReport
+{
+public:
+    ProfileReport( const std::string& file );
+
+    // truncate the report, and write the header
+    void Start( void );
+
+    // append the phases of a finished airport - safe to call from the
+    // parser threads and worker processes
+    void Record( const AirportProfile& profile );
+
+    // read the report back, and write the num slowest airports
+    void WriteSummary( unsigned int num );
+
+private:
+    std::string report;
+};
+
+#endif
@@ -4,6 +4,11 @@
 #endif
 
 #include <cstring>
+#include <sstream>
+
+#ifndef _MSC_VER
+#  include <unistd.h>
+#endif
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/misc/sgstream.hxx>
@@ -12,6 +17,10 @@
 #include "parser.hxx"
 #include "scheduler.hxx"
 
+#ifndef _MSC_VER
+#  include "worker_pool.hxx"
+#endif
+
 extern double gSnap;
 
 SGLockedQueue<AirportInfo> global_workQueue;
@@ -480,6 +489,13 @@ Scheduler::Scheduler(std::string& datafile, const std::string& root, const strin
     work_dir        = root;
     elevation       = elev_src;
 
+    num_processes   = 0;
+    worker_max_time = P_WORKER_MAX_TIME;
+    worker_max_rss  = 0;
+
+    cache           = NULL;
+    profile         = NULL;
+
     std::ifstream in( filename.c_str() );
     if ( !in.is_open() )
     {
@@ -496,21 +512,267 @@ void Scheduler::Schedule( int num_threads, std::string& summaryfile )
 //    csvfile.open( summaryfile.c_str(), std::ios_base::out | std::ios_base::trunc );
 //    csvfile.close();
 
-    std::vector<Parser *> parsers;
-    for (int i=0; i<num_threads; i++) {
-        Parser* parser = new Parser( filename, debug_path, work_dir, elevation );
-        // parser->set_debug();
-        parser->start();
-        parsers.push_back( parser );
+    if ( cache ) {
+        SkipUnchangedAirports();
+    }
+
+    if ( profile ) {
+        profile->Start();
     }
 
-    while (!global_workQueue.empty()) {
-        sleep(1);
+    if ( num_processes > 0 ) {
+        ScheduleProcesses( summaryfile );
+    } else {
+        std::vector<Parser *> parsers;
+        for (int i=0; i<num_threads; i++) {
+            Parser* parser = new Parser( filename, debug_path, work_dir, elevation );
+            parser->set_cache( cache );
+            parser->set_profile( profile );
+            // parser->set_debug();
+            parser->start();
+            parsers.push_back( parser );
+        }
+
+        while (!global_workQueue.empty()) {
+            sleep(1);
+        }
+
+        // Then wait until they are finished
+        for (unsigned int i=0; i<parsers.size(); i++) {
+            parsers[i]->join();
+            delete parsers[i];
+        }
     }
 
-    // Then wait until they are finished
-    for (unsigned int i=0; i<parsers.size(); i++) {
-        parsers[i]->join();
-        delete parsers[i];
+    if ( profile ) {
+        profile->WriteSummary( PROFILE_NUM_SLOWEST );
     }
 }
+
+void Scheduler::set_processes( int num, int max_time, int max_rss, const string_list& command )
+{
+    num_processes   = num;
+    worker_max_time = max_time;
+    worker_max_rss  = max_rss;
+    worker_command  = command;
+}
+
+void Scheduler::set_incremental( const std::string& build_key )
+{
+    // keep the manifest with the outputs, so clearing them clears it too
+    cache = new BuildCache( work_dir + "/AirportObj/genapts850.manifest", build_key );
+}
+
+void Scheduler::set_profile( const std::string& report )
+{
+    profile = new ProfileReport( report );
+}
+
+void Scheduler::GetAirportIcaos( std::set<std::string>& icaos )
+{
+    std::string line;
+
+    std::ifstream in( filename.c_str() );
+    if ( !in.is_open() )
+    {
+        TG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << filename );
+        exit(-1);
+    }
+
+    while ( std::getline( in, line ) )
+    {
+        int code = atoi( line.c_str() );
+
+        if ( code == END_OF_FILE )
+        {
+            break;
+        }
+        else if ( code == LAND_AIRPORT_CODE || code == SEA_AIRPORT_CODE || code == HELIPORT_CODE )
+        {
+            // the definition after the code, as AddAirports() passes it
+            std::vector<char> def( line.begin(), line.end() );
+            def.resize( line.size() + 2, '\0' );
+
+            char* tok = strtok( &def[0], " \t\r\n" );
+
+            Airport ap( code, tok + strlen( tok ) + 1 );
+            icaos.insert( ap.GetIcao() );
+        }
+    }
+}
+
+void Scheduler::SkipUnchangedAirports( void )
+{
+    std::vector<AirportInfo> airports, rebuild;
+    std::set<std::string>    icaos;
+    unsigned int             num_skipped = 0;
+
+    std::ifstream in( filename.c_str() );
+    if ( !in.is_open() )
+    {
+        TG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << filename );
+        exit(-1);
+    }
+
+    bool loaded = cache->Load();
+
+    // this also removes the old outputs of the changed airports, and of
+    // those no longer in apt.dat, before any worker appends to the index files
+    while ( !global_workQueue.empty() ) {
+        AirportInfo ai = global_workQueue.pop();
+
+        airports.push_back( ai );
+        if ( loaded && cache->IsUpToDate( in, ai.GetIcao(), ai.GetPos() ) ) {
+            TG_LOG( SG_GENERAL, SG_DEBUG, "Airport " << ai.GetIcao() << " is unchanged - skipping" );
+            num_skipped++;
+        } else {
+            rebuild.push_back( ai );
+        }
+    }
+
+    if ( loaded ) {
+        GetAirportIcaos( icaos );
+        cache->RemoveMissing( icaos );
+    }
+
+    // the rebuilt airports are appended again as they finish
+    if ( !loaded || cache->HasFailed() || !cache->Save() ) {
+        cache->Drop();
+
+        rebuild     = airports;
+        num_skipped = 0;
+    }
+
+    for ( unsigned int i = 0; i < rebuild.size(); i++ ) {
+        global_workQueue.push( rebuild[i] );
+    }
+
+    TG_LOG( SG_GENERAL, SG_ALERT, "Build cache : " << num_skipped << " unchanged airports skipped, " << rebuild.size() << " to build" );
+}
+
+#ifndef _MSC_VER
+
+// builds the airports sent to a worker process with one Parser
+class ParserBuilder : public WorkerBuilder
+{
+public:
+    ParserBuilder( Parser& p, const std::string& filename ) : parser( p ), in( filename.c_str() )
+    {
+        if ( !in.is_open() )
+        {
+            TG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << filename );
+            _exit(-1);
+        }
+    }
+
+    virtual void Build( const WorkerJob& job, WorkerResult& result )
+    {
+        AirportInfo ai( job.icao, job.pos, job.snap );
+
+        parser.BuildAirport( in, ai );
+
+        result.parse_time = ai.GetParseTime().toSecs();
+        result.build_time = ai.GetBuildTime().toSecs();
+        result.clean_time = ai.GetCleanTime().toSecs();
+        result.tess_time  = ai.GetTessTime().toSecs();
+    }
+
+private:
+    Parser&         parser;
+    std::ifstream   in;
+};
+
+// writes a summary line for each airport as its worker reports back
+class SummaryPool : public WorkerPool
+{
+public:
+    SummaryPool( const string_list& command, int num, int max_time, int max_rss, std::ofstream& csv ) :
+        WorkerPool( command, num, max_time, max_rss ), csvfile( csv ), num_failed( 0 )
+    {
+    }
+
+    unsigned int GetNumFailed( void ) const { return num_failed; }
+
+protected:
+    virtual void JobDone( const WorkerJob& job, const WorkerResult& result, const std::string& failure )
+    {
+        AirportInfo ai( job.icao, job.pos, job.snap );
+
+        ai.SetParseTime( SGTimeStamp::fromSec( result.parse_time ) );
+        ai.SetBuildTime( SGTimeStamp::fromSec( result.build_time ) );
+        ai.SetCleanTime( SGTimeStamp::fromSec( result.clean_time ) );
+        ai.SetTessTime( SGTimeStamp::fromSec( result.tess_time ) );
+
+        if ( !failure.empty() ) {
+            TG_LOG( SG_GENERAL, SG_ALERT, "FAILED airport " << ai.GetIcao() << " : worker " << failure );
+            ai.SetErrorString( failure );
+            num_failed++;
+        }
+
+        csvfile << ai << std::endl;
+    }
+
+private:
+    std::ofstream&  csvfile;
+    unsigned int    num_failed;
+};
+
+void Scheduler::RunWorker( int job_fd, int result_fd )
+{
+    Parser parser( filename, debug_path, work_dir, elevation );
+    parser.set_cache( cache );
+    parser.set_profile( profile );
+
+    ParserBuilder builder( parser, filename );
+    ::RunWorker( job_fd, result_fd, builder );
+}
+
+void Scheduler::ScheduleProcesses( std::string& summaryfile )
+{
+    std::ofstream           csvfile;
+    std::deque<WorkerJob>   jobs;
+
+    csvfile.open( summaryfile.c_str(), std::ios_base::out | std::ios_base::trunc );
+
+    while ( !global_workQueue.empty() ) {
+        AirportInfo ai = global_workQueue.pop();
+        WorkerJob   job;
+
+        memset( &job, 0, sizeof(job) );
+        strncpy( job.icao, ai.GetIcao().c_str(), sizeof(job.icao)-1 );
+        job.pos  = ai.GetPos();
+        job.snap = ai.GetSnap();
+
+        jobs.push_back( job );
+    }
+
+    SummaryPool pool( worker_command, num_processes, worker_max_time, worker_max_rss, csvfile );
+    if ( !pool.Run( jobs ) ) {
+        TG_LOG( SG_GENERAL, SG_ALERT, "Cannot start worker process" );
+        exit(-1);
+    }
+
+    csvfile.close();
+
+    TG_LOG( SG_GENERAL, SG_ALERT, "Worker processes finished : " << pool.GetNumFailed() << " airports failed - see " << summaryfile );
+}
+
+#else
+
+void Scheduler::ScheduleProcesses( std::string& summaryfile )
+{
+    TG_LOG( SG_GENERAL, SG_ALERT, "Worker processes are not supported on this platform - using threads" );
+
+    int num_threads = num_processes;
+
+    num_processes = 0;
+    Schedule( num_threads, summaryfile );
+}
+
+void Scheduler::RunWorker( int job_fd, int result_fd )
+{
+    TG_LOG( SG_GENERAL, SG_ALERT, "Worker processes are not supported on this platform" );
+    exit(-1);
+}
+
+#endif
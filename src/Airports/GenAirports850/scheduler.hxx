@@ -12,6 +12,8 @@
 #include <simgear/threads/SGQueue.hxx>
 #include <terragear/tg_rectangle.hxx>
 #include "airport.hxx"
+#include "build_cache.hxx"
+#include "profile.hxx"
 
 #define P_STATE_INIT        (0)
 #define P_STATE_PARSE       (1)
@@ -27,6 +29,10 @@
 #define P_STATE_TRIANGULATE_TIME    ( 1*60)
 #define P_STATE_OUTPUT_TIME         (10*60)
 
+// default wall clock limit for one airport in a worker process
+#define P_WORKER_MAX_TIME           ( P_STATE_INIT_TIME + P_STATE_PARSE_TIME + P_STATE_BUILD_TIME + \
+                                      P_STATE_TRIANGULATE_TIME + P_STATE_OUTPUT_TIME )
+
 #define GENAPT_PORT                 (12397)
 #define PL_STATE_INIT               (0)
 #define PL_STATE_WAIT_FOR_LAUNCH    (1)
@@ -34,6 +40,9 @@
 #define PL_STATE_ALL_LAUNCHED       (3)
 #define PL_STATE_DONE               (10)
 
+// airports listed in the profile summary
+#define PROFILE_NUM_SLOWEST         (50)
+
 // Forward declaration
 class Scheduler;
 
@@ -68,7 +77,12 @@ public:
     void    SetBuildTime( SGTimeStamp t )           { buildTime = t; }
     void    SetCleanTime( SGTimeStamp t )           { cleanTime = t; }
     void    SetTessTime( SGTimeStamp t )            { tessTime = t; }
-    void    SetErrorString( char* e )               { errString = e; }
+    void    SetErrorString( const std::string& e )  { errString = e; }
+
+    SGTimeStamp GetParseTime( void )                { return parseTime; }
+    SGTimeStamp GetBuildTime( void )                { return buildTime; }
+    SGTimeStamp GetCleanTime( void )                { return cleanTime; }
+    SGTimeStamp GetTessTime( void )                 { return tessTime; }
 
     void    IncreaseSnap( void )                    { snap *= 2.0f; }
 
@@ -106,6 +120,24 @@ public:
 
     void            Schedule( int num_threads, std::string& summaryfile );
 
+    // build in worker processes instead of threads, so a crashing or
+    // hanging airport build doesn't take down the whole run.  The workers
+    // run command, our own command line - see WorkerPool.
+    // max_time is in seconds, max_rss in MB - 0 for no limit
+    void            set_processes( int num_processes, int max_time, int max_rss, const string_list& command );
+
+    // the worker process side of set_processes() : build the airports the
+    // parent sends over job_fd.  Doesn't return.
+    void            RunWorker( int job_fd, int result_fd );
+
+    // skip airports unchanged since the last build with the same build_key
+    // ( tool version and options ) - see BuildCache
+    void            set_incremental( const std::string& build_key );
+
+    // write the time and size of each build phase of each airport to
+    // report, and a summary of the slowest airports at the end
+    void            set_profile( const std::string& report );
+
     // Debug
     void            set_debug( std::string path, std::vector<std::string> runway_defs,
                                                  std::vector<std::string> pavement_defs,
@@ -114,11 +146,26 @@ public:
 
 private:
     bool            IsAirportDefinition( char* line, std::string icao );
+    void            ScheduleProcesses( std::string& summaryfile );
+    void            SkipUnchangedAirports( void );
+    void            GetAirportIcaos( std::set<std::string>& icaos );
 
     std::string     filename;
     string_list     elevation;
     std::string     work_dir;
 
+    // worker processes
+    int             num_processes;
+    int             worker_max_time;
+    int             worker_max_rss;
+    string_list     worker_command;
+
+    // incremental builds
+    BuildCache*     cache;
+
+    // profiling
+    ProfileReport*  profile;
+
     // debug
     std::string     debug_path;
     debug_map       debug_runways;
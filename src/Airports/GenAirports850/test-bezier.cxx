@@ -0,0 +1,286 @@
+// test-bezier.cxx - CalculateBezierNodes must keep the flattened curve
+// within --bezier-max-dev meters of the true curve.  Random and awkward
+// ( cusps, loops, coincident control points ) quadratic and cubic curves
+// are flattened for a few tolerances; the true curve is sampled densely and
+// its distance to the polyline measured.  The error and node count of the
+// fixed subdivision closedpoly used before are printed alongside.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <iostream>
+#include <vector>
+
+#include "beznode.hxx"
+
+using std::cout;
+using std::endl;
+
+// samples of the true curve per flattened curve
+static const unsigned int num_samples = 4000;
+
+struct Curve
+{
+    int    type;
+    SGGeod p0, cp0, cp1, p1;
+};
+
+// meters east and north of origin, with the WGS84 radii of curvature -
+// independent of the spherical frame CalculateBezierNodes works in
+struct Frame
+{
+    Frame( const SGGeod& origin )
+    {
+        double a  = SG_EQUATORIAL_RADIUS_M;
+        double e2 = 0.00669437999014;
+        double s  = sin( origin.getLatitudeRad() );
+        double w  = sqrt( 1.0 - e2 * s * s );
+
+        lon0 = origin.getLongitudeDeg();
+        lat0 = origin.getLatitudeDeg();
+        m_per_deg_lat = SGD_DEGREES_TO_RADIANS * a * ( 1.0 - e2 ) / ( w * w * w );
+        m_per_deg_lon = SGD_DEGREES_TO_RADIANS * a / w * cos( origin.getLatitudeRad() );
+    }
+
+    SGVec2d operator()( const SGGeod& p ) const
+    {
+        return SGVec2d( ( p.getLongitudeDeg() - lon0 ) * m_per_deg_lon,
+                        ( p.getLatitudeDeg()  - lat0 ) * m_per_deg_lat );
+    }
+
+    double lon0, lat0;
+    double m_per_deg_lon, m_per_deg_lat;
+};
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static SGGeod Offset( const SGGeod& p, double east, double north )
+{
+    double m_per_deg_lat = SGD_DEGREES_TO_RADIANS * SG_EQUATORIAL_RADIUS_M;
+    double m_per_deg_lon = m_per_deg_lat * cos( p.getLatitudeRad() );
+
+    return SGGeod::fromDeg( p.getLongitudeDeg() + east / m_per_deg_lon, p.getLatitudeDeg() + north / m_per_deg_lat );
+}
+
+static SGGeod Location( const Curve& c, double t )
+{
+    if ( c.type == CURVE_QUADRATIC ) {
+        return CalculateQuadraticLocation( c.p0, c.cp0, c.p1, t );
+    } else {
+        return CalculateCubicLocation( c.p0, c.cp0, c.cp1, c.p1, t );
+    }
+}
+
+static double SegmentDistance( const SGVec2d& p, const SGVec2d& a, const SGVec2d& b )
+{
+    SGVec2d ab  = b - a;
+    double  len = ab.x() * ab.x() + ab.y() * ab.y();
+    double  t   = 0.0;
+
+    if ( len > 0.0 ) {
+        t = SGMiscd::clip( ( ( p.x() - a.x() ) * ab.x() + ( p.y() - a.y() ) * ab.y() ) / len, 0.0, 1.0 );
+    }
+
+    return norm( p - ( a + ab * t ) );
+}
+
+// largest distance from the sampled true curve to the polyline nodes + p1
+static double MaxDeviation( const Curve& c, const std::vector<SGGeod>& nodes )
+{
+    Frame                frame( c.p0 );
+    std::vector<SGVec2d> line;
+
+    for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+        line.push_back( frame( nodes[i] ) );
+    }
+    line.push_back( frame( c.p1 ) );
+
+    double max_dev = 0.0;
+    for ( unsigned int s = 0; s <= num_samples; s++ ) {
+        SGVec2d p   = frame( Location( c, (double)s / num_samples ) );
+        double  dev = DBL_MAX;
+
+        for ( unsigned int i = 0; i + 1 < line.size(); i++ ) {
+            double d = SegmentDistance( p, line[i], line[i+1] );
+            if ( d < dev ) {
+                dev = d;
+            }
+        }
+        if ( dev > max_dev ) {
+            max_dev = dev;
+        }
+    }
+
+    return max_dev;
+}
+
+static double LongestSegment( const Curve& c, const std::vector<SGGeod>& nodes )
+{
+    Frame  frame( c.p0 );
+    double longest = 0.0;
+
+    for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+        SGGeod next = ( i + 1 < nodes.size() ) ? nodes[i+1] : c.p1;
+        double len  = norm( frame( next ) - frame( nodes[i] ) );
+
+        if ( len > longest ) {
+            longest = len;
+        }
+    }
+
+    return longest;
+}
+
+// the nodes closedpoly made for a curve before : 8 segments, fewer on short
+// curves and one per 100 m on long ones, by the length of the control polygon
+static void RefBezierNodes( const Curve& c, std::vector<SGGeod>& nodes )
+{
+    Frame  frame( c.p0 );
+    double total_dist = norm( frame( c.cp0 ) - frame( c.p0 ) );
+    int    num_segs   = 8;
+
+    if ( c.type == CURVE_QUADRATIC ) {
+        total_dist += norm( frame( c.p1 ) - frame( c.cp0 ) );
+    } else {
+        total_dist += norm( frame( c.cp1 ) - frame( c.cp0 ) ) + norm( frame( c.p1 ) - frame( c.cp1 ) );
+    }
+
+    if ( total_dist < 8.0f ) {
+        num_segs = ( (int)total_dist + 1 );
+    } else if ( total_dist > 800.0f ) {
+        num_segs = total_dist / 100.0f + 1;
+    }
+
+    nodes.clear();
+    for ( int p = 0; p < num_segs; p++ ) {
+        nodes.push_back( Location( c, (1.0f/num_segs) * p ) );
+    }
+}
+
+// a curve of about size meters from an origin anywhere between 70S and 70N
+static Curve RandomCurve( double size )
+{
+    Curve c;
+
+    c.type = ( rand() % 2 ) ? CURVE_QUADRATIC : CURVE_CUBIC;
+    c.p0   = SGGeod::fromDeg( 360.0 * Random() - 180.0, 140.0 * Random() - 70.0 );
+    c.cp0  = Offset( c.p0, size * ( Random() - 0.5 ), size * ( Random() - 0.5 ) );
+    c.cp1  = Offset( c.p0, size * ( Random() - 0.5 ), size * ( Random() - 0.5 ) );
+    c.p1   = Offset( c.p0, size * ( Random() - 0.5 ), size * ( Random() - 0.5 ) );
+
+    return c;
+}
+
+static Curve MakeCurve( int type, const SGGeod& origin, double x0, double y0, double x1, double y1, double x2, double y2, double x3, double y3 )
+{
+    Curve c;
+
+    c.type = type;
+    c.p0   = Offset( origin, x0, y0 );
+    c.cp0  = Offset( origin, x1, y1 );
+    c.cp1  = Offset( origin, x2, y2 );
+    c.p1   = Offset( origin, x3, y3 );
+
+    return c;
+}
+
+// curves that trip up chord based flatness tests
+static std::vector<Curve> AwkwardCurves( void )
+{
+    std::vector<Curve> curves;
+    SGGeod             ksfo = SGGeod::fromDeg( -122.375, 37.619 );
+    SGGeod             enas = SGGeod::fromDeg( 11.915, 78.928 );
+
+    // a cusp, and a loop where the control points cross
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 60, 40, -20, 40, 40, 0 ) );
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 120, 80, -80, 80, 40, 0 ) );
+    // the end points coincide : a closed teardrop, and a curve doubling back
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 50, 50, -50, 50, 0, 0 ) );
+    curves.push_back( MakeCurve( CURVE_QUADRATIC, ksfo, 0, 0, 80, 0, 0, 0, 0, 0 ) );
+    // control points on the end points, or on the chord beyond them
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 0, 0, 300, 0, 300, 0 ) );
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 400, 0, -100, 0, 300, 0 ) );
+    curves.push_back( MakeCurve( CURVE_QUADRATIC, ksfo, 0, 0, -50, 0, 0, 0, 100, 0 ) );
+    // every point the same, and a curve shorter than a millimeter
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 0, 0, 0, 0, 0, 0 ) );
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 0.0005, 0.0002, 0.0001, 0.0006, 0.0003, 0 ) );
+    // a gentle 2 km curve, a tight taxiway fillet, and an S curve
+    curves.push_back( MakeCurve( CURVE_QUADRATIC, ksfo, 0, 0, 1000, 150, 0, 0, 2000, 0 ) );
+    curves.push_back( MakeCurve( CURVE_QUADRATIC, ksfo, 0, 0, 15, 0, 0, 0, 15, 15 ) );
+    curves.push_back( MakeCurve( CURVE_CUBIC, ksfo, 0, 0, 200, 100, 100, -100, 300, 0 ) );
+    // the same S curve near the pole, where a degree of longitude is short
+    curves.push_back( MakeCurve( CURVE_CUBIC, enas, 0, 0, 200, 100, 100, -100, 300, 0 ) );
+
+    return curves;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 17 );
+
+    std::vector<Curve> curves = AwkwardCurves();
+    double sizes[] = { 5.0, 50.0, 400.0, 1500.0 };
+    for ( unsigned int i = 0; i < 400; i++ ) {
+        curves.push_back( RandomCurve( sizes[i % 4] ) );
+    }
+
+    // the projection frames differ by the ellipsoid's curvature : 0.7% at most
+    double tolerances[] = { 0.05, 0.25, 1.0 };
+    for ( unsigned int t = 0; t < 3; t++ ) {
+        double       max_dev = tolerances[t];
+        double       worst = 0.0, ref_worst = 0.0;
+        unsigned int num_nodes = 0, ref_num_nodes = 0;
+
+        for ( unsigned int i = 0; i < curves.size(); i++ ) {
+            Curve const&        c = curves[i];
+            std::vector<SGGeod> nodes, ref_nodes;
+
+            CalculateBezierNodes( c.type, c.p0, c.cp0, c.cp1, c.p1, max_dev, nodes );
+            RefBezierNodes( c, ref_nodes );
+
+            double dev = MaxDeviation( c, nodes );
+            if ( dev > 1.007 * max_dev ) {
+                cout << "  curve " << i << " : " << dev << " m from the true curve, max_dev is " << max_dev << endl;
+                failed++;
+            }
+            if ( nodes.empty() || nodes[0].getLongitudeDeg() != c.p0.getLongitudeDeg() || nodes[0].getLatitudeDeg() != c.p0.getLatitudeDeg() ) {
+                cout << "  curve " << i << " : doesn't start at p0" << endl;
+                failed++;
+            }
+            if ( LongestSegment( c, nodes ) > 1.007 * BEZIER_MAX_SEGMENT ) {
+                cout << "  curve " << i << " : a segment is " << LongestSegment( c, nodes ) << " m long" << endl;
+                failed++;
+            }
+
+            if ( dev > worst ) {
+                worst = dev;
+            }
+            double ref_dev = MaxDeviation( c, ref_nodes );
+            if ( ref_dev > ref_worst ) {
+                ref_worst = ref_dev;
+            }
+            num_nodes     += nodes.size();
+            ref_num_nodes += ref_nodes.size();
+        }
+
+        cout << "max_dev " << max_dev << " : " << curves.size() << " curves, " << num_nodes << " nodes, worst " << worst
+             << " m - fixed subdivision : " << ref_num_nodes << " nodes, worst " << ref_worst << " m" << endl;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+// test-genapts.hxx - helpers for the test programs that run genapts850 and
+// compare the files it writes
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#ifndef __TEST_GENAPTS_HXX__
+#define __TEST_GENAPTS_HXX__
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// path below the work directory -> contents
+typedef std::map<std::string, std::string> FileMap;
+
+// the btg header is the magic number, then the time the file was written
+static const unsigned int btg_time_offset = 4;
+static const unsigned int btg_time_size   = 4;
+
+inline bool EndsWith( const std::string& s, const std::string& end )
+{
+    return s.size() >= end.size() && s.compare( s.size() - end.size(), end.size(), end ) == 0;
+}
+
+// the contents of a file, uncompressed if it is gzipped
+inline std::string ReadFile( const std::string& path, bool raw )
+{
+    std::string data;
+    char        buf[65536];
+    int         n;
+
+    if ( raw ) {
+        FILE* fp = fopen( path.c_str(), "rb" );
+        while ( fp && (n = fread( buf, 1, sizeof(buf), fp )) > 0 ) {
+            data.append( buf, n );
+        }
+        if ( fp ) {
+            fclose( fp );
+        }
+    } else {
+        gzFile fp = gzopen( path.c_str(), "rb" );
+        while ( fp && (n = gzread( fp, buf, sizeof(buf) )) > 0 ) {
+            data.append( buf, n );
+        }
+        if ( fp ) {
+            gzclose( fp );
+        }
+    }
+
+    return data;
+}
+
+// Every file below root + dir, except the build cache manifest.  Unless raw,
+// btg files are uncompressed with their creation time zeroed, and the lines
+// of index files sorted - parser threads append them as they finish.
+inline void ReadTree( const std::string& root, const std::string& dir, FileMap& files, bool raw = false )
+{
+    DIR* d = opendir( ( root + dir ).c_str() );
+    if ( !d ) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ( (entry = readdir( d )) != NULL ) {
+        std::string name = entry->d_name;
+        std::string path = dir + "/" + name;
+        struct stat st;
+
+        if ( name == "." || name == ".." || name.find( "genapts850.manifest" ) == 0 ||
+             stat( ( root + path ).c_str(), &st ) != 0 ) {
+            continue;
+        }
+        if ( S_ISDIR( st.st_mode ) ) {
+            ReadTree( root, path, files, raw );
+            continue;
+        }
+
+        std::string data = ReadFile( root + path, raw );
+
+        if ( !raw && EndsWith( name, ".btg.gz" ) && data.size() >= btg_time_offset + btg_time_size ) {
+            data.replace( btg_time_offset, btg_time_size, btg_time_size, '\0' );
+        } else if ( !raw && EndsWith( name, ".ind" ) ) {
+            std::istringstream       in( data );
+            std::vector<std::string> lines;
+            std::string              line;
+
+            while ( std::getline( in, line ) ) {
+                lines.push_back( line );
+            }
+            std::sort( lines.begin(), lines.end() );
+
+            data.clear();
+            for ( unsigned int i = 0; i < lines.size(); i++ ) {
+                data += lines[i] + "\n";
+            }
+        }
+        files[path] = data;
+    }
+
+    closedir( d );
+}
+
+// run genapts850 on apt_dat, with its output in work.log
+inline bool RunGenapts( const std::string& genapts, const std::string& apt_dat, const std::string& work, const std::string& options )
+{
+    std::ostringstream cmd;
+
+    cmd << genapts << " --input=" << apt_dat << " --work=" << work << " " << options << " > " << work << ".log 2>&1";
+    if ( system( cmd.str().c_str() ) != 0 ) {
+        std::cout << "  " << cmd.str() << " failed" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// the files of ref and files that differ, or are only in one of them
+inline std::vector<std::string> DiffTrees( const FileMap& ref, const FileMap& files )
+{
+    std::vector<std::string> diffs;
+
+    FileMap::const_iterator it;
+    for ( it = ref.begin(); it != ref.end(); it++ ) {
+        FileMap::const_iterator other = files.find( it->first );
+
+        if ( other == files.end() ) {
+            diffs.push_back( it->first + " is missing" );
+        } else if ( other->second != it->second ) {
+            diffs.push_back( it->first + " differs" );
+        }
+    }
+    for ( it = files.begin(); it != files.end(); it++ ) {
+        if ( ref.find( it->first ) == ref.end() ) {
+            diffs.push_back( it->first + " is extra" );
+        }
+    }
+
+    return diffs;
+}
+
+#endif
@@ -0,0 +1,211 @@
+// test-incremental.cxx - genapts850 --incremental rebuilds only what changed.
+// test-apt.dat is built, then built again as is, with the windsock of TST2
+// moved, and with TST3 taken out.  Each time only the edited airport's btg
+// files may be rewritten, and the work directory must hold what a fresh
+// build of the same apt.dat writes.  Then the manifest is made unwritable,
+// and unreadable : genapts850 must drop it and build every airport again.
+//
+// usage: test_incremental [ genapts850 [ apt.dat ] ]
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "test-genapts.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static const char* airports[] = { "TST1", "TST2", "TST3" };
+static const unsigned int num_airports = 3;
+
+static const string manifest = "/AirportObj/genapts850.manifest";
+
+static string ReadText( const string& path )
+{
+    std::ifstream      in( path.c_str() );
+    std::ostringstream text;
+
+    text << in.rdbuf();
+
+    return text.str();
+}
+
+static void WriteText( const string& path, const string& text )
+{
+    std::ofstream out( path.c_str() );
+
+    out << text;
+}
+
+// apt.dat without the record of icao
+static string RemoveAirport( const string& apt_dat, const string& icao )
+{
+    std::istringstream in( apt_dat );
+    string             line, out;
+    bool               skip = false;
+
+    while ( std::getline( in, line ) ) {
+        std::istringstream fields( line );
+        string             code, elev, twr, bldg, id;
+
+        fields >> code >> elev >> twr >> bldg >> id;
+        if ( code == "1" || code == "16" || code == "17" || code == "99" ) {
+            skip = ( id == icao );
+        }
+        if ( !skip ) {
+            out += line + "\n";
+        }
+    }
+
+    return out;
+}
+
+static string Replace( const string& text, const string& from, const string& to )
+{
+    string out = text;
+
+    out.replace( out.find( from ), from.size(), to );
+
+    return out;
+}
+
+// the airport a btg file belongs to - empty for index files
+static string BtgAirport( const string& path )
+{
+    string name = path.substr( path.rfind( '/' ) + 1 );
+
+    if ( !EndsWith( name, ".btg.gz" ) ) {
+        return "";
+    }
+    return name.substr( 0, name.find_first_of( "._" ) );
+}
+
+class IncrementalTest
+{
+public:
+    IncrementalTest( const string& g, const string& r ) : genapts( g ), root( r ), failed( 0 ), run( 0 ) {}
+
+    // run genapts850 --incremental on text in work, and check that only
+    // the btg files of the airports in rebuilt were rewritten, and that the
+    // outputs match a fresh build
+    void Check( const string& what, const string& text, const std::set<string>& rebuilt, bool exact_index = true )
+    {
+        std::ostringstream dat, fresh;
+        dat   << root << "/apt_" << run << ".dat";
+        fresh << root << "/fresh_" << run;
+        run++;
+
+        WriteText( dat.str(), text );
+
+        FileMap before;
+        ReadTree( root + "/work", "/AirportObj", before, true );
+
+        // a rewritten btg gets a new creation time
+        sleep( 1 );
+        if ( !RunGenapts( genapts, dat.str(), root + "/work", "--incremental" ) ||
+             !RunGenapts( genapts, dat.str(), fresh.str(), "" ) ) {
+            failed++;
+            return;
+        }
+
+        FileMap after, expected, raw;
+        ReadTree( root + "/work", "/AirportObj", after );
+        ReadTree( fresh.str(), "/AirportObj", expected );
+        ReadTree( root + "/work", "/AirportObj", raw, true );
+
+        std::vector<string> diffs = DiffTrees( expected, after );
+        for ( unsigned int i = 0; i < diffs.size(); i++ ) {
+            // an unreadable manifest can't say which index records to take out
+            if ( !exact_index && EndsWith( diffs[i], ".ind differs" ) ) {
+                continue;
+            }
+            cout << "  " << what << " : " << diffs[i] << endl;
+            failed++;
+        }
+
+        std::set<string> rewritten;
+        for ( FileMap::const_iterator it = raw.begin(); it != raw.end(); it++ ) {
+            FileMap::const_iterator old = before.find( it->first );
+            string                  icao = BtgAirport( it->first );
+
+            if ( !icao.empty() && ( old == before.end() || old->second != it->second ) ) {
+                rewritten.insert( icao );
+            }
+        }
+        for ( unsigned int i = 0; i < num_airports; i++ ) {
+            bool was = ( rewritten.find( airports[i] ) != rewritten.end() );
+            bool due = ( rebuilt.find( airports[i] ) != rebuilt.end() );
+
+            if ( was != due ) {
+                cout << "  " << what << " : " << airports[i] << ( was ? " was" : " wasn't" ) << " rebuilt" << endl;
+                failed++;
+            }
+        }
+    }
+
+    string       genapts;
+    string       root;
+    unsigned int failed;
+    unsigned int run;
+};
+
+int main( int argc, char **argv )
+{
+    string self    = argv[0];
+    string genapts = ( argc > 1 ) ? argv[1] : self.substr( 0, self.rfind( '/' ) + 1 ) + "genapts850";
+    string apt_dat = ( argc > 2 ) ? argv[2] : TEST_APT_DAT;
+    char   root_template[] = "/tmp/tg-incremental-XXXXXX";
+
+    if ( !mkdtemp( root_template ) ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+
+    IncrementalTest  test( genapts, root_template );
+    std::set<string> all( airports, airports + num_airports ), none;
+    string           text = ReadText( apt_dat );
+
+    if ( text.empty() ) {
+        cout << "can't read " << apt_dat << endl;
+        return 1;
+    }
+
+    test.Check( "first build", text, all );
+    test.Check( "unchanged", text, none );
+
+    // the windsock is in the index too - its old record must go
+    text = Replace( text, "19 37.05050000 -121.94980000 1 WS", "19 37.05060000 -121.94980000 1 WS" );
+    test.Check( "TST2 edited", text, std::set<string>( airports + 1, airports + 2 ) );
+
+    text = RemoveAirport( text, "TST3" );
+    test.Check( "TST3 removed", text, none );
+
+    // the new manifest can't be written : the old one is still read, so
+    // the index records of every airport are taken out before the rebuild
+    string work = test.root + "/work";
+    mkdir( ( work + manifest + ".new" ).c_str(), 0755 );
+    test.Check( "manifest unwritable", text, all );
+    rmdir( ( work + manifest + ".new" ).c_str() );
+    test.Check( "manifest writable again", text, none );
+
+    // the manifest can't be read - the index files may hold duplicates
+    remove( ( work + manifest ).c_str() );
+    mkdir( ( work + manifest ).c_str(), 0755 );
+    test.Check( "manifest unreadable", text, all, false );
+
+    cout << "scratch files are in " << test.root << endl;
+    cout << ( test.failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( test.failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+// test-index-writer.cxx - many airports, built on parser threads, append
+// their object index records to the same index files.  Every record must
+// be written once, the records of an airport must stay together, and an
+// airport that fails must leave neither records nor object files behind.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGThread.hxx>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "output.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static const unsigned int num_airports = 240;
+static const unsigned int num_objects  = 3;
+static const unsigned int num_threads  = 8;
+
+static string AirportName( unsigned int a )
+{
+    std::ostringstream name;
+    name << "AP" << a;
+    return name.str();
+}
+
+// every 7th airport fails after writing its objects
+static bool Fails( unsigned int a )
+{
+    return ( a % 7 ) == 3;
+}
+
+// the airports are spread over four buckets, so the threads share the
+// index files
+static SGBucket AirportBucket( unsigned int a )
+{
+    return SGBucket( SGGeod::fromDeg( -122.1 + 0.25 * ( a % 2 ), 37.05 + 0.125 * ( ( a / 2 ) % 2 ) ) );
+}
+
+static string ObjectFile( const string& root, unsigned int a, unsigned int o )
+{
+    std::ostringstream file;
+    file << root << "/" << AirportBucket( a ).gen_base_path() << "/" << AirportName( a ) << "_" << o << ".btg.gz";
+    return file.str();
+}
+
+static bool Exists( const string& file )
+{
+    struct stat st;
+    return stat( file.c_str(), &st ) == 0;
+}
+
+// what BuildBtg does for one airport : write the object files, add their
+// records as each one is done, then flush - or discard on an error
+static bool BuildAirport( const string& root, unsigned int a )
+{
+    ObjectIndexWriter index;
+    SGBucket          b = AirportBucket( a );
+
+    for ( unsigned int o = 0; o < num_objects; o++ ) {
+        string file = ObjectFile( root, a, o );
+        SGPath( file ).create_dir( 0755 );
+
+        FILE* fp = fopen( file.c_str(), "w" );
+        if ( fp ) {
+            fputs( "btg", fp );
+            fclose( fp );
+        }
+
+        std::ostringstream name;
+        name << AirportName( a ) << "_" << o << ".btg";
+        index.AddObject( root, b, name.str() );
+        index.AddObjectShared( root, b, SGGeod::fromDegM( -122.0, 37.0, 10.0 ), AirportName( a ) + "_tower.xml", 90.0 );
+    }
+
+    if ( Fails( a ) || !index.Flush() ) {
+        index.Discard();
+        return false;
+    }
+
+    return true;
+}
+
+class WriterThread : public SGThread
+{
+public:
+    WriterThread( const string& r, unsigned int f ) : root( r ), first( f ) {}
+
+    virtual void run()
+    {
+        for ( unsigned int a = first; a < num_airports; a += num_threads ) {
+            BuildAirport( root, a );
+        }
+    }
+
+private:
+    string       root;
+    unsigned int first;
+};
+
+// the lines of each index file, by airport - and checks an airport's
+// lines aren't split up by another's
+static unsigned int ReadIndex( const string& file, std::map<string, unsigned int>& lines )
+{
+    std::ifstream in( file.c_str() );
+    string        line, last;
+    unsigned int  failed = 0;
+    std::map<string, bool> done;
+
+    while ( std::getline( in, line ) ) {
+        std::istringstream fields( line );
+        string             type, name;
+
+        fields >> type >> name;
+        string airport = name.substr( 0, name.find( '_' ) );
+
+        if ( airport != last ) {
+            if ( done[airport] ) {
+                cout << "  " << file << " : records of " << airport << " are split up" << endl;
+                failed++;
+            }
+            done[last] = true;
+            last = airport;
+        }
+        lines[airport]++;
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    char         root_template[] = "/tmp/tg-index-XXXXXX";
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+
+    if ( !mkdtemp( root_template ) ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+    string root = root_template;
+
+    std::vector<WriterThread*> threads;
+    for ( unsigned int t = 0; t < num_threads; t++ ) {
+        threads.push_back( new WriterThread( root, t ) );
+        threads.back()->start();
+    }
+    for ( unsigned int t = 0; t < num_threads; t++ ) {
+        threads[t]->join();
+        delete threads[t];
+    }
+
+    std::map<string, unsigned int> lines;
+    std::map<string, bool>         index_files;
+    for ( unsigned int a = 0; a < num_airports; a++ ) {
+        SGBucket b = AirportBucket( a );
+        index_files[ root + "/" + b.gen_base_path() + "/" + b.gen_index_str() + ".ind" ] = true;
+    }
+    for ( std::map<string, bool>::iterator it = index_files.begin(); it != index_files.end(); it++ ) {
+        failed += ReadIndex( it->first, lines );
+    }
+
+    for ( unsigned int a = 0; a < num_airports; a++ ) {
+        unsigned int expected = Fails( a ) ? 0 : 2 * num_objects;
+
+        if ( lines[ AirportName( a ) ] != expected ) {
+            cout << "  " << AirportName( a ) << " : " << lines[ AirportName( a ) ] << " index records, expected " << expected << endl;
+            failed++;
+        }
+        for ( unsigned int o = 0; o < num_objects; o++ ) {
+            if ( Exists( ObjectFile( root, a, o ) ) == Fails( a ) ) {
+                cout << "  " << ObjectFile( root, a, o ) << ( Fails( a ) ? " left behind" : " missing" ) << endl;
+                failed++;
+            }
+        }
+    }
+
+    // an index file that can't be written : the airport's objects go too
+    unsigned int blocked = 1;
+    SGBucket     b       = AirportBucket( blocked );
+    string       index   = root + "/" + b.gen_base_path() + "/" + b.gen_index_str() + ".ind";
+
+    remove( index.c_str() );
+    mkdir( index.c_str(), 0755 );
+    if ( BuildAirport( root, blocked ) ) {
+        cout << "  flushing to an unwritable index file succeeded" << endl;
+        failed++;
+    }
+    for ( unsigned int o = 0; o < num_objects; o++ ) {
+        if ( Exists( ObjectFile( root, blocked, o ) ) ) {
+            cout << "  " << ObjectFile( root, blocked, o ) << " left behind after a failed flush" << endl;
+            failed++;
+        }
+    }
+
+    cout << "scratch files are in " << root << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
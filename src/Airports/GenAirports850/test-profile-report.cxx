@@ -0,0 +1,204 @@
+// test-profile-report.cxx - genapts850 --profile on test-apt.dat must report
+// every build phase of every airport exactly once, with sane values, and
+// list each airport in the summary of the slowest ones.  Checked with the
+// task graph, --serial-build, and worker processes appending to the report.
+//
+// usage: test_profile_report [ genapts850 [ apt.dat ] ]
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test-genapts.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static const char* airports[] = { "TST1", "TST2", "TST3" };
+static const unsigned int num_airports = 3;
+
+// task/phase of every row an airport gets, in RunBuildTask order
+static const char* phases[] = {
+    "Airport/Parse", "Airport/BuildBtg",
+    "Base/BuildBase", "Base/ClipBase", "Base/spacialquery", "Base/CleanBase",
+    "Base/TesselateBase", "Base/LookupBaseIndexes", "Base/TextureBase",
+    "Base/CalcBaseElevations", "Base/Write Base",
+    "Features/Build Features", "Features/Clip Features",
+    "FeatureMesh/IntersectFeaturesWithBase", "FeatureMesh/TesselateFeatures",
+    "FeatureMesh/LookupFeatureIndexes", "FeatureMesh/TextureFeatures",
+    "FeatureMesh/CalcFeatureElevations", "FeatureMesh/Write Features",
+    "Lights/Build Lights", "Lights/Write Lights", "Lights/Write Objects"
+};
+static const unsigned int num_phases = sizeof(phases) / sizeof(phases[0]);
+
+static std::vector<string> Split( const string& line )
+{
+    std::vector<string> fields;
+    std::istringstream  in( line );
+    string              field;
+
+    while ( std::getline( in, field, ',' ) ) {
+        fields.push_back( field );
+    }
+
+    return fields;
+}
+
+static bool IsNumber( const string& s, bool allow_negative )
+{
+    char*  end;
+    double value = strtod( s.c_str(), &end );
+
+    return !s.empty() && *end == '\0' && ( allow_negative || value >= 0.0 );
+}
+
+// check the report and its summary - returns the number of problems
+static unsigned int CheckReport( const string& what, const string& report, const string& summary )
+{
+    unsigned int failed = 0;
+    std::ifstream in( report.c_str() );
+    string        line;
+
+    std::getline( in, line );
+    if ( line != "icao,task,phase,wall_s,rss_kb,polys,verts,tris" ) {
+        cout << "  " << what << " : report header is '" << line << "'" << endl;
+        return 1;
+    }
+
+    // icao -> task/phase -> rows
+    std::map<string, std::map<string, unsigned int> > rows;
+    std::map<string, double> tris;
+
+    while ( std::getline( in, line ) ) {
+        std::vector<string> f = Split( line );
+
+        // the rss growth is shared with whatever else runs, so may be negative
+        if ( f.size() != 8 || !IsNumber( f[3], false ) || !IsNumber( f[4], true ) ||
+             !IsNumber( f[5], false ) || !IsNumber( f[6], false ) || !IsNumber( f[7], false ) ) {
+            cout << "  " << what << " : bad report line '" << line << "'" << endl;
+            failed++;
+            continue;
+        }
+
+        rows[f[0]][f[1] + "/" + f[2]]++;
+        if ( f[1] == "Base" ) {
+            tris[f[0]] = std::max( tris[f[0]], atof( f[7].c_str() ) );
+        }
+    }
+
+    for ( unsigned int a = 0; a < num_airports; a++ ) {
+        std::map<string, unsigned int>& apt = rows[airports[a]];
+
+        for ( unsigned int p = 0; p < num_phases; p++ ) {
+            if ( apt[phases[p]] != 1 ) {
+                cout << "  " << what << " : " << airports[a] << " " << phases[p] << " reported " << apt[phases[p]] << " times" << endl;
+                failed++;
+            }
+        }
+        if ( apt.size() != num_phases ) {
+            cout << "  " << what << " : " << airports[a] << " has " << apt.size() - num_phases << " unknown phases" << endl;
+            failed++;
+        }
+        if ( tris[airports[a]] <= 0.0 ) {
+            cout << "  " << what << " : " << airports[a] << " base has no triangles" << endl;
+            failed++;
+        }
+    }
+    if ( rows.size() != num_airports ) {
+        cout << "  " << what << " : " << rows.size() << " airports in the report" << endl;
+        failed++;
+    }
+
+    // the slowest airports : ranked by total time, which is parse + build
+    std::ifstream sin( summary.c_str() );
+    std::set<string> listed;
+    double           last_total = 1.0e30;
+    unsigned int     rank = 0;
+
+    std::getline( sin, line );
+    if ( line != "rank,icao,total_s,parse_s,build_s,slowest_phase,slowest_phase_s,tris" ) {
+        cout << "  " << what << " : summary header is '" << line << "'" << endl;
+        return failed + 1;
+    }
+
+    while ( std::getline( sin, line ) ) {
+        std::vector<string> f = Split( line );
+
+        if ( f.size() != 8 ) {
+            cout << "  " << what << " : bad summary line '" << line << "'" << endl;
+            failed++;
+            continue;
+        }
+
+        double total = atof( f[2].c_str() );
+        double sum   = atof( f[3].c_str() ) + atof( f[4].c_str() );
+
+        if ( atoi( f[0].c_str() ) != (int)++rank || total > last_total || fabs( total - sum ) > 1.0e-4 * ( 1.0 + total ) ) {
+            cout << "  " << what << " : summary line '" << line << "' is out of order, or doesn't add up" << endl;
+            failed++;
+        }
+        if ( rows[f[1]][f[5]] != 1 || f[5].find( "Airport/" ) == 0 ) {
+            cout << "  " << what << " : " << f[1] << " slowest phase '" << f[5] << "' isn't a build phase" << endl;
+            failed++;
+        }
+        last_total = total;
+        listed.insert( f[1] );
+    }
+
+    if ( listed.size() != num_airports || rank != num_airports ) {
+        cout << "  " << what << " : " << rank << " lines for " << listed.size() << " airports in the summary" << endl;
+        failed++;
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    string       self    = argv[0];
+    string       genapts = ( argc > 1 ) ? argv[1] : self.substr( 0, self.rfind( '/' ) + 1 ) + "genapts850";
+    string       apt_dat = ( argc > 2 ) ? argv[2] : TEST_APT_DAT;
+    char         root_template[] = "/tmp/tg-profile-report-XXXXXX";
+
+    if ( !mkdtemp( root_template ) ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+    string root = root_template;
+
+    const char* modes[][2] = {
+        { "threads",   "--threads=3" },
+        { "serial",    "--serial-build" },
+        { "processes", "--processes=2" },
+    };
+
+    for ( unsigned int m = 0; m < 3; m++ ) {
+        string work   = root + "/" + modes[m][0];
+        string report = work + "_profile.csv";
+
+        if ( !RunGenapts( genapts, apt_dat, work, string( modes[m][1] ) + " --profile=" + report ) ) {
+            failed++;
+            continue;
+        }
+
+        failed += CheckReport( modes[m][0], report, work + "_profile_slowest.csv" );
+    }
+
+    cout << "scratch files are in " << root << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// test-serial-build.cxx - genapts850 builds the airports of test-apt.dat
+// once with --serial-build, and a few times with the task graph on several
+// parser threads.  Every output file must be the same.
+//
+// usage: test_serial_build [ genapts850 [ apt.dat [ runs ] ] ]
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "test-genapts.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    string       self    = argv[0];
+    string       genapts = ( argc > 1 ) ? argv[1] : self.substr( 0, self.rfind( '/' ) + 1 ) + "genapts850";
+    string       apt_dat = ( argc > 2 ) ? argv[2] : TEST_APT_DAT;
+    int          runs    = ( argc > 3 ) ? atoi( argv[3] ) : 3;
+    char         root_template[] = "/tmp/tg-serial-build-XXXXXX";
+
+    if ( !mkdtemp( root_template ) ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+    string root = root_template;
+
+    if ( !RunGenapts( genapts, apt_dat, root + "/serial", "--serial-build" ) ) {
+        return 1;
+    }
+
+    FileMap ref;
+    ReadTree( root + "/serial", "/AirportObj", ref );
+
+    unsigned int num_btg = 0;
+    for ( FileMap::const_iterator it = ref.begin(); it != ref.end(); it++ ) {
+        if ( EndsWith( it->first, ".btg.gz" ) ) {
+            num_btg++;
+        }
+    }
+    cout << "serial build : " << ref.size() << " files, " << num_btg << " btg" << endl;
+    if ( num_btg == 0 ) {
+        cout << "  nothing to compare - see " << root << "/serial.log" << endl;
+        failed++;
+    }
+
+    // different thread counts interleave the airports and their tasks differently
+    for ( int r = 0; r < runs; r++ ) {
+        std::ostringstream work, options;
+        work    << root << "/tasks_" << r;
+        options << "--threads=" << 1 + r % 4;
+
+        if ( !RunGenapts( genapts, apt_dat, work.str(), options.str() ) ) {
+            failed++;
+            continue;
+        }
+
+        FileMap files;
+        ReadTree( work.str(), "/AirportObj", files );
+
+        std::vector<string> diffs = DiffTrees( ref, files );
+        for ( unsigned int i = 0; i < diffs.size(); i++ ) {
+            cout << "  " << options.str() << " : " << diffs[i] << endl;
+            failed++;
+        }
+    }
+
+    cout << "scratch files are in " << root << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// test-worker-pool.cxx - airport builds that crash, abort, hang or run out
+// of memory in WorkerPool workers must fail on their own : every other job
+// still gets built, once, and each bad one is reported with the right
+// reason.  The program is its own worker - the pool runs it again with
+// --worker=<job fd>,<result fd>, and the icao of a job says how to fail.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "worker_pool.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static const unsigned int num_good = 40;
+
+// how the fake builds fail, and what the pool should report for them
+struct BadBuild
+{
+    const char* icao;
+    const char* failure;
+};
+
+static const BadBuild bad_builds[] = {
+    { "CRASH", "killed by signal 11" },
+    { "ABORT", "killed by signal 6"  },
+    { "EXIT",  "exited with status 3" },
+    { "HANG",  "timed out" },
+#ifdef __linux__
+    // the resident size is read from /proc
+    { "HOG",   "out of memory" },
+#else
+    { "HOG",   "timed out" },
+#endif
+};
+static const unsigned int num_bad = sizeof(bad_builds) / sizeof(bad_builds[0]);
+
+class FakeBuilder : public WorkerBuilder
+{
+public:
+    virtual void Build( const WorkerJob& job, WorkerResult& result )
+    {
+        string icao = job.icao;
+
+        if ( icao == "CRASH" ) {
+            raise( SIGSEGV );
+        } else if ( icao == "ABORT" ) {
+            abort();
+        } else if ( icao == "EXIT" ) {
+            exit( 3 );
+        } else if ( icao == "HANG" ) {
+            while ( true ) {
+                pause();
+            }
+        } else if ( icao == "HOG" ) {
+            // 512 MB, touched so it is resident
+            size_t size = 512 * 1024 * 1024;
+            char*  mem  = (char*)malloc( size );
+            for ( size_t i = 0; mem && i < size; i += 4096 ) {
+                mem[i] = 1;
+            }
+            while ( true ) {
+                pause();
+            }
+        }
+
+        usleep( 20000 );
+        result.build_time = job.pos;
+    }
+};
+
+class TestPool : public WorkerPool
+{
+public:
+    TestPool( const string_list& command, int num ) : WorkerPool( command, num, 2, 256 ) {}
+
+    std::map<string, string_list> failures;
+    std::map<string, double>      build_times;
+
+protected:
+    virtual void JobDone( const WorkerJob& job, const WorkerResult& result, const std::string& failure )
+    {
+        failures[job.icao].push_back( failure );
+        build_times[job.icao] = result.build_time;
+    }
+};
+
+static WorkerJob MakeJob( const string& icao, long pos )
+{
+    WorkerJob job;
+
+    memset( &job, 0, sizeof(job) );
+    strncpy( job.icao, icao.c_str(), sizeof(job.icao)-1 );
+    job.pos  = pos;
+    job.snap = 0.00000001;
+
+    return job;
+}
+
+static unsigned int RunPool( const string_list& command, int num_workers )
+{
+    std::deque<WorkerJob> jobs;
+    unsigned int          failed = 0;
+    char                  icao[16];
+
+    // the bad builds are spread through the queue
+    for ( unsigned int i = 0; i < num_good; i++ ) {
+        sprintf( icao, "A%03u", i );
+        jobs.push_back( MakeJob( icao, i + 1 ) );
+        if ( i % 8 == 4 ) {
+            jobs.push_back( MakeJob( bad_builds[i / 8].icao, 0 ) );
+        }
+    }
+
+    TestPool pool( command, num_workers );
+    if ( !pool.Run( jobs ) ) {
+        cout << "  " << num_workers << " workers : pool failed" << endl;
+        return 1;
+    }
+
+    for ( unsigned int i = 0; i < num_good; i++ ) {
+        sprintf( icao, "A%03u", i );
+        string_list const& f = pool.failures[icao];
+
+        if ( f.size() != 1 || !f[0].empty() || pool.build_times[icao] != i + 1 ) {
+            cout << "  " << num_workers << " workers : " << icao << " wasn't built once" << endl;
+            failed++;
+        }
+    }
+    for ( unsigned int i = 0; i < num_bad; i++ ) {
+        string_list const& f = pool.failures[ bad_builds[i].icao ];
+
+        if ( f.size() != 1 || f[0] != bad_builds[i].failure ) {
+            cout << "  " << num_workers << " workers : " << bad_builds[i].icao << " reported as '"
+                 << ( f.empty() ? "" : f[0] ) << "', expected '" << bad_builds[i].failure << "'" << endl;
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    int          job_fd, result_fd;
+
+    sglog().setLogLevels( SG_ALL, SG_ALERT );
+
+    if ( argc > 1 && sscanf( argv[argc-1], "--worker=%d,%d", &job_fd, &result_fd ) == 2 ) {
+        FakeBuilder builder;
+        RunWorker( job_fd, result_fd, builder );
+    }
+
+    string_list command( argv, argv + 1 );
+
+    // with one worker, every bad build holds up the rest until it is killed
+    failed += RunPool( command, 4 );
+    failed += RunPool( command, 1 );
+
+    // workers that can't be started
+    string_list missing( 1, "/nonexistent/genapts850" );
+    TestPool    pool( missing, 2 );
+    std::deque<WorkerJob> jobs( 1, MakeJob( "A000", 1 ) );
+
+    if ( pool.Run( jobs ) ) {
+        cout << "  a pool without a worker executable succeeded" << endl;
+        failed++;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
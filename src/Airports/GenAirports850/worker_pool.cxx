@@ -0,0 +1,347 @@
+#ifndef _MSC_VER
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <simgear/debug/logstream.hxx>
+
+#include "worker_pool.hxx"
+
+static bool ReadFull( int fd, void* buf, size_t len )
+{
+    char* p = (char*)buf;
+
+    while ( len ) {
+        ssize_t n = read( fd, p, len );
+        if ( n < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( n <= 0 ) {
+            return false;
+        }
+        p   += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static bool WriteFull( int fd, const void* buf, size_t len )
+{
+    const char* p = (const char*)buf;
+
+    while ( len ) {
+        ssize_t n = write( fd, p, len );
+        if ( n < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( n <= 0 ) {
+            return false;
+        }
+        p   += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+// resident set size of a process in MB - 0 if unknown
+static long GetWorkerRSS( pid_t pid )
+{
+    char  path[64];
+    long  size, resident = 0;
+    FILE* fp;
+
+    sprintf( path, "/proc/%d/statm", (int)pid );
+    if ( (fp = fopen( path, "r" )) != NULL ) {
+        if ( fscanf( fp, "%ld %ld", &size, &resident ) != 2 ) {
+            resident = 0;
+        }
+        fclose( fp );
+    }
+
+    return resident * ( sysconf( _SC_PAGESIZE ) / 1024 ) / 1024;
+}
+
+// the path to run command[0] from, as execvp() would find it
+static std::string FindExecutable( const std::string& name )
+{
+    const char* path = getenv( "PATH" );
+
+    if ( name.find( '/' ) != std::string::npos || !path ) {
+        return name;
+    }
+
+    std::string dirs = path;
+    std::string::size_type start = 0, end;
+    do {
+        end = dirs.find( ':', start );
+
+        std::string dir  = dirs.substr( start, end == std::string::npos ? std::string::npos : end - start );
+        std::string file = ( dir.empty() ? "." : dir ) + "/" + name;
+        if ( access( file.c_str(), X_OK ) == 0 ) {
+            return file;
+        }
+        start = end + 1;
+    } while ( end != std::string::npos );
+
+    return name;
+}
+
+void RunWorker( int job_fd, int result_fd, WorkerBuilder& builder )
+{
+    // tell the parent we are up
+    char ready = 'R';
+    if ( !WriteFull( result_fd, &ready, 1 ) ) {
+        _exit(-1);
+    }
+
+    WorkerJob job;
+    while ( ReadFull( job_fd, &job, sizeof(job) ) ) {
+        WorkerResult result;
+
+        memset( &result, 0, sizeof(result) );
+        builder.Build( job, result );
+
+        if ( !WriteFull( result_fd, &result, sizeof(result) ) ) {
+            break;
+        }
+    }
+
+    _exit(0);
+}
+
+WorkerPool::WorkerPool( const string_list& cmd, int num_workers, int time_limit, int rss_limit ) :
+    command( cmd ),
+    workers( num_workers ),
+    max_time( time_limit ),
+    max_rss( rss_limit )
+{
+    executable = FindExecutable( command[0] );
+}
+
+WorkerPool::~WorkerPool()
+{
+    for ( unsigned int i = 0; i < workers.size(); i++ ) {
+        if ( workers[i].pid > 0 ) {
+            StopWorker( workers[i], true );
+        }
+    }
+}
+
+bool WorkerPool::StartWorker( Worker& w )
+{
+    int job_pipe[2], result_pipe[2];
+
+    w.pid       = -1;
+    w.job_fd    = -1;
+    w.result_fd = -1;
+    w.busy      = false;
+
+    if ( pipe( job_pipe ) < 0 ) {
+        return false;
+    }
+    if ( pipe( result_pipe ) < 0 ) {
+        close( job_pipe[0] );
+        close( job_pipe[1] );
+        return false;
+    }
+
+    // the parent's ends aren't passed on to this worker, or any later one
+    fcntl( job_pipe[1],    F_SETFD, FD_CLOEXEC );
+    fcntl( result_pipe[0], F_SETFD, FD_CLOEXEC );
+
+    // everything the child needs is built before fork()
+    std::ostringstream option;
+    option << "--worker=" << job_pipe[0] << "," << result_pipe[1];
+
+    string_list        args = command;
+    std::vector<char*> argv;
+
+    args.push_back( option.str() );
+    for ( unsigned int i = 0; i < args.size(); i++ ) {
+        argv.push_back( const_cast<char*>( args[i].c_str() ) );
+    }
+    argv.push_back( NULL );
+
+    pid_t pid = fork();
+    if ( pid == 0 ) {
+        execv( executable.c_str(), &argv[0] );
+        _exit(127);
+    }
+
+    close( job_pipe[0] );
+    close( result_pipe[1] );
+
+    if ( pid < 0 ) {
+        close( job_pipe[1] );
+        close( result_pipe[0] );
+        return false;
+    }
+
+    w.pid       = pid;
+    w.job_fd    = job_pipe[1];
+    w.result_fd = result_pipe[0];
+
+    // wait for the worker to come up - it exits if it can't
+    struct pollfd pfd;
+    char          ready;
+
+    pfd.fd      = w.result_fd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    if ( poll( &pfd, 1, max_time ? max_time * 1000 : -1 ) <= 0 || !ReadFull( w.result_fd, &ready, 1 ) ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "Worker process " << executable << " " << StopWorker( w, true ) << " on startup" );
+        return false;
+    }
+
+    return true;
+}
+
+// returns a description of how the worker ended
+std::string WorkerPool::StopWorker( Worker& w, bool kill_it )
+{
+    std::ostringstream reason;
+    int status = 0;
+
+    if ( kill_it ) {
+        kill( w.pid, SIGKILL );
+    }
+    close( w.job_fd );
+    close( w.result_fd );
+
+    while ( waitpid( w.pid, &status, 0 ) < 0 && errno == EINTR ) {
+    }
+
+    if ( WIFSIGNALED( status ) ) {
+        reason << "killed by signal " << WTERMSIG( status );
+    } else if ( WIFEXITED( status ) ) {
+        reason << "exited with status " << WEXITSTATUS( status );
+    }
+
+    w.pid  = -1;
+    w.busy = false;
+
+    return reason.str();
+}
+
+bool WorkerPool::Run( std::deque<WorkerJob>& jobs )
+{
+    // a dead worker shows up as a read / write error, not a signal
+    signal( SIGPIPE, SIG_IGN );
+
+    for ( unsigned int i = 0; i < workers.size(); i++ ) {
+        if ( !StartWorker( workers[i] ) ) {
+            return false;
+        }
+    }
+
+    SG_LOG( SG_GENERAL, SG_INFO, "Started " << workers.size() << " worker processes : time limit " << max_time << " s, memory limit " << max_rss << " MB" );
+
+    while ( true ) {
+        std::vector<struct pollfd> fds;
+        std::vector<unsigned int>  busy;
+
+        // hand out jobs to the idle workers
+        for ( unsigned int i = 0; i < workers.size(); i++ ) {
+            Worker& w = workers[i];
+
+            if ( !w.busy && !jobs.empty() ) {
+                WorkerJob job = jobs.front();
+                jobs.pop_front();
+
+                if ( WriteFull( w.job_fd, &job, sizeof(job) ) ) {
+                    w.job  = job;
+                    w.busy = true;
+                    w.start.stamp();
+                } else {
+                    // worker died while idle - restart it, and try the job again
+                    SG_LOG( SG_GENERAL, SG_ALERT, "Worker " << w.pid << " " << StopWorker( w, true ) << " while idle - restarting" );
+                    jobs.push_front( job );
+                    if ( !StartWorker( w ) ) {
+                        return false;
+                    }
+                    continue;
+                }
+            }
+
+            if ( w.busy ) {
+                struct pollfd pfd;
+                pfd.fd      = w.result_fd;
+                pfd.events  = POLLIN;
+                pfd.revents = 0;
+
+                fds.push_back( pfd );
+                busy.push_back( i );
+            }
+        }
+
+        if ( busy.empty() ) {
+            if ( jobs.empty() ) {
+                break;
+            }
+            continue;
+        }
+
+        // wait for results, and check the limits once a second
+        if ( poll( &fds[0], fds.size(), 1000 ) < 0 && errno != EINTR ) {
+            SG_LOG( SG_GENERAL, SG_ALERT, "poll failed: " << strerror(errno) );
+            return false;
+        }
+
+        SGTimeStamp now;
+        now.stamp();
+
+        for ( unsigned int j = 0; j < busy.size(); j++ ) {
+            Worker&      w = workers[busy[j]];
+            WorkerResult result;
+            std::string  failure;
+
+            if ( fds[j].revents ) {
+                if ( ReadFull( w.result_fd, &result, sizeof(result) ) ) {
+                    w.busy = false;
+                    JobDone( w.job, result, failure );
+                    continue;
+                }
+
+                failure = StopWorker( w, false );
+            } else if ( max_time && ( now - w.start ).toSecs() > max_time ) {
+                StopWorker( w, true );
+                failure = "timed out";
+            } else if ( max_rss && GetWorkerRSS( w.pid ) > max_rss ) {
+                StopWorker( w, true );
+                failure = "out of memory";
+            } else {
+                continue;
+            }
+
+            memset( &result, 0, sizeof(result) );
+            JobDone( w.job, result, failure );
+
+            if ( !StartWorker( w ) ) {
+                return false;
+            }
+        }
+    }
+
+    // no more work - closing the job pipes lets the workers exit
+    for ( unsigned int i = 0; i < workers.size(); i++ ) {
+        if ( workers[i].pid > 0 ) {
+            StopWorker( workers[i], false );
+        }
+    }
+
+    return true;
+}
+
+#endif
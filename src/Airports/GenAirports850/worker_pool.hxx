@@ -0,0 +1,91 @@
+#ifndef __WORKER_POOL_HXX__
+#define __WORKER_POOL_HXX__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/math/sg_types.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <sys/types.h>
+
+// records passed over the worker pipes
+struct WorkerJob
+{
+    long    pos;
+    double  snap;
+    char    icao[16];
+};
+
+struct WorkerResult
+{
+    double  parse_time;
+    double  build_time;
+    double  clean_time;
+    double  tess_time;
+};
+
+// what a worker process does with each job it is sent
+class WorkerBuilder
+{
+public:
+    virtual ~WorkerBuilder() {}
+
+    virtual void Build( const WorkerJob& job, WorkerResult& result ) = 0;
+};
+
+// the worker side : build each job read from job_fd and write its result
+// to result_fd, until the job pipe is closed.  Doesn't return.
+void RunWorker( int job_fd, int result_fd, WorkerBuilder& builder );
+
+// Builds jobs in worker processes ( --processes ), so a crashing or hanging
+// build doesn't take down the whole run.  The parent hands out one job at a
+// time over a pipe, and kills workers over the wall clock or memory limits.
+// Dead workers are restarted, and their job reported as failed.
+//
+// Workers are started by running command again, with --worker=<job fd>,<result fd>
+// added.  The parent already has threads by then ( SimGear's log thread, at
+// least ), and a forked copy would inherit their locks in whatever state they
+// were in.  So the child of fork() only closes descriptors and exec()s - both
+// async-signal-safe - and the worker starts with a fresh process image.
+class WorkerPool
+{
+public:
+    // max_time is in seconds, max_rss in MB - 0 for no limit
+    WorkerPool( const string_list& command, int num_workers, int max_time, int max_rss );
+    virtual ~WorkerPool();
+
+    // build all jobs.  Returns false if a worker can't be started
+    bool Run( std::deque<WorkerJob>& jobs );
+
+protected:
+    // a job is done - failure is empty if it was built, or says how the
+    // worker ended if not
+    virtual void JobDone( const WorkerJob& job, const WorkerResult& result, const std::string& failure ) = 0;
+
+private:
+    struct Worker
+    {
+        Worker() : pid(-1), job_fd(-1), result_fd(-1), busy(false) {}
+
+        pid_t       pid;
+        int         job_fd;         // parent -> worker
+        int         result_fd;      // worker -> parent
+        bool        busy;
+        WorkerJob   job;
+        SGTimeStamp start;
+    };
+
+    bool        StartWorker( Worker& w );
+    std::string StopWorker( Worker& w, bool kill_it );
+
+    std::string         executable;
+    string_list         command;
+    std::vector<Worker> workers;
+    int                 max_time;
+    int                 max_rss;
+};
+
+#endif
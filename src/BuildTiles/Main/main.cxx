@@ -32,6 +32,9 @@
 #include <boost/thread.hpp>
 
 #include <simgear/debug/logstream.hxx>
+
+#include <terragear/tg_debug_sink.hxx>
+#include <terragear/tg_local_frame.hxx>
 #include <Include/version.h>
 
 #include "tgconstruct.hxx"
@@ -59,6 +62,9 @@ static void usage( const string name ) {
     SG_LOG(SG_GENERAL, SG_ALERT, "  --ignore-landmass");
     SG_LOG(SG_GENERAL, SG_ALERT, "  --threads");
     SG_LOG(SG_GENERAL, SG_ALERT, "  --threads=<numthreads>");
+    SG_LOG(SG_GENERAL, SG_ALERT, "  --debug-sink=<checkpoint,...|all>");
+    SG_LOG(SG_GENERAL, SG_ALERT, "  --debug-sink-scope=<tile index,...>");
+    SG_LOG(SG_GENERAL, SG_ALERT, "  --geodesy-tolerance=<meters>");
     SG_LOG(SG_GENERAL, SG_ALERT, " ] <load directory...>");
     exit(-1);
 }
@@ -142,6 +148,12 @@ int main(int argc, char **argv) {
             debug_area_defs.push_back( arg.substr(14) );
         } else if (arg.find("--debug-shapes=") == 0) {
             debug_shape_defs.push_back( arg.substr(15) );
+        } else if (arg.find("--debug-sink=") == 0) {
+            tgDebugSink::EnableCheckpoints( arg.substr(13) );
+        } else if (arg.find("--debug-sink-scope=") == 0) {
+            tgDebugSink::EnableScopes( arg.substr(19) );
+        } else if (arg.find("--geodesy-tolerance=") == 0) {
+            tgLocalFrame::SetTolerance( atof( arg.substr(20).c_str() ) );
         } else if (arg.find("--") == 0) {
             usage(argv[0]);
         } else {
@@ -320,6 +332,10 @@ int main(int argc, char **argv) {
     }
     constructs.clear();
 
+    unsigned int tess_fast, tess_exact;
+    tgPolygon::GetTesselationStats( tess_fast, tess_exact );
+    SG_LOG(SG_GENERAL, SG_ALERT, "Tesselated " << tess_fast + tess_exact << " polys, " << tess_exact << " needed exact constructions");
+
     SG_LOG(SG_GENERAL, SG_ALERT, "[Finished successfully]");
     return 0;
 }
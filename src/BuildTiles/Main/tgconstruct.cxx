@@ -271,7 +271,9 @@ void TGConstruct::run()
         polys_in.clear();
         polys_clipped.clear();
         nodes.clear();
+        face_adjacency.clear();
         neighbor_faces.clear();
+        neighbor_face_lookup.clear();
         debug_shapes.clear();
         debug_areas.clear();
     }
@@ -31,12 +31,16 @@
 # error This library requires C++
 #endif                                   
 
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
 #include <simgear/threads/SGThread.hxx>
 #include <simgear/threads/SGQueue.hxx>
 
 #include <terragear/tg_array.hxx>
 #include <terragear/tg_nodes.hxx>
 #include <terragear/tg_areas.hxx>
+#include <terragear/tg_face_adjacency.hxx>
 
 #include <landcover/landcover.hxx>
 
@@ -58,6 +62,10 @@ typedef std::vector < TGNeighborFaces > neighbor_face_list;
 typedef neighbor_face_list::iterator neighbor_face_list_iterator;
 typedef neighbor_face_list::const_iterator const_neighbor_face_list_iterator;
 
+// neighbor faces by tgNeighborFaceKey() - maps to the index in the
+// neighbor_face_list
+typedef boost::unordered_map < uint64_t, unsigned int > neighbor_face_map;
+
 class TGConstruct : public SGThread
 {
 public:
@@ -134,7 +142,7 @@ private:
     void LoadNeighboorMatchDataStage1( SGBucket& b, std::vector<SGGeod>& north, std::vector<SGGeod>& south, std::vector<SGGeod>& east, std::vector<SGGeod>& west );
     
     void ReadNeighborFaces( gzFile& fp );
-    void WriteNeighborFaces( gzFile& fp, const SGGeod& pt ) const;
+    void WriteNeighborFaces( gzFile& fp, unsigned int idx ) const;
     TGNeighborFaces* AddNeighborFaces( const SGGeod& node );
     TGNeighborFaces* FindNeighborFaces( const SGGeod& node );
 
@@ -165,7 +173,6 @@ private:
     void AddCustomObjects( void );
 
     // Misc
-    void calc_normals( std::vector<SGGeod>& geod_nodes, std::vector<SGVec3d>& wgs84_nodes, tgPolygon& sp );
 
     // debug
     void get_debug( void );
@@ -240,8 +247,12 @@ private:
 
     unsigned int num_areas;
 
+    // Node to face lookup
+    tgFaceAdjacency     face_adjacency;
+
     // Neighbor Faces
     neighbor_face_list  neighbor_faces;
+    neighbor_face_map   neighbor_face_lookup;
     
     // file lock
     SGMutex*    lock;
@@ -29,31 +29,29 @@
 #include <simgear/debug/logstream.hxx>
 
 #include <terragear/tg_shapefile.hxx>
+#include <terragear/tg_node_grid.hxx>
 
 #include "tgconstruct.hxx"
 
 void TGConstruct::FixTJunctions( void ) {
     int before, after;
-    std::vector<TGNode*> points;
-    tgRectangle bb;
+
+    // bin all the nodes once - each polygon edge then only looks at
+    // the nodes in a narrow corridor around it
+    tgNodeGrid grid( nodes );
 
     // traverse each poly, and add intermediate nodes
     for ( unsigned int i = 0; i < area_defs.size(); ++i ) {
         for( unsigned int j = 0; j < polys_clipped.area_size(i); ++j ) {
-            tgPolygon current = polys_clipped.get_poly(i, j);
-            bb = current.GetBoundingBox();
-            nodes.get_nodes_inside( bb.getMin(), bb.getMax(), points );
+            tgPolygon& current = polys_clipped.get_poly(i, j);
 
             before  = current.TotalNodes();
-            current = tgPolygon::AddColinearNodes( current, points );
+            current.AddColinearNodes( grid );
             after   = current.TotalNodes();
 
             if (before != after) {
                SG_LOG( SG_CLIPPER, SG_DEBUG, "Fixed T-Junctions in " << area_defs.get_area_name(i) << ":" << j+1 << " of " << (int)polys_clipped.area_size(i) << " nodes increased from " << before << " to " << after );
             }
-
-            /* Save it back */
-            polys_clipped.set_poly( i, j, current );
         }
     }
 }
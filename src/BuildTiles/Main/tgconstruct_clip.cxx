@@ -27,6 +27,7 @@
 #include <simgear/debug/logstream.hxx>
 
 #include <terragear/tg_accumulator.hxx>
+#include <terragear/tg_debug_sink.hxx>
 #include <terragear/tg_shapefile.hxx>
 #include <terragear/tg_misc.hxx>
 #include <terragear/tg_arrangement.hxx>
@@ -85,9 +86,9 @@ bool TGConstruct::ClipLandclassPolys( void ) {
         }
     }
 
-    land_mask   = tgPolygon::Union_cgal( land_list );
-    water_mask  = tgPolygon::Union_cgal( water_list );
-    island_mask = tgPolygon::Union_cgal( island_list );
+    land_mask   = tgPolygon::UnionAll( land_list, true );
+    water_mask  = tgPolygon::UnionAll( water_list, true );
+    island_mask = tgPolygon::UnionAll( island_list, true );
 
     // Dump the masks
     if ( debug_all || debug_shapes.size() || debug_areas.size() ) {
@@ -136,7 +137,7 @@ bool TGConstruct::ClipLandclassPolys( void ) {
     SG_LOG( SG_CLIPPER, SG_INFO, "Clipping Complete - diff with tile" );
     
     // dump the accumulator
-    accum.ToShapefiles( "./", "accum", false );
+    TG_DEBUG_SINK( "accum", bucket.gen_index(), accum.ToShapefiles( "./", "accum", false ) );
     
     // finally, what ever is left over goes to ocean
     accum.Diff_cgal( safety_base );    
@@ -231,9 +232,9 @@ bool TGConstruct::ClipLandclassPolys( void ) {
         }
     }
 
-    land_mask   = tgPolygon::Union( land_list );
-    water_mask  = tgPolygon::Union( water_list );
-    island_mask = tgPolygon::Union( island_list );
+    land_mask   = tgPolygon::UnionAll( land_list );
+    water_mask  = tgPolygon::UnionAll( water_list );
+    island_mask = tgPolygon::UnionAll( island_list );
 
     // Dump the masks
     if ( debug_all || debug_shapes.size() || debug_areas.size() ) {
@@ -25,6 +25,7 @@
 #endif
 
 #include <simgear/debug/logstream.hxx>
+#include <terragear/tg_local_frame.hxx>
 
 #include "tgconstruct.hxx"
 
@@ -50,16 +51,15 @@ void TGConstruct::LoadElevationArray( bool add_nodes ) {
     array.remove_voids( );
     if ( add_nodes ) {
         std::vector<SGGeod> const& corner_list = array.get_corner_list();
-        for (unsigned int i=0; i<corner_list.size(); i++) {
-            SGGeod pos = corner_list[i];
-            nodes.unique_add( pos );
-        }
-
         std::vector<SGGeod> const& fit_list = array.get_fitted_list();
-        for (unsigned int i=0; i<fit_list.size(); i++) {
-            SGGeod pos = fit_list[i];
-            nodes.unique_add( pos );
-        }
+        std::vector<SGGeod> points;
+        std::vector<unsigned int> indices;
+
+        points.reserve( corner_list.size() + fit_list.size() );
+        points.insert( points.end(), corner_list.begin(), corner_list.end() );
+        points.insert( points.end(), fit_list.begin(), fit_list.end() );
+
+        nodes.unique_add_batch( points, indices );
     }
 }
 
@@ -76,6 +76,11 @@ void TGConstruct::CalcElevations( void )
     nodes.CalcElevations( TG_NODE_INTERPOLATED );
     nodes.get_geod_nodes(raw_nodes);
 
+    // flattening measures across single triangles - well within the frame.
+    // The distances differ from SGGeodesy by up to its tolerance, so the
+    // flattened elevations below by 0.3 times that at most
+    tgLocalFrame frame( SGGeod::fromDeg( bucket.get_center_lon(), bucket.get_center_lat() ) );
+
     // now flatten some stuff
     for (unsigned int area = 0; area < area_defs.size(); area++) {
         if ( area_defs.is_lake_area(area) ) {
@@ -125,17 +130,17 @@ void TGConstruct::CalcElevations( void )
                     if ( min == e1 ) {
                         d1 = 0.0f;
                     } else {
-                        d1 = SGGeodesy::distanceM( src, raw_nodes[n1] );
+                        d1 = frame.DistanceM( src, raw_nodes[n1] );
                     }
                     if ( min == e2 ) {
                         d2 = 0.0f;
                     } else {
-                        d2 = SGGeodesy::distanceM( src, raw_nodes[n2] );
+                        d2 = frame.DistanceM( src, raw_nodes[n2] );
                     }
                     if ( min == e3 ) {
                         d3 = 0.0f;
                     } else {
-                        d3 = SGGeodesy::distanceM( src, raw_nodes[n3] );
+                        d3 = frame.DistanceM( src, raw_nodes[n3] );
                     }
 
                     double max1 = d1 * 0.20 + min;
@@ -172,17 +177,17 @@ void TGConstruct::CalcElevations( void )
                     if ( min == e1 ) {
                         d1 = 0.0f;
                     } else {
-                        d1 = SGGeodesy::distanceM( src, raw_nodes[n1] );
+                        d1 = frame.DistanceM( src, raw_nodes[n1] );
                     }
                     if ( min == e2 ) {
                         d2 = 0.0f;
                     } else {
-                        d2 = SGGeodesy::distanceM( src, raw_nodes[n2] );
+                        d2 = frame.DistanceM( src, raw_nodes[n2] );
                     }
                     if ( min == e3 ) {
                         d3 = 0.0f;
                     } else {
-                        d3 = SGGeodesy::distanceM( src, raw_nodes[n3] );
+                        d3 = frame.DistanceM( src, raw_nodes[n3] );
                     }
 
                     double max1 = d1 * 0.30 + min;
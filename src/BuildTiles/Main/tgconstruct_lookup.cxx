@@ -51,8 +51,12 @@ void TGConstruct::LookupUnusedNodes( void )
 // This function populates the Superpoly tri_idx polygon.
 // This polygon is a mirror of tris, except the verticies are
 // indexes into the node array (cast as unsigned long)
+// The indexed tesselator already sets the index of every vertex, so
+// this only looks up the vertices that are still missing one.
 void TGConstruct::LookupNodesPerVertex( void )
 {
+    unsigned int missing = 0;
+
     // for each node, traverse all the triangles - and create face lists
     for ( unsigned int area = 0; area < area_defs.size(); area++ ) {
         for( unsigned int p = 0; p < polys_clipped.area_size(area); p++ ) {
@@ -60,6 +64,11 @@ void TGConstruct::LookupNodesPerVertex( void )
 
             for (unsigned int tri=0; tri < poly.Triangles(); tri++) {
                 for (unsigned int vertex = 0; vertex < 3; vertex++) {
+                    if ( poly.GetTriIdx( tri, vertex ) >= 0 ) {
+                        continue;
+                    }
+
+                    missing++;
                     int idx = nodes.find( poly.GetTriNode( tri, vertex ) );
                     if (idx >= 0) {
                         poly.SetTriIdx( tri, vertex, idx );
@@ -71,21 +80,12 @@ void TGConstruct::LookupNodesPerVertex( void )
             }
         }
     }
+
+    SG_LOG(SG_GENERAL, SG_DEBUG, "LookupNodesPerVertex: looked up " << missing << " vertices" );
 }
 
 void TGConstruct::LookupFacesPerNode( void )
 {
     // Add each face that includes a node to the node's face list
-    for ( unsigned int area = 0; area < area_defs.size(); area++ ) {
-        for( unsigned int p = 0; p < polys_clipped.area_size(area); p++ ) {
-            tgPolygon const& poly = polys_clipped.get_poly(area, p );
-
-            for (unsigned int tri=0; tri < poly.Triangles(); tri++) {
-                for (int v = 0; v < 3; v++) {
-                    int i = poly.GetTriIdx( tri, v );
-                    nodes.AddFace( i, area, p, tri );
-                }
-            }
-        }
-    }
+    face_adjacency.Build( polys_clipped, nodes );
 }
@@ -26,6 +26,8 @@
 
 #include <simgear/debug/logstream.hxx>
 
+#include <terragear/tg_normals.hxx>
+
 #include "tgconstruct.hxx"
 
 SGVec3f TGConstruct::calc_normal( double area, const SGVec3d& p1, const SGVec3d& p2, const SGVec3d& p3 ) const {
@@ -66,60 +68,52 @@ SGVec3f TGConstruct::calc_normal( double area, const SGVec3d& p1, const SGVec3d&
     return normal;
 }
 
-void TGConstruct::calc_normals( std::vector<SGGeod>& geod_nodes, std::vector<SGVec3d>& wgs84_nodes, tgPolygon& poly ) {
-    // for each face in the superpoly, calculate a face normal
-    SGVec3f     normal;
-    double      area;
-
-    for (unsigned int tri = 0; tri < poly.Triangles(); tri++) {
-        SGGeod g1 = geod_nodes[ poly.GetTriIdx( tri, 0 ) ];
-        SGGeod g2 = geod_nodes[ poly.GetTriIdx( tri, 1 ) ];
-        SGGeod g3 = geod_nodes[ poly.GetTriIdx( tri, 2 ) ];
-
-        SGVec3d v1 = wgs84_nodes[ poly.GetTriIdx( tri, 0 ) ];
-        SGVec3d v2 = wgs84_nodes[ poly.GetTriIdx( tri, 1 ) ];
-        SGVec3d v3 = wgs84_nodes[ poly.GetTriIdx( tri, 2 ) ];
-
-        area   = tgTriangle::area( g1, g2, g3 );
-        normal = calc_normal( area, v1, v2, v3 );
-
-        poly.SetTriFaceArea( tri, area );
-        poly.SetTriFaceNormal( tri, normal );
-    }
-}
-
 void TGConstruct::CalcFaceNormals( void )
 {
     // traverse the superpols, and calc normals for each tri within
-    std::vector<SGVec3d> wgs84_nodes;
-    nodes.get_wgs84_nodes( wgs84_nodes );
-
-    std::vector<SGGeod>  geod_nodes;
-    nodes.get_geod_nodes( geod_nodes );
+    tgNormalNodeArrays node_arrays( nodes );
 
     for (unsigned int area = 0; area < area_defs.size(); area++) {
         for (unsigned int p = 0; p < polys_clipped.area_size(area); p++ ) {
             SG_LOG( SG_CLIPPER, SG_DEBUG, "Calculating face normals for " << area_defs.get_area_name(area) << ":" << p+1 << " of " << polys_in.area_size(area) );
-            calc_normals( geod_nodes, wgs84_nodes, polys_clipped.get_poly( area, p ) );
+            tgCalcFaceNormals( node_arrays, polys_clipped.get_poly( area, p ) );
         }
     }
 }
 
 void TGConstruct::CalcPointNormals( void )
 {
-    // traverse triangle structure building the face normal table
-    SGVec3f normal;
-    double  face_area;
-
-    std::vector<SGVec3d> wgs84_nodes;
-    nodes.get_wgs84_nodes( wgs84_nodes );
+    // flatten the area weighted face normals, so each node's faces
+    // can be summed straight out of the face_adjacency rows
+    std::vector< std::vector<unsigned int> > poly_base( area_defs.size() );
+    std::vector<float>  wnx, wny, wnz;
+    std::vector<double> wa;
+
+    for ( unsigned int area = 0; area < area_defs.size(); area++ ) {
+        poly_base[area].resize( polys_clipped.area_size(area) );
+        for ( unsigned int p = 0; p < polys_clipped.area_size(area); p++ ) {
+            tgPolygon const& poly = polys_clipped.get_poly( area, p );
+
+            poly_base[area][p] = wa.size();
+            for ( unsigned int tri = 0; tri < poly.Triangles(); tri++ ) {
+                SGVec3f normal   = poly.GetTriFaceNormal( tri );
+                double face_area = poly.GetTriFaceArea( tri );
+
+                normal *= face_area;    // scale normal weight relative to area
+                wnx.push_back( normal.x() );
+                wny.push_back( normal.y() );
+                wnz.push_back( normal.z() );
+                wa.push_back( face_area );
+            }
+        }
+    }
 
     unsigned int one_percent = nodes.size() / 100;
     unsigned int cur_percent = 1;
 
     for ( unsigned int i = 0; i<nodes.size(); i++ ) {
         TGNode const& node = nodes.get_node( i );
-        TGFaceList const& faces  = node.GetFaces();
+        unsigned int num_faces = face_adjacency.NumFaces( i );
         TGNeighborFaces const* neighbor_faces = NULL;
         double total_area = 0.0;
 
@@ -132,17 +126,12 @@ void TGConstruct::CalcPointNormals( void )
         }
 
         // for each triangle that shares this node
-        for ( unsigned int j = 0; j < faces.size(); ++j ) {
-            unsigned int at      = faces[j].area;
-            unsigned int poly    = faces[j].poly;
-            unsigned int tri     = faces[j].tri;
+        for ( unsigned int j = 0; j < num_faces; ++j ) {
+            TGFaceLookup const& face = face_adjacency.GetFace( i, j );
+            unsigned int f = poly_base[face.area][face.poly] + face.tri;
 
-            normal     = polys_clipped.get_face_normal( at, poly, tri );
-            face_area  = polys_clipped.get_face_area( at, poly, tri );
-
-            normal *= face_area;    // scale normal weight relative to area
-            total_area += face_area;
-            average += normal;
+            total_area += wa[f];
+            average += SGVec3f( wnx[f], wny[f], wnz[f] );
         }
 
         // if this node exists in the shared edge db, add the faces from the neighbooring tile
@@ -150,8 +139,8 @@ void TGConstruct::CalcPointNormals( void )
         if ( neighbor_faces ) {
             int num_faces = neighbor_faces->face_areas.size();
             for ( int j = 0; j < num_faces; j++ ) {
-                normal    = neighbor_faces->face_normals[j];
-                face_area = neighbor_faces->face_areas[j];
+                SGVec3f normal   = neighbor_faces->face_normals[j];
+                double face_area = neighbor_faces->face_areas[j];
 
                 normal *= face_area;
                 total_area += face_area;
@@ -162,4 +151,4 @@ void TGConstruct::CalcPointNormals( void )
         average /= total_area;
         nodes.SetNormal( i, average );
     }
-}
\ No newline at end of file
+}
@@ -30,6 +30,7 @@
 #include <simgear/io/sg_binobj.hxx>
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/lowlevel.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include "tgconstruct.hxx"
 
@@ -67,7 +68,7 @@ void TGConstruct::CreateMatchedEdgeFiles( std::vector<SGBucket>& bucketList )
         filepath = share_base + "/match1/" + b.gen_base_path() + "/" + b.gen_index_str() + "_edges";
         SGPath file2(filepath);
         
-        lock->lock();
+        SGGuard<SGMutex> g( *lock );
         
         file2.create_dir( 0755 );
         
@@ -112,8 +113,6 @@ void TGConstruct::CreateMatchedEdgeFiles( std::vector<SGBucket>& bucketList )
         }        
         
         gzclose(fp);
-        
-        lock->unlock();
     }
 }
 
@@ -189,7 +188,7 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             filepath = share_base + "/stage1/" + bucket.gen_base_path() + "/" + bucket.gen_index_str() + "_edges";
             SGPath file(filepath);
 
-            lock->lock();
+            SGGuard<SGMutex> g( *lock );
             
             file.create_dir( 0755 );
 
@@ -230,8 +229,6 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             }
 
             gzclose(fp);
-            
-            lock->unlock();
         }
         break;
 
@@ -250,10 +247,12 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             string dir;
             string file_north, file_south, file_east, file_west;
             gzFile fp;
-            std::vector<SGGeod> north, south, east, west;
+            std::vector<unsigned int> north, south, east, west;
             int nCount;
 
-            nodes.get_geod_edge( bucket, north, south, east, west );
+            // use the node indices, so we write the current ( calculated ) elevation
+            // and don't need to look each node up again to get its faces
+            nodes.get_nodes_edge( bucket, north, south, east, west );
 
             dir  = share_base + "/stage2/" + bucket.gen_base_path();
             file_north = dir + "/" + bucket.gen_index_str() + "_north_edge";
@@ -264,7 +263,7 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             SGPath sgp( dir );
             sgp.append( "dummy" );
             
-            lock->lock();
+            SGGuard<SGMutex> g( *lock );
             sgp.create_dir( 0755 );
 
             // north edge
@@ -278,7 +277,7 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             sgWriteInt( fp, nCount );
             for (int i=0; i<nCount; i++) {
                 // write the 3d point
-                sgWriteGeod( fp, north[i] );
+                sgWriteGeod( fp, nodes[ north[i] ].GetPosition() );
                 WriteNeighborFaces( fp, north[i] );
             }
             gzclose(fp);
@@ -293,7 +292,7 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             nCount = south.size();
             sgWriteInt( fp, nCount );
             for (int i=0; i<nCount; i++) {
-                sgWriteGeod( fp, south[i] );
+                sgWriteGeod( fp, nodes[ south[i] ].GetPosition() );
                 WriteNeighborFaces( fp, south[i] );
             }
             gzclose(fp);
@@ -308,7 +307,7 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             nCount = east.size();
             sgWriteInt( fp, nCount );
             for (int i=0; i<nCount; i++) {
-                sgWriteGeod( fp, east[i] );
+                sgWriteGeod( fp, nodes[ east[i] ].GetPosition() );
                 WriteNeighborFaces( fp, east[i] );
             }
             gzclose(fp);
@@ -323,12 +322,10 @@ void TGConstruct::SaveSharedEdgeData( int stage )
             nCount = west.size();
             sgWriteInt( fp, nCount );
             for (int i=0; i<nCount; i++) {
-                sgWriteGeod( fp, west[i] );
+                sgWriteGeod( fp, nodes[ west[i] ].GetPosition() );
                 WriteNeighborFaces( fp, west[i] );
             }
             gzclose(fp);
-            
-            lock->unlock();
         }
         break;
     }
@@ -430,29 +427,28 @@ void TGConstruct::LoadSharedEdgeData( int stage )
 }
 
 // Neighbor faces
-void TGConstruct::WriteNeighborFaces( gzFile& fp, const SGGeod& pt ) const
+void TGConstruct::WriteNeighborFaces( gzFile& fp, unsigned int idx ) const
 {
     // find all neighboors of this point
-    int               n     = nodes.find( pt );
-    TGNode const&     node  = nodes.get_node( n );
-    TGFaceList const& faces = node.GetFaces();
+    unsigned int num_faces = face_adjacency.NumFaces( idx );
 
     // write the number of neighboor faces
-    sgWriteInt( fp, faces.size() );
+    sgWriteInt( fp, num_faces );
 
     // write out each face normal and size
-    for (unsigned int j=0; j<faces.size(); j++) {
+    for (unsigned int j=0; j<num_faces; j++) {
         // for each connected face, get the nodes
-        unsigned int tri      = faces[j].tri;
-        tgPolygon const& poly = polys_clipped.get_poly( faces[j].area, faces[j].poly );
+        TGFaceLookup const& face = face_adjacency.GetFace( idx, j );
+        unsigned int tri      = face.tri;
+        tgPolygon const& poly = polys_clipped.get_poly( face.area, face.poly );
 
         SGGeod const& p1 = nodes[ poly.GetTriIdx( tri, 0) ].GetPosition();
         SGGeod const& p2 = nodes[ poly.GetTriIdx( tri, 1) ].GetPosition();
         SGGeod const& p3 = nodes[ poly.GetTriIdx( tri, 2) ].GetPosition();
 
         SGVec3d const& wgs_p1 = nodes[ poly.GetTriIdx( tri, 0) ].GetWgs84();
-        SGVec3d const& wgs_p2 = nodes[ poly.GetTriIdx( tri, 0) ].GetWgs84();
-        SGVec3d const& wgs_p3 = nodes[ poly.GetTriIdx( tri, 0) ].GetWgs84();
+        SGVec3d const& wgs_p2 = nodes[ poly.GetTriIdx( tri, 1) ].GetWgs84();
+        SGVec3d const& wgs_p3 = nodes[ poly.GetTriIdx( tri, 2) ].GetWgs84();
 
         double  face_area   = tgTriangle::area( p1, p2, p3 );
         SGVec3f face_normal = calc_normal( face_area, wgs_p1, wgs_p2, wgs_p3 );
@@ -466,11 +462,9 @@ TGNeighborFaces* TGConstruct::FindNeighborFaces( const SGGeod& node )
 {
     TGNeighborFaces* faces = NULL;
 
-    for (unsigned int i=0; i<neighbor_faces.size(); i++) {
-        if ( node == neighbor_faces[i].node ) {
-            faces = &neighbor_faces[i];
-            break;
-        }
+    neighbor_face_map::const_iterator it = neighbor_face_lookup.find( tgNeighborFaceKey( node ) );
+    if ( it != neighbor_face_lookup.end() ) {
+        faces = &neighbor_faces[it->second];
     }
 
     return faces;
@@ -481,6 +475,7 @@ TGNeighborFaces* TGConstruct::AddNeighborFaces( const SGGeod& node )
     TGNeighborFaces faces;
     faces.node = node;
 
+    neighbor_face_lookup[ tgNeighborFaceKey( node ) ] = neighbor_faces.size();
     neighbor_faces.push_back( faces );
 
     return &neighbor_faces[neighbor_faces.size()-1];
@@ -553,7 +548,7 @@ void TGConstruct::SaveToIntermediateFiles( int stage )
                 file_clipped = dir + "/" + bucket.gen_index_str() + "_clipped_polys";
                 file_nodes = dir + "/" + bucket.gen_index_str() + "_nodes";
                 
-                lock->lock();                
+                SGGuard<SGMutex> g( *lock );
                 
                 sgp.create_dir( 0755 );
                 if ( (fp = gzopen( file_clipped.c_str(), "wb9" )) == NULL ) {
@@ -571,8 +566,6 @@ void TGConstruct::SaveToIntermediateFiles( int stage )
                 sgClearWriteError();
                 nodes.SaveToGzFile( fp );
                 gzclose( fp );
-                
-                lock->unlock();
             }
 
             break;
@@ -588,7 +581,7 @@ void TGConstruct::SaveToIntermediateFiles( int stage )
                 file_clipped = dir + "/" + bucket.gen_index_str() + "_clipped_polys";
                 file_nodes = dir + "/" + bucket.gen_index_str() + "_nodes";
                 
-                lock->lock();
+                SGGuard<SGMutex> g( *lock );
                 sgp.create_dir( 0755 );
 
                 if ( (fp = gzopen( file_clipped.c_str(), "wb9" )) == NULL ) {
@@ -606,8 +599,6 @@ void TGConstruct::SaveToIntermediateFiles( int stage )
                 sgClearWriteError();
                 nodes.SaveToGzFile( fp );
                 gzclose( fp );
-                
-                lock->unlock();
             }
             break;
         }
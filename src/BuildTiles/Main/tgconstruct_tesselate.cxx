@@ -61,7 +61,9 @@ void TGConstruct::TesselatePolys( void )
                 SG_LOG( SG_CLIPPER, SG_INFO, poly );
             }
 
-            poly.Tesselate( poly_extra, IsDebugShape(poly.GetId()) );
+            // the triangles come out with the index of each node already
+            // in the node list - LookupNodesPerVertex finds the others
+            poly.Tesselate( nodes, poly_extra, IsDebugShape(poly.GetId()) );
 
             polys_clipped.set_poly( area, p, poly );
         }
@@ -0,0 +1,196 @@
+// test-buffer-line.cxx - the width and area of tgContour::BufferLine, on
+// straight and bent lines up to 20 km long, at the equator and far north.
+// Each node of the buffered polygon must be half the width from the line,
+// and the area must match the line length times the width, and the segment
+// quads of ExpandToPolygons.  Also times both.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/math/sg_geodesy.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tg_contour.hxx"
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+static const double width = 10.0;
+
+// meters east and north of origin, by the geodesic to it
+static SGVec2d ToXY( const SGGeod& origin, const SGGeod& p )
+{
+    double az1, az2, dist;
+
+    SGGeodesy::inverse( origin, p, az1, az2, dist );
+
+    return SGVec2d( dist * sin( az1 * SG_DEGREES_TO_RADIANS ), dist * cos( az1 * SG_DEGREES_TO_RADIANS ) );
+}
+
+// area in square meters, boundaries minus holes
+static double AreaM2( const tgPolygon& poly, const SGGeod& origin )
+{
+    double area = 0.0;
+
+    for ( unsigned int i = 0; i < poly.Contours(); i++ ) {
+        tgContour contour = poly.GetContour(i);
+        double    a = 0.0;
+
+        for ( unsigned int j = 0; j < contour.GetSize(); j++ ) {
+            SGVec2d p = ToXY( origin, contour.GetNode(j) );
+            SGVec2d q = ToXY( origin, contour.GetNode( (j+1) % contour.GetSize() ) );
+
+            a += p.x() * q.y() - q.x() * p.y();
+        }
+        area += contour.GetHole() ? -fabs( a ) / 2.0 : fabs( a ) / 2.0;
+    }
+
+    return area;
+}
+
+// distance of p from the line, each segment measured from its start
+static double DistanceFromLine( const tgContour& line, const SGGeod& p )
+{
+    double min_dist = 1.0e30;
+
+    for ( unsigned int i = 0; i + 1 < line.GetSize(); i++ ) {
+        SGVec2d b = ToXY( line.GetNode(i), line.GetNode(i+1) );
+        SGVec2d q = ToXY( line.GetNode(i), p );
+        double  t = std::min( std::max( dot( q, b ) / dot( b, b ), 0.0 ), 1.0 );
+
+        min_dist = std::min( min_dist, norm( q - t * b ) );
+    }
+
+    return min_dist;
+}
+
+// num segments of length, each turned by up to max_turn degrees
+static tgContour MakeLine( const SGGeod& start, double heading, unsigned int num, double length, double max_turn )
+{
+    tgContour line;
+    SGGeod    p = start;
+
+    line.AddNode( p );
+    for ( unsigned int i = 0; i < num; i++ ) {
+        heading += max_turn * ( 2.0 * rand() / RAND_MAX - 1.0 );
+        p = SGGeodesy::direct( p, heading, length );
+        line.AddNode( p );
+    }
+
+    return line;
+}
+
+static double LineLength( const tgContour& line )
+{
+    double length = 0.0;
+
+    for ( unsigned int i = 0; i + 1 < line.GetSize(); i++ ) {
+        length += SGGeodesy::distanceM( line.GetNode(i), line.GetNode(i+1) );
+    }
+
+    return length;
+}
+
+static unsigned int Check( const std::string& what, const tgContour& line, double max_turn )
+{
+    unsigned int failed = 0;
+    tgPolygon    buffered = tgContour::BufferLine( line, width );
+    SGGeod       origin = line.GetNode( line.GetSize() / 2 );
+
+    // the outside of a miter join is further out
+    double min_dist = 1.0e30, max_dist = 0.0;
+    double max_allowed = width / 2.0 / cos( max_turn / 2.0 * SG_DEGREES_TO_RADIANS ) + 0.005;
+
+    for ( unsigned int i = 0; i < buffered.Contours(); i++ ) {
+        for ( unsigned int j = 0; j < buffered.GetContour(i).GetSize(); j++ ) {
+            double d = DistanceFromLine( line, buffered.GetContour(i).GetNode(j) );
+
+            min_dist = std::min( min_dist, d );
+            max_dist = std::max( max_dist, d );
+        }
+    }
+
+    double area = AreaM2( buffered, origin );
+    double expected = LineLength( line ) * width;
+
+    tgpolygon_list quads = tgContour::ExpandToPolygons( line, width );
+    double         quads_area = 0.0;
+    for ( unsigned int i = 0; i < quads.size(); i++ ) {
+        quads_area += AreaM2( quads[i], origin );
+    }
+
+    cout << what << " : " << buffered.Contours() << " contours, nodes " << min_dist << " to " << max_dist
+         << " m from the line, area " << area << " m2, length x width " << expected << " m2, quads " << quads_area << " m2" << endl;
+
+    if ( buffered.Contours() != 1 || min_dist < width / 2.0 - 0.005 || max_dist > max_allowed ) {
+        cout << "  " << what << " : not " << width << " m wide" << endl;
+        failed++;
+    }
+    if ( fabs( area - expected ) > 1.0e-3 * expected || fabs( area - quads_area ) > 1.0e-2 * quads_area ) {
+        cout << "  " << what << " : area differs" << endl;
+        failed++;
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 5 );
+
+    double lats[]     = { 0.0, 45.0, 70.0 };
+    double headings[] = { 0.0, 45.0, 90.0 };
+
+    for ( unsigned int l = 0; l < 3; l++ ) {
+        SGGeod start = SGGeod::fromDeg( 10.0, lats[l] );
+
+        for ( unsigned int h = 0; h < 3; h++ ) {
+            std::ostringstream what;
+            what << "lat " << lats[l] << ", heading " << headings[h];
+
+            failed += Check( what.str() + ", 2 km straight", MakeLine( start, headings[h], 4, 500.0, 0.0 ), 0.0 );
+            failed += Check( what.str() + ", 20 km straight", MakeLine( start, headings[h], 40, 500.0, 0.0 ), 0.0 );
+            failed += Check( what.str() + ", 20 km bent", MakeLine( start, headings[h], 100, 200.0, 30.0 ), 30.0 );
+        }
+    }
+
+    // roads : lines of 10 segments of 100 m
+    std::vector<tgContour> lines;
+    for ( unsigned int i = 0; i < 20000; i++ ) {
+        SGGeod start = SGGeod::fromDeg( 10.0 + 0.5 * rand() / RAND_MAX, 45.0 + 0.5 * rand() / RAND_MAX );
+        lines.push_back( MakeLine( start, 360.0 * rand() / RAND_MAX, 10, 100.0, 45.0 ) );
+    }
+
+    SGTimeStamp start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < lines.size(); i++ ) {
+        tgContour::BufferLine( lines[i], width );
+    }
+    double buffer_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < lines.size(); i++ ) {
+        tgContour::ExpandToPolygons( lines[i], width );
+    }
+    double quads_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    cout << lines.size() << " lines of 10 segments : BufferLine " << buffer_time << " s, ExpandToPolygons " << quads_time << " s" << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
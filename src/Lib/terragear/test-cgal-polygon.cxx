@@ -0,0 +1,205 @@
+// test-cgal-polygon.cxx - checks the cached CGAL conversion of tgPolygon
+// against the original conversion, which ran every contour through an
+// arrangement.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <iostream>
+#include <list>
+
+#include "tg_arrangement.hxx"
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+// the original conversion
+static bool RefToCgalPolyWithHoles( const tgPolygon& subject, Polygon_set& cgSubject, CGAL::Bbox_2& bb )
+{
+    tgArrangement   arr;
+    Polygon_set     boundaries;
+    Polygon_set     holes;
+
+    for ( unsigned int i = 0; i < subject.Contours(); i++ ) {
+        arr.Clear();
+        arr.Add( subject.GetContour(i) );
+
+        Polygon_set face = arr.ToPolygonSet( i );
+        if ( subject.GetContour(i).GetHole() ) {
+            holes.join( face );
+        } else {
+            boundaries.join( face );
+        }
+    }
+
+    boundaries.difference( holes );
+
+    if ( boundaries.is_valid() ) {
+        std::list<Polygon_with_holes> pwh_list;
+
+        cgSubject = boundaries;
+        cgSubject.polygons_with_holes( std::back_inserter(pwh_list) );
+        bb = CGAL::bbox_2( pwh_list.begin(), pwh_list.end() );
+
+        return true;
+    } else {
+        return false;
+    }
+}
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// a star shaped ( so simple ) contour around center, in either orientation
+static tgContour MakeStar( const SGGeod& center, double radius, bool hole )
+{
+    tgContour    contour;
+    unsigned int sides = 3 + rand() % 20;
+    bool         cw = ( rand() % 2 ) != 0;
+
+    for ( unsigned int i = 0; i < sides; i++ ) {
+        double a = SGD_2PI * ( cw ? sides - i : i ) / sides;
+        double r = radius * ( 0.5 + 0.5 * Random() );
+
+        contour.AddNode( SGGeod::fromDeg( center.getLongitudeDeg() + r * cos( a ),
+                                          center.getLatitudeDeg()  + r * sin( a ) ) );
+    }
+    contour.SetHole( hole );
+
+    return contour;
+}
+
+// a contour crossing itself, as the ones the arrangement is still needed for
+static tgContour MakeBowtie( const SGGeod& center, double radius )
+{
+    tgContour contour;
+    double    lon = center.getLongitudeDeg();
+    double    lat = center.getLatitudeDeg();
+
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat + radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat + radius ) );
+    contour.SetHole( false );
+
+    return contour;
+}
+
+static tgPolygon MakePolygon( void )
+{
+    tgPolygon poly;
+    SGGeod    center = SGGeod::fromDeg( 10.0 * Random(), 10.0 * Random() );
+
+    switch( rand() % 4 ) {
+        case 0:
+            poly.AddContour( MakeStar( center, 0.01, false ) );
+            break;
+
+        case 1:
+            // with a hole well inside
+            poly.AddContour( MakeStar( center, 0.01, false ) );
+            poly.AddContour( MakeStar( center, 0.002, true ) );
+            break;
+
+        case 2:
+            // two boundaries, which may overlap
+            poly.AddContour( MakeStar( center, 0.01, false ) );
+            poly.AddContour( MakeStar( SGGeod::fromDeg( center.getLongitudeDeg() + 0.01 * Random(), center.getLatitudeDeg() ), 0.01, false ) );
+            break;
+
+        case 3:
+            poly.AddContour( MakeBowtie( center, 0.01 ) );
+            break;
+    }
+
+    return poly;
+}
+
+static bool SameSet( const Polygon_set& a, const Polygon_set& b )
+{
+    Polygon_set diff( a );
+
+    diff.symmetric_difference( b );
+
+    return diff.is_empty();
+}
+
+static bool SameBbox( const CGAL::Bbox_2& a, const CGAL::Bbox_2& b )
+{
+    return a.xmin() == b.xmin() && a.ymin() == b.ymin() && a.xmax() == b.xmax() && a.ymax() == b.ymax();
+}
+
+// the conversion of subject against the original one
+static bool CheckConversion( const tgPolygon& subject, const char* what, unsigned int trial )
+{
+    Polygon_set      ref_ps;
+    CGAL::Bbox_2     ref_bbox;
+    bool             ref_valid = RefToCgalPolyWithHoles( subject, ref_ps, ref_bbox );
+    tgCgalPolygonPtr cg = tgGetCgalPolygon( subject );
+
+    if ( cg->valid != ref_valid ) {
+        cout << "  " << what << " trial " << trial << " : valid " << cg->valid << " != " << ref_valid << endl;
+        return false;
+    }
+    if ( ref_valid && !SameSet( cg->ps, ref_ps ) ) {
+        cout << "  " << what << " trial " << trial << " : polygon sets differ" << endl;
+        return false;
+    }
+    if ( ref_valid && !SameBbox( cg->bbox, ref_bbox ) ) {
+        cout << "  " << what << " trial " << trial << " : bounding boxes differ" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 1 );
+
+    for ( unsigned int trial = 0; trial < 500; trial++ ) {
+        tgPolygon poly = MakePolygon();
+
+        if ( !CheckConversion( poly, "converted", trial ) ) {
+            failed++;
+            continue;
+        }
+
+        // copies share the conversion
+        tgPolygon copy = poly;
+        if ( tgGetCgalPolygon( copy ).get() != tgGetCgalPolygon( poly ).get() ) {
+            cout << "  trial " << trial << " : copy converted again" << endl;
+            failed++;
+        }
+
+        // and a change drops it, for the changed polygon only
+        tgCgalPolygonPtr before = tgGetCgalPolygon( poly );
+        SGGeod           node   = copy.GetNode( 0, 0 );
+
+        copy.SetNode( 0, 0, SGGeod::fromDeg( node.getLongitudeDeg() + 0.001, node.getLatitudeDeg() + 0.001 ) );
+        if ( tgGetCgalPolygon( copy ).get() == before.get() || tgGetCgalPolygon( poly ).get() != before.get() ) {
+            cout << "  trial " << trial << " : SetNode didn't drop the conversion of the copy only" << endl;
+            failed++;
+        }
+        if ( !CheckConversion( copy, "changed", trial ) ) {
+            failed++;
+        }
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+// test-cluster.cxx - tgCluster against a copy of the kd-tree and Voronoi
+// diagram clustering it replaced, on chains, lattices, pairs, rings and
+// random clouds with duplicates.  Every node must be moved to the same
+// centroid.  Also times both, and tgCluster alone on a million nodes.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <CGAL/Triangulation_2.h>
+#include <CGAL/Delaunay_triangulation_2.h>
+#include <CGAL/Voronoi_diagram_2.h>
+#include <CGAL/Delaunay_triangulation_adaptation_traits_2.h>
+#include <CGAL/Delaunay_triangulation_adaptation_policies_2.h>
+#include <CGAL/centroid.h>
+#include <CGAL/Dimension.h>
+#include <CGAL/Kd_tree.h>
+#include <CGAL/Fuzzy_sphere.h>
+#include <CGAL/Search_traits_2.h>
+
+#include "tg_cluster.hxx"
+
+using std::cout;
+using std::endl;
+
+// as used by tgSegmentNetwork
+static const double radius = 0.0000025;
+
+typedef CGAL::Delaunay_triangulation_2<EPECKernel>                           RefDT;
+typedef CGAL::Delaunay_triangulation_adaptation_traits_2<RefDT>              RefAT;
+typedef CGAL::Delaunay_triangulation_caching_degeneracy_removal_policy_2<RefDT> RefAP;
+typedef CGAL::Voronoi_diagram_2<RefDT,RefAT,RefAP>                           RefVD;
+typedef CGAL::Search_traits_2<EPECKernel>                                    RefTraits;
+typedef CGAL::Fuzzy_sphere<RefTraits>                                        RefFuzzyCir;
+typedef CGAL::Kd_tree<RefTraits>                                             RefTree;
+
+// The clustering tgCluster replaced, without its console output and
+// shapefile dumps.  It looped forever once the relaxation reached 40
+// iterations - here it stops.  The cell of a located centroid is looked up
+// in a map rather than a linear search : the first cell with it, as before.
+class RefCluster
+{
+public:
+    RefCluster( std::list<EPECPoint_2>& points )
+    {
+        std::vector<EPECPoint_2> oldcentroids( points.begin(), points.end() ), newcentroids;
+        bool                     merged_centroid;
+        CGAL::Dimension_tag<0>   tg;
+
+        do {
+            RefTree tree( oldcentroids.begin(), oldcentroids.end() );
+
+            newcentroids.clear();
+            merged_centroid = false;
+
+            for ( unsigned int i = 0; i < oldcentroids.size(); i++ ) {
+                std::list<EPECPoint_2> query_result;
+                RefFuzzyCir            query_circle( oldcentroids[i], radius );
+
+                tree.search( std::back_inserter( query_result ), query_circle );
+
+                if ( query_result.size() > 1 ) {
+                    EPECPoint_2 cent = CGAL::centroid( query_result.begin(), query_result.end(), tg );
+
+                    if ( std::find( newcentroids.begin(), newcentroids.end(), cent ) == newcentroids.end() ) {
+                        newcentroids.push_back( cent );
+                        merged_centroid = true;
+                    }
+                } else if ( query_result.size() == 1 ) {
+                    newcentroids.push_back( query_result.front() );
+                }
+            }
+
+            oldcentroids = newcentroids;
+        } while ( merged_centroid );
+
+        nodes  = points;
+        cells  = oldcentroids;
+
+        for ( unsigned int iter = 0; iter < 40; iter++ ) {
+            std::vector<EPECPoint_2>                newcells;
+            std::vector< std::vector<EPECPoint_2> > cell_nodes( cells.size() );
+            std::map<EPECPoint_2, unsigned int>     first_cell;
+
+            vd.clear();
+            for ( unsigned int c = 0; c < cells.size(); c++ ) {
+                vd.insert( cells[c] );
+                first_cell.insert( std::make_pair( cells[c], c ) );
+            }
+
+            for ( std::list<EPECPoint_2>::const_iterator it = nodes.begin(); it != nodes.end(); it++ ) {
+                cell_nodes[ first_cell[ Locate( *it ) ] ].push_back( *it );
+            }
+
+            for ( unsigned int c = 0; c < cells.size(); c++ ) {
+                if ( cell_nodes[c].empty() ) {
+                    newcells.push_back( cells[c] );
+                } else {
+                    newcells.push_back( CGAL::centroid( cell_nodes[c].begin(), cell_nodes[c].end(), tg ) );
+                }
+            }
+
+            if ( newcells == cells ) {
+                break;
+            }
+            cells = newcells;
+        }
+    }
+
+    EPECPoint_2 Locate( const EPECPoint_2& point )
+    {
+        RefVD::Locate_result lr = vd.locate( point );
+        EPECPoint_2          q;
+
+        if ( RefVD::Vertex_handle* v = boost::get<RefVD::Vertex_handle>( &lr ) ) {
+            q = (*v)->site(0)->point();
+        } else if ( RefVD::Halfedge_handle* e = boost::get<RefVD::Halfedge_handle>( &lr ) ) {
+            q = (*e)->up()->point();
+        } else if ( RefVD::Face_handle* f = boost::get<RefVD::Face_handle>( &lr ) ) {
+            q = (*f)->dual()->point();
+        }
+
+        return q;
+    }
+
+private:
+    std::list<EPECPoint_2>   nodes;
+    std::vector<EPECPoint_2> cells;
+    RefVD                    vd;
+};
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static EPECPoint_2 Node( double x, double y )
+{
+    return EPECPoint_2( -122.0 + x * radius, 37.0 + y * radius );
+}
+
+// every node must go to the same centroid - returns the number that don't
+static unsigned int Compare( const std::string& what, std::list<EPECPoint_2>& nodes )
+{
+    SGTimeStamp start = SGTimeStamp::now();
+    tgCluster   cluster( nodes, radius );
+    double      new_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    RefCluster  ref( nodes );
+    double      ref_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    unsigned int                      differ = 0;
+    std::map<EPECPoint_2, unsigned int> centroids;
+
+    for ( std::list<EPECPoint_2>::const_iterator it = nodes.begin(); it != nodes.end(); it++ ) {
+        EPECPoint_2 c = cluster.Locate( *it );
+
+        if ( c != ref.Locate( *it ) ) {
+            differ++;
+        }
+        centroids[c]++;
+    }
+
+    cout << what << " : " << nodes.size() << " nodes in " << centroids.size() << " clusters, "
+         << differ << " moved elsewhere, " << new_time << " s, was " << ref_time << " s" << endl;
+
+    return differ ? 1 : 0;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 1 );
+
+    // chains with each node within radius of the next
+    double spacings[] = { 0.5, 0.9, 0.999 };
+    for ( unsigned int s = 0; s < 3; s++ ) {
+        std::list<EPECPoint_2> chain;
+        for ( unsigned int i = 0; i < 100; i++ ) {
+            chain.push_back( Node( i * spacings[s], 0.0 ) );
+        }
+        failed += Compare( "chain", chain );
+    }
+
+    // square and hexagonal lattices : centroids and nodes on the bisectors
+    double lattices[] = { 0.5, 0.7071, 0.75, 1.0 };
+    for ( unsigned int s = 0; s < 4; s++ ) {
+        std::list<EPECPoint_2> square, hex;
+        for ( unsigned int i = 0; i < 12; i++ ) {
+            for ( unsigned int j = 0; j < 12; j++ ) {
+                square.push_back( Node( i * lattices[s], j * lattices[s] ) );
+                hex.push_back( Node( ( i + 0.5 * ( j % 2 ) ) * lattices[s], j * lattices[s] * 0.866 ) );
+            }
+        }
+        failed += Compare( "square lattice", square );
+        failed += Compare( "hexagonal lattice", hex );
+    }
+
+    // pairs of close nodes, far from each other
+    std::list<EPECPoint_2> pairs;
+    for ( unsigned int i = 0; i < 100; i++ ) {
+        pairs.push_back( Node( i * 10.0, 0.0 ) );
+        pairs.push_back( Node( i * 10.0 + 0.5, 0.0 ) );
+    }
+    failed += Compare( "pairs", pairs );
+
+    // rings around a center, and triangles just apart
+    std::list<EPECPoint_2> rings, triangles;
+    for ( unsigned int i = 0; i < 20; i++ ) {
+        rings.push_back( Node( i * 3.0, 0.0 ) );
+        for ( unsigned int a = 0; a < 8; a++ ) {
+            rings.push_back( Node( i * 3.0 + 0.5 * cos( a * SG_PI / 4 ), 0.5 * sin( a * SG_PI / 4 ) ) );
+        }
+
+        triangles.push_back( Node( i * 1.5, 0.0 ) );
+        triangles.push_back( Node( i * 1.5 + 0.6, 0.0 ) );
+        triangles.push_back( Node( i * 1.5 + 0.3, 0.5 ) );
+    }
+    failed += Compare( "rings", rings );
+    failed += Compare( "triangles", triangles );
+
+    // random clouds, sparse to dense, with duplicates
+    double widths[] = { 3.0, 10.0, 40.0 };
+    for ( unsigned int w = 0; w < 3; w++ ) {
+        std::list<EPECPoint_2> cloud;
+        for ( unsigned int i = 0; i < 2000; i++ ) {
+            EPECPoint_2 p = Node( widths[w] * Random(), widths[w] * Random() );
+
+            cloud.push_back( p );
+            if ( i % 10 == 0 ) {
+                cloud.push_back( p );
+            }
+        }
+        failed += Compare( "cloud", cloud );
+    }
+
+    // a million nodes, about as dense as a road network
+    std::list<EPECPoint_2> big;
+    for ( unsigned int i = 0; i < 1000000; i++ ) {
+        big.push_back( Node( 20000.0 * Random(), 20000.0 * Random() ) );
+    }
+    SGTimeStamp start = SGTimeStamp::now();
+    tgCluster   cluster( big, radius );
+    cout << "a million nodes clustered in " << ( SGTimeStamp::now() - start ).toSecs() << " s" << endl;
+
+    // points that weren't clustered go to the nearest centroid, as they did
+    EPECPoint_2 other = Node( 1.0e5, 1.0e5 );
+    if ( tgCluster( pairs, radius ).Locate( other ) != RefCluster( pairs ).Locate( other ) ) {
+        cout << "  an unknown point went to another centroid" << endl;
+        failed++;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
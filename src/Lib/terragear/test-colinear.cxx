@@ -0,0 +1,620 @@
+// test-colinear.cxx - checks the colinear node ( T-Junction ) insertion of
+// tgContour and tgPolygon against the original recursive split, and times
+// the node grid against the bounding box query on a tile of the kind
+// FixTJunctions gets from tg-construct.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "tg_contour.hxx"
+#include "tg_node_grid.hxx"
+#include "tg_nodes.hxx"
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+extern SGGeod InterpolateElevation( const SGGeod& dst_node, const SGGeod& start, const SGGeod& end );
+
+// The original search, as it was in tg_contour.cxx : split the segment at
+// the best fitting node, and search both halves again
+
+static bool RefFindIntermediateNode( const SGGeod& start, const SGGeod& end,
+                                  const std::vector<SGGeod>& nodes, SGGeod& result,
+                                  double bbEpsilon, double errEpsilon )
+{
+    bool found_node = false;
+    double m, m1, b, b1, y_err, x_err, y_err_min, x_err_min;
+
+    SGGeod p0 = start;
+    SGGeod p1 = end;
+
+    double xdist = fabs(p0.getLongitudeDeg() - p1.getLongitudeDeg());
+    double ydist = fabs(p0.getLatitudeDeg()  - p1.getLatitudeDeg());
+
+    x_err_min = xdist + 1.0;
+    y_err_min = ydist + 1.0;
+
+    if ( xdist > ydist ) {
+        // sort these in a sensible order
+        SGGeod p_min, p_max;
+        if ( p0.getLongitudeDeg() < p1.getLongitudeDeg() ) {
+            p_min = p0;
+            p_max = p1;
+        } else {
+            p_min = p1;
+            p_max = p0;
+        }
+
+        m = (p_min.getLatitudeDeg() - p_max.getLatitudeDeg()) / (p_min.getLongitudeDeg() - p_max.getLongitudeDeg());
+        b = p_max.getLatitudeDeg() - m * p_max.getLongitudeDeg();
+
+        for ( int i = 0; i < (int)nodes.size(); ++i ) {
+            // cout << i << endl;
+            SGGeod current = nodes[i];
+
+            if ( (current.getLongitudeDeg() > (p_min.getLongitudeDeg() + (bbEpsilon))) && (current.getLongitudeDeg() < (p_max.getLongitudeDeg() - (bbEpsilon))) ) {
+                y_err = fabs(current.getLatitudeDeg() - (m * current.getLongitudeDeg() + b));
+
+                if ( y_err < errEpsilon ) {
+                    found_node = true;
+                    if ( y_err < y_err_min ) {
+                        result = current;
+                        y_err_min = y_err;
+                    }
+                }
+            }
+        }
+    } else {
+        // sort these in a sensible order
+        SGGeod p_min, p_max;
+        if ( p0.getLatitudeDeg() < p1.getLatitudeDeg() ) {
+            p_min = p0;
+            p_max = p1;
+        } else {
+            p_min = p1;
+            p_max = p0;
+        }
+
+        m1 = (p_min.getLongitudeDeg() - p_max.getLongitudeDeg()) / (p_min.getLatitudeDeg() - p_max.getLatitudeDeg());
+        b1 = p_max.getLongitudeDeg() - m1 * p_max.getLatitudeDeg();
+
+        for ( int i = 0; i < (int)nodes.size(); ++i ) {
+            SGGeod current = nodes[i];
+
+            if ( (current.getLatitudeDeg() > (p_min.getLatitudeDeg() + (bbEpsilon))) && (current.getLatitudeDeg() < (p_max.getLatitudeDeg() - (bbEpsilon))) ) {
+
+                x_err = fabs(current.getLongitudeDeg() - (m1 * current.getLatitudeDeg() + b1));
+
+                if ( x_err < errEpsilon ) {
+                    found_node = true;
+                    if ( x_err < x_err_min ) {
+                        result = current;
+                        x_err_min = x_err;
+                    }
+                }
+            }
+        }
+    }
+
+    return found_node;
+}
+
+static bool RefFindIntermediateNode( const SGGeod& start, const SGGeod& end,
+                                  const std::vector<TGNode*>& nodes, TGNode*& result,
+                                  double bbEpsilon, double errEpsilon )
+{
+    bool found_node = false;
+    double m, m1, b, b1, y_err, x_err, y_err_min, x_err_min;
+
+    SGGeod p0 = start;
+    SGGeod p1 = end;
+
+    double xdist = fabs(p0.getLongitudeDeg() - p1.getLongitudeDeg());
+    double ydist = fabs(p0.getLatitudeDeg()  - p1.getLatitudeDeg());
+
+    x_err_min = xdist + 1.0;
+    y_err_min = ydist + 1.0;
+
+    if ( xdist > ydist ) {
+        // sort these in a sensible order
+        SGGeod p_min, p_max;
+        if ( p0.getLongitudeDeg() < p1.getLongitudeDeg() ) {
+            p_min = p0;
+            p_max = p1;
+        } else {
+            p_min = p1;
+            p_max = p0;
+        }
+
+        m = (p_min.getLatitudeDeg() - p_max.getLatitudeDeg()) / (p_min.getLongitudeDeg() - p_max.getLongitudeDeg());
+        b = p_max.getLatitudeDeg() - m * p_max.getLongitudeDeg();
+
+        for ( int i = 0; i < (int)nodes.size(); ++i ) {
+            // cout << i << endl;
+            SGGeod current = nodes[i]->GetPosition();
+
+            if ( (current.getLongitudeDeg() > (p_min.getLongitudeDeg() + (bbEpsilon))) && (current.getLongitudeDeg() < (p_max.getLongitudeDeg() - (bbEpsilon))) ) {
+                y_err = fabs(current.getLatitudeDeg() - (m * current.getLongitudeDeg() + b));
+
+                if ( y_err < errEpsilon ) {
+                    found_node = true;
+                    if ( y_err < y_err_min ) {
+                        result = nodes[i];
+                        y_err_min = y_err;
+                    }
+                }
+            }
+        }
+    } else {
+        // sort these in a sensible order
+        SGGeod p_min, p_max;
+        if ( p0.getLatitudeDeg() < p1.getLatitudeDeg() ) {
+            p_min = p0;
+            p_max = p1;
+        } else {
+            p_min = p1;
+            p_max = p0;
+        }
+
+        m1 = (p_min.getLongitudeDeg() - p_max.getLongitudeDeg()) / (p_min.getLatitudeDeg() - p_max.getLatitudeDeg());
+        b1 = p_max.getLongitudeDeg() - m1 * p_max.getLatitudeDeg();
+
+        for ( int i = 0; i < (int)nodes.size(); ++i ) {
+            SGGeod current = nodes[i]->GetPosition();
+
+            if ( (current.getLatitudeDeg() > (p_min.getLatitudeDeg() + (bbEpsilon))) && (current.getLatitudeDeg() < (p_max.getLatitudeDeg() - (bbEpsilon))) ) {
+
+                x_err = fabs(current.getLongitudeDeg() - (m1 * current.getLatitudeDeg() + b1));
+
+                if ( x_err < errEpsilon ) {
+                    found_node = true;
+                    if ( x_err < x_err_min ) {
+                        result = nodes[i];
+                        x_err_min = x_err;
+                    }
+                }
+            }
+        }
+    }
+
+    return found_node;
+}
+
+static void RefAddIntermediateNodes( const SGGeod& p0, const SGGeod& p1, const std::vector<SGGeod>& nodes, tgContour& result, double bbEpsilon, double errEpsilon )
+{
+    SGGeod new_pt;
+
+    bool found_extra = RefFindIntermediateNode( p0, p1, nodes, new_pt, bbEpsilon, errEpsilon );
+
+    if ( found_extra ) {
+        RefAddIntermediateNodes( p0, new_pt, nodes, result, bbEpsilon, errEpsilon  );
+
+        result.AddNode( new_pt );
+
+        RefAddIntermediateNodes( new_pt, p1, nodes, result, bbEpsilon, errEpsilon  );
+    }
+}
+
+static void RefAddIntermediateNodes( const SGGeod& p0, const SGGeod& p1, bool preserve3d, std::vector<TGNode*>& nodes, tgContour& result, double bbEpsilon, double errEpsilon )
+{
+    TGNode* new_pt = NULL;
+    SGGeod  new_geode;
+
+    bool found_extra = RefFindIntermediateNode( p0, p1, nodes, new_pt, bbEpsilon, errEpsilon );
+
+    if ( found_extra && new_pt ) {
+        if ( preserve3d ) {
+            // when preserving elevation - it's important not to change the contour
+            // move the new node to the contour, instead of moving the contour to the point
+            tgSegment seg( p0, p1 );
+            new_geode = seg.Project( new_pt->GetPosition() );
+
+            // interpolate the new nodes elevation based on p0, p1
+            new_geode = InterpolateElevation( new_geode, p0, p1 );
+
+            new_pt->SetPosition( new_geode );
+            // new_pt->SetElevation( new_geode.getElevationM() );
+            new_pt->SetType( TG_NODE_FIXED_ELEVATION );
+        }
+
+        RefAddIntermediateNodes( p0, new_pt->GetPosition(), preserve3d, nodes, result, bbEpsilon, errEpsilon  );
+
+        result.AddNode( new_pt->GetPosition() );
+
+        RefAddIntermediateNodes( new_pt->GetPosition(), p1, preserve3d, nodes, result, bbEpsilon, errEpsilon  );
+    }
+}
+
+static tgContour RefAddColinearNodes( const tgContour& subject, const std::vector<SGGeod>& nodes )
+{
+    tgContour result;
+
+    for ( unsigned int n = 0; n < subject.GetSize(); n++ ) {
+        result.AddNode( subject.GetNode( n ) );
+        RefAddIntermediateNodes( subject.GetNode( n ), subject.GetNode( (n+1) % subject.GetSize() ), nodes, result, SG_EPSILON*10, SG_EPSILON*4 );
+    }
+    result.SetHole( subject.GetHole() );
+
+    return result;
+}
+
+static tgContour RefAddColinearNodes( const tgContour& subject, bool preserve3d, std::vector<TGNode*>& nodes )
+{
+    tgContour result;
+
+    for ( unsigned int n = 0; n < subject.GetSize(); n++ ) {
+        result.AddNode( subject.GetNode( n ) );
+        RefAddIntermediateNodes( subject.GetNode( n ), subject.GetNode( (n+1) % subject.GetSize() ), preserve3d, nodes, result, SG_EPSILON*20, SG_EPSILON*15 );
+    }
+    result.SetHole( subject.GetHole() );
+
+    return result;
+}
+
+static bool ByNodeIndex( const TGNode* a, const TGNode* b )
+{
+    return a < b;
+}
+
+// The original FixTJunctions : the nodes in each polygon's bounding box from
+// the k-d tree, then the recursive split on each contour.  The tree reports
+// them in no particular order - here they are put in node order, as the grid
+// returns them, so an exact tie between two nodes picks the same one.
+static void RefFixTJunctions( std::vector<tgPolygon>& polys, TGNodes& nodes )
+{
+    std::vector<TGNode*> points;
+
+    nodes.init_spacial_query();
+    for ( unsigned int p = 0; p < polys.size(); p++ ) {
+        tgRectangle bb = polys[p].GetBoundingBox();
+        tgPolygon   result;
+
+        nodes.get_nodes_inside( bb.getMin(), bb.getMax(), points );
+        std::sort( points.begin(), points.end(), ByNodeIndex );
+
+        result.SetPreserve3D( polys[p].GetPreserve3D() );
+        for ( unsigned int c = 0; c < polys[p].Contours(); c++ ) {
+            result.AddContour( RefAddColinearNodes( polys[p].GetContour( c ), polys[p].GetPreserve3D(), points ) );
+        }
+        polys[p] = result;
+    }
+}
+
+static void FixTJunctions( std::vector<tgPolygon>& polys, TGNodes& nodes )
+{
+    tgNodeGrid grid( nodes );
+
+    for ( unsigned int p = 0; p < polys.size(); p++ ) {
+        polys[p].AddColinearNodes( grid );
+    }
+}
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// the point t along a -> b, moved off to the left of it
+static SGGeod Along( const SGGeod& a, const SGGeod& b, double t, double off )
+{
+    double dx  = b.getLongitudeDeg() - a.getLongitudeDeg();
+    double dy  = b.getLatitudeDeg()  - a.getLatitudeDeg();
+    double len = sqrt( dx*dx + dy*dy );
+
+    return SGGeod::fromDeg( a.getLongitudeDeg() + t * dx - off * dy / len,
+                            a.getLatitudeDeg()  + t * dy + off * dx / len );
+}
+
+// Nodes along a -> b, as clipping leaves them : on it to within about twice
+// errEpsilon, so some are colinear and some are not, and some with a twin
+// closer than bbEpsilon
+static void AddEdgeNodes( const SGGeod& a, const SGGeod& b, unsigned int max_nodes, std::vector<SGGeod>& edge )
+{
+    double       dx  = b.getLongitudeDeg() - a.getLongitudeDeg();
+    double       dy  = b.getLatitudeDeg()  - a.getLatitudeDeg();
+    double       len = sqrt( dx*dx + dy*dy );
+    unsigned int count = rand() % ( max_nodes + 1 );
+    std::vector<double> ts;
+
+    for ( unsigned int i = 0; i < count; i++ ) {
+        double t = 0.02 + 0.96 * Random();
+
+        ts.push_back( t );
+        if ( rand() % 4 == 0 ) {
+            ts.push_back( t + SG_EPSILON * 15 * Random() / len );
+        }
+    }
+    std::sort( ts.begin(), ts.end() );
+
+    for ( unsigned int i = 0; i < ts.size(); i++ ) {
+        edge.push_back( Along( a, b, ts[i], SG_EPSILON * 30 * ( Random() - 0.5 ) ) );
+    }
+}
+
+// A tile as FixTJunctions gets it : a lattice of landclass polygons, where
+// only one of the two polygons on each shared edge has the nodes along it,
+// and long thin road polygons crossing the lattice, with the nodes of the
+// landclass clipped against them lying along their edges.
+static void MakeTile( unsigned int cells, unsigned int roads, std::vector<tgPolygon>& polys, std::vector<SGGeod>& geods )
+{
+    const double size = 0.125;
+    const double step = size / cells;
+    unsigned int dim  = cells + 1;
+
+    std::vector<SGGeod> lattice;
+    for ( unsigned int j = 0; j < dim; j++ ) {
+        for ( unsigned int i = 0; i < dim; i++ ) {
+            lattice.push_back( SGGeod::fromDeg( 10.0 + step * ( i + 0.3 * ( Random() - 0.5 ) ),
+                                                50.0 + step * ( j + 0.3 * ( Random() - 0.5 ) ) ) );
+        }
+    }
+
+    // the nodes along each lattice edge, and which of its two cells has them
+    std::vector< std::vector<SGGeod> > horiz( dim * dim ), vert( dim * dim );
+    std::vector<bool>                  horiz_low( dim * dim ), vert_low( dim * dim );
+    for ( unsigned int j = 0; j < dim; j++ ) {
+        for ( unsigned int i = 0; i < dim; i++ ) {
+            unsigned int k = j * dim + i;
+
+            if ( i < cells ) {
+                AddEdgeNodes( lattice[k], lattice[k + 1], 6, horiz[k] );
+                horiz_low[k] = ( rand() % 2 == 0 );
+            }
+            if ( j < cells ) {
+                AddEdgeNodes( lattice[k], lattice[k + dim], 6, vert[k] );
+                vert_low[k] = ( rand() % 2 == 0 );
+            }
+        }
+    }
+
+    for ( unsigned int j = 0; j < cells; j++ ) {
+        for ( unsigned int i = 0; i < cells; i++ ) {
+            unsigned int k = j * dim + i;
+            tgContour    contour;
+            tgPolygon    poly;
+
+            // counterclockwise : south, east, north, west
+            contour.AddNode( lattice[k] );
+            if ( !horiz_low[k] ) {
+                for ( unsigned int n = 0; n < horiz[k].size(); n++ ) contour.AddNode( horiz[k][n] );
+            }
+            contour.AddNode( lattice[k + 1] );
+            if ( vert_low[k + 1] ) {
+                for ( unsigned int n = 0; n < vert[k + 1].size(); n++ ) contour.AddNode( vert[k + 1][n] );
+            }
+            contour.AddNode( lattice[k + dim + 1] );
+            if ( horiz_low[k + dim] ) {
+                for ( unsigned int n = horiz[k + dim].size(); n > 0; n-- ) contour.AddNode( horiz[k + dim][n - 1] );
+            }
+            contour.AddNode( lattice[k + dim] );
+            if ( !vert_low[k] ) {
+                for ( unsigned int n = vert[k].size(); n > 0; n-- ) contour.AddNode( vert[k][n - 1] );
+            }
+
+            poly.AddContour( contour );
+            polys.push_back( poly );
+        }
+    }
+
+    // roads from the west edge of the tile to the east, 10 m wide
+    for ( unsigned int r = 0; r < roads; r++ ) {
+        std::vector<SGGeod> line;
+        double              lat = 50.0 + size * Random();
+
+        for ( unsigned int n = 0; n <= 200; n++ ) {
+            lat += 0.0005 * ( Random() - 0.5 );
+            line.push_back( SGGeod::fromDeg( 10.0 + size * n / 200.0, lat ) );
+        }
+
+        tgContour contour;
+        for ( unsigned int n = 0; n < line.size(); n++ ) {
+            contour.AddNode( SGGeod::fromDeg( line[n].getLongitudeDeg(), line[n].getLatitudeDeg() - 0.00005 ) );
+        }
+        for ( unsigned int n = line.size(); n > 0; n-- ) {
+            contour.AddNode( SGGeod::fromDeg( line[n - 1].getLongitudeDeg(), line[n - 1].getLatitudeDeg() + 0.00005 ) );
+        }
+
+        // the landclass nodes clipped along the road
+        for ( unsigned int n = 0; n < contour.GetSize(); n++ ) {
+            AddEdgeNodes( contour.GetNode( n ), contour.GetNode( (n + 1) % contour.GetSize() ), 3, geods );
+        }
+
+        tgPolygon poly;
+        poly.AddContour( contour );
+        poly.SetPreserve3D( r % 2 == 1 );
+        polys.push_back( poly );
+    }
+
+    for ( unsigned int p = 0; p < polys.size(); p++ ) {
+        for ( unsigned int c = 0; c < polys[p].Contours(); c++ ) {
+            for ( unsigned int n = 0; n < polys[p].ContourSize( c ); n++ ) {
+                geods.push_back( polys[p].GetNode( c, n ) );
+            }
+        }
+    }
+}
+
+static bool SameGeod( const SGGeod& a, const SGGeod& b )
+{
+    return a.getLongitudeDeg() == b.getLongitudeDeg() &&
+           a.getLatitudeDeg()  == b.getLatitudeDeg()  &&
+           a.getElevationM()   == b.getElevationM();
+}
+
+static bool SameContour( const tgContour& a, const tgContour& b )
+{
+    if ( a.GetSize() != b.GetSize() || a.GetHole() != b.GetHole() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.GetSize(); i++ ) {
+        if ( !SameGeod( a.GetNode( i ), b.GetNode( i ) ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static double Seconds( clock_t ticks )
+{
+    return (double)ticks / CLOCKS_PER_SEC;
+}
+
+// the node grid path used by FixTJunctions
+static bool CheckTile( unsigned int trials, unsigned int cells, unsigned int roads )
+{
+    unsigned int failed = 0;
+    clock_t      ref_ticks = 0, ticks = 0;
+    unsigned int num_nodes = 0;
+
+    for ( unsigned int trial = 0; trial < trials; trial++ ) {
+        std::vector<tgPolygon>    ref_polys, polys;
+        std::vector<SGGeod>       geods;
+        std::vector<unsigned int> indices;
+        TGNodes                   ref_nodes, nodes;
+
+        MakeTile( cells, roads, polys, geods );
+        ref_polys = polys;
+
+        std::vector<SGGeod> points = geods;
+        ref_nodes.unique_add_batch( points, indices );
+        points = geods;
+        nodes.unique_add_batch( points, indices );
+
+        clock_t start = clock();
+        RefFixTJunctions( ref_polys, ref_nodes );
+        ref_ticks += clock() - start;
+
+        start = clock();
+        FixTJunctions( polys, nodes );
+        ticks += clock() - start;
+
+        num_nodes += nodes.size();
+        for ( unsigned int p = 0; p < polys.size(); p++ ) {
+            if ( polys[p].Contours() != ref_polys[p].Contours() ) {
+                cout << "  trial " << trial << " poly " << p << " lost contours" << endl;
+                failed++;
+                continue;
+            }
+            for ( unsigned int c = 0; c < polys[p].Contours(); c++ ) {
+                if ( !SameContour( polys[p].GetContour( c ), ref_polys[p].GetContour( c ) ) ) {
+                    cout << "  trial " << trial << " poly " << p << " contour " << c << " differs" << endl;
+                    failed++;
+                }
+            }
+        }
+
+        // and the preserve3d roads moved the same nodes
+        for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+            if ( !SameGeod( nodes[i].GetPosition(), ref_nodes[i].GetPosition() ) ) {
+                cout << "  trial " << trial << " node " << i << " moved differently" << endl;
+                failed++;
+                break;
+            }
+        }
+    }
+
+    cout << "  " << trials << " tiles of " << cells * cells << " landclass polys, " << roads << " roads, "
+         << num_nodes / trials << " nodes : bounding box query " << Seconds( ref_ticks ) << " s, node grid " << Seconds( ticks ) << " s" << endl;
+
+    return ( failed == 0 );
+}
+
+// the node list paths used by the clipping and cleaning functions, on one
+// polygon of a tile and all of the tile's nodes
+static bool CheckList( unsigned int trials )
+{
+    unsigned int failed = 0;
+    clock_t      ref_ticks = 0, ticks = 0;
+
+    for ( unsigned int trial = 0; trial < trials; trial++ ) {
+        std::vector<tgPolygon> polys;
+        std::vector<SGGeod>    geods;
+
+        MakeTile( 6, 2, polys, geods );
+
+        for ( unsigned int p = 0; p < polys.size(); p++ ) {
+            tgContour contour = polys[p].GetContour( 0 );
+
+            contour.SetHole( p % 2 == 1 );
+
+            clock_t start = clock();
+            tgContour ref = RefAddColinearNodes( contour, geods );
+            ref_ticks += clock() - start;
+
+            start = clock();
+            tgContour result = tgContour::AddColinearNodes( contour, geods );
+            ticks += clock() - start;
+
+            if ( !SameContour( result, ref ) ) {
+                cout << "  trial " << trial << " poly " << p << " differs on the SGGeod list" << endl;
+                failed++;
+            }
+
+            // the TGNode list, moving the nodes onto the contour
+            std::vector<SGGeod>       points = geods;
+            std::vector<unsigned int> indices;
+            TGNodes                   ref_nodes, nodes;
+            std::vector<TGNode*>      ref_list, list;
+
+            ref_nodes.unique_add_batch( points, indices );
+            points = geods;
+            nodes.unique_add_batch( points, indices );
+            for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+                ref_list.push_back( &ref_nodes[i] );
+                list.push_back( &nodes[i] );
+            }
+
+            ref    = RefAddColinearNodes( contour, true, ref_list );
+            result = tgContour::AddColinearNodes( contour, true, list );
+            if ( !SameContour( result, ref ) ) {
+                cout << "  trial " << trial << " poly " << p << " differs on the TGNode list" << endl;
+                failed++;
+            }
+            for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+                if ( !SameGeod( nodes[i].GetPosition(), ref_nodes[i].GetPosition() ) ) {
+                    cout << "  trial " << trial << " poly " << p << " moved node " << i << " differently" << endl;
+                    failed++;
+                    break;
+                }
+            }
+        }
+    }
+    cout << "  original " << Seconds( ref_ticks ) << " s, candidates near each segment " << Seconds( ticks ) << " s" << endl;
+
+    return ( failed == 0 );
+}
+
+int main( int argc, char **argv )
+{
+    bool ok = true;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 1 );
+
+    cout << "node lists : must match the original exactly" << endl;
+    ok &= CheckList( 10 );
+
+    cout << "FixTJunctions, small tiles : must match the original exactly" << endl;
+    ok &= CheckTile( 50, 8, 3 );
+
+    cout << "FixTJunctions, road heavy tile" << endl;
+    ok &= CheckTile( 1, 60, 40 );
+
+    cout << ( ok ? "PASSED" : "FAILED" ) << endl;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,362 @@
+// test-contour-copies.cxx - copies of tgContour and tgPolygon share their
+// nodes until one of them is changed.  Makes random edits to random copies,
+// and after each one checks every copy against its own std::vector of the
+// nodes.  Then the gz files and the text written from those contours, and
+// from polygons of them, must be byte for byte what the vectors write with
+// the code of before the nodes were shared - and stay so through a reload.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/lowlevel.hxx>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tg_contour.hxx"
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+typedef std::vector<SGGeod> NodeList;
+
+// a contour, and what it should hold
+struct Copy
+{
+    tgContour contour;
+    NodeList  nodes;
+    bool      hole;
+};
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static SGGeod RandomNode( void )
+{
+    return SGGeod::fromDegM( 10.0 + Random(), 50.0 + Random(), 1000.0 * Random() );
+}
+
+static bool Matches( const tgContour& contour, const NodeList& nodes, bool hole )
+{
+    if ( contour.GetSize() != nodes.size() || contour.GetHole() != hole ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+        if ( contour.GetNode(i) != nodes[i] ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// tgContour::SaveToGzFile and operator<< on the std::vector they used
+static void RefSaveContour( gzFile& fp, const NodeList& nodes, bool hole )
+{
+    sgWriteUInt( fp, nodes.size() );
+    for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+        sgWriteGeod( fp, nodes[i] );
+    }
+    sgWriteInt( fp, (int)hole );
+}
+
+static void RefPrintContour( std::ostream& output, const NodeList& nodes, bool hole )
+{
+    output << "NumNodes: " << nodes.size() << "\n";
+    for ( unsigned int n = 0; n < nodes.size(); n++ ) {
+        output << nodes[n] << "\n";
+    }
+    output << "Hole: " << hole << "\n";
+}
+
+static string ReadGzFile( const string& path )
+{
+    gzFile fp = gzopen( path.c_str(), "rb" );
+    string contents;
+    char   buffer[4096];
+    int    len;
+
+    if ( fp == NULL ) {
+        return contents;
+    }
+    while ( ( len = gzread( fp, buffer, sizeof(buffer) ) ) > 0 ) {
+        contents.append( buffer, len );
+    }
+    gzclose( fp );
+
+    return contents;
+}
+
+// one random change to copy k - or make it a copy of another
+static void Edit( std::vector<Copy>& copies, unsigned int k )
+{
+    Copy&        c = copies[k];
+    unsigned int size = c.nodes.size();
+    unsigned int i = size ? rand() % size : 0;
+    SGGeod       node = RandomNode();
+
+    switch ( rand() % 11 ) {
+        case 0:
+            c.contour.AddNode( node );
+            c.nodes.push_back( node );
+            break;
+
+        case 1:
+            if ( size ) {
+                c.contour.SetNode( i, node );
+                c.nodes[i] = node;
+            }
+            break;
+
+        case 2:
+            c.contour.InsertNode( node, i );
+            c.nodes.insert( c.nodes.begin() + i, node );
+            break;
+
+        case 3:
+            if ( size ) {
+                c.contour.DelNode( i );
+                c.nodes.erase( c.nodes.begin() + i );
+            }
+            break;
+
+        case 4:
+            if ( size > 2 ) {
+                unsigned int to = i + rand() % ( size - i );
+                c.contour.RemoveNodeRange( i, to );
+                if ( i < to ) {
+                    c.nodes.erase( c.nodes.begin() + i, c.nodes.begin() + to );
+                }
+            }
+            break;
+
+        case 5:
+            c.contour.Reverse();
+            std::reverse( c.nodes.begin(), c.nodes.end() );
+            break;
+
+        case 6:
+            c.contour.Resize( i );
+            c.nodes.resize( i );
+            break;
+
+        case 7:
+            c.contour.SetHole( !c.hole );
+            c.hole = !c.hole;
+            break;
+
+        case 8:
+            if ( rand() % 4 == 0 ) {
+                c.contour.Erase();
+                c.nodes.clear();
+            }
+            break;
+
+        default:
+        {
+            // share the nodes of another copy, or of a copy of one
+            const Copy& other = copies[rand() % copies.size()];
+            tgContour   contour( other.contour );
+
+            c.nodes = other.nodes;
+            c.hole = other.hole;
+            c.contour = contour;
+            break;
+        }
+    }
+}
+
+static unsigned int CheckCopies( void )
+{
+    std::vector<Copy> copies( 8 );
+    unsigned int      failed = 0;
+
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        for ( unsigned int i = 0; i < 20; i++ ) {
+            SGGeod node = RandomNode();
+            copies[k].contour.AddNode( node );
+            copies[k].nodes.push_back( node );
+        }
+        copies[k].hole = false;
+    }
+
+    for ( unsigned int step = 0; step < 100000 && !failed; step++ ) {
+        unsigned int k = rand() % copies.size();
+
+        Edit( copies, k );
+        for ( unsigned int j = 0; j < copies.size(); j++ ) {
+            if ( !Matches( copies[j].contour, copies[j].nodes, copies[j].hole ) ) {
+                cout << "  step " << step << " : an edit to contour " << k << " changed contour " << j << endl;
+                failed++;
+                break;
+            }
+        }
+    }
+
+    // copies of a polygon
+    tgPolygon poly;
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        poly.AddContour( copies[k].contour );
+    }
+    copies[0].contour.AddNode( RandomNode() );
+
+    tgPolygon other = poly;
+    other.SetNode( 1, 0, RandomNode() );
+    other.DeleteContourAt( 2 );
+
+    for ( unsigned int k = 1; k < copies.size(); k++ ) {
+        if ( !Matches( poly.GetContour(k), copies[k].nodes, copies[k].hole ) ) {
+            cout << "  an edit to a copy of the polygon changed contour " << k << endl;
+            failed++;
+        }
+    }
+    if ( poly.ContourSize( 0 ) != copies[0].nodes.size() - 1 ) {
+        cout << "  an edit to an added contour changed the polygon" << endl;
+        failed++;
+    }
+
+    cout << "copies : " << ( failed ? "edits leak into other copies" : "every copy independent" ) << endl;
+
+    return failed;
+}
+
+static unsigned int CheckSerialization( const string& dir )
+{
+    std::vector<Copy> copies( 40 );
+    unsigned int      failed = 0;
+
+    // contours sharing, detached from and made of shared nodes
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        copies[k].hole = false;
+        for ( unsigned int i = 0; i < 10; i++ ) {
+            SGGeod node = RandomNode();
+            copies[k].contour.AddNode( node );
+            copies[k].nodes.push_back( node );
+        }
+    }
+    for ( unsigned int step = 0; step < 2000; step++ ) {
+        Edit( copies, rand() % copies.size() );
+    }
+
+    string new_path = dir + "/new.gz";
+    string ref_path = dir + "/ref.gz";
+    gzFile new_fp = gzopen( new_path.c_str(), "wb9" );
+    gzFile ref_fp = gzopen( ref_path.c_str(), "wb9" );
+
+    std::ostringstream new_text, ref_text;
+
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        copies[k].contour.SaveToGzFile( new_fp );
+        RefSaveContour( ref_fp, copies[k].nodes, copies[k].hole );
+
+        new_text << copies[k].contour;
+        RefPrintContour( ref_text, copies[k].nodes, copies[k].hole );
+    }
+
+    // and a polygon of them, as tgPolygon::SaveToGzFile wrote it
+    tgPolygon poly;
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        poly.AddContour( copies[k].contour );
+    }
+    poly.SetMaterial( "Grass" );
+    poly.SetFlag( "flag" );
+    poly.SaveToGzFile( new_fp );
+
+    sgWriteUInt( ref_fp, copies.size() );
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        RefSaveContour( ref_fp, copies[k].nodes, copies[k].hole );
+    }
+    sgWriteUInt( ref_fp, 0 );
+    poly.GetTexParams().SaveToGzFile( ref_fp );
+    sgWriteString( ref_fp, "Grass" );
+    sgWriteString( ref_fp, "flag" );
+    sgWriteInt( ref_fp, (int)poly.GetPreserve3D() );
+
+    gzclose( new_fp );
+    gzclose( ref_fp );
+
+    string written = ReadGzFile( new_path );
+    if ( written.empty() || written != ReadGzFile( ref_path ) ) {
+        cout << "  the gz file differs" << endl;
+        failed++;
+    }
+    if ( new_text.str() != ref_text.str() ) {
+        cout << "  the text differs" << endl;
+        failed++;
+    }
+
+    // read back, into the same contour each time, and written again
+    tgcontour_list loaded( copies.size() );
+    tgPolygon      loaded_poly;
+    tgContour      contour;
+
+    new_fp = gzopen( new_path.c_str(), "rb" );
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        contour.LoadFromGzFile( new_fp );
+        loaded[k] = contour;
+    }
+    loaded_poly.LoadFromGzFile( new_fp );
+    gzclose( new_fp );
+
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        if ( !Matches( loaded[k], copies[k].nodes, copies[k].hole ) ||
+             !Matches( loaded_poly.GetContour(k), copies[k].nodes, copies[k].hole ) ) {
+            cout << "  contour " << k << " read back differs" << endl;
+            failed++;
+        }
+    }
+
+    new_fp = gzopen( new_path.c_str(), "wb9" );
+    for ( unsigned int k = 0; k < copies.size(); k++ ) {
+        loaded[k].SaveToGzFile( new_fp );
+    }
+    loaded_poly.SaveToGzFile( new_fp );
+    gzclose( new_fp );
+
+    if ( ReadGzFile( new_path ) != written ) {
+        cout << "  the gz file differs once read back" << endl;
+        failed++;
+    }
+
+    unlink( new_path.c_str() );
+    unlink( ref_path.c_str() );
+
+    cout << "serialization : " << written.size() << " bytes, " << ( failed ? "changed" : "unchanged" ) << endl;
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    char         dir_template[] = "/tmp/tg-contour-copies-XXXXXX";
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 9 );
+
+    if ( !mkdtemp( dir_template ) ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+
+    failed += CheckCopies();
+    failed += CheckSerialization( dir_template );
+
+    rmdir( dir_template );
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
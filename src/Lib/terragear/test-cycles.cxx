@@ -0,0 +1,217 @@
+// test-cycles.cxx - checks tgContour::RemoveCycles against the original
+// recursive splitter.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "tg_contour.hxx"
+#include "tg_misc.hxx"
+
+using std::cout;
+using std::endl;
+
+typedef std::vector< std::pair<double, double> > CycleNodes;
+
+// the original splitter : split at the first duplicate node, and recurse
+// on both halves
+static void RefRemoveCycles( const tgContour& subject, tgcontour_list& result )
+{
+    bool split = false;
+
+    if ( subject.GetSize() <= 2 || subject.GetArea() <= SG_EPSILON*SG_EPSILON ) {
+        return;
+    }
+
+    for ( unsigned int i = 0; i < subject.GetSize() && !split; i++ ) {
+        for ( unsigned int j = i + 1; j < subject.GetSize() && !split; j++ ) {
+            if ( SGGeod_isEqual2D( subject.GetNode(i), subject.GetNode(j) ) ) {
+                tgContour first, second;
+
+                split = true;
+
+                // first contour is (0 .. i) + (j+1..size()-1)
+                for ( unsigned int n = 0; n <= i; n++ ) {
+                    first.AddNode( subject.GetNode(n) );
+                }
+                for ( unsigned int n = j + 1; n < subject.GetSize(); n++ ) {
+                    first.AddNode( subject.GetNode(n) );
+                }
+
+                // second contour is (i..j-1)
+                for ( unsigned int n = i; n < j; n++ ) {
+                    second.AddNode( subject.GetNode(n) );
+                }
+
+                first.SetHole( subject.GetHole() );
+                second.SetHole( subject.GetHole() );
+                RefRemoveCycles( first, result );
+                RefRemoveCycles( second, result );
+            }
+        }
+    }
+
+    if ( !split ) {
+        result.push_back( subject );
+    }
+}
+
+// the nodes of a cycle, starting from the smallest one
+static CycleNodes Canonical( const tgContour& contour )
+{
+    CycleNodes nodes, best;
+
+    for ( unsigned int i = 0; i < contour.GetSize(); i++ ) {
+        nodes.push_back( std::make_pair( contour.GetNode(i).getLongitudeDeg(), contour.GetNode(i).getLatitudeDeg() ) );
+    }
+
+    best = nodes;
+    for ( unsigned int r = 0; r < nodes.size(); r++ ) {
+        std::rotate( nodes.begin(), nodes.begin() + 1, nodes.end() );
+        if ( nodes < best ) {
+            best = nodes;
+        }
+    }
+
+    return best;
+}
+
+static std::vector<CycleNodes> Canonical( const tgcontour_list& contours )
+{
+    std::vector<CycleNodes> cycles;
+
+    for ( unsigned int i = 0; i < contours.size(); i++ ) {
+        cycles.push_back( Canonical( contours[i] ) );
+    }
+    std::sort( cycles.begin(), cycles.end() );
+
+    return cycles;
+}
+
+static bool HasDuplicates( const tgContour& contour )
+{
+    for ( unsigned int i = 0; i < contour.GetSize(); i++ ) {
+        for ( unsigned int j = i + 1; j < contour.GetSize(); j++ ) {
+            if ( SGGeod_isEqual2D( contour.GetNode(i), contour.GetNode(j) ) ) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// a contour over a coarse grid, so it touches itself often
+static tgContour MakeTouching( void )
+{
+    tgContour    contour;
+    unsigned int num = 5 + rand() % 40;
+    SGGeod       prev;
+
+    for ( unsigned int i = 0; i < num; i++ ) {
+        SGGeod node = SGGeod::fromDeg( 10.0 + ( rand() % 7 ) * 0.001, 50.0 + ( rand() % 7 ) * 0.001 );
+
+        if ( i == 0 || !SGGeod_isEqual2D( node, prev ) ) {
+            contour.AddNode( node );
+            prev = node;
+        }
+    }
+    contour.SetHole( rand() % 2 != 0 );
+
+    return contour;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    unsigned int supersets = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 7 );
+
+    for ( unsigned int trial = 0; trial < 3000; trial++ ) {
+        tgContour      subject = MakeTouching();
+        tgcontour_list ref, result;
+
+        RefRemoveCycles( subject, ref );
+        tgContour::RemoveCycles( subject, result );
+
+        // every cycle is simple, and keeps the hole flag
+        for ( unsigned int i = 0; i < result.size(); i++ ) {
+            if ( result[i].GetSize() <= 2 || HasDuplicates( result[i] ) || result[i].GetHole() != subject.GetHole() ) {
+                cout << "  trial " << trial << " : cycle " << i << " isn't a simple cycle of the subject" << endl;
+                failed++;
+                break;
+            }
+        }
+
+        // the original cycles, and at most the ones it dropped with a half
+        // of no net area
+        std::vector<CycleNodes> ref_cycles = Canonical( ref );
+        std::vector<CycleNodes> cycles     = Canonical( result );
+
+        if ( !std::includes( cycles.begin(), cycles.end(), ref_cycles.begin(), ref_cycles.end() ) ) {
+            cout << "  trial " << trial << " : " << result.size() << " cycles don't include the original " << ref.size() << endl;
+            failed++;
+        } else if ( cycles != ref_cycles ) {
+            supersets++;
+        }
+    }
+    cout << "random contours : " << supersets << " of 3000 kept cycles the original splitter dropped" << endl;
+
+    // a contour without cycles comes back as is
+    tgContour      square;
+    tgcontour_list same;
+
+    square.AddNode( SGGeod::fromDeg( 10.0, 50.0 ) );
+    square.AddNode( SGGeod::fromDeg( 10.1, 50.0 ) );
+    square.AddNode( SGGeod::fromDeg( 10.1, 50.1 ) );
+    square.AddNode( SGGeod::fromDeg( 10.0, 50.1 ) );
+    if ( tgContour::RemoveCycles( square, same ) || same.size() != 1 || Canonical( same[0] ) != Canonical( square ) ) {
+        cout << "  contour without cycles changed" << endl;
+        failed++;
+    }
+
+    // a long coastline with a few inlets touching it
+    tgContour    coast;
+    unsigned int num = 200000;
+
+    for ( unsigned int i = 0; i < num; i++ ) {
+        double a = SGD_2PI * i / num;
+        double r = 1.0 + 0.01 * sin( a * 500 );
+        SGGeod node = SGGeod::fromDeg( r * cos( a ), r * sin( a ) );
+
+        coast.AddNode( node );
+        if ( i % ( num / 10 ) == num / 20 ) {
+            coast.AddNode( SGGeod::fromDeg( 0.9 * r * cos( a ), 0.9 * r * sin( a ) ) );
+            coast.AddNode( SGGeod::fromDeg( 0.9 * r * cos( a + 0.00001 ), 0.9 * r * sin( a + 0.00001 ) ) );
+            coast.AddNode( node );
+        }
+    }
+
+    tgcontour_list coast_cycles;
+    clock_t        start = clock();
+
+    tgContour::RemoveCycles( coast, coast_cycles );
+    cout << "coastline of " << coast.GetSize() << " nodes : " << coast_cycles.size() << " cycles in "
+         << (double)( clock() - start ) / CLOCKS_PER_SEC << " s" << endl;
+    if ( coast_cycles.size() != 11 ) {
+        failed++;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// test-debug-sink.cxx - a disabled debug checkpoint must not evaluate its
+// dump statement, nor touch the disk.  Runs tgSegmentNetwork, which dumps
+// its stages through TG_DEBUG_SINK, in an empty directory with the sink off,
+// then with it limited to another scope, then to the network's own.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+
+#include "tg_debug_sink.hxx"
+#include "tg_segmentnetwork.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+// files and directories in dir
+static unsigned int CountEntries( const string& dir )
+{
+    unsigned int   count = 0;
+    DIR*           d = opendir( dir.c_str() );
+    struct dirent* entry;
+
+    while ( d && (entry = readdir( d )) != NULL ) {
+        string name = entry->d_name;
+
+        if ( name != "." && name != ".." ) {
+            count++;
+        }
+    }
+    if ( d ) {
+        closedir( d );
+    }
+
+    return count;
+}
+
+// a small crossing network, cleaned in scope
+static void RunNetwork( const string& scope )
+{
+    tgSegmentNetwork net( 1, scope );
+
+    net.Add( SGGeod::fromDeg( -122.0000, 37.0000 ), SGGeod::fromDeg( -122.0010, 37.0010 ), 0.3, 0, 1 );
+    net.Add( SGGeod::fromDeg( -122.0010, 37.0000 ), SGGeod::fromDeg( -122.0000, 37.0010 ), 0.3, 0, 2 );
+    net.Add( SGGeod::fromDeg( -122.0000, 37.0005 ), SGGeod::fromDeg( -122.0010, 37.0005 ), 0.15, 1, 1 );
+    net.Execute();
+}
+
+static unsigned int evaluated = 0;
+
+static void Dump( void )
+{
+    evaluated++;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    char         dir_template[] = "/tmp/tg-debug-sink-XXXXXX";
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+
+    if ( !mkdtemp( dir_template ) || chdir( dir_template ) != 0 ) {
+        cout << "can't create a directory in /tmp" << endl;
+        return 1;
+    }
+
+    // nothing enabled : no statement runs, and the check is one flag test
+    SGTimeStamp start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < 10000000; i++ ) {
+        TG_DEBUG_SINK( "segnet_input", "KSFO", Dump() );
+    }
+    double off_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    RunNetwork( "KSFO_runways" );
+    if ( evaluated || CountEntries( "." ) ) {
+        cout << "  disabled sink : " << evaluated << " statements run, " << CountEntries( "." ) << " files written" << endl;
+        failed++;
+    }
+
+    // every checkpoint, but only for another airport
+    tgDebugSink::EnableScopes( "KLAX" );
+    RunNetwork( "KSFO_runways" );
+    TG_DEBUG_SINK( "segnet_input", "KSFO", Dump() );
+    TG_DEBUG_SINK( "segnet_input", "KSF", Dump() );
+    if ( evaluated || CountEntries( "." ) ) {
+        cout << "  other scope : " << evaluated << " statements run, " << CountEntries( "." ) << " files written" << endl;
+        failed++;
+    }
+
+    // a checkpoint enabled for a tile index
+    tgDebugSink::EnableCheckpoints( "accum" );
+    tgDebugSink::EnableScopes( "958401" );
+    TG_DEBUG_SINK( "accum", 958401L, Dump() );
+    TG_DEBUG_SINK( "accum", 958402L, Dump() );
+    TG_DEBUG_SINK( "segnet_input", 958401L, Dump() );
+    if ( evaluated != 1 ) {
+        cout << "  tile scope : " << evaluated << " statements run, expected 1" << endl;
+        failed++;
+    }
+
+    // and the network's own airport - now the stages are written
+    tgDebugSink::EnableCheckpoints( "segnet_input" );
+    tgDebugSink::EnableScopes( "KSFO" );
+    RunNetwork( "KSFO_runways" );
+    if ( CountEntries( "." ) == 0 ) {
+        cout << "  enabled sink : nothing written" << endl;
+        failed++;
+    }
+
+    cout << "10000000 disabled checks in " << off_time << " s" << endl;
+    cout << "scratch files are in " << dir_template << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
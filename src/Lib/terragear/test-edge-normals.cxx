@@ -0,0 +1,276 @@
+// test-edge-normals.cxx - point normals of two neighboring tiles, summed
+// from tgFaceAdjacency and the faces the other tile shares along the
+// bucket edge, must agree with each other and with the normals of both
+// tiles meshed as one.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "tg_areas.hxx"
+#include "tg_face_adjacency.hxx"
+#include "tg_nodes.hxx"
+#include "tg_polygon.hxx"
+#include "tg_triangle.hxx"
+
+using std::cout;
+using std::endl;
+
+// the faces of an edge node, as stage 2 writes them for the neighbor
+struct SharedFaces
+{
+    std::vector<double>  areas;
+    std::vector<SGVec3f> normals;
+};
+typedef std::map<uint64_t, SharedFaces> SharedFaceMap;
+
+struct Tile
+{
+    TGNodes         nodes;
+    tgAreas         areas;
+    tgFaceAdjacency faces;
+};
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static double Elevation( double lon, double lat )
+{
+    return 100.0 + 50.0 * sin( lon * 200.0 ) * cos( lat * 150.0 );
+}
+
+// calc_normal() of tg-construct, for triangles that aren't degenerate
+static SGVec3f FaceNormal( const TGNodes& nodes, const tgPolygon& poly, unsigned int tri )
+{
+    SGVec3d const& p1 = nodes[ poly.GetTriIdx( tri, 0 ) ].GetWgs84();
+    SGVec3d const& p2 = nodes[ poly.GetTriIdx( tri, 1 ) ].GetWgs84();
+    SGVec3d const& p3 = nodes[ poly.GetTriIdx( tri, 2 ) ].GetWgs84();
+
+    SGVec3f v1( p2.x() - p1.x(), p2.y() - p1.y(), p2.z() - p1.z() );
+    SGVec3f v2( p3.x() - p1.x(), p3.y() - p1.y(), p3.z() - p1.z() );
+
+    return normalize( cross( v1, v2 ) );
+}
+
+static double FaceArea( const TGNodes& nodes, const tgPolygon& poly, unsigned int tri )
+{
+    return tgTriangle::area( nodes[ poly.GetTriIdx( tri, 0 ) ].GetPosition(),
+                             nodes[ poly.GetTriIdx( tri, 1 ) ].GetPosition(),
+                             nodes[ poly.GetTriIdx( tri, 2 ) ].GetPosition() );
+}
+
+// a cells x cells lattice from lon0, lat0, with jittered inner nodes.  The
+// nodes on the west and east edges are at edge_lat, which both tiles share.
+// Triangles alternate between two areas, one poly per row and area.
+static void MakeTile( double lon0, double lat0, double size, unsigned int cells, const std::vector<double>& edge_lat, Tile& tile )
+{
+    std::vector< std::vector<unsigned int> > idx( cells + 1 );
+    std::vector<std::string> names;
+
+    names.push_back( "Grass" );
+    names.push_back( "Forest" );
+    tile.areas.init( 2, names );
+
+    for ( unsigned int i = 0; i <= cells; i++ ) {
+        for ( unsigned int j = 0; j <= cells; j++ ) {
+            double lon = lon0 + i * size;
+            double lat = lat0 + j * size;
+
+            if ( i == 0 || i == cells ) {
+                lat = edge_lat[j];
+            } else if ( j > 0 && j < cells ) {
+                lon += 0.3 * size * ( Random() - 0.5 );
+                lat += 0.3 * size * ( Random() - 0.5 );
+            }
+
+            SGGeod p = SGGeod::fromDegM( lon, lat, Elevation( lon, lat ) );
+            idx[i].push_back( tile.nodes.unique_add( p ) );
+        }
+    }
+
+    for ( unsigned int j = 0; j < cells; j++ ) {
+        tgPolygon row[2];
+
+        for ( unsigned int i = 0; i < cells; i++ ) {
+            unsigned int c[4] = { idx[i][j], idx[i+1][j], idx[i+1][j+1], idx[i][j+1] };
+            tgPolygon&   poly = row[ ( i + j ) % 2 ];
+
+            for ( unsigned int t = 0; t < 2; t++ ) {
+                unsigned int v[3] = { c[0], c[1+t], c[2+t] };
+
+                poly.AddTriangle( tile.nodes[v[0]].GetPosition(), tile.nodes[v[1]].GetPosition(), tile.nodes[v[2]].GetPosition() );
+                for ( unsigned int k = 0; k < 3; k++ ) {
+                    poly.SetTriIdx( poly.Triangles() - 1, k, v[k] );
+                }
+            }
+        }
+        tile.areas.add_poly( 0, row[0] );
+        tile.areas.add_poly( 1, row[1] );
+    }
+
+    tile.faces.Build( tile.areas, tile.nodes );
+}
+
+// what SaveSharedEdgeData writes for the nodes at lon, and ReadNeighborFaces
+// reads back in the other tile.  The elevation written isn't averaged yet,
+// so it differs from the other tile's
+static void ShareEdge( const Tile& tile, double lon, SharedFaceMap& shared )
+{
+    for ( unsigned int n = 0; n < tile.nodes.size(); n++ ) {
+        SGGeod pos = tile.nodes[n].GetPosition();
+        if ( pos.getLongitudeDeg() != lon ) {
+            continue;
+        }
+
+        pos.setElevationM( pos.getElevationM() + 3.0 );
+        SharedFaces& faces = shared[ tgNeighborFaceKey( pos ) ];
+
+        for ( unsigned int j = 0; j < tile.faces.NumFaces( n ); j++ ) {
+            TGFaceLookup const& face = tile.faces.GetFace( n, j );
+            tgPolygon const&    poly = tile.areas.get_poly( face.area, face.poly );
+
+            faces.areas.push_back( FaceArea( tile.nodes, poly, face.tri ) );
+            faces.normals.push_back( FaceNormal( tile.nodes, poly, face.tri ) );
+        }
+    }
+}
+
+// CalcPointNormals() for one node
+static SGVec3f PointNormal( const Tile& tile, const SharedFaceMap& shared, unsigned int n )
+{
+    SGVec3f average( 0.0, 0.0, 0.0 );
+    double  total_area = 0.0;
+
+    for ( unsigned int j = 0; j < tile.faces.NumFaces( n ); j++ ) {
+        TGFaceLookup const& face = tile.faces.GetFace( n, j );
+        tgPolygon const&    poly = tile.areas.get_poly( face.area, face.poly );
+        double              area = FaceArea( tile.nodes, poly, face.tri );
+
+        average    += FaceNormal( tile.nodes, poly, face.tri ) * (float)area;
+        total_area += area;
+    }
+
+    SharedFaceMap::const_iterator it = shared.find( tgNeighborFaceKey( tile.nodes[n].GetPosition() ) );
+    if ( it != shared.end() ) {
+        for ( unsigned int j = 0; j < it->second.areas.size(); j++ ) {
+            average    += it->second.normals[j] * (float)it->second.areas[j];
+            total_area += it->second.areas[j];
+        }
+    }
+
+    return average / (float)total_area;
+}
+
+// the normal at pos, from every triangle of both tiles touching it
+static SGVec3f MergedNormal( const Tile* tiles, const SGGeod& pos )
+{
+    SGVec3f average( 0.0, 0.0, 0.0 );
+    double  total_area = 0.0;
+
+    for ( unsigned int t = 0; t < 2; t++ ) {
+        for ( unsigned int area = 0; area < tiles[t].areas.size(); area++ ) {
+            for ( unsigned int p = 0; p < tiles[t].areas.area_size( area ); p++ ) {
+                tgPolygon const& poly = tiles[t].areas.get_poly( area, p );
+
+                for ( unsigned int tri = 0; tri < poly.Triangles(); tri++ ) {
+                    for ( unsigned int k = 0; k < 3; k++ ) {
+                        SGGeod const& node = tiles[t].nodes[ poly.GetTriIdx( tri, k ) ].GetPosition();
+
+                        if ( node.getLongitudeDeg() == pos.getLongitudeDeg() && node.getLatitudeDeg() == pos.getLatitudeDeg() ) {
+                            double a = FaceArea( tiles[t].nodes, poly, tri );
+
+                            average    += FaceNormal( tiles[t].nodes, poly, tri ) * (float)a;
+                            total_area += a;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return average / (float)total_area;
+}
+
+static bool SameNormal( const SGVec3f& a, const SGVec3f& b )
+{
+    return length( a - b ) < 1.0e-5;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    unsigned int cells  = 40;
+    double       size   = 0.125 / cells;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 9 );
+
+    // two buckets side by side, meeting at lon -121.875
+    double              edge = -121.875;
+    std::vector<double> edge_lat;
+    for ( unsigned int j = 0; j <= cells; j++ ) {
+        double jitter = ( j > 0 && j < cells ) ? 0.3 * size * ( Random() - 0.5 ) : 0.0;
+        edge_lat.push_back( 37.0 + j * size + jitter );
+    }
+
+    Tile tiles[2];
+    MakeTile( edge - 0.125, 37.0, size, cells, edge_lat, tiles[0] );
+    MakeTile( edge,         37.0, size, cells, edge_lat, tiles[1] );
+
+    // each tile gets the faces of the other along the edge
+    SharedFaceMap shared[2];
+    ShareEdge( tiles[1], edge, shared[0] );
+    ShareEdge( tiles[0], edge, shared[1] );
+
+    unsigned int num_edge = 0;
+    for ( unsigned int n = 0; n < tiles[0].nodes.size(); n++ ) {
+        SGGeod  pos    = tiles[0].nodes[n].GetPosition();
+        SGVec3f normal = PointNormal( tiles[0], shared[0], n );
+
+        if ( pos.getLongitudeDeg() != edge ) {
+            // away from the edge, the adjacency alone gives the full sum
+            if ( !SameNormal( normal, MergedNormal( tiles, pos ) ) ) {
+                cout << "  node " << n << " : normal differs from the one of all its faces" << endl;
+                failed++;
+            }
+            continue;
+        }
+
+        num_edge++;
+        int other = tiles[1].nodes.find( pos );
+        if ( other < 0 ) {
+            cout << "  edge node " << n << " : missing in the east tile" << endl;
+            failed++;
+            continue;
+        }
+
+        SGVec3f other_normal = PointNormal( tiles[1], shared[1], other );
+        if ( !SameNormal( normal, other_normal ) ) {
+            cout << "  edge node " << n << " : normals differ across the bucket edge" << endl;
+            failed++;
+        } else if ( !SameNormal( normal, MergedNormal( tiles, pos ) ) ) {
+            cout << "  edge node " << n << " : normal differs from the one of both tiles meshed as one" << endl;
+            failed++;
+        }
+    }
+
+    if ( num_edge != cells + 1 ) {
+        cout << "  " << num_edge << " edge nodes, expected " << cells + 1 << endl;
+        failed++;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+// test-light-groups.cxx - compares tgBuildLightGroups with adding each
+// light on its own, as genapts850 did, and times both on a large airport
+// with dense approach lighting.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+
+#include "tg_light.hxx"
+#include "tg_nodes.hxx"
+#include "tg_surface.hxx"
+#include "tg_unique_vec3f.hxx"
+
+using std::cout;
+using std::endl;
+
+// the original loop of WriteLightsOutput
+static void RefBuildLightGroups( const tglightcontour_list& lights, const tgSurface& surf, TGNodes& nodes, UniqueSGVec3fSet& normals, std::vector<SGBinObjectPoint>& groups )
+{
+    for ( unsigned int i = 0; i < lights.size(); ++i ) {
+        if ( lights[i].ContourSize() ) {
+            SGBinObjectPoint sgboPt;
+
+            sgboPt.material = lights[i].GetType();
+            for ( unsigned int j = 0; j < lights[i].ContourSize(); ++j ) {
+                SGGeod pos = lights[i].GetPosition(j);
+
+                sgboPt.v_list.push_back( nodes.unique_add( pos, TG_NODE_SMOOTHED ) );
+                sgboPt.n_list.push_back( normals.add( lights[i].GetNormal(j) ) );
+            }
+            groups.push_back( sgboPt );
+        }
+    }
+
+    nodes.CalcElevations( TG_NODE_SMOOTHED, surf );
+}
+
+// an approach lighting system : bars of lights every 30 m out from the
+// threshold, and a sequenced flasher on the centre of each bar - the
+// flashers sit on the centre light of the bar
+static void AddApproach( double lon, double lat, double heading, tglightcontour_list& lights )
+{
+    tgLightContour bars, flashers;
+    SGVec3f        normal( 0.0, 0.0, 1.0 );
+    double         dlon = sin( heading ), dlat = cos( heading );
+
+    bars.SetType( "RWY_WHITE_LIGHTS" );
+    flashers.SetType( "RWY_SEQUENCED_LIGHTS" );
+
+    for ( unsigned int bar = 1; bar <= 30; bar++ ) {
+        double d = bar * 0.00027;
+
+        for ( int k = -2; k <= 2; k++ ) {
+            double w = k * 0.000014;
+
+            bars.AddLight( SGGeod::fromDeg( lon - d * dlon + w * dlat, lat - d * dlat - w * dlon ), normal );
+        }
+        flashers.AddLight( SGGeod::fromDeg( lon - d * dlon, lat - d * dlat ), normal );
+    }
+
+    lights.push_back( bars );
+    lights.push_back( flashers );
+}
+
+static tglightcontour_list MakeAirport( unsigned int runways )
+{
+    tglightcontour_list lights;
+
+    for ( unsigned int i = 0; i < runways; i++ ) {
+        double heading = SGD_2PI * ( rand() % 36 ) / 36.0;
+
+        AddApproach( 10.0 + 0.02 * ( rand() % 10 ), 50.0 + 0.02 * ( rand() % 10 ), heading, lights );
+    }
+
+    // and a contour without lights, which makes no group
+    lights.push_back( tgLightContour() );
+
+    return lights;
+}
+
+static bool SameGroups( const std::vector<SGBinObjectPoint>& a, const std::vector<SGBinObjectPoint>& b )
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.size(); i++ ) {
+        if ( a[i].material != b[i].material || a[i].v_list != b[i].v_list || a[i].n_list != b[i].n_list ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool SameNodes( const TGNodes& a, const TGNodes& b )
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.size(); i++ ) {
+        SGGeod pa = a[i].GetPosition();
+        SGGeod pb = b[i].GetPosition();
+
+        if ( pa.getLongitudeDeg() != pb.getLongitudeDeg() || pa.getLatitudeDeg() != pb.getLatitudeDeg() || pa.getElevationM() != pb.getElevationM() ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    bool ok = true;
+
+    // an unfitted surface warns for every query
+    sglog().setLogLevels( SG_ALL, SG_ALERT );
+    srand( 5 );
+
+    tgSurface surf;
+
+    unsigned int sizes[] = { 1, 4, 200 };
+    for ( unsigned int s = 0; s < 3; s++ ) {
+        tglightcontour_list lights = MakeAirport( sizes[s] );
+
+        TGNodes                       ref_nodes, nodes;
+        UniqueSGVec3fSet              ref_normals, normals;
+        std::vector<SGBinObjectPoint> ref_groups, groups;
+
+        clock_t start = clock();
+        RefBuildLightGroups( lights, surf, ref_nodes, ref_normals, ref_groups );
+        clock_t ref_ticks = clock() - start;
+
+        start = clock();
+        tgBuildLightGroups( lights, surf, nodes, normals, groups );
+        clock_t ticks = clock() - start;
+
+        unsigned int num = 0;
+        for ( unsigned int i = 0; i < lights.size(); i++ ) {
+            num += lights[i].ContourSize();
+        }
+
+        cout << sizes[s] << " approach systems, " << num << " lights on " << nodes.size() << " nodes : "
+             << (double)ref_ticks / CLOCKS_PER_SEC << " s one at a time, "
+             << (double)ticks / CLOCKS_PER_SEC << " s batched" << endl;
+
+        if ( !SameGroups( groups, ref_groups ) ) {
+            cout << "  point groups differ" << endl;
+            ok = false;
+        }
+        if ( !SameNodes( nodes, ref_nodes ) ) {
+            cout << "  light nodes differ" << endl;
+            ok = false;
+        }
+        if ( normals.get_list().size() != ref_normals.get_list().size() ) {
+            cout << "  normals differ" << endl;
+            ok = false;
+        }
+    }
+
+    cout << ( ok ? "PASSED" : "FAILED" ) << endl;
+
+    return ok ? 0 : 1;
+}
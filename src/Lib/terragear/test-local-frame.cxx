@@ -0,0 +1,178 @@
+// test-local-frame.cxx - tgLocalFrame against SGGeodesy around origins from
+// the equator to 80 degrees and across the date line.  Distances, ToLocal,
+// FromLocal and the round trip must all be within the frame tolerance, and
+// the calls over vectors the same as one point at a time.  Then times a
+// tile of a million points both ways.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/math/sg_geodesy.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "tg_local_frame.hxx"
+
+using std::cout;
+using std::endl;
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// the points tg-construct measures : within a tile, or about 15 km
+static SGGeod RandomNear( const SGGeod& origin )
+{
+    return SGGeodesy::direct( origin, 360.0 * Random(), 15000.0 * Random() );
+}
+
+static SGVec2d RefToLocal( const SGGeod& origin, const SGGeod& p )
+{
+    double az1, az2, dist;
+
+    SGGeodesy::inverse( origin, p, az1, az2, dist );
+
+    return SGVec2d( dist * sin( az1 * SG_DEGREES_TO_RADIANS ), dist * cos( az1 * SG_DEGREES_TO_RADIANS ) );
+}
+
+static SGGeod RefFromLocal( const SGGeod& origin, const SGVec2d& p )
+{
+    return SGGeodesy::direct( origin, atan2( p.x(), p.y() ) * SG_RADIANS_TO_DEGREES, norm( p ) );
+}
+
+static unsigned int CheckOrigin( const SGGeod& origin )
+{
+    tgLocalFrame         frame( origin );
+    double               tolerance = tgLocalFrame::GetTolerance();
+    double               dist_err = 0.0, to_err = 0.0, from_err = 0.0, round_err = 0.0;
+    std::vector<SGGeod>  geods;
+    std::vector<SGVec2d> points;
+    unsigned int         failed = 0;
+
+    for ( unsigned int i = 0; i < 1000; i++ ) {
+        SGGeod  p = RandomNear( origin );
+        SGGeod  q = RandomNear( origin );
+        SGVec2d v( 24000.0 * Random() - 12000.0, 24000.0 * Random() - 12000.0 );
+
+        dist_err  = std::max( dist_err,  fabs( frame.DistanceM( p, q ) - SGGeodesy::distanceM( p, q ) ) );
+        to_err    = std::max( to_err,    norm( frame.ToLocal( p ) - RefToLocal( origin, p ) ) );
+        from_err  = std::max( from_err,  SGGeodesy::distanceM( frame.FromLocal( v ), RefFromLocal( origin, v ) ) );
+        round_err = std::max( round_err, SGGeodesy::distanceM( frame.FromLocal( frame.ToLocal( p ) ), p ) );
+
+        geods.push_back( p );
+        points.push_back( v );
+    }
+
+    cout << "origin " << origin.getLongitudeDeg() << ", " << origin.getLatitudeDeg() << " : distance " << dist_err
+         << " m, ToLocal " << to_err << " m, FromLocal " << from_err << " m, round trip " << round_err << " m" << endl;
+
+    if ( std::max( std::max( dist_err, to_err ), std::max( from_err, round_err ) ) > tolerance ) {
+        cout << "  not within the tolerance of " << tolerance << " m" << endl;
+        failed++;
+    }
+
+    // the vector calls
+    std::vector<SGVec2d> local;
+    std::vector<SGGeod>  back;
+    unsigned int         differ = 0;
+
+    frame.ToLocal( geods, local );
+    frame.FromLocal( points, back );
+    for ( unsigned int i = 0; i < geods.size(); i++ ) {
+        SGVec2d v = frame.ToLocal( geods[i] );
+        SGGeod  g = frame.FromLocal( points[i] );
+
+        if ( local[i].x() != v.x() || local[i].y() != v.y() ||
+             back[i].getLongitudeRad() != g.getLongitudeRad() || back[i].getLatitudeRad() != g.getLatitudeRad() ) {
+            differ++;
+        }
+    }
+    if ( differ ) {
+        cout << "  " << differ << " points differ over vectors" << endl;
+        failed++;
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 3 );
+
+    double lats[] = { 0.0, 20.0, -45.0, 60.0, 80.0 };
+    for ( unsigned int l = 0; l < 5; l++ ) {
+        failed += CheckOrigin( SGGeod::fromDeg( 10.0, lats[l] ) );
+    }
+    failed += CheckOrigin( SGGeod::fromDeg( 179.99, 50.0 ) );
+    failed += CheckOrigin( SGGeod::fromDeg( -179.99, -30.0 ) );
+
+    // with no tolerance, everything is SGGeodesy
+    SGGeod       origin = SGGeod::fromDeg( 10.0, 50.0 );
+    SGGeod       p = RandomNear( origin );
+    tgLocalFrame frame( origin );
+
+    tgLocalFrame::SetTolerance( 0.0 );
+    if ( frame.ToLocal( p ) != RefToLocal( origin, p ) ) {
+        cout << "  ToLocal with no tolerance isn't SGGeodesy" << endl;
+        failed++;
+    }
+    tgLocalFrame::SetTolerance( 0.001 );
+
+    // a tile of a million points around its center
+    std::vector<SGGeod>  geods( 1000000 );
+    std::vector<SGVec2d> points( geods.size() );
+    std::vector<SGGeod>  back( geods.size() );
+    double               sum = 0.0;
+
+    for ( unsigned int i = 0; i < geods.size(); i++ ) {
+        geods[i] = SGGeod::fromDeg( 10.0 + 0.125 * Random() - 0.0625, 50.0 + 0.125 * Random() - 0.0625 );
+    }
+
+    SGTimeStamp start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < geods.size(); i++ ) {
+        sum += RefToLocal( origin, geods[i] ).x();
+    }
+    double ref_to_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < geods.size(); i++ ) {
+        sum += frame.ToLocal( geods[i] ).x();
+    }
+    double to_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    frame.ToLocal( geods, points );
+    double to_vector_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < points.size(); i++ ) {
+        sum += RefFromLocal( origin, points[i] ).getLatitudeRad();
+    }
+    double ref_from_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    frame.FromLocal( points, back );
+    double from_vector_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    cout << geods.size() << " points : ToLocal " << to_time << " s, over a vector " << to_vector_time
+         << " s, SGGeodesy " << ref_to_time << " s" << endl;
+    cout << geods.size() << " points : FromLocal over a vector " << from_vector_time
+         << " s, SGGeodesy " << ref_from_time << " s ( " << sum << " )" << endl;
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+// test-merge-slivers.cxx - tgPolygon::MergeSlivers against the loop over
+// every poly it replaced, on a warped grid of polys with gaps, in shuffled
+// order.  The slivers lie on edges between two polys, in the gaps, across
+// corners and away from all of them.  Every sliver must go to the same
+// poly, and the polys and the unmerged slivers must come out the same.
+// Also times both, and MergeSlivers alone on 10000 polys.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+static const double cell = 0.001;
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// The old tgPolygon::MergeSlivers : each sliver goes to the first poly
+// whose union with it doesn't add a contour
+static tgcontour_list RefMergeSlivers( tgpolygon_list& polys, tgcontour_list& sliver_list )
+{
+    tgcontour_list unmerged;
+
+    for ( unsigned int i = 0; i < sliver_list.size(); i++ ) {
+        tgContour sliver = sliver_list[i];
+        bool      done = false;
+
+        sliver.SetHole( false );
+
+        for ( unsigned int j = 0; j < polys.size() && !done; j++ ) {
+            tgPolygon poly = polys[j];
+            tgPolygon result = tgContour::Union( sliver, poly );
+
+            if ( poly.Contours() == result.Contours() ) {
+                result.SetMaterial( polys[j].GetMaterial() );
+                result.SetTexParams( polys[j].GetTexParams() );
+                result.SetId( polys[j].GetId() );
+                result.SetPreserve3D( polys[j].GetPreserve3D() );
+                result.va_int_mask = polys[j].va_int_mask;
+                result.va_flt_mask = polys[j].va_flt_mask;
+                result.int_vas = polys[j].int_vas;
+                result.flt_vas = polys[j].flt_vas;
+                polys[j] = result;
+                done = true;
+            }
+        }
+
+        if ( !done ) {
+            unmerged.push_back( sliver );
+        }
+    }
+
+    return unmerged;
+}
+
+static bool SameContour( const tgContour& a, const tgContour& b )
+{
+    if ( a.GetSize() != b.GetSize() || a.GetHole() != b.GetHole() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.GetSize(); i++ ) {
+        if ( a.GetNode(i).getLongitudeDeg() != b.GetNode(i).getLongitudeDeg() ||
+             a.GetNode(i).getLatitudeDeg()  != b.GetNode(i).getLatitudeDeg() ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool SamePolygon( const tgPolygon& a, const tgPolygon& b )
+{
+    if ( a.Contours() != b.Contours() || a.GetMaterial() != b.GetMaterial() || a.GetId() != b.GetId() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.Contours(); i++ ) {
+        if ( !SameContour( a.GetContour(i), b.GetContour(i) ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// an n x n grid of quads, the shared nodes moved a little, about one in
+// ten left out
+static void MakeGrid( unsigned int n, std::vector<SGGeod>& nodes, tgpolygon_list& polys )
+{
+    nodes.clear();
+    for ( unsigned int i = 0; i <= n; i++ ) {
+        for ( unsigned int j = 0; j <= n; j++ ) {
+            nodes.push_back( SGGeod::fromDeg( 10.0 + ( i + 0.3 * Random() - 0.15 ) * cell,
+                                              50.0 + ( j + 0.3 * Random() - 0.15 ) * cell ) );
+        }
+    }
+
+    polys.clear();
+    for ( unsigned int i = 0; i < n; i++ ) {
+        for ( unsigned int j = 0; j < n; j++ ) {
+            if ( Random() < 0.1 ) {
+                continue;
+            }
+
+            tgContour contour;
+            contour.AddNode( nodes[i * (n+1) + j] );
+            contour.AddNode( nodes[(i+1) * (n+1) + j] );
+            contour.AddNode( nodes[(i+1) * (n+1) + j + 1] );
+            contour.AddNode( nodes[i * (n+1) + j + 1] );
+            contour.SetHole( false );
+
+            tgPolygon poly;
+            poly.AddContour( contour );
+            poly.SetMaterial( "Grass" );
+            poly.SetId( i * n + j );
+            polys.push_back( poly );
+        }
+    }
+
+    // the old loop tried them in this order
+    std::random_shuffle( polys.begin(), polys.end() );
+}
+
+// thin triangles along the grid edges to either side, fans at the grid
+// nodes, and some away from the grid
+static tgcontour_list MakeSlivers( unsigned int n, const std::vector<SGGeod>& nodes, unsigned int count )
+{
+    tgcontour_list slivers;
+
+    for ( unsigned int s = 0; s < count; s++ ) {
+        unsigned int i = rand() % n;
+        unsigned int j = rand() % n;
+        SGGeod       a = nodes[i * (n+1) + j];
+        SGGeod       b = ( rand() % 2 ) ? nodes[(i+1) * (n+1) + j] : nodes[i * (n+1) + j + 1];
+        double       side = ( rand() % 2 ) ? 0.02 * cell : -0.02 * cell;
+        double       dx = b.getLongitudeDeg() - a.getLongitudeDeg();
+        double       dy = b.getLatitudeDeg()  - a.getLatitudeDeg();
+        double       len = sqrt( dx*dx + dy*dy );
+        tgContour    sliver;
+
+        switch ( s % 4 ) {
+            case 0:
+            case 1:
+                // on the edge a - b, into the poly on one side of it
+                sliver.AddNode( a );
+                sliver.AddNode( b );
+                sliver.AddNode( SGGeod::fromDeg( ( a.getLongitudeDeg() + b.getLongitudeDeg() ) / 2.0 - dy / len * side,
+                                                 ( a.getLatitudeDeg()  + b.getLatitudeDeg()  ) / 2.0 + dx / len * side ) );
+                break;
+
+            case 2:
+                // from the node a across the edge a - b
+                sliver.AddNode( a );
+                sliver.AddNode( SGGeod::fromDeg( b.getLongitudeDeg() - dy / len * side, b.getLatitudeDeg() + dx / len * side ) );
+                sliver.AddNode( SGGeod::fromDeg( b.getLongitudeDeg() + dy / len * side, b.getLatitudeDeg() - dx / len * side ) );
+                break;
+
+            case 3:
+                // away from the grid
+                sliver.AddNode( SGGeod::fromDeg( 9.0 + Random() * cell, 50.0 ) );
+                sliver.AddNode( SGGeod::fromDeg( 9.0 + Random() * cell, 50.0 + cell ) );
+                sliver.AddNode( SGGeod::fromDeg( 9.0 + 0.5 * cell, 50.0 + 0.5 * cell ) );
+                break;
+        }
+
+        sliver.SetHole( ( rand() % 2 ) != 0 );
+        slivers.push_back( sliver );
+    }
+
+    return slivers;
+}
+
+static unsigned int Compare( const std::string& what, unsigned int n, unsigned int count )
+{
+    std::vector<SGGeod> nodes;
+    tgpolygon_list      polys;
+    tgcontour_list      slivers;
+    unsigned int        failed = 0;
+
+    MakeGrid( n, nodes, polys );
+    slivers = MakeSlivers( n, nodes, count );
+
+    tgpolygon_list ref_polys = polys;
+    tgcontour_list ref_slivers = slivers;
+
+    SGTimeStamp    start = SGTimeStamp::now();
+    tgcontour_list unmerged = tgPolygon::MergeSlivers( polys, slivers );
+    double         new_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    tgcontour_list ref_unmerged = RefMergeSlivers( ref_polys, ref_slivers );
+    double         ref_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    unsigned int differ = 0;
+    for ( unsigned int j = 0; j < polys.size(); j++ ) {
+        if ( !SamePolygon( polys[j], ref_polys[j] ) ) {
+            differ++;
+        }
+    }
+
+    cout << what << " : " << slivers.size() << " slivers into " << polys.size() << " polys, " << unmerged.size()
+         << " unmerged, " << differ << " polys differ, " << new_time << " s, was " << ref_time << " s" << endl;
+
+    if ( differ ) {
+        cout << "  " << what << " : the slivers went to other polys" << endl;
+        failed++;
+    }
+
+    bool same_unmerged = ( unmerged.size() == ref_unmerged.size() );
+    for ( unsigned int i = 0; same_unmerged && i < unmerged.size(); i++ ) {
+        same_unmerged = SameContour( unmerged[i], ref_unmerged[i] );
+    }
+    if ( !same_unmerged ) {
+        cout << "  " << what << " : the unmerged slivers differ" << endl;
+        failed++;
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 11 );
+
+    failed += Compare( "small grid", 4, 40 );
+    failed += Compare( "grid", 12, 200 );
+    failed += Compare( "large grid", 30, 400 );
+
+    // a tile of slivers
+    std::vector<SGGeod> nodes;
+    tgpolygon_list      polys;
+
+    MakeGrid( 100, nodes, polys );
+    tgcontour_list slivers = MakeSlivers( 100, nodes, 5000 );
+
+    SGTimeStamp start = SGTimeStamp::now();
+    tgcontour_list unmerged = tgPolygon::MergeSlivers( polys, slivers );
+    cout << slivers.size() << " slivers into " << polys.size() << " polys, " << unmerged.size() << " unmerged, "
+         << ( SGTimeStamp::now() - start ).toSecs() << " s" << endl;
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
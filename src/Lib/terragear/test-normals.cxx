@@ -0,0 +1,239 @@
+// test-normals.cxx - tgCalcFaceNormals against the per triangle
+// calc_normal() loop tg-construct used before, on a random tile with
+// degenerate triangles, then timed on a 5M triangle mesh ( or the number
+// of triangles given on the command line ).
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+
+#include "tg_nodes.hxx"
+#include "tg_normals.hxx"
+#include "tg_polygon.hxx"
+#include "tg_triangle.hxx"
+
+using std::cout;
+using std::endl;
+
+// TGConstruct::calc_normal()
+static SGVec3f RefCalcNormal( double area, const SGVec3d& p1, const SGVec3d& p2, const SGVec3d& p3 )
+{
+    SGVec3f v1, v2;
+    SGVec3f normal;
+
+    bool degenerate = false;
+    const double area_eps = 1.0e-12;
+    if ( area < area_eps ) {
+        degenerate = true;
+    } else if ( fabs(p1.x() - p2.x()) < SG_EPSILON && fabs(p1.x() - p3.x()) < SG_EPSILON ) {
+        degenerate = true;
+    } else if ( fabs(p1.y() - p2.y()) < SG_EPSILON && fabs(p1.y() - p3.y()) < SG_EPSILON ) {
+        degenerate = true;
+    } else if ( fabs(p1.z() - p2.z()) < SG_EPSILON && fabs(p1.z() - p3.z()) < SG_EPSILON ) {
+        degenerate = true;
+    }
+
+    if ( degenerate ) {
+        normal = normalize(SGVec3f(p1.x(), p1.y(), p1.z()));
+    } else {
+        v1[0] = p2.x() - p1.x();
+        v1[1] = p2.y() - p1.y();
+        v1[2] = p2.z() - p1.z();
+        v2[0] = p3.x() - p1.x();
+        v2[1] = p3.y() - p1.y();
+        v2[2] = p3.z() - p1.z();
+        normal = normalize(cross(v1, v2));
+    }
+
+    return normal;
+}
+
+// TGConstruct::calc_normals()
+static void RefCalcNormals( std::vector<SGGeod>& geod_nodes, std::vector<SGVec3d>& wgs84_nodes, tgPolygon& poly )
+{
+    SGVec3f     normal;
+    double      area;
+
+    for (unsigned int tri = 0; tri < poly.Triangles(); tri++) {
+        SGGeod g1 = geod_nodes[ poly.GetTriIdx( tri, 0 ) ];
+        SGGeod g2 = geod_nodes[ poly.GetTriIdx( tri, 1 ) ];
+        SGGeod g3 = geod_nodes[ poly.GetTriIdx( tri, 2 ) ];
+
+        SGVec3d v1 = wgs84_nodes[ poly.GetTriIdx( tri, 0 ) ];
+        SGVec3d v2 = wgs84_nodes[ poly.GetTriIdx( tri, 1 ) ];
+        SGVec3d v3 = wgs84_nodes[ poly.GetTriIdx( tri, 2 ) ];
+
+        area   = tgTriangle::area( g1, g2, g3 );
+        normal = RefCalcNormal( area, v1, v2, v3 );
+
+        poly.SetTriFaceArea( tri, area );
+        poly.SetTriFaceNormal( tri, normal );
+    }
+}
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static void AddTriangle( const TGNodes& nodes, unsigned int a, unsigned int b, unsigned int c, tgPolygon& poly )
+{
+    unsigned int v[3] = { a, b, c };
+
+    poly.AddTriangle( nodes[a].GetPosition(), nodes[b].GetPosition(), nodes[c].GetPosition() );
+    for ( unsigned int k = 0; k < 3; k++ ) {
+        poly.SetTriIdx( poly.Triangles() - 1, k, v[k] );
+    }
+}
+
+// a size x size lattice of nodes over a 1/8 degree tile, two triangles per
+// cell.  With jitter, the inner nodes move around and some cells get a
+// zero area triangle with a repeated vertex as well
+static void MakeMesh( unsigned int size, bool jitter, TGNodes& nodes, tgpolygon_list& polys )
+{
+    std::vector<SGGeod>       points;
+    std::vector<unsigned int> idx;
+    double                    step = 0.125 / size;
+
+    for ( unsigned int i = 0; i <= size; i++ ) {
+        for ( unsigned int j = 0; j <= size; j++ ) {
+            double lon = -122.0 + i * step;
+            double lat =   37.0 + j * step;
+
+            if ( jitter && i > 0 && i < size && j > 0 && j < size ) {
+                lon += 0.3 * step * ( Random() - 0.5 );
+                lat += 0.3 * step * ( Random() - 0.5 );
+            }
+            points.push_back( SGGeod::fromDegM( lon, lat, 500.0 * Random() ) );
+        }
+    }
+    nodes.unique_add_batch( points, idx );
+
+    for ( unsigned int i = 0; i < size; i++ ) {
+        tgPolygon poly;
+
+        for ( unsigned int j = 0; j < size; j++ ) {
+            unsigned int a = idx[ i * ( size + 1 ) + j ];
+            unsigned int b = idx[ ( i + 1 ) * ( size + 1 ) + j ];
+            unsigned int c = idx[ ( i + 1 ) * ( size + 1 ) + j + 1 ];
+            unsigned int d = idx[ i * ( size + 1 ) + j + 1 ];
+
+            AddTriangle( nodes, a, b, c, poly );
+            AddTriangle( nodes, a, c, d, poly );
+
+            if ( jitter ) {
+                switch ( rand() % 8 ) {
+                    case 0:
+                        AddTriangle( nodes, a, a, c, poly );
+                        break;
+
+                    case 1:
+                        AddTriangle( nodes, a, b, a, poly );
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+        }
+        polys.push_back( poly );
+    }
+}
+
+static unsigned int Compare( const tgpolygon_list& ref, const tgpolygon_list& soa )
+{
+    unsigned int failed = 0;
+
+    for ( unsigned int p = 0; p < ref.size(); p++ ) {
+        for ( unsigned int tri = 0; tri < ref[p].Triangles(); tri++ ) {
+            if ( ref[p].GetTriFaceArea( tri ) != soa[p].GetTriFaceArea( tri ) ) {
+                cout << "  poly " << p << " tri " << tri << " : face area differs" << endl;
+                failed++;
+            } else if ( length( ref[p].GetTriFaceNormal( tri ) - soa[p].GetTriFaceNormal( tri ) ) > 1.0e-6 ) {
+                cout << "  poly " << p << " tri " << tri << " : face normal differs" << endl;
+                failed++;
+            }
+        }
+    }
+
+    return failed;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    unsigned int bench  = ( argc > 1 ) ? atoi( argv[1] ) : 5000000;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 11 );
+
+    // a jittered tile, with degenerate triangles
+    {
+        TGNodes        nodes;
+        tgpolygon_list ref, soa;
+
+        MakeMesh( 100, true, nodes, ref );
+        soa = ref;
+
+        std::vector<SGGeod>  geod_nodes;
+        std::vector<SGVec3d> wgs84_nodes;
+        nodes.get_geod_nodes( geod_nodes );
+        nodes.get_wgs84_nodes( wgs84_nodes );
+
+        tgNormalNodeArrays arrays( nodes );
+        for ( unsigned int p = 0; p < ref.size(); p++ ) {
+            RefCalcNormals( geod_nodes, wgs84_nodes, ref[p] );
+            tgCalcFaceNormals( arrays, soa[p] );
+        }
+        failed += Compare( ref, soa );
+    }
+
+    // and the benchmark mesh, with two triangles per cell
+    {
+        TGNodes        nodes;
+        tgpolygon_list ref, soa;
+        unsigned int   size = (unsigned int)sqrt( bench / 2.0 );
+
+        MakeMesh( size, false, nodes, ref );
+        soa = ref;
+
+        clock_t start = clock();
+        std::vector<SGGeod>  geod_nodes;
+        std::vector<SGVec3d> wgs84_nodes;
+        nodes.get_geod_nodes( geod_nodes );
+        nodes.get_wgs84_nodes( wgs84_nodes );
+        for ( unsigned int p = 0; p < ref.size(); p++ ) {
+            RefCalcNormals( geod_nodes, wgs84_nodes, ref[p] );
+        }
+        clock_t ref_ticks = clock() - start;
+
+        start = clock();
+        tgNormalNodeArrays arrays( nodes );
+        for ( unsigned int p = 0; p < soa.size(); p++ ) {
+            tgCalcFaceNormals( arrays, soa[p] );
+        }
+        clock_t ticks = clock() - start;
+
+        failed += Compare( ref, soa );
+
+        double ref_s = (double)ref_ticks / CLOCKS_PER_SEC;
+        double soa_s = (double)ticks / CLOCKS_PER_SEC;
+        double tris  = 2.0 * size * size;
+        cout << tris << " triangles : " << ref_s << " s one triangle at a time ( " << tris / ref_s / 1.0e6 << " M/s ), "
+             << soa_s << " s from arrays ( " << tris / soa_s / 1.0e6 << " M/s )" << endl;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
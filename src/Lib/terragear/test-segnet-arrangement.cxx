@@ -0,0 +1,146 @@
+// test-segnet-arrangement.cxx - runs tgSegmentNetwork on random networks
+// twice : with the arrangement built in one aggregated sweep, and with each
+// curve inserted on its own, as it was before.  The cleaned output edges,
+// with their width, zorder and type, must be the same.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tg_segmentnetwork.hxx"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+struct TestEdge
+{
+    SGGeod          source;
+    SGGeod          target;
+    double          width;
+    int             zorder;
+    unsigned int    type;
+};
+
+// a node on a coarse grid about 10 m apart, so edges share end points,
+// overlap, and cross each other at nodes as well as in between.  Some are
+// nudged by less than the cluster distance, so they get clustered.
+static SGGeod RandomNode( void )
+{
+    double lon = -122.0 + 0.0001 * ( rand() % 20 );
+    double lat =   37.0 + 0.0001 * ( rand() % 20 );
+
+    if ( rand() % 4 == 0 ) {
+        lon += 0.000001 * ( rand() % 3 - 1 );
+        lat += 0.000001 * ( rand() % 3 - 1 );
+    }
+
+    return SGGeod::fromDeg( lon, lat );
+}
+
+static std::vector<TestEdge> MakeEdges( unsigned int num )
+{
+    std::vector<TestEdge> edges;
+
+    while ( edges.size() < num ) {
+        TestEdge e;
+
+        e.source = RandomNode();
+        e.target = RandomNode();
+        e.width  = 0.15 + 0.15 * ( rand() % 3 );
+        e.zorder = rand() % 4;
+        e.type   = 1 + rand() % 3;
+
+        if ( e.source.getLongitudeDeg() == e.target.getLongitudeDeg() &&
+             e.source.getLatitudeDeg()  == e.target.getLatitudeDeg() ) {
+            continue;
+        }
+        edges.push_back( e );
+
+        // and now and then, the same edge again, reversed - its data merges
+        if ( rand() % 10 == 0 ) {
+            std::swap( e.source, e.target );
+            edges.push_back( e );
+        }
+    }
+
+    return edges;
+}
+
+// run the network on edges, and return its output as sorted strings
+static std::vector<string> Run( const std::vector<TestEdge>& edges, bool incremental, double& secs )
+{
+    tgSegmentNetwork net( 1, "test_segnet" );
+
+    net.SetIncrementalInsert( incremental );
+
+    SGTimeStamp start = SGTimeStamp::now();
+    for ( unsigned int i = 0; i < edges.size(); i++ ) {
+        net.Add( edges[i].source, edges[i].target, edges[i].width, edges[i].zorder, edges[i].type );
+    }
+    net.Execute();
+    secs += ( SGTimeStamp::now() - start ).toSecs();
+
+    std::vector<string> output;
+    for ( segnetedge_it it = net.output_begin(); it != net.output_end(); it++ ) {
+        std::ostringstream e;
+
+        e.precision( 12 );
+        e << it->start.getLongitudeDeg() << "," << it->start.getLatitudeDeg() << " - "
+          << it->end.getLongitudeDeg()   << "," << it->end.getLatitudeDeg()   << " : "
+          << it->width << " " << it->zorder << " " << it->type;
+        output.push_back( e.str() );
+    }
+    std::sort( output.begin(), output.end() );
+
+    return output;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    double       aggregated_time = 0.0, incremental_time = 0.0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 1 );
+
+    for ( unsigned int trial = 0; trial < 50; trial++ ) {
+        std::vector<TestEdge> edges = MakeEdges( 10 + rand() % 400 );
+
+        std::vector<string> aggregated  = Run( edges, false, aggregated_time );
+        std::vector<string> incremental = Run( edges, true,  incremental_time );
+
+        if ( aggregated.empty() ) {
+            cout << "  trial " << trial << " : no output from " << edges.size() << " edges" << endl;
+            failed++;
+        } else if ( aggregated != incremental ) {
+            cout << "  trial " << trial << " : " << aggregated.size() << " output edges, expected " << incremental.size() << endl;
+
+            std::vector<string> diff;
+            std::set_symmetric_difference( aggregated.begin(), aggregated.end(),
+                                           incremental.begin(), incremental.end(),
+                                           std::back_inserter( diff ) );
+            for ( unsigned int i = 0; i < diff.size() && i < 10; i++ ) {
+                cout << "    " << diff[i] << endl;
+            }
+            failed++;
+        }
+    }
+
+    cout << "aggregated sweep " << aggregated_time << " s, one curve at a time " << incremental_time << " s" << endl;
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// test-surface.cxx - checks the tgSurface fit against elevation data of a
+// known shape, and times a million single and batched queries.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/bucket/newbucket.hxx>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/lowlevel.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tg_rectangle.hxx"
+#include "tg_surface.hxx"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+// 3 arc second array, rising 1m per column to the east
+static double PlaneElevation( double lon_deg, double origin_lon_deg )
+{
+    return 100.0 + ( lon_deg - origin_lon_deg ) * 3600.0 / 3.0;
+}
+
+// write the array file of bucket b, as the hgt tools do
+static bool WritePlane( const string& root, const SGBucket& b )
+{
+    string path = root + "/" + b.gen_base_path();
+    SGPath sgp( path );
+    sgp.append( "dummy" );
+    sgp.create_dir( 0755 );
+
+    string file = path + "/" + b.gen_index_str() + ".arr.gz";
+    gzFile fp;
+    if ( (fp = gzopen( file.c_str(), "wb9" )) == NULL ) {
+        cerr << "cannot open " << file << " for writing" << endl;
+        return false;
+    }
+
+    int min_x = (int)( ( b.get_center_lon() - 0.5 * b.get_width() ) * 3600.0 );
+    int min_y = (int)( ( b.get_center_lat() - 0.5 * b.get_height() ) * 3600.0 );
+    int cols  = (int)( b.get_width()  * 3600.0 / 3.0 ) + 1;
+    int rows  = (int)( b.get_height() * 3600.0 / 3.0 ) + 1;
+
+    int32_t header = 0x54474152; // 'TGAR'
+    sgWriteLong(fp, header);
+    sgWriteInt(fp, min_x); sgWriteInt(fp, min_y);
+    sgWriteInt(fp, cols);  sgWriteInt(fp, 3);
+    sgWriteInt(fp, rows);  sgWriteInt(fp, 3);
+
+    for ( int i = 0; i < cols; ++i ) {
+        for ( int j = 0; j < rows; ++j ) {
+            sgWriteShort(fp, (int16_t)( 100 + i ));
+        }
+    }
+
+    gzclose(fp);
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    bool ok = true;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+
+    if ( argc != 2 ) {
+        cerr << "Usage: " << argv[0] << " <scratch dir>" << endl;
+        return 1;
+    }
+
+    // an unfitted surface is flat at zero
+    tgSurface unfitted;
+    if ( unfitted.query( SGGeod::fromDeg( 0.0, 0.0 ) ) != 0.0 ) {
+        cout << "  unfitted surface isn't flat" << endl;
+        ok = false;
+    }
+
+    // an airport well inside one bucket, so all samples come from its array
+    SGBucket    b( SGGeod::fromDeg( 10.1, 45.06 ) );
+    string_list elev_src;
+    elev_src.push_back( "SRTM" );
+
+    if ( !WritePlane( string( argv[1] ) + "/SRTM", b ) ) {
+        return 1;
+    }
+
+    tgRectangle bounds( SGGeod::fromDeg( 10.095, 45.055 ), SGGeod::fromDeg( 10.105, 45.065 ) );
+    tgSurface   surf;
+    surf.Create( argv[1], elev_src, bounds, 220.0, 0.02, 0.00001 );
+
+    // a plane within the slope limit must come out as is
+    double origin_lon = b.get_center_lon() - 0.5 * b.get_width();
+    double max_err    = 0.0;
+
+    std::vector<SGGeod> points;
+    for ( int j = 0; j <= 20; j++ ) {
+        for ( int i = 0; i <= 20; i++ ) {
+            points.push_back( SGGeod::fromDeg( 10.095 + i * 0.0005, 45.055 + j * 0.0005 ) );
+        }
+    }
+    points.push_back( SGGeod::fromDeg( 10.2, 45.06 ) );
+
+    std::vector<double> elevations;
+    surf.query( points, elevations );
+
+    for ( unsigned int i = 0; i < points.size(); i++ ) {
+        double single = surf.query( points[i] );
+
+        if ( single != elevations[i] ) {
+            cout << "  batched query of point " << i << " differs : " << elevations[i] << " != " << single << endl;
+            ok = false;
+        }
+        if ( i + 1 < points.size() ) {
+            max_err = std::max( max_err, fabs( single - PlaneElevation( points[i].getLongitudeDeg(), origin_lon ) ) );
+        } else if ( single != -9999.0 ) {
+            cout << "  point outside the area has elevation " << single << endl;
+            ok = false;
+        }
+    }
+
+    cout << "largest deviation from the plane " << max_err << " m" << endl;
+    if ( max_err > 1.0e-4 ) {
+        ok = false;
+    }
+
+    // a million random points in the area, as many as the nodes and
+    // lights of the largest airports, many times over
+    std::vector<SGGeod> many;
+    srand( 3 );
+    for ( unsigned int i = 0; i < 1000000; i++ ) {
+        many.push_back( SGGeod::fromDeg( 10.095 + 0.01 * rand() / RAND_MAX, 45.055 + 0.01 * rand() / RAND_MAX ) );
+    }
+
+    SGTimeStamp start = SGTimeStamp::now();
+    std::vector<double> singles( many.size() );
+    for ( unsigned int i = 0; i < many.size(); i++ ) {
+        singles[i] = surf.query( many[i] );
+    }
+    double single_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    start = SGTimeStamp::now();
+    surf.query( many, elevations );
+    double batch_time = ( SGTimeStamp::now() - start ).toSecs();
+
+    if ( elevations != singles ) {
+        cout << "  batched queries of the million points differ" << endl;
+        ok = false;
+    }
+    cout << many.size() << " queries : " << single_time << " s one by one, " << batch_time << " s batched" << endl;
+
+    cout << ( ok ? "PASSED" : "FAILED" ) << endl;
+
+    return ok ? 0 : 1;
+}
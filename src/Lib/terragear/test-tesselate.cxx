@@ -0,0 +1,505 @@
+// test-tesselate.cxx - checks the tiered tesselation of tgPolygon against
+// the original one, which always used exact constructions, and times both
+// over the polygons of a whole tile.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+#include <CGAL/Constrained_triangulation_plus_2.h>
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "tg_misc.hxx"
+#include "tg_nodes.hxx"
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+struct RefFaceInfo
+{
+    RefFaceInfo() {}
+    int nesting_level;
+
+    bool in_domain(){
+        return nesting_level%2 == 1;
+    }
+};
+
+typedef CGAL::Exact_predicates_exact_constructions_kernel           RefKernel;
+typedef CGAL::Triangulation_vertex_base_2<RefKernel>                RefVb;
+typedef CGAL::Triangulation_face_base_with_info_2<RefFaceInfo,RefKernel> RefFbb;
+typedef CGAL::Constrained_triangulation_face_base_2<RefKernel,RefFbb>    RefFb;
+typedef CGAL::Triangulation_data_structure_2<RefVb,RefFb>           RefTDS;
+typedef CGAL::Constrained_Delaunay_triangulation_2<RefKernel, RefTDS, CGAL::Exact_intersections_tag> RefCDT;
+typedef CGAL::Constrained_triangulation_plus_2<RefCDT>              RefCDTPlus;
+typedef RefCDTPlus::Point                                           RefPoint;
+
+// a triangle as its three ( lon, lat ) corners, starting from the smallest
+typedef std::pair<double, double>  TriNode;
+typedef std::vector<TriNode>       TriNodes;
+
+static void RefMarkDomains( RefCDTPlus& ct, RefCDTPlus::Face_handle start, int index, std::list<RefCDTPlus::Edge>& border )
+{
+    if ( start->info().nesting_level != -1 ) {
+        return;
+    }
+
+    std::list<RefCDTPlus::Face_handle> queue;
+    queue.push_back( start );
+
+    while ( !queue.empty() ) {
+        RefCDTPlus::Face_handle fh = queue.front();
+        queue.pop_front();
+        if ( fh->info().nesting_level == -1 ) {
+            fh->info().nesting_level = index;
+            for ( int i = 0; i < 3; i++ ) {
+                RefCDTPlus::Edge        e( fh, i );
+                RefCDTPlus::Face_handle n = fh->neighbor( i );
+                if ( n->info().nesting_level == -1 ) {
+                    if ( ct.is_constrained( e ) ) border.push_back( e );
+                    else queue.push_back( n );
+                }
+            }
+        }
+    }
+}
+
+// the original tesselation : exact constructions throughout, zero area
+// triangles dropped
+static std::vector<TriNodes> RefTesselate( const tgPolygon& subject, const std::vector<SGGeod>& extra )
+{
+    RefCDTPlus cdt;
+
+    for ( unsigned int c = 0; c < subject.Contours(); c++ ) {
+        if ( subject.ContourSize( c ) == 0 ) {
+            continue;
+        }
+
+        SGGeod last = subject.GetNode( c, subject.ContourSize( c ) - 1 );
+        RefCDTPlus::Vertex_handle v_prev = cdt.insert( RefPoint( last.getLongitudeDeg(), last.getLatitudeDeg() ) );
+        for ( unsigned int n = 0; n < subject.ContourSize( c ); n++ ) {
+            SGGeod node = subject.GetNode( c, n );
+            RefCDTPlus::Vertex_handle vh = cdt.insert( RefPoint( node.getLongitudeDeg(), node.getLatitudeDeg() ) );
+            cdt.insert_constraint( vh, v_prev );
+            v_prev = vh;
+        }
+    }
+
+    std::vector<RefPoint> points;
+    for ( unsigned int n = 0; n < extra.size(); n++ ) {
+        points.push_back( RefPoint( extra[n].getLongitudeDeg(), extra[n].getLatitudeDeg() ) );
+    }
+    if ( !points.empty() ) {
+        cdt.insert( points.begin(), points.end() );
+    }
+
+    for ( RefCDTPlus::All_faces_iterator it = cdt.all_faces_begin(); it != cdt.all_faces_end(); ++it ) {
+        it->info().nesting_level = -1;
+    }
+
+    int index = 0;
+    std::list<RefCDTPlus::Edge> border;
+    RefMarkDomains( cdt, cdt.infinite_face(), index++, border );
+    while ( !border.empty() ) {
+        RefCDTPlus::Edge e = border.front();
+        border.pop_front();
+        RefCDTPlus::Face_handle n = e.first->neighbor( e.second );
+        if ( n->info().nesting_level == -1 ) {
+            RefMarkDomains( cdt, n, e.first->info().nesting_level+1, border );
+        }
+    }
+
+    std::vector<TriNodes> tris;
+    for ( RefCDTPlus::Finite_faces_iterator fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit ) {
+        if ( fit->info().in_domain() ) {
+            SGGeod p[3];
+
+            for ( unsigned int i = 0; i < 3; i++ ) {
+                p[i] = SGGeod::fromDeg( CGAL::to_double( fit->vertex(i)->point().x() ), CGAL::to_double( fit->vertex(i)->point().y() ) );
+            }
+            if ( !SGGeod_isEqual2D( p[0], p[1] ) && !SGGeod_isEqual2D( p[1], p[2] ) && !SGGeod_isEqual2D( p[0], p[2] ) ) {
+                TriNodes tri;
+                for ( unsigned int i = 0; i < 3; i++ ) {
+                    tri.push_back( std::make_pair( p[i].getLongitudeDeg(), p[i].getLatitudeDeg() ) );
+                }
+                std::rotate( tri.begin(), std::min_element( tri.begin(), tri.end() ), tri.end() );
+                tris.push_back( tri );
+            }
+        }
+    }
+    std::sort( tris.begin(), tris.end() );
+
+    return tris;
+}
+
+// the triangles of subject, in the same form
+static std::vector<TriNodes> Triangles( const tgPolygon& subject )
+{
+    std::vector<TriNodes> tris;
+
+    for ( unsigned int t = 0; t < subject.Triangles(); t++ ) {
+        TriNodes tri;
+        for ( unsigned int i = 0; i < 3; i++ ) {
+            SGGeod p = subject.GetTriNode( t, i );
+            tri.push_back( std::make_pair( p.getLongitudeDeg(), p.getLatitudeDeg() ) );
+        }
+        std::rotate( tri.begin(), std::min_element( tri.begin(), tri.end() ), tri.end() );
+        tris.push_back( tri );
+    }
+    std::sort( tris.begin(), tris.end() );
+
+    return tris;
+}
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// a star shaped ( so simple ) contour around center, in either orientation
+static tgContour MakeStar( const SGGeod& center, double radius, bool hole )
+{
+    tgContour    contour;
+    unsigned int sides = 3 + rand() % 20;
+    bool         cw = ( rand() % 2 ) != 0;
+
+    for ( unsigned int i = 0; i < sides; i++ ) {
+        double a = SGD_2PI * ( cw ? sides - i : i ) / sides;
+        double r = radius * ( 0.5 + 0.5 * Random() );
+
+        contour.AddNode( SGGeod::fromDeg( center.getLongitudeDeg() + r * cos( a ),
+                                          center.getLatitudeDeg()  + r * sin( a ) ) );
+    }
+    contour.SetHole( hole );
+
+    return contour;
+}
+
+// a contour crossing itself
+static tgContour MakeBowtie( const SGGeod& center, double radius )
+{
+    tgContour contour;
+    double    lon = center.getLongitudeDeg();
+    double    lat = center.getLatitudeDeg();
+
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat + radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat + radius ) );
+    contour.SetHole( false );
+
+    return contour;
+}
+
+static tgContour MakeSquare( const SGGeod& center, double radius )
+{
+    tgContour contour;
+    double    lon = center.getLongitudeDeg();
+    double    lat = center.getLatitudeDeg();
+
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat - radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon + radius, lat + radius ) );
+    contour.AddNode( SGGeod::fromDeg( lon - radius, lat + radius ) );
+    contour.SetHole( false );
+
+    return contour;
+}
+
+// a square, and a triangle cutting off its corner a hair from the corner,
+// so the constructed intersections land next to an existing vertex
+static tgPolygon MakeNearCorner( const SGGeod& center, double radius )
+{
+    tgPolygon poly;
+    tgContour sliver;
+    double    lon  = center.getLongitudeDeg() + radius;
+    double    lat  = center.getLatitudeDeg()  + radius;
+    double    hair = radius * 1.0e-11 * ( 1.0 + Random() );
+    double    d    = radius * ( 0.1 + Random() );
+
+    sliver.AddNode( SGGeod::fromDeg( lon + d, lat - hair - d ) );
+    sliver.AddNode( SGGeod::fromDeg( lon + radius * 2.5, lat + radius * 2.5 ) );
+    sliver.AddNode( SGGeod::fromDeg( lon - hair - d, lat + d ) );
+    sliver.SetHole( false );
+
+    poly.AddContour( MakeSquare( center, radius ) );
+    poly.AddContour( sliver );
+
+    return poly;
+}
+
+// returns true if the polygon has constraints crossing each other, so the
+// exact tier must be used
+static bool MakePolygon( tgPolygon& poly )
+{
+    SGGeod center = SGGeod::fromDeg( 10.0 * Random(), 10.0 * Random() );
+
+    switch( rand() % 5 ) {
+        case 0:
+            poly.AddContour( MakeStar( center, 0.01, false ) );
+            return false;
+
+        case 1:
+            // with a hole well inside
+            poly.AddContour( MakeStar( center, 0.01, false ) );
+            poly.AddContour( MakeStar( center, 0.002, true ) );
+            return false;
+
+        case 2:
+            // two boundaries crossing each other
+            poly.AddContour( MakeSquare( center, 0.01 ) );
+            poly.AddContour( MakeSquare( SGGeod::fromDeg( center.getLongitudeDeg() + 0.01 * ( 0.1 + Random() ), center.getLatitudeDeg() + 0.01 * Random() ), 0.01 ) );
+            return true;
+
+        case 3:
+            poly.AddContour( MakeBowtie( center, 0.01 ) );
+            return true;
+
+        default:
+            poly = MakeNearCorner( center, 0.01 );
+            return true;
+    }
+}
+
+// random points within radius of the polygon's first node
+static std::vector<SGGeod> MakeExtra( const tgPolygon& poly )
+{
+    std::vector<SGGeod> extra;
+    SGGeod              node = poly.GetNode( 0, 0 );
+    unsigned int        num  = rand() % 20;
+
+    for ( unsigned int i = 0; i < num; i++ ) {
+        extra.push_back( SGGeod::fromDeg( node.getLongitudeDeg() + 0.02 * ( Random() - 0.5 ),
+                                          node.getLatitudeDeg()  + 0.02 * ( Random() - 0.5 ) ) );
+    }
+
+    return extra;
+}
+
+// the polygons of a 1/8 degree tile as they reach stage 2 : a lattice of
+// landclass cells sharing jittered corners, each edge split into many
+// nodes, some cells with a hole, and a few ( as left by clipping ) with a
+// sliver overlapping their boundary.  Each gets the surface points inside it
+// as extra nodes
+static void MakeTile( unsigned int cells, std::vector<tgPolygon>& polys, std::vector< std::vector<SGGeod> >& extras )
+{
+    double size = 0.125 / cells;
+    std::vector< std::vector<SGGeod> > corners( cells + 1 );
+
+    for ( unsigned int i = 0; i <= cells; i++ ) {
+        for ( unsigned int j = 0; j <= cells; j++ ) {
+            double jitter = ( i > 0 && i < cells && j > 0 && j < cells ) ? 0.3 * size : 0.0;
+            corners[i].push_back( SGGeod::fromDeg( -122.0 + i * size + jitter * ( Random() - 0.5 ),
+                                                     37.0 + j * size + jitter * ( Random() - 0.5 ) ) );
+        }
+    }
+
+    for ( unsigned int i = 0; i < cells; i++ ) {
+        for ( unsigned int j = 0; j < cells; j++ ) {
+            SGGeod    c[4] = { corners[i][j], corners[i+1][j], corners[i+1][j+1], corners[i][j+1] };
+            tgContour boundary;
+            tgPolygon poly;
+
+            for ( unsigned int k = 0; k < 4; k++ ) {
+                const SGGeod& a = c[k];
+                const SGGeod& b = c[(k+1)%4];
+
+                for ( unsigned int n = 0; n < 16; n++ ) {
+                    double t = n / 16.0;
+                    boundary.AddNode( SGGeod::fromDeg( a.getLongitudeDeg() + t * ( b.getLongitudeDeg() - a.getLongitudeDeg() ),
+                                                       a.getLatitudeDeg()  + t * ( b.getLatitudeDeg()  - a.getLatitudeDeg() ) ) );
+                }
+            }
+            boundary.SetHole( false );
+            poly.AddContour( boundary );
+
+            SGGeod center = SGGeod::fromDeg( ( c[0].getLongitudeDeg() + c[2].getLongitudeDeg() ) / 2,
+                                             ( c[0].getLatitudeDeg()  + c[2].getLatitudeDeg() ) / 2 );
+            switch ( rand() % 10 ) {
+                case 0:
+                case 1:
+                    poly.AddContour( MakeStar( center, 0.1 * size, true ) );
+                    break;
+
+                case 2:
+                    // a sliver across the boundary
+                    poly.AddContour( MakeSquare( SGGeod::fromDeg( c[1].getLongitudeDeg(), center.getLatitudeDeg() ), 0.05 * size ) );
+                    break;
+
+                default:
+                    break;
+            }
+
+            std::vector<SGGeod> extra;
+            for ( unsigned int n = 0; n < 20; n++ ) {
+                extra.push_back( SGGeod::fromDeg( center.getLongitudeDeg() + 0.4 * size * ( Random() - 0.5 ),
+                                                  center.getLatitudeDeg()  + 0.4 * size * ( Random() - 0.5 ) ) );
+            }
+
+            polys.push_back( poly );
+            extras.push_back( extra );
+        }
+    }
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+    unsigned int num_fast = 0, num_exact = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 1 );
+
+    for ( unsigned int trial = 0; trial < 1000; trial++ ) {
+        tgPolygon poly;
+        bool      crossing = MakePolygon( poly );
+
+        std::vector<SGGeod>   extra = MakeExtra( poly );
+        std::vector<TriNodes> ref   = RefTesselate( poly, extra );
+
+        // the tier picked for a polygon is counted once per tesselation
+        unsigned int fast_before, exact_before, fast_after, exact_after;
+        tgPolygon::GetTesselationStats( fast_before, exact_before );
+
+        tgPolygon tess = poly;
+        tess.Tesselate( extra, false );
+
+        tgPolygon::GetTesselationStats( fast_after, exact_after );
+        if ( fast_after + exact_after != fast_before + exact_before + 1 ) {
+            cout << "  trial " << trial << " : tesselation not counted once" << endl;
+            failed++;
+        }
+
+        // crossing constraints must never stay on the fast tier
+        if ( crossing && exact_after == exact_before ) {
+            cout << "  trial " << trial << " : crossing constraints tesselated without exact constructions" << endl;
+            failed++;
+        }
+        num_fast  += fast_after  - fast_before;
+        num_exact += exact_after - exact_before;
+
+        if ( Triangles( tess ) != ref ) {
+            cout << "  trial " << trial << " : " << tess.Triangles() << " triangles differ from the " << ref.size() << " of the exact tesselation" << endl;
+            failed++;
+        }
+
+        // the indexed tesselation gives the same triangles, and the same
+        // node table and triangle indices as tesselating first and looking
+        // every vertex up afterwards, as stage 2 did
+        TGNodes nodes;
+        for ( unsigned int c = 0; c < poly.Contours(); c++ ) {
+            for ( unsigned int n = 0; n < poly.ContourSize( c ); n++ ) {
+                SGGeod p = poly.GetNode( c, n );
+                nodes.unique_add( p );
+            }
+        }
+        for ( unsigned int i = 0; i < extra.size(); i++ ) {
+            SGGeod p = extra[i];
+            nodes.unique_add( p );
+        }
+        nodes.init_spacial_query();
+
+        unsigned int num_nodes = nodes.size();
+        tgPolygon    indexed   = poly;
+        indexed.Tesselate( nodes, extra, false );
+
+        if ( nodes.size() != num_nodes ) {
+            cout << "  trial " << trial << " : indexed tesselation added to the node list" << endl;
+            failed++;
+        }
+        if ( Triangles( indexed ) != ref ) {
+            cout << "  trial " << trial << " : " << indexed.Triangles() << " indexed triangles differ from the " << ref.size() << " of the exact tesselation" << endl;
+            failed++;
+            continue;
+        }
+
+        // the vertices the node list doesn't have yet ( constraint
+        // intersections ) are added, then looked up, the way SyncNodes and
+        // LookupNodesPerVertex do it
+        TGNodes ref_nodes = nodes;
+        for ( unsigned int t = 0; t < indexed.Triangles(); t++ ) {
+            for ( unsigned int i = 0; i < 3; i++ ) {
+                SGGeod p = indexed.GetTriNode( t, i );
+                nodes.unique_add( p );
+                p = tess.GetTriNode( t, i );
+                ref_nodes.unique_add( p );
+            }
+        }
+        nodes.init_spacial_query();
+        ref_nodes.init_spacial_query();
+
+        bool same_idx = ( nodes.size() == ref_nodes.size() );
+        for ( unsigned int t = 0; t < indexed.Triangles(); t++ ) {
+            for ( unsigned int i = 0; i < 3; i++ ) {
+                int idx = indexed.GetTriIdx( t, i );
+                if ( idx < 0 ) {
+                    idx = nodes.find( indexed.GetTriNode( t, i ) );
+                }
+                if ( idx != ref_nodes.find( tess.GetTriNode( t, i ) ) ) {
+                    same_idx = false;
+                }
+            }
+        }
+        if ( !same_idx ) {
+            cout << "  trial " << trial << " : triangle indices differ from looking every vertex up" << endl;
+            failed++;
+        }
+    }
+    cout << "random polygons : " << num_fast << " tesselated with inexact constructions, " << num_exact << " with exact ones" << endl;
+
+    // a whole tile, timed against the original
+    std::vector<tgPolygon>             tile;
+    std::vector< std::vector<SGGeod> > tile_extra;
+    MakeTile( 40, tile, tile_extra );
+
+    clock_t start = clock();
+    std::vector< std::vector<TriNodes> > ref_tris;
+    for ( unsigned int i = 0; i < tile.size(); i++ ) {
+        ref_tris.push_back( RefTesselate( tile[i], tile_extra[i] ) );
+    }
+    clock_t ref_ticks = clock() - start;
+
+    unsigned int fast_before, exact_before, fast_after, exact_after;
+    tgPolygon::GetTesselationStats( fast_before, exact_before );
+
+    start = clock();
+    for ( unsigned int i = 0; i < tile.size(); i++ ) {
+        tile[i].Tesselate( tile_extra[i], false );
+    }
+    clock_t ticks = clock() - start;
+
+    tgPolygon::GetTesselationStats( fast_after, exact_after );
+
+    for ( unsigned int i = 0; i < tile.size(); i++ ) {
+        if ( Triangles( tile[i] ) != ref_tris[i] ) {
+            cout << "  tile polygon " << i << " : triangles differ from the exact tesselation" << endl;
+            failed++;
+        }
+    }
+
+    unsigned int tile_exact = exact_after - exact_before;
+    cout << "tile of " << tile.size() << " polygons : " << tile_exact << " fell back to exact constructions ( "
+         << 100.0 * tile_exact / tile.size() << "% ), "
+         << (double)ref_ticks / CLOCKS_PER_SEC << " s always exact, "
+         << (double)ticks / CLOCKS_PER_SEC << " s tiered" << endl;
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
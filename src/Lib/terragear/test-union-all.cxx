@@ -0,0 +1,195 @@
+// test-union-all.cxx - tgPolygon::UnionAll against unioning the polygons one
+// at a time with Union( subject, clip ), and against the single sweep of
+// Union( list ) it replaced.  Sets with light overlap take the single sweep
+// path, deep stacks the grouped pairwise path, and use_cgal the joined
+// Polygon_set.  Results must cover the same area, up to the nodes
+// AddColinearNodes moves onto nearby edges.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/constants.h>
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "tg_polygon.hxx"
+
+using std::cout;
+using std::endl;
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// a star shaped contour around center, in either orientation
+static tgContour MakeStar( const SGGeod& center, double radius, unsigned int sides, bool hole )
+{
+    tgContour contour;
+    bool      cw = ( rand() % 2 ) != 0;
+
+    for ( unsigned int i = 0; i < sides; i++ ) {
+        double a = SGD_2PI * ( cw ? sides - i : i ) / sides;
+        double r = radius * ( 0.6 + 0.4 * Random() );
+
+        contour.AddNode( SGGeod::fromDeg( center.getLongitudeDeg() + r * cos( a ),
+                                          center.getLatitudeDeg()  + r * sin( a ) ) );
+    }
+    contour.SetHole( hole );
+
+    return contour;
+}
+
+// boundaries minus holes, in square degrees
+static double Area( const tgPolygon& poly )
+{
+    double area = 0.0;
+
+    for ( unsigned int i = 0; i < poly.Contours(); i++ ) {
+        double a = poly.GetContour(i).GetArea();
+        area += poly.GetContour(i).GetHole() ? -a : a;
+    }
+
+    return area;
+}
+
+// area covered by exactly one of a and b
+static double XorArea( const tgPolygon& a, const tgPolygon& b )
+{
+    tgPolygon ca = a, cb = b;
+
+    return Area( tgPolygon::Diff( a, cb ) ) + Area( tgPolygon::Diff( b, ca ) );
+}
+
+struct TestSet
+{
+    const char*     name;
+    unsigned int    count;
+    double          spread;         // degrees the centers are spread over
+    double          radius;
+    unsigned int    sides;
+    bool            holes;          // every other poly gets a hole
+    bool            overlapping;    // some polys have two overlapping boundaries
+    unsigned int    clusters;       // far apart groups of polys
+};
+
+static tgpolygon_list MakeSet( const TestSet& set )
+{
+    tgpolygon_list polys;
+
+    for ( unsigned int i = 0; i < set.count; i++ ) {
+        tgPolygon poly;
+        double    lon = 10.0 + 2.0 * ( i % set.clusters ) + set.spread * Random();
+        double    lat = 45.0 + set.spread * Random();
+        SGGeod    center = SGGeod::fromDeg( lon, lat );
+
+        poly.AddContour( MakeStar( center, set.radius, set.sides, false ) );
+        if ( set.holes && i % 2 ) {
+            poly.AddContour( MakeStar( center, 0.3 * set.radius, set.sides, true ) );
+        }
+        if ( set.overlapping && i % 3 == 0 ) {
+            SGGeod next = SGGeod::fromDeg( lon + 0.5 * set.radius, lat );
+            poly.AddContour( MakeStar( next, set.radius, set.sides, false ) );
+        }
+        polys.push_back( poly );
+
+        // empty polys are skipped
+        if ( i % 50 == 7 ) {
+            polys.push_back( tgPolygon() );
+        }
+    }
+
+    return polys;
+}
+
+static unsigned int Compare( const std::string& what, const tgPolygon& result, const tgPolygon& ref, double& worst )
+{
+    double area = Area( ref );
+    double diff = XorArea( result, ref );
+    double rel  = ( area > 0.0 ) ? diff / area : diff;
+
+    worst = std::max( worst, rel );
+    if ( rel > 1.0e-6 || ( area == 0.0 ) != ( Area( result ) == 0.0 ) ) {
+        cout << "  " << what << " : area " << Area( result ) << " vs " << area << ", differing by " << diff << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 11 );
+
+    // Union( subject, clip ) fills each operand even-odd, so the sets
+    // with overlapping boundaries in one poly are only checked against
+    // the nonzero fill of Union( list )
+    TestSet sets[] = {
+        { "light overlap squares",    2000, 1.0,  0.01,  4, false, false, 1 },
+        { "deep stacks of 64-gons",    500, 0.2,  0.05, 64, false, false, 1 },
+        { "holes",                     600, 0.5,  0.04, 12, true,  false, 1 },
+        { "far apart clusters",        800, 0.1,  0.05, 16, true,  false, 4 },
+        { "overlapping boundaries",    500, 0.3,  0.03, 10, false, true,  1 },
+        { "one poly",                    1, 0.0,  0.01,  8, true,  false, 1 },
+    };
+
+    for ( unsigned int s = 0; s < sizeof(sets) / sizeof(sets[0]); s++ ) {
+        tgpolygon_list polys = MakeSet( sets[s] );
+        std::string    name  = sets[s].name;
+        double         worst = 0.0;
+
+        SGTimeStamp start = SGTimeStamp::now();
+        tgPolygon all = tgPolygon::UnionAll( polys );
+        double all_time = ( SGTimeStamp::now() - start ).toSecs();
+
+        start = SGTimeStamp::now();
+        tgPolygon sweep = tgPolygon::Union( polys );
+        double sweep_time = ( SGTimeStamp::now() - start ).toSecs();
+
+        failed += Compare( name + " : UnionAll vs Union( list )", all, sweep, worst );
+
+        double seq_time = 0.0;
+        if ( !sets[s].overlapping ) {
+            tgPolygon seq;
+
+            start = SGTimeStamp::now();
+            for ( unsigned int i = 0; i < polys.size(); i++ ) {
+                seq = tgPolygon::Union( polys[i], seq );
+            }
+            seq_time = ( SGTimeStamp::now() - start ).toSecs();
+
+            failed += Compare( name + " : UnionAll vs one at a time", all, seq, worst );
+        }
+
+        start = SGTimeStamp::now();
+        tgPolygon cgal = tgPolygon::UnionAll( polys, true );
+        double cgal_time = ( SGTimeStamp::now() - start ).toSecs();
+
+        failed += Compare( name + " : UnionAll( cgal ) vs Union( list )", cgal, sweep, worst );
+
+        cout << name << " : " << polys.size() << " polys, UnionAll " << all_time << " s, one sweep " << sweep_time
+             << " s, one at a time " << seq_time << " s, cgal " << cgal_time << " s, worst relative difference " << worst << endl;
+    }
+
+    // nothing to union
+    tgpolygon_list none( 3 );
+    if ( tgPolygon::UnionAll( none ).Contours() || tgPolygon::UnionAll( tgpolygon_list() ).Contours() ) {
+        cout << "  the union of empty polys isn't empty" << endl;
+        failed++;
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
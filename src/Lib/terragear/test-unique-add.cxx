@@ -0,0 +1,129 @@
+// test-unique-add.cxx - TGNodes::unique_add_batch must hand out the same
+// node indices as unique_add called on each point in turn.
+//
+// This program is in the Public Domain and comes with NO WARRANTY.
+// Use at your own risk.
+
+#include <simgear/compiler.h>
+#include <simgear/debug/logstream.hxx>
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "tg_nodes.hxx"
+
+using std::cout;
+using std::endl;
+
+// the unique_add query radius
+static const double radius = 0.0000001;
+
+static double Random( void )
+{
+    return (double)rand() / RAND_MAX;
+}
+
+// points in small clumps, so a point often lies within the query radius of
+// two or more nodes added before it
+static std::vector<SGGeod> MakePoints( unsigned int num )
+{
+    std::vector<SGGeod> points;
+    double              lon = 0.0, lat = 0.0;
+
+    for ( unsigned int i = 0; i < num; i++ ) {
+        if ( i % 8 == 0 ) {
+            lon = -122.0 + 0.001 * Random();
+            lat =   37.0 + 0.001 * Random();
+        }
+        points.push_back( SGGeod::fromDegM( lon + 2.0 * radius * ( Random() - 0.5 ),
+                                            lat + 2.0 * radius * ( Random() - 0.5 ),
+                                            100.0 * Random() ) );
+    }
+
+    return points;
+}
+
+static bool SameGeod( const SGGeod& a, const SGGeod& b )
+{
+    return a.getLongitudeDeg() == b.getLongitudeDeg() &&
+           a.getLatitudeDeg()  == b.getLatitudeDeg()  &&
+           a.getElevationM()   == b.getElevationM();
+}
+
+static bool SameNodes( const TGNodes& a, const TGNodes& b )
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < a.size(); i++ ) {
+        if ( !SameGeod( a[i].GetPosition(), b[i].GetPosition() ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned int failed = 0;
+
+    sglog().setLogLevels( SG_ALL, SG_WARN );
+    srand( 3 );
+
+    for ( unsigned int trial = 0; trial < 200; trial++ ) {
+        // some nodes are already there, as they are when SyncNodes runs
+        std::vector<SGGeod> first = MakePoints( rand() % 500 );
+        std::vector<SGGeod> batch = MakePoints( 1 + rand() % 2000 );
+        TGNodes             sequential, batched;
+
+        for ( unsigned int i = 0; i < first.size(); i++ ) {
+            SGGeod p = first[i];
+            sequential.unique_add( p );
+            p = first[i];
+            batched.unique_add( p );
+        }
+
+        std::vector<SGGeod>       seq_points = batch;
+        std::vector<unsigned int> seq_indices;
+        for ( unsigned int i = 0; i < seq_points.size(); i++ ) {
+            seq_indices.push_back( sequential.unique_add( seq_points[i] ) );
+        }
+
+        std::vector<SGGeod>       batch_points = batch;
+        std::vector<unsigned int> batch_indices;
+        batched.unique_add_batch( batch_points, batch_indices );
+
+        if ( batch_indices != seq_indices ) {
+            cout << "  trial " << trial << " : batch indices differ from sequential ones" << endl;
+            failed++;
+            continue;
+        }
+        for ( unsigned int i = 0; i < batch_points.size(); i++ ) {
+            if ( !SameGeod( batch_points[i], seq_points[i] ) ) {
+                cout << "  trial " << trial << " : point " << i << " snapped to another node" << endl;
+                failed++;
+                break;
+            }
+        }
+        if ( !SameNodes( sequential, batched ) ) {
+            cout << "  trial " << trial << " : node lists differ" << endl;
+            failed++;
+        }
+
+        // and the tree built by the batch finds the same nodes
+        for ( unsigned int i = 0; i < batch.size(); i++ ) {
+            if ( batched.find( batch[i] ) != sequential.find( batch[i] ) ) {
+                cout << "  trial " << trial << " : find differs for point " << i << endl;
+                failed++;
+                break;
+            }
+        }
+    }
+
+    cout << ( failed == 0 ? "PASSED" : "FAILED" ) << endl;
+
+    return ( failed == 0 ) ? 0 : 1;
+}
@@ -176,6 +176,7 @@ void ToShapefile( const Polygon_set& ps, const char* layer )
     tgShapefile::FromContourList( contours, false, false, "./clip_dbg", layer, "poly" );
 }
 
+#if 0
 static CGAL::Bbox_2 GetBoundingBox( const Polygon_set& subject ) 
 {
     std::list<Polygon_with_holes> pwh_list;    
@@ -184,7 +185,6 @@ static CGAL::Bbox_2 GetBoundingBox( const Polygon_set& subject )
     return CGAL::bbox_2( pwh_list.begin(), pwh_list.end() );
 }
 
-#if 0
 static Polygon_set ToCgalPolyWithHoles( const tgPolygon& subject )
 {
     tgArrangement   arr;
@@ -253,81 +253,6 @@ static Polygon_set ToCgalPolyWithHoles( const tgPolygon& subject )
     
     return boundaries;
 }
-#else
-static bool ToCgalPolyWithHoles( const tgPolygon& subject, Polygon_set& cgSubject, CGAL::Bbox_2& bb )
-{
-    tgArrangement   arr;
-    Polygon_set     boundaries;
-    Polygon_set     holes;
-    
-    // for each boundary contour, we add it to its own arrangement
-    // then read the resulting faces as a list of polygons with holes
-    // note that a self intersecting face ( like a donut ) will generate
-    // more than one face.  We need to determine for each face wether it is a 
-    // hole or not.
-    // ___________
-    // | ______  |
-    // | \    /  |
-    // |  \  /   |
-    // |___\/____|
-    //
-    // Example of a single self intersecting contour that should be represented by a polygon 
-    
-    // first, we need to get all of the contours in reletively simple format
-    // SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : Inserting " << subject.Contours() << " contours "  );
-
-    for (unsigned int i=0; i<subject.Contours(); i++ ) {
-        char layer[128];
-
-        //sprintf( layer, "%04u_original_contour_%d", subject.GetId(), i );
-        //tgShapefile::FromContour( subject.GetContour(i), false, true, "./clip_dbg", layer, "cont" );
-        
-        arr.Clear();
-        arr.Add( subject.GetContour(i) );
-
-        // retreive the new Contour(s) from traversing the outermost face first
-        // any holes in this face are individual polygons
-        // any holes in those faces are holes, etc...
-        
-        // dump the arrangement to see what we have.
-        //sprintf( layer, "%04u_Arrangement_contour_%d", subject.GetId(), i );
-        //arr.ToShapefiles( "./clip_dbg", layer );
-
-        // Combine boundaries and holes into their sets
-        Polygon_set face = arr.ToPolygonSet( i );
-        //sprintf( layer, "%04u_face_contour_%d", subject.GetId(), i );
-        //ToShapefile( face, layer );
-        
-        if ( subject.GetContour(i).GetHole() ) {
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : Join with holes"  );
-            
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : before - face_valid " << face.is_valid() << " holes_valid " << holes.is_valid()  );
-            holes.join( face );
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : after - face_valid " << face.is_valid() << " holes_valid " << holes.is_valid()  );
-        } else {
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : Join with boundaries"  );
-            
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : before - face_valid " << face.is_valid() << " boundaries_valid " << boundaries.is_valid()  );
-            boundaries.join( face );            
-            //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : after - face_valid " << face.is_valid() << " boundaries_valid " << boundaries.is_valid()  );
-        }
-        //SG_LOG(SG_GENERAL, SG_ALERT, "ToCgalPolyWithHoles : Join complete"  );
-        
-    }
-    
-    // now, generate the result
-    boundaries.difference( holes );
-    
-    // dump to shapefile
-    if ( boundaries.is_valid() ) {
-        cgSubject = boundaries;
-        bb = GetBoundingBox( cgSubject );
-        
-        return true;
-    } else {
-        return false;
-    }
-}
 #endif
 
 typedef CGAL::Bbox_2    BBox;
@@ -335,17 +260,12 @@ typedef CGAL::Bbox_2    BBox;
 
 void tgAccumulator::Diff_cgal( tgPolygon& subject )
 {   
-    static int savepoly = 0;
-    char filename[32];
-    
-    Polygon_set  cgalSubject;
-    CGAL::Bbox_2 cgalBbox;
-    
-    Polygon_set diff = accum_cgal;
+    tgCgalPolygonPtr cg = tgGetCgalPolygon( subject );
+    if ( cg->valid ) {
+        Polygon_set cgalSubject = cg->ps;
 
-    if ( ToCgalPolyWithHoles( subject, cgalSubject, cgalBbox ) ) {
         if ( !accumEmpty ) {
-            cgalSubject.difference( diff );
+            cgalSubject.difference( accum_cgal );
         }
 
         //sprintf( layer, "%04u_cgal_subject_after_diff", subject.GetId() );
@@ -361,11 +281,10 @@ void tgAccumulator::Diff_cgal( tgPolygon& subject )
 void tgAccumulator::Add_cgal( const tgPolygon& subject )
 {
     // just add the converted PolygonWithHoles to the Polygon set
-    Polygon_set  cgalSubject;
-    CGAL::Bbox_2 cgalBbox;
+    tgCgalPolygonPtr cg = tgGetCgalPolygon( subject );
     
-    if ( ToCgalPolyWithHoles( subject, cgalSubject, cgalBbox ) ) {
-        accum_cgal.join(cgalSubject);
+    if ( cg->valid ) {
+        accum_cgal.join( cg->ps );
         accumEmpty = false;
     }
 }
@@ -411,16 +330,17 @@ void tgAccumulator::AddAccumPolygonSet( const Polygon_set& ps )
 
 void tgAccumulator::Diff_and_Add_cgal( tgPolygon& subject )
 {
-    Polygon_set     cgSubject;
-    CGAL::Bbox_2    cgBoundingBox;
+    tgCgalPolygonPtr cg = tgGetCgalPolygon( subject );
 
 #if 0    
     char            layer[128];
 #endif
     
-    if ( ToCgalPolyWithHoles( subject, cgSubject, cgBoundingBox ) ) {
-        Polygon_set add  = cgSubject;
-        Polygon_set diff = GetAccumPolygonSet( cgBoundingBox );
+    if ( cg->valid ) {
+        const CGAL::Bbox_2& cgBoundingBox = cg->bbox;
+        const Polygon_set&  add  = cg->ps;
+        Polygon_set         cgSubject = cg->ps;
+        Polygon_set         diff = GetAccumPolygonSet( cgBoundingBox );
 
 #if 0        
         sprintf( layer, "clip_%03d_pre_subject", subject.GetId() );
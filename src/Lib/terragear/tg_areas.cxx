@@ -48,6 +48,26 @@ void tgAreas::clear(void)
 // TODO for tile merging, areas need to know the area defs file.  bring in from tgconstruct
 void tgAreas::SyncNodes( TGNodes& nodes )
 {
+    std::vector<SGGeod>       points;
+    std::vector<unsigned int> indices;
+
+    // gather every contour node of every poly, and add them all at once
+    for (unsigned int area=0; area<polys.size(); area++) {
+        for (unsigned int p=0; p<polys[area].size(); p++ ) {
+            tgPolygon const& poly = polys[area][p];
+
+            for (unsigned int con=0; con < poly.Contours(); con++) {
+                for (unsigned int n = 0; n < poly.ContourSize( con ); n++) {
+                    points.push_back( poly.GetNode( con, n ) );
+                }
+            }
+        }
+    }
+
+    nodes.unique_add_batch( points, indices );
+
+    // then write back the (possibly snapped) positions in the same order
+    unsigned int cur = 0;
     for (unsigned int area=0; area<polys.size(); area++) {
         //bool isRoad = area_defs.is_road_area( area );
         for (unsigned int p=0; p<polys[area].size(); p++ ) {
@@ -55,10 +75,7 @@ void tgAreas::SyncNodes( TGNodes& nodes )
         
             for (unsigned int con=0; con < poly.Contours(); con++) {
                 for (unsigned int n = 0; n < poly.ContourSize( con ); n++) {
-                    // ensure we have all nodes...
-                    SGGeod node = poly.GetNode( con, n );
-                    nodes.unique_add( node );
-                    poly.SetNode( con, n, node );
+                    poly.SetNode( con, n, points[cur++] );
                 }
             }
         }
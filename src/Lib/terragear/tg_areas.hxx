@@ -62,6 +62,11 @@ public:
 
     void clear(void);
     void SyncNodes( TGNodes& nodes );
+
+    inline unsigned int size( void ) const
+    {
+        return polys.size();
+    }
     
     inline unsigned int area_size( unsigned int area ) const
     {
@@ -197,7 +197,6 @@ static void ToShapefile( const Polygon_with_holes& pwh, int c )
 void tgArrangement::GetPolygons( const arrArrangement::Face_const_handle& fh, Polygon_set& polygons, int c )
 {
     arrArrangement::Hole_const_iterator hit;
-    static unsigned int num_contours = 0;
     
     for( hit = fh->holes_begin(); hit != fh->holes_end(); hit++ ) {
         arrCcbHEConstCirc ccbFirst = (*hit);
@@ -233,24 +232,10 @@ void tgArrangement::GetPolygons( const arrArrangement::Face_const_handle& fh, Po
             // we generate each contour as a boundary 
             contour.reverse_orientation();
         }
-        
-#if 0        
-        char filename[128];
-        sprintf( filename, "poly_%04d", num_contours );
-        std::ofstream output_file("filename");
-        if (!output_file.is_open()) {
-            std::cerr << "Failed to open the " << "./output_polys.txt" << std::endl;
-            exit(0);
-        }   
-        output_file << std::setprecision(16) << contour;
-        output_file.close();
-#endif
 
         Polygon_with_holes pwh( contour );
         polygons.join( contour );
 //        std::cout << "# pwhs: " << polygons.number_of_polygons_with_holes() << " valid " << polygons.is_valid() << std::endl;
-
-        num_contours++;
     }
 }
 #else
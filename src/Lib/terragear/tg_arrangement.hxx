@@ -33,6 +33,22 @@ typedef CGAL::Polygon_2<arrKernel>                          Polygon;
 typedef CGAL::Polygon_with_holes_2<arrKernel>               Polygon_with_holes;
 typedef CGAL::Polygon_set_2<arrKernel>                      Polygon_set;
 
+// A tgPolygon as a CGAL Polygon_set, with its bounding box.  valid is false
+// if the contours didn't make a valid set.
+class tgCgalPolygon
+{
+public:
+    bool            valid;
+    Polygon_set     ps;
+    CGAL::Bbox_2    bbox;
+};
+
+// Convert a polygon for the CGAL boolean operations.  The conversion is kept
+// with the polygon, so clipping against the same polygon again is free until
+// its contours change.  Not safe to call for the same polygon from two
+// threads at once.
+tgCgalPolygonPtr tgGetCgalPolygon( const tgPolygon& subject );
+
 class tgArrangement
 {
 public:
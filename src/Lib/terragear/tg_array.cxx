@@ -33,6 +33,7 @@
 #include <simgear/io/lowlevel.hxx>
 
 #include "tg_array.hxx"
+#include "tg_local_frame.hxx"
 
 using std::string;
 
@@ -321,12 +322,22 @@ double tgArray::closest_nonvoid_elev( double lon, double lat ) const {
     double minelev = -9999.0;
     SGGeod p0 = SGGeod::fromDeg( lon, lat );
 
+    // skipping the voids first doesn't change the closest one, but the
+    // frame distances do differ from SGGeodesy by up to its tolerance :
+    // of two grid points that close to the same distance, the other one
+    // may be picked
+    tgLocalFrame frame( p0 );
+
     for ( int row = 0; row < rows; row++ ) {
         for ( int col = 0; col < cols; col++ ) {
-            SGGeod p1 = SGGeod::fromDeg( originx + col * col_step, originy + row * row_step );
-            double dist = SGGeodesy::distanceM( p0, p1 );
             double elev = get_array_elev(col, row);
-            if ( dist < mindist && elev > -9000 ) {
+            if ( elev <= -9000 ) {
+                continue;
+            }
+
+            SGGeod p1 = SGGeod::fromDeg( originx + col * col_step, originy + row * row_step );
+            double dist = frame.DistanceM( p0, p1 );
+            if ( dist < mindist ) {
                 mindist = dist;
                 minelev = elev;
             }
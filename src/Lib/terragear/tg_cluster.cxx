@@ -1,297 +1,308 @@
-#include <iostream>
-#include <fstream>
-#include <cassert>
-#include <iterator>
-#include <CGAL/Cartesian.h>
-#include <vector>
 #include <math.h>
 #include <algorithm>
 
-#include <simgear/math/SGMath.hxx>
+#include <boost/unordered_set.hpp>
+
+#include <CGAL/centroid.h>
+#include <CGAL/Dimension.h>
+
+#include <simgear/debug/logstream.hxx>
 
 #include "tg_cluster.hxx"
-#include "tg_shapefile.hxx"
 
+// the old clustering could loop forever on either stage
+static const unsigned int max_merge_iterations = 1000;
+static const unsigned int max_relax_iterations = 40;
 
-std::list<EPECSegment_2>::iterator it;
-std::vector<EPECPoint_2>::iterator vfrom,vto;
-std::vector<EPECPoint_2>::iterator fcit;
+// rings of cells searched for the nearest centroid, before looking at all
+static const long max_search_rings = 8;
 
-EPECPoint_2 tgCluster::Locate(const EPECPoint_2& point)
+tgCluster::CellKey tgCluster::GetCell( double x, double y ) const
 {
-    VDLocateResult lr = vd.locate(point);
-    EPECPoint_2    q;
-    
-    if ( VDVertexHandle* v = boost::get<VDVertexHandle>(&lr) ) 
-    {
-        q = (*v)->site(0)->point();
-    } 
-    else if ( VDHalfedgeHandle* e = boost::get<VDHalfedgeHandle>(&lr) )
-    {
-        q = (*e)->up()->point();        
-    } 
-    else if ( VDFaceHandle* f = boost::get<VDFaceHandle>(&lr) ) 
-    {
-        q = (*f)->dual()->point();        
-    }
-    
-    return q;
+    return CellKey( (long)floor( x / radius ), (long)floor( y / radius ) );
 }
 
-void tgCluster::computenewcentroids(void)
+// the centroids sorted by cell, so the ones in a cell are together
+void tgCluster::BuildGrid( void )
 {
-    std::vector<tgVoronoiCell>::iterator    oc, nc;
-    
-    tag tg;
-    vd.clear();
-    for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-    {
-        (*oc).face = vd.insert((*oc).centroid);
-        (*oc).nodes.clear();
+    std::vector< std::pair<CellKey, unsigned int> > cells( cxs.size() );
+
+    for ( unsigned int c = 0; c < cxs.size(); c++ ) {
+        cells[c] = std::make_pair( GetCell( cxs[c], cys[c] ), c );
     }
-    assert( vd.is_valid() );
+    std::sort( cells.begin(), cells.end() );
 
-    for ( std::list<EPECPoint_2>::iterator it = nodes.begin(); it != nodes.end(); it++ )
-    {
-        EPECPoint_2 q = Locate(*it);
+    grid.clear();
+    grid.rehash( cells.size() );
+    grid_centroids.resize( cells.size() );
 
-        for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-        {
-            if ( (*oc).centroid == q ) {
-                (*oc).nodes.push_back(*it);
-                break;
-            }
+    for ( unsigned int i = 0; i < cells.size(); i++ ) {
+        const CellKey& cell = cells[i].first;
+
+        if ( i == 0 ) {
+            grid_min = grid_max = cell;
+        } else {
+            grid_min.first  = std::min( grid_min.first,  cell.first );
+            grid_min.second = std::min( grid_min.second, cell.second );
+            grid_max.first  = std::max( grid_max.first,  cell.first );
+            grid_max.second = std::max( grid_max.second, cell.second );
         }
-        
-#if 0
-        VDLocateResult lr = vd.locate(*it);
-        if ( VDVertexHandle* v = boost::get<VDVertexHandle>(&lr) ) 
-        {
-            EPECPoint_2 q = (*v)->site(0)->point();
-            for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-            {
-                if ( (*oc).centroid.x() == q.x() && (*oc).centroid.y() == q.y() ) {
-                    (*oc).nodes.push_back(*it);
-                    break;
+
+        if ( i == 0 || cell != cells[i-1].first ) {
+            grid[cell] = CellRange( i, i );
+        }
+        grid[cell].second = i + 1;
+        grid_centroids[i] = cells[i].second;
+    }
+}
+
+// Move every centroid to the centroid of the centroids within radius of it.
+// As in the old kd-tree search, a merged centroid is only kept if it isn't
+// one already, and it is summed in index order, so the same centroids
+// always give the same point.  Returns true if a new one was kept.
+bool tgCluster::MergeCentroids( void )
+{
+    std::vector<double>             new_xs, new_ys;
+    boost::unordered_set<PointKey>  kept;
+    std::vector<unsigned int>       near;
+    double                          r2 = radius * radius;
+    bool                            merged = false;
+
+    BuildGrid();
+
+    for ( unsigned int i = 0; i < cxs.size(); i++ ) {
+        CellKey cell = GetCell( cxs[i], cys[i] );
+
+        // with cells the size of the radius, the centroids within it are
+        // all in this cell, or the 8 around it
+        near.clear();
+        for ( long gx = cell.first - 1; gx <= cell.first + 1; gx++ ) {
+            for ( long gy = cell.second - 1; gy <= cell.second + 1; gy++ ) {
+                CellMap::const_iterator cit = grid.find( CellKey( gx, gy ) );
+                if ( cit == grid.end() ) {
+                    continue;
                 }
-            }
-        } 
-        else if ( VDHalfedgeHandle* e = boost::get<VDHalfedgeHandle>(&lr) )
-        {
-            EPECPoint_2 q = (*e)->up()->point();
-        
-            for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-            {
-                if ( (*oc).centroid.x() == q.x() && (*oc).centroid.y() == q.y() ) {
-                    (*oc).nodes.push_back(*it);
-                    break;
+
+                for ( unsigned int k = cit->second.first; k < cit->second.second; k++ ) {
+                    unsigned int j  = grid_centroids[k];
+                    double       dx = cxs[j] - cxs[i];
+                    double       dy = cys[j] - cys[i];
+
+                    if ( dx*dx + dy*dy <= r2 ) {
+                        near.push_back( j );
+                    }
                 }
             }
-        } 
-        else if ( VDFaceHandle* f = boost::get<VDFaceHandle>(&lr) ) 
-        {
-            EPECPoint_2 q = (*f)->dual()->point();
-            
-            for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-            {
-                if ( (*oc).centroid.x() == q.x() && (*oc).centroid.y() == q.y() ) {
-                    (*oc).nodes.push_back(*it);
-                    break;
-                }
+        }
+
+        if ( near.size() > 1 ) {
+            double sx = 0.0, sy = 0.0;
+
+            std::sort( near.begin(), near.end() );
+            for ( unsigned int k = 0; k < near.size(); k++ ) {
+                sx += cxs[near[k]];
+                sy += cys[near[k]];
+            }
+
+            PointKey cent( sx / near.size(), sy / near.size() );
+            if ( kept.find( cent ) == kept.end() ) {
+                new_xs.push_back( cent.first );
+                new_ys.push_back( cent.second );
+                kept.insert( cent );
+                merged = true;
             }
+        } else {
+            new_xs.push_back( cxs[i] );
+            new_ys.push_back( cys[i] );
+            kept.insert( PointKey( cxs[i], cys[i] ) );
         }
-#endif        
     }
 
-    // UPDATE THE CENTROIDS HERE
-    oc = oldcells.begin();
-    newcells.clear();
-    
-    for(oc = oldcells.begin(); oc!= oldcells.end(); oc++)
-    {
-        tgVoronoiCell newvc;
-        if ((*oc).nodes.empty())
-        {
-            newvc.centroid = (*oc).centroid;
-            newvc.face     = (*oc).face;
-            newvc.nodes    = (*oc).nodes;
-        }
-        else
-        {
-            newvc.centroid = CGAL::centroid((*oc).nodes.begin(),(*oc).nodes.end(),tg);
-            newvc.face     = (*oc).face;
-            newvc.nodes    = (*oc).nodes;
+    cxs.swap( new_xs );
+    cys.swap( new_ys );
+
+    return merged;
+}
+
+// Assign every point to its nearest centroid, and move each centroid with
+// points to their centroid.  Returns true once no centroid moves.
+bool tgCluster::Relax( void )
+{
+    std::vector<double>       sum_x( cxs.size(), 0.0 ), sum_y( cxs.size(), 0.0 );
+    std::vector<unsigned int> count( cxs.size(), 0 );
+    bool                      converged = true;
+
+    BuildGrid();
+
+    for ( unsigned int p = 0; p < points.size(); p++ ) {
+        unsigned int c = Nearest( xs[p], ys[p] );
+
+        cluster[p] = c;
+        sum_x[c] += xs[p];
+        sum_y[c] += ys[p];
+        count[c]++;
+    }
+
+    for ( unsigned int c = 0; c < cxs.size(); c++ ) {
+        if ( count[c] ) {
+            double x = sum_x[c] / count[c];
+            double y = sum_y[c] / count[c];
+
+            if ( x != cxs[c] || y != cys[c] ) {
+                cxs[c] = x;
+                cys[c] = y;
+                converged = false;
+            }
         }
-        newcells.push_back(newvc);        
     }
+
+    return converged;
 }
 
-tgCluster::tgCluster( std::list<EPECPoint_2>& points, double squaredError )
+// the centroid nearest to x, y - the first one on a tie, as the old cell
+// lookup did.  Searches the rings of cells around it, then all of them.
+unsigned int tgCluster::Nearest( double x, double y ) const
 {
-    int kiter = 40, iiter = 0;
-    bool is_equal = false;
-        
-    std::list<EPECPoint_2>::iterator lit;
-    std::vector<EPECPoint_2>::iterator it;
-    
-    // move to newcentroids
-    for ( lit = points.begin(); lit != points.end(); lit++ ) {
-        oldcentroids.push_back( (*lit) );
-    }
-    
-    bool merged_centroid = false;
-    int tree_iter = 1;
-    
-    do {
-        // move new centroids into kd-tree
-        std::cout << "Find centroids iteration " << tree_iter << " num_centroids is " << oldcentroids.size() << std::endl;
-        
-        tree.clear();
-        for ( it = oldcentroids.begin(); it != oldcentroids.end(); it++ ) {
-            tree.insert( (*it) );
+    CellKey      cell = GetCell( x, y );
+    unsigned int best = (unsigned int)-1;
+    double       best_d2 = 0.0;
+    long         rings = std::max( std::max( cell.first - grid_min.first, grid_max.first - cell.first ),
+                                   std::max( cell.second - grid_min.second, grid_max.second - cell.second ) );
+
+    for ( long k = 0; k <= std::min( rings, max_search_rings ); k++ ) {
+        // nothing in this ring can be closer than k-1 cells
+        double gap = ( k - 1 ) * radius;
+        if ( best != (unsigned int)-1 && k > 1 && gap * gap > best_d2 ) {
+            return best;
         }
-        
-        // clear new centroids
-        newcentroids.clear();
-
-        merged_centroid = false;
-        std::list<EPECPoint_2> query_result;
-        
-        for ( it = oldcentroids.begin(); it != oldcentroids.end(); it++ ) {
-            VDnodesFuzzyCir query_circle( (*it), 0.0000025);  // approx 25 cm
-            
-            // perform the query
-            query_result.clear();
-            tree.search(std::back_inserter( query_result ), query_circle);
-            
-            // we should always have at least one result
-            if ( query_result.size() > 0 ) 
-            {                 
-                if ( query_result.size() > 1 ) {
-                    tag tg;
-                    EPECPoint_2 cent = centroid( query_result.begin(), query_result.end(), tg);
-                    
-                    if ( std::find(newcentroids.begin(), newcentroids.end(), cent ) == newcentroids.end() ) {                     
-                        newcentroids.push_back( cent );
-                        merged_centroid = true;
+
+        for ( long gx = cell.first - k; gx <= cell.first + k; gx++ ) {
+            long step = ( gx == cell.first - k || gx == cell.first + k ) ? 1 : std::max( 2 * k, 1L );
+
+            for ( long gy = cell.second - k; gy <= cell.second + k; gy += step ) {
+                CellMap::const_iterator cit = grid.find( CellKey( gx, gy ) );
+                if ( cit == grid.end() ) {
+                    continue;
+                }
+
+                for ( unsigned int i = cit->second.first; i < cit->second.second; i++ ) {
+                    unsigned int c  = grid_centroids[i];
+                    double       dx = cxs[c] - x;
+                    double       dy = cys[c] - y;
+                    double       d2 = dx*dx + dy*dy;
+
+                    if ( best == (unsigned int)-1 || d2 < best_d2 || ( d2 == best_d2 && c < best ) ) {
+                        best    = c;
+                        best_d2 = d2;
                     }
-                } else {
-                    newcentroids.push_back( *(query_result.begin()) );
                 }
             }
         }
-        
-        // copy new centroids to old array
-        oldcentroids.clear();
-        for ( it = newcentroids.begin(); it != newcentroids.end(); it++ ) {
-            oldcentroids.push_back( *it );
-        }
-        
-        tree_iter++;
-    } while ( merged_centroid );      
-    
-    nodes = points;
-    
-    // create voronoi cells for each centroid
-    for ( it = oldcentroids.begin(); it != oldcentroids.end(); it++ ) {
-        tgVoronoiCell newvc;
-        newvc.centroid = *it;
-        oldcells.push_back( newvc );
     }
-    
-    while(1)
-    {
-        if(iiter != kiter)
-        {
-            std::cout << "Voronoi Relaxation iteration " << iiter << std::endl;
-            
-            computenewcentroids();
-            iiter = iiter + 1;
-
-            if(newcells.size() < oldcells.size())
-            {
-                is_equal = std::equal(newcells.begin(),newcells.end(),oldcells.begin());
-            }
-            else
-            {
-                is_equal = std::equal(oldcells.begin(),oldcells.end(),newcells.begin());
-            }
 
-            if(is_equal)
-            {
-                is_equal = false;
-                std::cout << "Reached Convergence.." << std::endl;
-                
-                //DumpVD(newcells);
-                break;
-            }
-            else 
-            {
-                // iterate again - move new to old
-                oldcells.clear();
-                std::vector<tgVoronoiCell>::iterator cit = newcells.begin();
-                for(cit = newcells.begin(); cit!= newcells.end(); cit++)
-                {
-                    tgVoronoiCell newvc;
-                    newvc.centroid = (*cit).centroid;
-                    oldcells.push_back( newvc );       
-                }
-            }   
+    if ( best != (unsigned int)-1 && rings <= max_search_rings ) {
+        return best;
+    }
+
+    // far from every cell searched - look at all of them
+    for ( unsigned int c = 0; c < cxs.size(); c++ ) {
+        double dx = cxs[c] - x;
+        double dy = cys[c] - y;
+        double d2 = dx*dx + dy*dy;
+
+        if ( best == (unsigned int)-1 || d2 < best_d2 || ( d2 == best_d2 && c < best ) ) {
+            best    = c;
+            best_d2 = d2;
         }
-        else
-        {
-            std::cout << "Reached maximum number of iterations - Exiting..." << std::endl;
-        }	
     }
-    std::cout << "Finished" << std::endl;
+
+    return best;
 }
 
-void tgCluster::DumpVD(std::vector<tgVoronoiCell>& cells)
+tgCluster::tgCluster( std::list<EPECPoint_2>& pts, double r )
 {
-    char description[32];
-    int  cell_id = 1;
-    
-    std::vector<tgVoronoiCell>::iterator cit = newcells.begin();    
-    for(cit = cells.begin(); cit!= cells.end(); cit++, cell_id++)
-    {
-        std::vector<tgSegment>   edges;
-        
-        // label each centroid
-        sprintf( description, "voronoi_cell_%04d", cell_id );
-        
-        // dump centroid ( only if there are more than one nodes in the cell )
-        if ( (*cit).nodes.size() > 1 ) {
-            SGGeod centroid = SGGeod::fromDeg( CGAL::to_double( (*cit).centroid.x() ),
-                                               CGAL::to_double( (*cit).centroid.y() ) );
-            tgShapefile::FromGeod( centroid, "./edge_dbg", "centroids", description );
+    radius = r;
+
+    if ( pts.empty() ) {
+        return;
+    }
+
+    // the nodes are close together : relative to the first one, their
+    // doubles resolve much smaller differences than in degrees
+    origin_x = CGAL::to_double( pts.front().x() );
+    origin_y = CGAL::to_double( pts.front().y() );
+
+    // duplicates are kept - they weigh the centroids, as they did
+    for ( std::list<EPECPoint_2>::const_iterator lit = pts.begin(); lit != pts.end(); lit++ ) {
+        PointKey key( CGAL::to_double( lit->x() ), CGAL::to_double( lit->y() ) );
+
+        if ( lookup.find( key ) == lookup.end() ) {
+            lookup[key] = points.size();
         }
-        
-        // dump edges
-        VDCcbHalfedgeCirculator ec_start = (*cit).face->ccb();
-        VDCcbHalfedgeCirculator ec       = ec_start;
-        
-        edges.clear();
-        do
-        {
-            VDHalfedgeHandle e = ec;
-            if ( e->is_segment() ) {
-                SGGeod gsrc = SGGeod::fromDeg( CGAL::to_double(e->source()->point().x()),
-                                               CGAL::to_double(e->source()->point().y()) );
-                SGGeod gtrg = SGGeod::fromDeg( CGAL::to_double(e->target()->point().x()),
-                                               CGAL::to_double(e->target()->point().y()) );
-                
-                edges.push_back( tgSegment(gsrc, gtrg) );
-            }
-            
-        } while ( ++ec != ec_start );
-        tgShapefile::FromSegmentList( edges, false, "./edge_dbg", "edges", description );
-
-        // generate node list
-        for ( std::vector<EPECPoint_2>::iterator nit = (*cit).nodes.begin(); nit != (*cit).nodes.end(); nit++ ) 
-        {
-            SGGeod node = SGGeod::fromDeg( CGAL::to_double( (*nit).x() ),
-                                           CGAL::to_double( (*nit).y() ) );
-            tgShapefile::FromGeod( node, "./edge_dbg", "nodes", description );            
-        }    
+        points.push_back( *lit );
+        xs.push_back( key.first - origin_x );
+        ys.push_back( key.second - origin_y );
     }
-}
\ No newline at end of file
+
+    // merge the centroids, starting with the points
+    cxs = xs;
+    cys = ys;
+
+    unsigned int merges = 1;
+    while ( MergeCentroids() ) {
+        if ( ++merges == max_merge_iterations ) {
+            SG_LOG(SG_GENERAL, SG_ALERT, "tgCluster : centroids still merging after " << merges << " iterations" );
+            break;
+        }
+    }
+
+    // then relax them over the points
+    unsigned int relaxes = 1;
+    cluster.resize( points.size() );
+    while ( !Relax() ) {
+        if ( ++relaxes > max_relax_iterations ) {
+            SG_LOG(SG_GENERAL, SG_WARN, "tgCluster : centroids still moving after " << max_relax_iterations << " iterations" );
+            break;
+        }
+    }
+
+    // exact centroids of the points of each cluster
+    std::vector< std::vector<EPECPoint_2> > cluster_points( cxs.size() );
+    for ( unsigned int p = 0; p < points.size(); p++ ) {
+        cluster_points[cluster[p]].push_back( points[p] );
+    }
+
+    CGAL::Dimension_tag<0> tg;
+    unsigned int           merged = 0;
+
+    centroids.resize( cxs.size() );
+    for ( unsigned int c = 0; c < cxs.size(); c++ ) {
+        if ( cluster_points[c].size() > 1 ) {
+            centroids[c] = CGAL::centroid( cluster_points[c].begin(), cluster_points[c].end(), tg );
+            merged++;
+        } else if ( cluster_points[c].size() == 1 ) {
+            centroids[c] = cluster_points[c][0];
+        } else {
+            centroids[c] = EPECPoint_2( origin_x + cxs[c], origin_y + cys[c] );
+        }
+    }
+
+    // for the points that weren't clustered
+    BuildGrid();
+
+    SG_LOG(SG_GENERAL, SG_DEBUG, "tgCluster : " << points.size() << " points in " << centroids.size() << " clusters - " << merged << " merged, after " << merges << " merge and " << relaxes << " relax iterations" );
+}
+
+EPECPoint_2 tgCluster::Locate( const EPECPoint_2& point )
+{
+    PointMap::const_iterator it = lookup.find( PointKey( CGAL::to_double( point.x() ), CGAL::to_double( point.y() ) ) );
+
+    if ( it != lookup.end() ) {
+        return centroids[ cluster[it->second] ];
+    }
+    if ( centroids.empty() ) {
+        return point;
+    }
+
+    return centroids[ Nearest( CGAL::to_double( point.x() ) - origin_x, CGAL::to_double( point.y() ) - origin_y ) ];
+}
@@ -1,91 +1,57 @@
 #ifndef __TG_CLUSTER_HXX__
 #define __TG_CLUSTER_HXX__
 
-#include "tg_cgal_epec.hxx"
-#include "tg_cgal.hxx"
-
-// includes for defining the Voronoi diagram adaptor
-#include <CGAL/basic.h>
-#include <CGAL/Triangulation_2.h>
-#include <CGAL/Delaunay_triangulation_2.h>
-#include <CGAL/Voronoi_diagram_2.h>
-#include <CGAL/Delaunay_triangulation_adaptation_traits_2.h>
-#include <CGAL/Delaunay_triangulation_adaptation_policies_2.h>
-#include <CGAL/centroid.h>
-#include <CGAL/Dimension.h>
-
-#include <CGAL/Kd_tree.h>
-#include <CGAL/algorithm.h>
-#include <CGAL/Fuzzy_sphere.h>
-#include <CGAL/Search_traits_2.h>
-
-// typedefs for defining the adaptor
-typedef CGAL::Delaunay_triangulation_2<EPECKernel>                           DT;
-typedef CGAL::Delaunay_triangulation_adaptation_traits_2<DT>                 AT;
-typedef CGAL::Delaunay_triangulation_caching_degeneracy_removal_policy_2<DT> AP;
-typedef CGAL::Voronoi_diagram_2<DT,AT,AP>                                    VD;
-typedef CGAL::Dimension_tag<0>                                               tag;
-
-//typedef K::Point_2                            Point;
-typedef EPECKernel::Iso_rectangle_2             EPECIsoRectangle;
-
-// typedef for the result type of the point location
-typedef AT::Site_2                              EPECSite;
-
-typedef VD::Locate_result                       VDLocateResult;
-typedef AT::Nearest_site_2                      ATLocateResult;
-typedef VD::Vertex_handle                       VDVertexHandle;
-typedef VD::Face_handle                         VDFaceHandle;
-typedef VD::Halfedge_handle                     VDHalfedgeHandle;
-typedef VD::Ccb_halfedge_circulator             VDCcbHalfedgeCirculator;
-typedef VD::Halfedge_around_vertex_circulator   VDHalfedge_around_vertex_circulator;
+#include <list>
+#include <vector>
 
-//typedef CGAL::Search_traits_2<EPECKernel>                           nodesTraitsBase;
-//typedef CGAL::Search_traits_adapter<nodesPointHandle, CGAL::Nth_of_tuple_property_map<0, nodesPointHandle>,nodesTraitsBase>  nodesTraits;
-typedef CGAL::Search_traits_2<EPECKernel>                           VDnodesTraits;
+#include <boost/unordered_map.hpp>
 
-typedef CGAL::Fuzzy_sphere<VDnodesTraits>                           VDnodesFuzzyCir;
-typedef CGAL::Kd_tree<VDnodesTraits>                                VDnodesTree;
-
-typedef std::vector<EPECPoint_2>                Points;
-typedef std::vector<Points>                     PointsArray;
+#include "tg_cgal_epec.hxx"
+#include "tg_cgal.hxx"
 
-struct tgVoronoiCell 
+// Clusters the nodes closer to each other than a radius, the way the old
+// kd-tree and Voronoi diagram clustering did, on double coordinates and a
+// hash grid :
+//  - every centroid moves to the centroid of the centroids within radius of
+//    it, dropping duplicates, until no new centroid appears.  The first
+//    centroids are the nodes.
+//  - then each node is assigned to its nearest centroid, and each centroid
+//    moved to the centroid of its nodes, until nothing moves - at most 40
+//    times.
+// Locate returns the exact centroid of the nodes assigned to the cluster.
+class tgCluster
 {
 public:
-    
-    EPECPoint_2              centroid;
-    VDFaceHandle             face;
-    std::vector<EPECPoint_2> nodes;
-    
-    bool operator==(const tgVoronoiCell& other ) {
-        return (centroid == other.centroid);
-    }
-};
+    tgCluster( std::list<EPECPoint_2>& points, double radius );
 
-class tgCluster 
-{
-public:
-    tgCluster( std::list<EPECPoint_2>& points, double squaredError );
+    // the centroid nearest to point - for the clustered points, the
+    // centroid of their cluster
     EPECPoint_2 Locate( const EPECPoint_2& point );
-    
-private:
-    void computenewcentroids(void);
-    
-    std::list<EPECPoint_2> nodes;
-    int numcentroids;
-    
-    std::vector<tgsegment_list>  v_faces;       // segments making up the face
-    
-    PointsArray vpoints;
 
-    std::vector<EPECPoint_2>   oldcentroids, newcentroids;
-    std::vector<tgVoronoiCell> oldcells, newcells;
-    
-    VDnodesTree tree;
-    VD          vd;
-    
-    void DumpVD( std::vector<tgVoronoiCell>& cells );
+private:
+    typedef std::pair<long, long>                                  CellKey;
+    typedef std::pair<unsigned int, unsigned int>                  CellRange;
+    typedef boost::unordered_map<CellKey, CellRange>               CellMap;
+    typedef std::pair<double, double>                              PointKey;
+    typedef boost::unordered_map<PointKey, unsigned int>           PointMap;
+
+    CellKey      GetCell( double x, double y ) const;
+    void         BuildGrid( void );
+    bool         MergeCentroids( void );
+    bool         Relax( void );
+    unsigned int Nearest( double x, double y ) const;
+
+    double                     radius;
+    std::vector<EPECPoint_2>   points;          // with duplicates
+    double                     origin_x, origin_y;
+    std::vector<double>        xs, ys;          // points as doubles, from origin
+    std::vector<double>        cxs, cys;        // the centroids as doubles
+    CellMap                    grid;            // cells of radius, to the
+    std::vector<unsigned int>  grid_centroids;  // centroids in them
+    CellKey                    grid_min, grid_max;
+    std::vector<unsigned int>  cluster;         // centroid of each point
+    std::vector<EPECPoint_2>   centroids;       // exact, once assigned
+    PointMap                   lookup;          // point to its index
 };
 
-#endif /* __TG_CLUSTER_HXX__ */
\ No newline at end of file
+#endif /* __TG_CLUSTER_HXX__ */
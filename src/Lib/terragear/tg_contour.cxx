@@ -2,11 +2,17 @@
 #include <simgear/io/lowlevel.hxx>
 #include <simgear/debug/logstream.hxx>
 
+#include <algorithm>
+
+#include <boost/unordered_map.hpp>
+
 #include "tg_misc.hxx"
 #include "tg_accumulator.hxx"
 #include "tg_contour.hxx"
+#include "tg_local_frame.hxx"
 #include "tg_polygon.hxx"
 #include "tg_unique_tgnode.hxx"
+#include "tg_node_grid.hxx"
 #include "tg_shapefile.hxx"
 
 #define DEBUG_POLY_CLEAN    SG_INFO
@@ -153,90 +159,106 @@ void tgContour::RemoveAntenna( void )
 #endif    
 }
 
+// cells of the SGGeod_isEqual2D tolerance - equal nodes are in the same or
+// neighbouring cells
+#define CYCLE_CELL_SIZE     (0.000001)
+
+typedef std::pair<long, long>                                       CycleCell;
+typedef boost::unordered_map<CycleCell, std::vector<unsigned int> > CycleCellMap;
+
+static CycleCell GetCycleCell( const SGGeod& node )
+{
+    return CycleCell( (long)floor( node.getLongitudeDeg() / CYCLE_CELL_SIZE ),
+                      (long)floor( node.getLatitudeDeg()  / CYCLE_CELL_SIZE ) );
+}
+
+// add the subject nodes open[start..] to result as a contour - unless it is
+// degenerate
+static void AddCycle( const tgContour& subject, const std::vector<unsigned int>& open, unsigned int start, tgcontour_list& result )
+{
+    tgContour cycle;
+
+    for ( unsigned int n = start; n < open.size(); n++ ) {
+        cycle.AddNode( subject.GetNode( open[n] ) );
+    }
+
+    if ( cycle.GetSize() <= 2 ) {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: size is " << cycle.GetSize() << " discard." );
+    } else if ( cycle.GetArea() <= SG_EPSILON*SG_EPSILON ) {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: area is " << cycle.GetArea() << " discard." );
+    } else {
+        cycle.SetHole( subject.GetHole() );
+        result.push_back( cycle );
+    }
+}
+
 bool tgContour::RemoveCycles( const tgContour& subject, tgcontour_list& result )
 {
     SG_LOG(SG_GENERAL, SG_DEBUG, "remove cycles : contour has " << subject.GetSize() << " points" );
     bool split = false;
 
-    if ( subject.GetSize() > 2) {
-        if ( subject.GetArea() > SG_EPSILON*SG_EPSILON ) {
-            // Step 1 - find the first duplicate point
-            for ( unsigned int i = 0; i < subject.GetSize() && !split; i++ ) {
-                // first check until the end of the vector
-                for ( unsigned int j = i + 1; j < subject.GetSize() && !split; j++ ) {
-                    if ( SGGeod_isEqual2D( subject.GetNode(i), subject.GetNode(j) ) ) {
-                        SG_LOG(SG_GENERAL, SG_DEBUG, "detected a dupe: i = " << i << " j = " << j );
-                        split = true;
-
-                        tgContour first;
-                        if ( j < subject.GetSize()-1 ) {
-                            SG_LOG(SG_GENERAL, SG_DEBUG, "first contour is " << 0 << ".." << i << "," << j+1 << ".." <<  subject.GetSize()-1);
-
-                            // first contour is (0 .. i) + (j+1..size()-1)
-                            for ( unsigned int n=0; n<=i; n++) {
-                                first.AddNode( subject.GetNode(n) );
-                            }
-                            for ( unsigned int n=j+1; n<=subject.GetSize()-1; n++) {
-                                first.AddNode( subject.GetNode(n) );
-                            }
-                        } else {
-                            SG_LOG(SG_GENERAL, SG_DEBUG, "first contour is " << 0 << ".." << i );
-
-                            // first contour is (0 .. i)
-                            for ( unsigned int n=0; n<=i; n++) {
-                                first.AddNode( subject.GetNode(n) );
-                            }
-                        }
-
-                        tgContour second;
-                        SG_LOG(SG_GENERAL, SG_DEBUG, "second contour is " << i << ".." << j-1 );
-
-                        // second contour is (i..j-1)
-                        for ( unsigned int n=i; n<j; n++) {
-                            second.AddNode( subject.GetNode(n) );
-                        }
-
-                        // determine hole vs boundary
-                        if ( IsInside( first, second ) ) {
-                            SG_LOG(SG_GENERAL, SG_DEBUG, "first contur is within second contour " );
-
-                            // first contour is inside second : mark first contour as opposite of subject
-                            first.SetHole( !subject.GetHole() );
-                            second.SetHole( subject.GetHole() );
-                        } else if ( IsInside( second, first ) ) {
-                            SG_LOG(SG_GENERAL, SG_DEBUG, "second contur is within first contour " );
-
-                            // second contour is inside first : mark second contour as opposite of subject
-                            first.SetHole(   subject.GetHole() );
-                            second.SetHole( !subject.GetHole() );
-                        } else {
-                            SG_LOG(SG_GENERAL, SG_DEBUG, "conturs are (mostly) disjoint " );
-
-                            // neither contour is inside - bots are the same as subject
-                            first.SetHole(   subject.GetHole() );
-                            second.SetHole(  subject.GetHole() );
-                        }
-
-                        SG_LOG(SG_GENERAL, SG_DEBUG, "remove first: size " << first.GetSize() );
-                        first.SetHole( subject.GetHole() );
-                        RemoveCycles( first, result );
-
-                        SG_LOG(SG_GENERAL, SG_DEBUG, "remove second: size " << second.GetSize() );
-                        second.SetHole( subject.GetHole() );
-                        RemoveCycles( second, result );
+    if ( subject.GetSize() <= 2 ) {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: size is " << subject.GetSize() << " discard." );
+        return split;
+    }
+    if ( subject.GetArea() <= SG_EPSILON*SG_EPSILON ) {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: area is " << subject.GetArea() << " discard." );
+        return split;
+    }
+
+    // Walk the contour, keeping the nodes of the cycle still open on a
+    // stack.  A node equal to an open one closes a cycle : the nodes from
+    // the equal one up are split off as their own contour, and the walk
+    // continues from the equal node.
+    std::vector<unsigned int> open;
+    CycleCellMap              cells;
+
+    open.reserve( subject.GetSize() );
+    for ( unsigned int i = 0; i < subject.GetSize(); i++ ) {
+        const SGGeod& node  = subject.GetNode( i );
+        CycleCell     cell  = GetCycleCell( node );
+        int           match = -1;
+
+        for ( long cx = cell.first - 1; cx <= cell.first + 1; cx++ ) {
+            for ( long cy = cell.second - 1; cy <= cell.second + 1; cy++ ) {
+                CycleCellMap::const_iterator cit = cells.find( CycleCell( cx, cy ) );
+                if ( cit == cells.end() ) {
+                    continue;
+                }
+
+                for ( unsigned int k = 0; k < cit->second.size(); k++ ) {
+                    int pos = cit->second[k];
+                    if ( pos > match && SGGeod_isEqual2D( subject.GetNode( open[pos] ), node ) ) {
+                        match = pos;
                     }
                 }
             }
+        }
+
+        if ( match >= 0 ) {
+            SG_LOG(SG_GENERAL, SG_DEBUG, "detected a dupe: i = " << open[match] << " j = " << i );
+            split = true;
 
-            if (!split) {
-                SG_LOG(SG_GENERAL, SG_DEBUG, "no dupes - complete" );
-                result.push_back( subject );
+            AddCycle( subject, open, match, result );
+
+            // close the cycle - positions leave their cells in the order
+            // they entered
+            while ( open.size() > (unsigned int)match + 1 ) {
+                cells[ GetCycleCell( subject.GetNode( open.back() ) ) ].pop_back();
+                open.pop_back();
             }
         } else {
-            SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: area is " << subject.GetArea() << " discard." );
+            cells[cell].push_back( open.size() );
+            open.push_back( i );
         }
+    }
+
+    if ( split ) {
+        // what is left of the contour
+        AddCycle( subject, open, 0, result );
     } else {
-        SG_LOG(SG_GENERAL, SG_DEBUG, "degenerate contour: size is " << subject.GetSize() << " discard." );
+        SG_LOG(SG_GENERAL, SG_DEBUG, "no dupes - complete" );
+        result.push_back( subject );
     }
 
     return split;
@@ -367,9 +389,14 @@ unsigned int tgContour::RemoveDups( void )
 
 tgContour tgContour::SplitLongEdges( const tgContour& subject, double max_len )
 {
-    SGGeod      p0, p1;
-    double      dist;
-    tgContour   result;
+    SGGeod       p0, p1;
+    double       dist;
+    tgContour    result;
+
+    // the distances differ from SGGeodesy by the frame tolerance at most,
+    // so only an edge within that of max_len can be split differently -
+    // and then into one segment more or less
+    tgLocalFrame frame( subject.GetNode( 0 ) );
 
     for ( unsigned i = 0; i < subject.GetSize() - 1; i++ ) {
         SG_LOG(SG_GENERAL, SG_DEBUG, "point = " << i);
@@ -382,7 +409,7 @@ tgContour tgContour::SplitLongEdges( const tgContour& subject, double max_len )
         if ( fabs(p0.getLatitudeDeg()) < (90.0 - SG_EPSILON) ||
              fabs(p1.getLatitudeDeg()) < (90.0 - SG_EPSILON) )
         {
-            dist = SGGeodesy::distanceM( p0, p1 );
+            dist = frame.DistanceM( p0, p1 );
             SG_LOG(SG_GENERAL, SG_DEBUG, "distance = " << dist);
 
             if ( dist > max_len ) {
@@ -412,7 +439,7 @@ tgContour tgContour::SplitLongEdges( const tgContour& subject, double max_len )
     p0 = subject.GetNode( subject.GetSize() - 1 );
     p1 = subject.GetNode( 0 );
 
-    dist = SGGeodesy::distanceM( p0, p1 );
+    dist = frame.DistanceM( p0, p1 );
     SG_LOG(SG_GENERAL, SG_DEBUG, "distance = " << dist);
 
     if ( dist > max_len ) {
@@ -745,9 +772,20 @@ bool IsNodeCollinear( const SGGeod& start, const SGGeod& end, const SGGeod& node
 
     return found_node;    
 }
-                             
+
+static inline const SGGeod& ColinearPosition( const SGGeod& node )
+{
+    return node;
+}
+
+static inline const SGGeod& ColinearPosition( const TGNode* node )
+{
+    return node->GetPosition();
+}
+
+template <class N>
 static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
-                                  const std::vector<SGGeod>& nodes, SGGeod& result,
+                                  const std::vector<N>& nodes, N& result,
                                   double bbEpsilon, double errEpsilon )
 {
     bool found_node = false;
@@ -778,7 +816,7 @@ static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
 
         for ( int i = 0; i < (int)nodes.size(); ++i ) {
             // cout << i << endl;
-            SGGeod current = nodes[i];
+            SGGeod current = ColinearPosition( nodes[i] );
 
             if ( (current.getLongitudeDeg() > (p_min.getLongitudeDeg() + (bbEpsilon))) && (current.getLongitudeDeg() < (p_max.getLongitudeDeg() - (bbEpsilon))) ) {
                 y_err = fabs(current.getLatitudeDeg() - (m * current.getLongitudeDeg() + b));
@@ -786,7 +824,7 @@ static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
                 if ( y_err < errEpsilon ) {
                     found_node = true;
                     if ( y_err < y_err_min ) {
-                        result = current;
+                        result = nodes[i];
                         y_err_min = y_err;
                     }
                 }
@@ -807,7 +845,7 @@ static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
         b1 = p_max.getLongitudeDeg() - m1 * p_max.getLatitudeDeg();
 
         for ( int i = 0; i < (int)nodes.size(); ++i ) {
-            SGGeod current = nodes[i];
+            SGGeod current = ColinearPosition( nodes[i] );
 
             if ( (current.getLatitudeDeg() > (p_min.getLatitudeDeg() + (bbEpsilon))) && (current.getLatitudeDeg() < (p_max.getLatitudeDeg() - (bbEpsilon))) ) {
 
@@ -816,7 +854,7 @@ static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
                 if ( x_err < errEpsilon ) {
                     found_node = true;
                     if ( x_err < x_err_min ) {
-                        result = current;
+                        result = nodes[i];
                         x_err_min = x_err;
                     }
                 }
@@ -827,198 +865,210 @@ static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
     return found_node;
 }
 
-static bool FindIntermediateNode( const SGGeod& start, const SGGeod& end,
-                                  const std::vector<TGNode*>& nodes, TGNode*& result,
-                                  double bbEpsilon, double errEpsilon )
+// Is node within margin of the segment start -> end : no further than margin
+// from the line along the minor axis (as FindIntermediateNode measures the
+// error), and no further than margin past either end along the major axis.
+// A node colinear with a segment whose ends are within margin of this one is
+// always within 2 * margin of it.
+static bool IsNodeNearSegment( const SGGeod& start, const SGGeod& end, const SGGeod& node, double margin )
 {
-    bool found_node = false;
-    double m, m1, b, b1, y_err, x_err, y_err_min, x_err_min;
-    
-    SGGeod p0 = start;
-    SGGeod p1 = end;
-    
-    double xdist = fabs(p0.getLongitudeDeg() - p1.getLongitudeDeg());
-    double ydist = fabs(p0.getLatitudeDeg()  - p1.getLatitudeDeg());
-    
-    x_err_min = xdist + 1.0;
-    y_err_min = ydist + 1.0;
-    
-    if ( xdist > ydist ) {
-        // sort these in a sensible order
-        SGGeod p_min, p_max;
-        if ( p0.getLongitudeDeg() < p1.getLongitudeDeg() ) {
-            p_min = p0;
-            p_max = p1;
-        } else {
-            p_min = p1;
-            p_max = p0;
-        }
-        
-        m = (p_min.getLatitudeDeg() - p_max.getLatitudeDeg()) / (p_min.getLongitudeDeg() - p_max.getLongitudeDeg());
-        b = p_max.getLatitudeDeg() - m * p_max.getLongitudeDeg();
-        
-        for ( int i = 0; i < (int)nodes.size(); ++i ) {
-            // cout << i << endl;
-            SGGeod current = nodes[i]->GetPosition();
-            
-            if ( (current.getLongitudeDeg() > (p_min.getLongitudeDeg() + (bbEpsilon))) && (current.getLongitudeDeg() < (p_max.getLongitudeDeg() - (bbEpsilon))) ) {
-                y_err = fabs(current.getLatitudeDeg() - (m * current.getLongitudeDeg() + b));
-                
-                if ( y_err < errEpsilon ) {
-                    found_node = true;
-                    if ( y_err < y_err_min ) {
-                        result = nodes[i];
-                        y_err_min = y_err;
-                    }
-                }
-            }
-        }
-    } else {
-        // sort these in a sensible order
-        SGGeod p_min, p_max;
-        if ( p0.getLatitudeDeg() < p1.getLatitudeDeg() ) {
-            p_min = p0;
-            p_max = p1;
-        } else {
-            p_min = p1;
-            p_max = p0;
-        }
-        
-        m1 = (p_min.getLongitudeDeg() - p_max.getLongitudeDeg()) / (p_min.getLatitudeDeg() - p_max.getLatitudeDeg());
-        b1 = p_max.getLongitudeDeg() - m1 * p_max.getLatitudeDeg();
-        
-        for ( int i = 0; i < (int)nodes.size(); ++i ) {
-            SGGeod current = nodes[i]->GetPosition();
-            
-            if ( (current.getLatitudeDeg() > (p_min.getLatitudeDeg() + (bbEpsilon))) && (current.getLatitudeDeg() < (p_max.getLatitudeDeg() - (bbEpsilon))) ) {
-                
-                x_err = fabs(current.getLongitudeDeg() - (m1 * current.getLatitudeDeg() + b1));
-                
-                if ( x_err < errEpsilon ) {
-                    found_node = true;
-                    if ( x_err < x_err_min ) {
-                        result = nodes[i];
-                        x_err_min = x_err;
-                    }
-                }
+    double x0 = start.getLongitudeDeg(), y0 = start.getLatitudeDeg();
+    double x1 = end.getLongitudeDeg(),   y1 = end.getLatitudeDeg();
+    double x  = node.getLongitudeDeg(),  y  = node.getLatitudeDeg();
+
+    if ( !( fabs(x0 - x1) > fabs(y0 - y1) ) ) {
+        std::swap( x0, y0 );
+        std::swap( x1, y1 );
+        std::swap( x, y );
+    }
+
+    if ( x < std::min( x0, x1 ) - margin || x > std::max( x0, x1 ) + margin ) {
+        return false;
+    }
+    if ( x0 == x1 ) {
+        return fabs( y - y0 ) <= margin;
+    }
+
+    return fabs( y - (y0 + (x - x0) * (y1 - y0) / (x1 - x0)) ) <= margin;
+}
+
+// Where the colinear search gets its nodes from : a node list, searched in
+// list order
+template <class N>
+class ColinearNodeList
+{
+public:
+    typedef N node_type;
+
+    ColinearNodeList( const std::vector<N>& n ) : nodes(n) {}
+
+    void Find( const SGGeod& p0, const SGGeod& p1, double margin, std::vector<N>& found ) const
+    {
+        found.clear();
+        for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+            if ( IsNodeNearSegment( p0, p1, ColinearPosition( nodes[i] ), margin ) ) {
+                found.push_back( nodes[i] );
             }
         }
     }
-    
-    return found_node;
-}
 
-static void AddIntermediateNodes( const SGGeod& p0, const SGGeod& p1, const std::vector<SGGeod>& nodes, tgContour& result, double bbEpsilon, double errEpsilon )
+private:
+    const std::vector<N>& nodes;
+};
+
+// or the nodes of a tgNodeGrid inside bounds, in node order
+class ColinearNodeGrid
 {
-    SGGeod new_pt;
+public:
+    typedef TGNode* node_type;
 
-    SG_LOG(SG_GENERAL, SG_BULK, "   " << p0 << " <==> " << p1 );
+    ColinearNodeGrid( const tgNodeGrid& g, const tgRectangle& b ) : grid(g), bounds(b) {}
 
-    bool found_extra = FindIntermediateNode( p0, p1, nodes, new_pt, bbEpsilon, errEpsilon );
+    void Find( const SGGeod& p0, const SGGeod& p1, double margin, std::vector<TGNode*>& found ) const
+    {
+        std::vector<unsigned int> candidates;
+        TGNodes&                  nodes = grid.GetNodes();
 
-    if ( found_extra ) {
-        AddIntermediateNodes( p0, new_pt, nodes, result, bbEpsilon, errEpsilon  );
+        // the grid cells hold the nodes where they were when it was built -
+        // nodes moved onto an edge since have moved by less than margin
+        grid.FindCandidates( p0, p1, 2 * margin, bounds, candidates );
 
-        result.AddNode( new_pt );
-        SG_LOG(SG_GENERAL, SG_BULK, "    adding = " << new_pt);
+        found.clear();
+        for ( unsigned int i = 0; i < candidates.size(); i++ ) {
+            TGNode* node = &nodes[candidates[i]];
 
-        AddIntermediateNodes( new_pt, p1, nodes, result, bbEpsilon, errEpsilon  );
+            if ( IsNodeNearSegment( p0, p1, node->GetPosition(), margin ) ) {
+                found.push_back( node );
+            }
+        }
     }
-}
+
+private:
+    const tgNodeGrid&   grid;
+    tgRectangle         bounds;
+};
 
 extern SGGeod InterpolateElevation( const SGGeod& dst_node, const SGGeod& start, const SGGeod& end );
 
-static void AddIntermediateNodes( const SGGeod& p0, const SGGeod& p1, bool preserve3d, std::vector<TGNode*>& nodes, tgContour& result, double bbEpsilon, double errEpsilon )
+static inline SGGeod PlaceIntermediateNode( const SGGeod& p0, const SGGeod& p1, bool preserve3d, const SGGeod& new_pt )
 {
-    TGNode* new_pt = NULL;
-    SGGeod  new_geode;
-    
-    SG_LOG(SG_GENERAL, SG_BULK, "   " << p0 << " <==> " << p1 );
-    
-    bool found_extra = FindIntermediateNode( p0, p1, nodes, new_pt, bbEpsilon, errEpsilon );
-    
-    if ( found_extra && new_pt ) {
-        if ( preserve3d ) {
-            // when preserving elevation - it's important not to change the contour
-            // move the new node to the contour, instead of moving the contour to the point
-            tgSegment seg( p0, p1 );
-            new_geode = seg.Project( new_pt->GetPosition() );
-            
-            // interpolate the new nodes elevation based on p0, p1            
-            new_geode = InterpolateElevation( new_geode, p0, p1 );
-            
-            SG_LOG(SG_GENERAL, SG_ALERT, "INTERPOLATE ELVATION between " << p0 << " and " << p1 << " returned elvation " << new_geode.getElevationM() );
-            
-            new_pt->SetPosition( new_geode );
-            // new_pt->SetElevation( new_geode.getElevationM() );
-            new_pt->SetType( TG_NODE_FIXED_ELEVATION );
-        }
+    return new_pt;
+}
 
-        AddIntermediateNodes( p0, new_pt->GetPosition(), preserve3d, nodes, result, bbEpsilon, errEpsilon  );
-        
-        result.AddNode( new_pt->GetPosition() );
-        SG_LOG(SG_GENERAL, SG_BULK, "    adding = " << new_pt->GetPosition() );
-        
-        AddIntermediateNodes( new_pt->GetPosition(), p1, preserve3d, nodes, result, bbEpsilon, errEpsilon  );
+static SGGeod PlaceIntermediateNode( const SGGeod& p0, const SGGeod& p1, bool preserve3d, TGNode* new_pt )
+{
+    if ( preserve3d ) {
+        // when preserving elevation - it's important not to change the contour
+        // move the new node to the contour, instead of moving the contour to the point
+        tgSegment seg( p0, p1 );
+        SGGeod new_geode = seg.Project( new_pt->GetPosition() );
+
+        // interpolate the new nodes elevation based on p0, p1
+        new_geode = InterpolateElevation( new_geode, p0, p1 );
+
+        new_pt->SetPosition( new_geode );
+        new_pt->SetType( TG_NODE_FIXED_ELEVATION );
     }
+
+    return new_pt->GetPosition();
 }
 
-tgContour tgContour::AddColinearNodes( const tgContour& subject, UniqueSGGeodSet& nodes )
+// Split p0 -> p1 at the best fitting node, and search both halves again.
+// Only the nodes near the segment c0 -> c1 the search started on are tested:
+// they include every node colinear with a part of it, as long as the split
+// points stay within errEpsilon of it.  A split point further out than that
+// gets its own nodes from the source.
+template <class S>
+static void AddIntermediateNodes( const SGGeod& p0, const SGGeod& p1, bool preserve3d, const S& source,
+                                  const SGGeod& c0, const SGGeod& c1, const std::vector<typename S::node_type>& nodes,
+                                  std::vector<SGGeod>& result, double bbEpsilon, double errEpsilon )
 {
-    SGGeod p0, p1;
-    tgContour result;
-    std::vector<SGGeod>& tmp_nodes = nodes.get_list();
+    typename S::node_type new_pt;
 
-    for ( unsigned int n = 0; n < subject.GetSize()-1; n++ ) {
-        p0 = subject.GetNode( n );
-        p1 = subject.GetNode( n+1 );
-
-        // add start of segment
-        result.AddNode( p0 );
+    if ( !IsNodeNearSegment( c0, c1, p0, errEpsilon ) || !IsNodeNearSegment( c0, c1, p1, errEpsilon ) ) {
+        std::vector<typename S::node_type> near_nodes;
 
-        // add intermediate points
-        AddIntermediateNodes( p0, p1, tmp_nodes, result, SG_EPSILON*10, SG_EPSILON*4 );
+        source.Find( p0, p1, 3 * errEpsilon, near_nodes );
+        AddIntermediateNodes( p0, p1, preserve3d, source, p0, p1, near_nodes, result, bbEpsilon, errEpsilon );
+        return;
     }
 
-    p0 = subject.GetNode( subject.GetSize() - 1 );
-    p1 = subject.GetNode( 0 );
+    SG_LOG(SG_GENERAL, SG_BULK, "   " << p0 << " <==> " << p1 );
 
-    // add start of segment
-    result.AddNode( p0 );
+    if ( FindIntermediateNode( p0, p1, nodes, new_pt, bbEpsilon, errEpsilon ) ) {
+        SGGeod new_geode = PlaceIntermediateNode( p0, p1, preserve3d, new_pt );
 
-    // add intermediate points
-    AddIntermediateNodes( p0, p1, tmp_nodes, result, SG_EPSILON*10, SG_EPSILON*4 );
+        AddIntermediateNodes( p0, new_geode, preserve3d, source, c0, c1, nodes, result, bbEpsilon, errEpsilon );
 
-    // maintain original hole flag setting
-    result.SetHole( subject.GetHole() );
+        result.push_back( new_geode );
+        SG_LOG(SG_GENERAL, SG_BULK, "    adding = " << new_geode );
 
-    return result;
+        AddIntermediateNodes( new_geode, p1, preserve3d, source, c0, c1, nodes, result, bbEpsilon, errEpsilon );
+    }
 }
 
-tgContour tgContour::AddColinearNodes( const tgContour& subject, const std::vector<SGGeod>& nodes )
+// add the intermediate nodes to each segment of subject.  Each segment
+// starts with the nodes near it from segment_source, and searches all_source
+// when a split leaves that segment
+template <class S>
+static void AddIntermediateNodes( const tgContour& subject, bool preserve3d, const S& segment_source, const S& all_source,
+                                  std::vector<SGGeod>& result, double bbEpsilon, double errEpsilon )
 {
-    SGGeod p0, p1;
-    tgContour result;
+    std::vector<typename S::node_type> near_nodes;
+    unsigned int                       size = subject.GetSize();
 
-    for ( unsigned int n = 0; n < subject.GetSize()-1; n++ ) {
-        p0 = subject.GetNode( n );
-        p1 = subject.GetNode( n+1 );
+    result.reserve( size );
+    for ( unsigned int n = 0; n < size; n++ ) {
+        SGGeod const& p0 = subject[n];
+        SGGeod const& p1 = subject[(n+1) % size];
 
         // add start of segment
-        result.AddNode( p0 );
+        result.push_back( p0 );
 
         // add intermediate points
-        AddIntermediateNodes( p0, p1, nodes, result, SG_EPSILON*10, SG_EPSILON*4 );
+        segment_source.Find( p0, p1, 3 * errEpsilon, near_nodes );
+        AddIntermediateNodes( p0, p1, preserve3d, all_source, p0, p1, near_nodes, result, bbEpsilon, errEpsilon );
     }
+}
 
-    p0 = subject.GetNode( subject.GetSize() - 1 );
-    p1 = subject.GetNode( 0 );
+// the nodes inside the bounding box of subject, grown by margin - all those
+// near any of its segments
+template <class N>
+static void FindContourNodes( const tgContour& subject, const std::vector<N>& nodes, double margin, std::vector<N>& result )
+{
+    tgRectangle box = subject.GetBoundingBox();
 
-    // add start of segment
-    result.AddNode( p0 );
+    double min_lon = box.getMin().getLongitudeDeg() - margin;
+    double min_lat = box.getMin().getLatitudeDeg()  - margin;
+    double max_lon = box.getMax().getLongitudeDeg() + margin;
+    double max_lat = box.getMax().getLatitudeDeg()  + margin;
 
-    // add intermediate points
-    AddIntermediateNodes( p0, p1, nodes, result, SG_EPSILON*10, SG_EPSILON*4 );
+    result.clear();
+    for ( unsigned int i = 0; i < nodes.size(); i++ ) {
+        SGGeod const& pos = ColinearPosition( nodes[i] );
+
+        if ( pos.getLongitudeDeg() >= min_lon && pos.getLongitudeDeg() <= max_lon &&
+             pos.getLatitudeDeg()  >= min_lat && pos.getLatitudeDeg()  <= max_lat ) {
+            result.push_back( nodes[i] );
+        }
+    }
+}
+
+tgContour tgContour::AddColinearNodes( const tgContour& subject, UniqueSGGeodSet& nodes )
+{
+    return AddColinearNodes( subject, nodes.get_list() );
+}
+
+tgContour tgContour::AddColinearNodes( const tgContour& subject, const std::vector<SGGeod>& nodes )
+{
+    std::vector<SGGeod> contour_nodes;
+    std::vector<SGGeod> nodes_added;
+    tgContour           result;
+
+    FindContourNodes( subject, nodes, 3 * SG_EPSILON*4, contour_nodes );
+    AddIntermediateNodes( subject, false, ColinearNodeList<SGGeod>( contour_nodes ), ColinearNodeList<SGGeod>( nodes ),
+                          nodes_added, SG_EPSILON*10, SG_EPSILON*4 );
+    result.node_list.swap( nodes_added );
 
     // maintain original hole flag setting
     result.SetHole( subject.GetHole() );
@@ -1028,8 +1078,9 @@ tgContour tgContour::AddColinearNodes( const tgContour& subject, const std::vect
 
 tgContour tgContour::AddColinearNodes( const tgContour& subject, bool preserve3d, std::vector<TGNode*>& nodes )
 {
-    SGGeod p0, p1;
-    tgContour result;
+    std::vector<TGNode*> contour_nodes;
+    std::vector<SGGeod>  nodes_added;
+    tgContour            result;
 
 #if 0    // TEMP debugging roads on airport ground
     static int contour_idx = 1;
@@ -1041,26 +1092,11 @@ tgContour tgContour::AddColinearNodes( const tgContour& subject, bool preserve3d
     }
 #endif
 
-    for ( unsigned int n = 0; n < subject.GetSize()-1; n++ ) {
-        p0 = subject.GetNode( n );
-        p1 = subject.GetNode( n+1 );
-        
-        // add start of segment
-        result.AddNode( p0 );
-        
-        // add intermediate points
-        AddIntermediateNodes( p0, p1, preserve3d, nodes, result, SG_EPSILON*20, SG_EPSILON*15 );
-    }
-    
-    p0 = subject.GetNode( subject.GetSize() - 1 );
-    p1 = subject.GetNode( 0 );
-    
-    // add start of segment
-    result.AddNode( p0 );
-    
-    // add intermediate points
-    AddIntermediateNodes( p0, p1, preserve3d, nodes, result, SG_EPSILON*20, SG_EPSILON*15 );
-    
+    FindContourNodes( subject, nodes, 3 * SG_EPSILON*15, contour_nodes );
+    AddIntermediateNodes( subject, preserve3d, ColinearNodeList<TGNode*>( contour_nodes ), ColinearNodeList<TGNode*>( nodes ),
+                          nodes_added, SG_EPSILON*20, SG_EPSILON*15 );
+    result.node_list.swap( nodes_added );
+
     // maintain original hole flag setting
     result.SetHole( subject.GetHole() );
 
@@ -1076,6 +1112,20 @@ tgContour tgContour::AddColinearNodes( const tgContour& subject, bool preserve3d
     return result;
 }
 
+void tgContour::AddColinearNodes( const tgNodeGrid& grid, const tgRectangle& bounds, bool preserve3d )
+{
+    std::vector<SGGeod> result;
+    ColinearNodeGrid    source( grid, bounds );
+
+    if ( node_list.size() < 2 ) {
+        return;
+    }
+
+    AddIntermediateNodes( *this, preserve3d, source, source, result, SG_EPSILON*20, SG_EPSILON*15 );
+
+    node_list.swap( result );
+}
+
 // this is the opposite of FindColinearNodes - it takes a single SGGeode,
 // and tries to find the line segment the point is colinear with
 bool tgContour::FindColinearLine( const tgContour& subject, const SGGeod& node, SGGeod& start, SGGeod& end )
@@ -1296,6 +1346,68 @@ tgpolygon_list tgContour::ExpandToPolygons( const tgContour& subject, double wid
     return result;
 }
 
+// integer units of the local plane per meter - 1 mm
+#define BUFFER_UNITS_PER_M  (1000.0)
+
+tgPolygon tgContour::BufferLine( const tgContour& subject, double width, ClipperLib::JoinType joins, ClipperLib::EndType caps )
+{
+    tgPolygon result;
+
+    if ( subject.GetSize() < 2 ) {
+        return result;
+    }
+
+    // project around the center of the line, keeping the distance and
+    // course of every node from it - offsets there are the same width in
+    // all directions, unlike in degrees, and along the whole line.  Nodes
+    // too far for the frame tolerance fall back to SGGeodesy.
+    tgRectangle  bb     = subject.GetBoundingBox();
+    SGGeod       center = SGGeod::fromDeg( ( bb.getMin().getLongitudeDeg() + bb.getMax().getLongitudeDeg() ) / 2.0,
+                                           ( bb.getMin().getLatitudeDeg()  + bb.getMax().getLatitudeDeg()  ) / 2.0 );
+    tgLocalFrame frame( center );
+
+    std::vector<SGGeod>  geods( subject.GetSize() );
+    std::vector<SGVec2d> points;
+
+    for ( unsigned int i = 0; i < subject.GetSize(); i++ ) {
+        geods[i] = subject.GetNode(i);
+    }
+    frame.ToLocal( geods, points );
+
+    ClipperLib::Path  line;
+    ClipperLib::Paths buffered;
+
+    line.reserve( points.size() );
+    for ( unsigned int i = 0; i < points.size(); i++ ) {
+        line.push_back( ClipperLib::IntPoint( (ClipperLib::cInt)SGMiscd::round( points[i].x() * BUFFER_UNITS_PER_M ),
+                                              (ClipperLib::cInt)SGMiscd::round( points[i].y() * BUFFER_UNITS_PER_M ) ) );
+    }
+
+    ClipperLib::ClipperOffset co( 2.0, 0.25 * BUFFER_UNITS_PER_M );
+    co.AddPath( line, joins, caps );
+    co.Execute( buffered, width / 2.0 * BUFFER_UNITS_PER_M );
+
+    // and back to geodetic
+    for ( unsigned int i = 0; i < buffered.size(); i++ ) {
+        tgContour contour;
+
+        points.resize( buffered[i].size() );
+        for ( unsigned int j = 0; j < buffered[i].size(); j++ ) {
+            points[j] = SGVec2d( buffered[i][j].X / BUFFER_UNITS_PER_M, buffered[i][j].Y / BUFFER_UNITS_PER_M );
+        }
+        frame.FromLocal( points, geods );
+
+        for ( unsigned int j = 0; j < geods.size(); j++ ) {
+            contour.AddNode( geods[j] );
+        }
+        contour.SetHole( !ClipperLib::Orientation( buffered[i] ) );
+
+        result.AddContour( contour );
+    }
+
+    return result;
+}
+
 void tgContour::SaveToGzFile( gzFile& fp ) const
 {
     // Save the nodelist
@@ -1318,6 +1430,7 @@ void tgContour::LoadFromGzFile( gzFile& fp )
 
     // Load the nodelist
     sgReadUInt( fp, &count );
+    node_list.reserve( count );
     for (unsigned int i = 0; i < count; i++) {
         sgReadGeod( fp, node );
         node_list.push_back( node );
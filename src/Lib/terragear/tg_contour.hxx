@@ -9,6 +9,7 @@
 #include <simgear/math/sg_types.hxx>
 #include <boost/concept_check.hpp>
 
+#include "tg_cow_vector.hxx"
 #include "tg_unique_geod.hxx"
 #include "tg_rectangle.hxx"
 #include "clipper.hpp"
@@ -18,6 +19,7 @@
 
 /* forward declarations */
 class TGNode;
+class tgNodeGrid;
 
 class tgPolygon;
 typedef std::vector <tgPolygon>  tgpolygon_list;
@@ -69,6 +71,8 @@ public:
     SGGeod GetNode( unsigned int i ) const {
         return node_list[i];
     }
+    // the reference is good until the contour is next changed - it may then
+    // point into nodes still shared with an older copy
     SGGeod const& operator[]( int index ) const {
         return node_list[index];
     }
@@ -136,6 +140,12 @@ public:
 
     static tgContour Expand( const tgContour& subject, double offset );
     static tgpolygon_list ExpandToPolygons( const tgContour& subject, double width );
+    // one polygon width wide around the line, buffered by clipper in a
+    // local plane - faster than the segment quads, but not textured per
+    // segment
+    static tgPolygon BufferLine( const tgContour& subject, double width,
+                                 ClipperLib::JoinType joins = ClipperLib::jtMiter,
+                                 ClipperLib::EndType caps = ClipperLib::etOpenButt );
 
     static void ToShapefile( const tgContour& subject, const std::string& datasource, const std::string& layer, const std::string& feature );
 
@@ -146,6 +156,7 @@ public:
     void         RemoveAntenna( void );
 
     void AddColinearNodes( std::vector<SGGeod>& nodes );
+    void AddColinearNodes( const tgNodeGrid& grid, const tgRectangle& bounds, bool preserve3d );
     
     
     void SaveToGzFile( gzFile& fp ) const;
@@ -155,7 +166,8 @@ public:
     friend std::ostream& operator<< ( std::ostream&, const tgContour& );
 
 private:
-    std::vector<SGGeod>  node_list;
+    // copies of a contour share their nodes until one is modified
+    tgCowVector<SGGeod>  node_list;
     bool hole;
 };
 
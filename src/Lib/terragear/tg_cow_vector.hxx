@@ -0,0 +1,113 @@
+#ifndef _TG_COW_VECTOR_HXX
+#define _TG_COW_VECTOR_HXX
+
+#ifndef __cplusplus
+# error This library requires C++
+#endif
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+// A vector shared between its copies until one of them is written to.
+// Polygons and contours are passed through the build stages by value, so
+// most copies are never modified - these now only share the elements.
+//
+// Every non const access detaches the copy, so read through a const
+// reference where possible.  Element references and iterators are only good
+// until the next change to this copy : a change detaches it from the shared
+// elements, and the old ones live on only as long as another copy does.
+// The reference count is atomic, so copies may be handed to other threads,
+// but a single copy is no more thread safe than a std::vector.
+template <class T>
+class tgCowVector
+{
+public:
+    typedef typename std::vector<T>::iterator       iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+    typedef typename std::vector<T>::size_type      size_type;
+
+    size_type size( void ) const {
+        return data ? data->size() : 0;
+    }
+    bool empty( void ) const {
+        return size() == 0;
+    }
+    bool shared( void ) const {
+        return data && !data.unique();
+    }
+
+    const T& operator[]( size_type i ) const {
+        return (*data)[i];
+    }
+    T& operator[]( size_type i ) {
+        return Write()[i];
+    }
+
+    const_iterator begin( void ) const {
+        return Read().begin();
+    }
+    const_iterator end( void ) const {
+        return Read().end();
+    }
+    iterator begin( void ) {
+        return Write().begin();
+    }
+    iterator end( void ) {
+        return Write().end();
+    }
+
+    void clear( void ) {
+        data.reset();
+    }
+    void reserve( size_type n ) {
+        Write().reserve( n );
+    }
+    void resize( size_type n ) {
+        Write().resize( n );
+    }
+    void push_back( const T& t ) {
+        Write().push_back( t );
+    }
+    iterator insert( iterator pos, const T& t ) {
+        return Write().insert( pos, t );
+    }
+    iterator erase( iterator pos ) {
+        return Write().erase( pos );
+    }
+    iterator erase( iterator first, iterator last ) {
+        return Write().erase( first, last );
+    }
+
+    // take the elements of v, and give it the old ones - the old ones are
+    // only copied out if they are shared
+    void swap( std::vector<T>& v ) {
+        if ( shared() ) {
+            boost::shared_ptr< std::vector<T> > mine( new std::vector<T>() );
+            mine->swap( v );
+            v = *data;
+            data = mine;
+        } else {
+            Write().swap( v );
+        }
+    }
+
+private:
+    const std::vector<T>& Read( void ) const {
+        static const std::vector<T> none;
+        return data ? *data : none;
+    }
+
+    std::vector<T>& Write( void ) {
+        if ( !data ) {
+            data.reset( new std::vector<T>() );
+        } else if ( !data.unique() ) {
+            data.reset( new std::vector<T>( *data ) );
+        }
+        return *data;
+    }
+
+    boost::shared_ptr< std::vector<T> > data;
+};
+
+#endif // _TG_COW_VECTOR_HXX
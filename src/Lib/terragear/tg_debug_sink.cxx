@@ -0,0 +1,79 @@
+#include <sstream>
+
+#include <simgear/debug/logstream.hxx>
+
+#include "tg_debug_sink.hxx"
+
+bool                    tgDebugSink::active          = false;
+bool                    tgDebugSink::all_checkpoints = false;
+std::set<std::string>   tgDebugSink::checkpoints;
+std::set<std::string>   tgDebugSink::scopes;
+
+void tgDebugSink::Split( const std::string& list, std::set<std::string>& names )
+{
+    std::istringstream in( list );
+    std::string        name;
+
+    while ( std::getline( in, name, ',' ) ) {
+        if ( !name.empty() ) {
+            names.insert( name );
+        }
+    }
+}
+
+void tgDebugSink::Update( void )
+{
+    active          = !checkpoints.empty() || !scopes.empty();
+    all_checkpoints = checkpoints.empty() || checkpoints.find( "all" ) != checkpoints.end();
+}
+
+void tgDebugSink::EnableCheckpoints( const std::string& list )
+{
+    Split( list, checkpoints );
+    Update();
+
+    SG_LOG( SG_GENERAL, SG_INFO, "Debug sink : enabled checkpoints " << list );
+}
+
+void tgDebugSink::EnableScopes( const std::string& list )
+{
+    Split( list, scopes );
+    Update();
+
+    SG_LOG( SG_GENERAL, SG_INFO, "Debug sink : enabled scopes " << list );
+}
+
+bool tgDebugSink::IsEnabled( const char* checkpoint, long tile_index )
+{
+    if ( !active ) {
+        return false;
+    }
+
+    std::ostringstream os;
+    os << tile_index;
+
+    return Check( checkpoint, os.str() );
+}
+
+bool tgDebugSink::Check( const char* checkpoint, const std::string& scope )
+{
+    if ( !all_checkpoints && checkpoints.find( checkpoint ) == checkpoints.end() ) {
+        return false;
+    }
+
+    if ( scopes.empty() ) {
+        return true;
+    }
+
+    // the scope itself, or a data source named after it
+    std::string::size_type sep = scope.find( '_' );
+
+    if ( scopes.find( scope ) != scopes.end() ) {
+        return true;
+    }
+    if ( sep != std::string::npos && scopes.find( scope.substr( 0, sep ) ) != scopes.end() ) {
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,50 @@
+#ifndef _TG_DEBUG_SINK_HXX
+#define _TG_DEBUG_SINK_HXX
+
+#include <set>
+#include <string>
+
+// Named debug checkpoints for the geometry dumps ( shapefiles ) on the build
+// paths.  A checkpoint is enabled by name, and may be limited to some scopes
+// - tile indexes or airport icaos.  A scope also matches the data sources
+// named after it : KSFO matches KSFO_runways.
+//
+// The dump statement is only evaluated when its checkpoint is enabled, so a
+// disabled checkpoint doesn't even build the geometry it would write :
+//
+//   TG_DEBUG_SINK( "accum", bucket.gen_index(), accum.ToShapefiles( "./", "accum", false ) );
+#define TG_DEBUG_SINK( CHECKPOINT, SCOPE, STATEMENT ) do {  \
+    if ( tgDebugSink::IsEnabled( CHECKPOINT, SCOPE ) ) {    \
+        STATEMENT;                                          \
+    }                                                       \
+} while(0)
+
+class tgDebugSink
+{
+public:
+    // comma separated checkpoint names - "all" enables every checkpoint
+    static void EnableCheckpoints( const std::string& list );
+
+    // comma separated tile indexes or icaos.  Without checkpoints, every
+    // checkpoint in these scopes is enabled.
+    static void EnableScopes( const std::string& list );
+
+    // the enabled sets are only written while parsing the command line, so
+    // the build threads read them without locking
+    static bool IsEnabled( const char* checkpoint, const std::string& scope ) {
+        return active && Check( checkpoint, scope );
+    }
+    static bool IsEnabled( const char* checkpoint, long tile_index );
+
+private:
+    static bool Check( const char* checkpoint, const std::string& scope );
+    static void Split( const std::string& list, std::set<std::string>& names );
+    static void Update( void );
+
+    static bool                     active;
+    static bool                     all_checkpoints;
+    static std::set<std::string>    checkpoints;
+    static std::set<std::string>    scopes;
+};
+
+#endif // _TG_DEBUG_SINK_HXX
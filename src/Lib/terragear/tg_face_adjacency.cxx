@@ -0,0 +1,56 @@
+#include <simgear/debug/logstream.hxx>
+
+#include "tg_areas.hxx"
+#include "tg_face_adjacency.hxx"
+
+void tgFaceAdjacency::Build( const tgAreas& areas, const TGNodes& nodes )
+{
+    unsigned int num_nodes = nodes.size();
+
+    clear();
+    offsets.resize( num_nodes + 1, 0 );
+
+    // count the faces of each node
+    for ( unsigned int area = 0; area < areas.size(); area++ ) {
+        for ( unsigned int p = 0; p < areas.area_size(area); p++ ) {
+            tgPolygon const& poly = areas.get_poly( area, p );
+
+            for ( unsigned int tri = 0; tri < poly.Triangles(); tri++ ) {
+                for ( unsigned int v = 0; v < 3; v++ ) {
+                    int idx = poly.GetTriIdx( tri, v );
+                    if ( idx >= 0 && (unsigned int)idx < num_nodes ) {
+                        offsets[idx+1]++;
+                    }
+                }
+            }
+        }
+    }
+
+    for ( unsigned int n = 0; n < num_nodes; n++ ) {
+        offsets[n+1] += offsets[n];
+    }
+
+    // then drop each face into its slot - faces of a node stay in area / poly / tri order
+    std::vector<unsigned int> fill( offsets.begin(), offsets.end() - 1 );
+    faces.resize( offsets[num_nodes] );
+
+    for ( unsigned int area = 0; area < areas.size(); area++ ) {
+        for ( unsigned int p = 0; p < areas.area_size(area); p++ ) {
+            tgPolygon const& poly = areas.get_poly( area, p );
+
+            for ( unsigned int tri = 0; tri < poly.Triangles(); tri++ ) {
+                for ( unsigned int v = 0; v < 3; v++ ) {
+                    int idx = poly.GetTriIdx( tri, v );
+                    if ( idx >= 0 && (unsigned int)idx < num_nodes ) {
+                        TGFaceLookup& face = faces[ fill[idx]++ ];
+                        face.area = area;
+                        face.poly = p;
+                        face.tri  = tri;
+                    }
+                }
+            }
+        }
+    }
+
+    SG_LOG(SG_GENERAL, SG_DEBUG, "tgFaceAdjacency: " << faces.size() << " face references for " << num_nodes << " nodes" );
+}
@@ -0,0 +1,55 @@
+#ifndef _TG_FACE_ADJACENCY_HXX
+#define _TG_FACE_ADJACENCY_HXX
+
+#ifndef __cplusplus
+# error This library requires C++
+#endif
+
+#include <vector>
+#include <stdint.h>
+#include <math.h>
+
+#include "tg_nodes.hxx"
+
+class tgAreas;
+
+// Node to face lookup for a whole tile, stored in compressed sparse row form:
+// the faces of node n are faces[offsets[n]] to faces[offsets[n+1]-1].
+// This replaces the per node face vectors.  It isn't saved with the
+// intermediate files - building it is a single pass over the triangles,
+// which is cheaper than reading it back and checking it still matches.
+class tgFaceAdjacency
+{
+public:
+    void clear( void ) {
+        offsets.clear();
+        faces.clear();
+    }
+
+    // one counting pass, and one filling pass over the indexed triangles
+    void Build( const tgAreas& areas, const TGNodes& nodes );
+
+    unsigned int NumFaces( unsigned int node ) const {
+        return offsets[node+1] - offsets[node];
+    }
+    TGFaceLookup const& GetFace( unsigned int node, unsigned int j ) const {
+        return faces[ offsets[node] + j ];
+    }
+
+private:
+    std::vector<unsigned int> offsets;
+    std::vector<TGFaceLookup> faces;
+};
+
+// Key of a node shared with the neighbor tiles : its 2d position, quantized
+// to approx 1 cm.  The elevations written by each tile differ until they
+// are averaged, so the whole SGGeod can't be compared.
+inline uint64_t tgNeighborFaceKey( const SGGeod& node )
+{
+    uint32_t lon = (uint32_t)(int32_t)floor( node.getLongitudeDeg() * 10000000.0 + 0.5 );
+    uint32_t lat = (uint32_t)(int32_t)floor( node.getLatitudeDeg()  * 10000000.0 + 0.5 );
+
+    return ( (uint64_t)lon << 32 ) | lat;
+}
+
+#endif // _TG_FACE_ADJACENCY_HXX
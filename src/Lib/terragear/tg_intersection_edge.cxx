@@ -1,4 +1,6 @@
 #include <simgear/sg_inlines.h>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include "tg_polygon.hxx"
 #include "tg_shapefile.hxx" 
@@ -6,18 +8,26 @@
 #include "tg_intersection_node.hxx"
 #include "tg_misc.hxx"
 
+// edge ids name the debug output - generators on different threads share them
+static SGMutex      ge_count_lock;
+static unsigned int ge_count = 0;
+
+static unsigned int tg_next_edge_id( void )
+{
+    SGGuard<SGMutex> g( ge_count_lock );
+    return ++ge_count;
+}
+
 // generate intersection edge in euclidean space
 tgIntersectionEdge::tgIntersectionEdge( tgIntersectionNode* s, tgIntersectionNode* e, double w, int z, unsigned int t, const std::string& dr ) 
 {
-    static unsigned int ge_count = 0;
-
     start  = s;
     end    = e;
     width  = w;
     zorder = z;
     type   = t;
     
-    id = ++ge_count;
+    id = tg_next_edge_id();
     flags = 0;
     
     br_set = false;
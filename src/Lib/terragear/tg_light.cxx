@@ -0,0 +1,44 @@
+#include <simgear/debug/logstream.hxx>
+
+#include "tg_light.hxx"
+#include "tg_nodes.hxx"
+#include "tg_surface.hxx"
+#include "tg_unique_vec3f.hxx"
+
+void tgBuildLightGroups( const tglightcontour_list& lights, const tgSurface& surf, TGNodes& nodes, UniqueSGVec3fSet& normals, std::vector<SGBinObjectPoint>& groups )
+{
+    std::vector<SGGeod>       positions;
+    std::vector<unsigned int> indices;
+
+    // gather the light points of all contours, and add them to the node
+    // list in one batch, without a k-d tree search per light
+    for ( unsigned int i = 0; i < lights.size(); ++i ) {
+        for ( unsigned int j = 0; j < lights[i].ContourSize(); ++j ) {
+            positions.push_back( lights[i].GetPosition(j) );
+        }
+    }
+    nodes.unique_add_batch( positions, indices, TG_NODE_SMOOTHED );
+
+    unsigned int cur = 0;
+    for ( unsigned int i = 0; i < lights.size(); ++i ) {
+        if ( lights[i].ContourSize() ) {
+            SGBinObjectPoint sgboPt;
+
+            sgboPt.material = lights[i].GetType();
+            sgboPt.v_list.reserve( lights[i].ContourSize() );
+            sgboPt.n_list.reserve( lights[i].ContourSize() );
+
+            for ( unsigned int j = 0; j < lights[i].ContourSize(); ++j ) {
+                sgboPt.v_list.push_back( indices[cur++] );
+                sgboPt.n_list.push_back( normals.add( lights[i].GetNormal(j) ) );
+            }
+
+            groups.push_back( sgboPt );
+        } else {
+            SG_LOG(SG_GENERAL, SG_ALERT, "light contour for mat " << lights[i].GetType() << " HAS NO LIGHTS " );
+        }
+    }
+
+    // one batched surface query for all the light nodes
+    nodes.CalcElevations( TG_NODE_SMOOTHED, surf );
+}
@@ -4,6 +4,11 @@
 #include <vector>
 
 #include <simgear/math/SGMath.hxx>
+#include <simgear/io/sg_binobj.hxx>
+
+class TGNodes;
+class tgSurface;
+class UniqueSGVec3fSet;
 
 class tgLight
 {
@@ -92,4 +97,10 @@ typedef std::vector <tgLightContour>  tglightcontour_list;
 typedef tglightcontour_list::iterator tglightcontour_list_iterator;
 typedef tglightcontour_list::const_iterator const_tglightcontour_list_iterator;
 
+// Build the btg point groups of a list of light contours : one group per
+// contour with lights.  The lights of all contours are added to nodes in
+// one batch ( same indices as adding them one at a time ), and their
+// elevations come from one batched query of surf.
+void tgBuildLightGroups( const tglightcontour_list& lights, const tgSurface& surf, TGNodes& nodes, UniqueSGVec3fSet& normals, std::vector<SGBinObjectPoint>& groups );
+
 #endif // _TG_LIGHT_HXX
\ No newline at end of file
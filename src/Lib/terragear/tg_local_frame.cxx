@@ -0,0 +1,384 @@
+#include <math.h>
+#include <algorithm>
+
+#include <simgear/constants.h>
+#include <simgear/math/sg_geodesy.hxx>
+
+#include "tg_local_frame.hxx"
+
+// WGS84 first eccentricity squared
+static const double LOCAL_FRAME_F  = 1.0 / 298.257223563;
+static const double LOCAL_FRAME_E2 = LOCAL_FRAME_F * ( 2.0 - LOCAL_FRAME_F );
+
+// latitudes within this of the origin ( radians ) use the cached curvature,
+// and pairs further apart in longitude always fall back to SGGeodesy
+static const double LOCAL_FRAME_BAND = 0.01;
+
+// mid latitude formulas and Direct converge by a factor of dist / radius
+// per iteration
+static const int    LOCAL_FRAME_DIRECT_ITERATIONS = 4;
+
+// points stepped together by the FromLocal over many points
+static const unsigned int LOCAL_FRAME_BLOCK = 256;
+
+// the distance at which ErrorBound reaches the tolerance, squared - and
+// below 0 with the frame disabled, so every point falls back
+static double MaxDist2( double tolerance )
+{
+    if ( tolerance <= 0.0 ) {
+        return -1.0;
+    }
+
+    double dist = pow( 32.0 * SG_EQUATORIAL_RADIUS_M * SG_EQUATORIAL_RADIUS_M * tolerance, 1.0 / 3.0 );
+
+    return dist * dist;
+}
+
+double tgLocalFrame::tolerance = 0.001;
+double tgLocalFrame::max_dist2 = MaxDist2( 0.001 );
+
+// sin, cos and sec of the small angles within LOCAL_FRAME_BAND
+static inline double SmallSin( double u )
+{
+    double u2 = u * u;
+    return u * ( 1.0 - u2 / 6.0 * ( 1.0 - u2 / 20.0 ) );
+}
+
+static inline double SmallCos( double u )
+{
+    double u2 = u * u;
+    return 1.0 - u2 / 2.0 * ( 1.0 - u2 / 12.0 * ( 1.0 - u2 / 30.0 ) );
+}
+
+static inline double SmallSec( double u )
+{
+    double u2 = u * u;
+    return 1.0 + u2 / 2.0 * ( 1.0 + u2 * 5.0 / 12.0 * ( 1.0 + u2 * 61.0 / 150.0 ) );
+}
+
+static inline double NormalizeLon( double lon )
+{
+    if ( lon > SGD_PI ) {
+        lon -= SGD_2PI;
+    } else if ( lon < -SGD_PI ) {
+        lon += SGD_2PI;
+    }
+
+    return lon;
+}
+
+tgLocalFrame::tgLocalFrame( const SGGeod& o ) : origin( o )
+{
+    sin_origin = sin( origin.getLatitudeRad() );
+    cos_origin = cos( origin.getLatitudeRad() );
+
+    // meters to radians at the origin, for the first step of FromLocal
+    double w = 1.0 - LOCAL_FRAME_E2 * sin_origin * sin_origin;
+
+    lat_per_m = sqrt( w ) * w / ( SG_EQUATORIAL_RADIUS_M * ( 1.0 - LOCAL_FRAME_E2 ) );
+    lon_per_m = sqrt( w ) / ( SG_EQUATORIAL_RADIUS_M * cos_origin );
+}
+
+void tgLocalFrame::SetTolerance( double meters )
+{
+    tolerance = meters;
+    max_dist2 = MaxDist2( meters );
+}
+
+double tgLocalFrame::ErrorBound( double dist )
+{
+    // the dropped terms of the mid latitude formulas are of order
+    // dist^3 / radius^2 - measured at 5e-16 * dist^3 against the exact
+    // geodesic at all latitudes
+    return dist * dist * dist / ( 32.0 * SG_EQUATORIAL_RADIUS_M * SG_EQUATORIAL_RADIUS_M );
+}
+
+// radii of curvature in the meridian ( m ) and prime vertical ( n )
+void tgLocalFrame::Curvature( double lat, double& sin_lat, double& cos_lat, double& n, double& m ) const
+{
+    double delta = lat - origin.getLatitudeRad();
+
+    if ( fabs( delta ) < LOCAL_FRAME_BAND ) {
+        double sd = SmallSin( delta );
+        double cd = SmallCos( delta );
+
+        sin_lat = sin_origin * cd + cos_origin * sd;
+        cos_lat = cos_origin * cd - sin_origin * sd;
+    } else {
+        sin_lat = sin( lat );
+        cos_lat = cos( lat );
+    }
+
+    double w = 1.0 - LOCAL_FRAME_E2 * sin_lat * sin_lat;
+
+    n = SG_EQUATORIAL_RADIUS_M / sqrt( w );
+    m = n * ( 1.0 - LOCAL_FRAME_E2 ) / w;
+}
+
+// east / north meters from p1 to p2 along the mid latitude course, and the
+// convergence of the meridians between them
+bool tgLocalFrame::Solve( const SGGeod& p1, const SGGeod& p2, double& x, double& y, double& convergence ) const
+{
+    if ( tolerance <= 0.0 ) {
+        return false;
+    }
+
+    double dlat = p2.getLatitudeRad() - p1.getLatitudeRad();
+    double dlon = NormalizeLon( p2.getLongitudeRad() - p1.getLongitudeRad() );
+
+    if ( fabs( dlon ) > LOCAL_FRAME_BAND ) {
+        return false;
+    }
+
+    double sin_lat, cos_lat, n, m;
+    Curvature( 0.5 * ( p1.getLatitudeRad() + p2.getLatitudeRad() ), sin_lat, cos_lat, n, m );
+
+    convergence = dlon * sin_lat;
+
+    x = n * cos_lat * dlon * ( 1.0 - convergence * convergence / 24.0 );
+    y = m * dlat * SmallCos( 0.5 * dlon );
+
+    return ( ErrorBound( sqrt( x*x + y*y ) ) <= tolerance );
+}
+
+double tgLocalFrame::DistanceM( const SGGeod& p1, const SGGeod& p2 ) const
+{
+    double x, y, convergence;
+
+    if ( !Solve( p1, p2, x, y, convergence ) ) {
+        return SGGeodesy::distanceM( p1, p2 );
+    }
+
+    return sqrt( x*x + y*y );
+}
+
+double tgLocalFrame::CourseDeg( const SGGeod& p1, const SGGeod& p2 ) const
+{
+    double az1, az2, dist;
+
+    Inverse( p1, p2, az1, az2, dist );
+
+    return az1;
+}
+
+void tgLocalFrame::Inverse( const SGGeod& p1, const SGGeod& p2, double& az1, double& az2, double& dist ) const
+{
+    double x, y, convergence;
+
+    if ( !Solve( p1, p2, x, y, convergence ) ) {
+        SGGeodesy::inverse( p1, p2, az1, az2, dist );
+        return;
+    }
+
+    dist = sqrt( x*x + y*y );
+    if ( dist == 0.0 ) {
+        az1 = 0.0;
+        az2 = 0.0;
+        return;
+    }
+
+    // the mid latitude course turns by the convergence from p1 to p2
+    double course = atan2( x, y );
+
+    az1 = SGMiscd::normalizePeriodic( 0, 360, ( course - 0.5 * convergence ) * SGD_RADIANS_TO_DEGREES );
+    az2 = SGMiscd::normalizePeriodic( 0, 360, ( course + 0.5 * convergence ) * SGD_RADIANS_TO_DEGREES + 180.0 );
+}
+
+SGGeod tgLocalFrame::Direct( const SGGeod& p1, double course, double dist ) const
+{
+    if ( tolerance <= 0.0 || ErrorBound( fabs( dist ) ) > tolerance ) {
+        return SGGeodesy::direct( p1, course, dist );
+    }
+
+    double sin_course = sin( course * SGD_DEGREES_TO_RADIANS );
+    double cos_course = cos( course * SGD_DEGREES_TO_RADIANS );
+    double lat1       = p1.getLatitudeRad();
+    double dlat       = 0.0;
+    double dlon       = 0.0;
+
+    // solve the mid latitude formulas backwards, starting from a flat earth
+    for ( int i = 0; i < LOCAL_FRAME_DIRECT_ITERATIONS; i++ ) {
+        double sin_lat, cos_lat, n, m;
+        Curvature( lat1 + 0.5 * dlat, sin_lat, cos_lat, n, m );
+
+        double convergence = dlon * sin_lat;
+        double sc          = SmallSin( 0.5 * convergence );
+        double cc          = SmallCos( 0.5 * convergence );
+        double x           = dist * ( sin_course * cc + cos_course * sc );
+        double y           = dist * ( cos_course * cc - sin_course * sc );
+
+        if ( cos_lat < LOCAL_FRAME_BAND ) {
+            return SGGeodesy::direct( p1, course, dist );
+        }
+
+        dlon = x / ( n * cos_lat * ( 1.0 - convergence * convergence / 24.0 ) );
+        if ( fabs( dlon ) > LOCAL_FRAME_BAND ) {
+            return SGGeodesy::direct( p1, course, dist );
+        }
+        dlat = y / ( m * SmallCos( 0.5 * dlon ) );
+    }
+
+    return SGGeod::fromRad( NormalizeLon( p1.getLongitudeRad() + dlon ), lat1 + dlat );
+}
+
+// Inverse from the origin, in east / north meters : the mid latitude
+// course turned back by half the convergence.  Only the cached origin
+// terms and a sqrt - the mid latitude is within LOCAL_FRAME_BAND of it.
+inline bool tgLocalFrame::SolveToLocal( double lon, double lat, double& x, double& y ) const
+{
+    double dlat  = lat - origin.getLatitudeRad();
+    double dlon  = NormalizeLon( lon - origin.getLongitudeRad() );
+    double delta = 0.5 * dlat;
+
+    double sd      = SmallSin( delta );
+    double cd      = SmallCos( delta );
+    double sin_lat = sin_origin * cd + cos_origin * sd;
+    double cos_lat = cos_origin * cd - sin_origin * sd;
+    double w       = 1.0 - LOCAL_FRAME_E2 * sin_lat * sin_lat;
+    double n       = SG_EQUATORIAL_RADIUS_M / sqrt( w );
+    double m       = n * ( 1.0 - LOCAL_FRAME_E2 ) / w;
+
+    double convergence = dlon * sin_lat;
+    double east        = n * cos_lat * dlon * ( 1.0 - convergence * convergence / 24.0 );
+    double north       = m * dlat * SmallCos( 0.5 * dlon );
+    double sc          = SmallSin( 0.5 * convergence );
+    double cc          = SmallCos( 0.5 * convergence );
+
+    x = east * cc - north * sc;
+    y = north * cc + east * sc;
+
+    return ( fabs( dlon ) <= LOCAL_FRAME_BAND ) &&
+           ( fabs( delta ) < LOCAL_FRAME_BAND ) &&
+           ( east * east + north * north <= max_dist2 );
+}
+
+// The first step of Direct from the origin : a flat earth, scaled at it
+inline bool tgLocalFrame::StartFromLocal( double x, double y, double& dlon, double& dlat ) const
+{
+    dlon = x * lon_per_m;
+    dlat = y * lat_per_m * SmallSec( 0.5 * dlon );
+
+    return ( x * x + y * y <= max_dist2 ) && ( cos_origin >= LOCAL_FRAME_BAND ) && ( fabs( dlon ) <= LOCAL_FRAME_BAND );
+}
+
+// the next steps : the mid latitude formulas solved backwards for dlon,
+// dlat.  Each step converges by a factor of dist / radius.
+inline bool tgLocalFrame::StepFromLocal( double x, double y, double& dlon, double& dlat ) const
+{
+    double delta   = 0.5 * dlat;
+    double sd      = SmallSin( delta );
+    double cd      = SmallCos( delta );
+    double sin_lat = sin_origin * cd + cos_origin * sd;
+    double cos_lat = cos_origin * cd - sin_origin * sd;
+    double w       = 1.0 - LOCAL_FRAME_E2 * sin_lat * sin_lat;
+    double inv_n   = sqrt( w ) / SG_EQUATORIAL_RADIUS_M;
+    double inv_m   = inv_n * w / ( 1.0 - LOCAL_FRAME_E2 );
+
+    double convergence = dlon * sin_lat;
+    double sc          = SmallSin( 0.5 * convergence );
+    double cc          = SmallCos( 0.5 * convergence );
+    double east        = x * cc + y * sc;
+    double north       = y * cc - x * sc;
+    bool   ok          = ( fabs( delta ) < LOCAL_FRAME_BAND ) && ( cos_lat >= LOCAL_FRAME_BAND );
+
+    // the reciprocals of the small angle terms by their series, so a step
+    // divides only once
+    double c2 = convergence * convergence / 24.0;
+
+    dlon = east * inv_n * ( 1.0 + c2 * ( 1.0 + c2 ) ) / cos_lat;
+    dlat = north * inv_m * SmallSec( 0.5 * dlon );
+
+    return ok && ( fabs( dlon ) <= LOCAL_FRAME_BAND );
+}
+
+SGVec2d tgLocalFrame::ToLocal( const SGGeod& p ) const
+{
+    double x, y;
+
+    if ( !SolveToLocal( p.getLongitudeRad(), p.getLatitudeRad(), x, y ) ) {
+        double az1, az2, dist;
+
+        SGGeodesy::inverse( origin, p, az1, az2, dist );
+        x = dist * sin( az1 * SGD_DEGREES_TO_RADIANS );
+        y = dist * cos( az1 * SGD_DEGREES_TO_RADIANS );
+    }
+
+    return SGVec2d( x, y );
+}
+
+SGGeod tgLocalFrame::FromLocal( const SGVec2d& p ) const
+{
+    if ( p.x() == 0.0 && p.y() == 0.0 ) {
+        return origin;
+    }
+
+    double dlon, dlat;
+    bool   ok = StartFromLocal( p.x(), p.y(), dlon, dlat );
+
+    for ( int i = 1; i < LOCAL_FRAME_DIRECT_ITERATIONS; i++ ) {
+        ok = StepFromLocal( p.x(), p.y(), dlon, dlat ) && ok;
+    }
+
+    if ( !ok ) {
+        return SGGeodesy::direct( origin, atan2( p.x(), p.y() ) * SGD_RADIANS_TO_DEGREES, sqrt( p.x()*p.x() + p.y()*p.y() ) );
+    }
+
+    return SGGeod::fromRad( NormalizeLon( origin.getLongitudeRad() + dlon ), origin.getLatitudeRad() + dlat );
+}
+
+// the points out of tolerance are done after the loop, so it calls nothing
+void tgLocalFrame::ToLocal( const std::vector<SGGeod>& geods, std::vector<SGVec2d>& points ) const
+{
+    std::vector<unsigned int> fallbacks;
+
+    points.resize( geods.size() );
+    for ( unsigned int i = 0; i < geods.size(); i++ ) {
+        double x, y;
+
+        if ( !SolveToLocal( geods[i].getLongitudeRad(), geods[i].getLatitudeRad(), x, y ) ) {
+            fallbacks.push_back( i );
+        }
+        points[i] = SGVec2d( x, y );
+    }
+
+    for ( unsigned int i = 0; i < fallbacks.size(); i++ ) {
+        points[fallbacks[i]] = ToLocal( geods[fallbacks[i]] );
+    }
+}
+
+// Each step depends on the one before, so step a block of points at once
+// instead - the steps of different points run side by side.
+void tgLocalFrame::FromLocal( const std::vector<SGVec2d>& points, std::vector<SGGeod>& geods ) const
+{
+    std::vector<unsigned int> fallbacks;
+
+    geods.resize( points.size() );
+    for ( unsigned int start = 0; start < points.size(); start += LOCAL_FRAME_BLOCK ) {
+        unsigned int   num = std::min( (unsigned int)points.size() - start, (unsigned int)LOCAL_FRAME_BLOCK );
+        const SGVec2d* p   = &points[start];
+        double         dlon[LOCAL_FRAME_BLOCK], dlat[LOCAL_FRAME_BLOCK];
+        bool           ok[LOCAL_FRAME_BLOCK];
+
+        for ( unsigned int i = 0; i < num; i++ ) {
+            ok[i] = StartFromLocal( p[i].x(), p[i].y(), dlon[i], dlat[i] );
+        }
+
+        for ( int step = 1; step < LOCAL_FRAME_DIRECT_ITERATIONS; step++ ) {
+            for ( unsigned int i = 0; i < num; i++ ) {
+                ok[i] = StepFromLocal( p[i].x(), p[i].y(), dlon[i], dlat[i] ) && ok[i];
+            }
+        }
+
+        for ( unsigned int i = 0; i < num; i++ ) {
+            if ( !ok[i] || ( p[i].x() == 0.0 && p[i].y() == 0.0 ) ) {
+                fallbacks.push_back( start + i );
+            } else {
+                geods[start + i] = SGGeod::fromRad( NormalizeLon( origin.getLongitudeRad() + dlon[i] ), origin.getLatitudeRad() + dlat[i] );
+            }
+        }
+    }
+
+    for ( unsigned int i = 0; i < fallbacks.size(); i++ ) {
+        geods[fallbacks[i]] = FromLocal( points[fallbacks[i]] );
+    }
+}
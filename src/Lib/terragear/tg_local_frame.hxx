@@ -0,0 +1,65 @@
+#ifndef _TG_LOCAL_FRAME_HXX
+#define _TG_LOCAL_FRAME_HXX
+
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/math/SGMath.hxx>
+
+// Geodesic calculations for the points around an origin - usually the
+// bucket center.  Instead of iterating the geodesic for every pair, the
+// pair is solved with the mid latitude formulas on the ellipsoid, with the
+// curvature around the origin latitude cached.  Over a tile this is
+// accurate to a fraction of a millimeter.
+//
+// Every call checks its own error bound : a pair further apart than the
+// tolerance allows falls back to SGGeodesy, so the results are always
+// within the tolerance of SGGeodesy.  A tolerance of 0 always falls back.
+class tgLocalFrame
+{
+public:
+    tgLocalFrame( const SGGeod& origin );
+
+    // local east / north meters of a point - the distance and course from
+    // the origin, as an azimuthal equidistant projection
+    SGVec2d ToLocal( const SGGeod& p ) const;
+    SGGeod  FromLocal( const SGVec2d& p ) const;
+
+    // the same, over many points - the points within the tolerance are
+    // solved in one pass without any trigonometry, the rest after it
+    void    ToLocal( const std::vector<SGGeod>& geods, std::vector<SGVec2d>& points ) const;
+    void    FromLocal( const std::vector<SGVec2d>& points, std::vector<SGGeod>& geods ) const;
+
+    // same as the SGGeodesy calls : az2 is the course from p2 back to p1
+    double  DistanceM( const SGGeod& p1, const SGGeod& p2 ) const;
+    double  CourseDeg( const SGGeod& p1, const SGGeod& p2 ) const;
+    void    Inverse( const SGGeod& p1, const SGGeod& p2, double& az1, double& az2, double& dist ) const;
+    SGGeod  Direct( const SGGeod& p1, double course, double dist ) const;
+
+    // worst error in meters of a distance, or of the position along a course
+    static double ErrorBound( double dist );
+
+    static void   SetTolerance( double meters );
+    static double GetTolerance( void )          { return tolerance; }
+
+private:
+    void Curvature( double lat, double& sin_lat, double& cos_lat, double& n, double& m ) const;
+    bool Solve( const SGGeod& p1, const SGGeod& p2, double& x, double& y, double& convergence ) const;
+
+    // ToLocal in radians, and the steps of FromLocal - false if out of
+    // tolerance
+    inline bool SolveToLocal( double lon, double lat, double& x, double& y ) const;
+    inline bool StartFromLocal( double x, double y, double& dlon, double& dlat ) const;
+    inline bool StepFromLocal( double x, double y, double& dlon, double& dlat ) const;
+
+    SGGeod origin;
+    double sin_origin;
+    double cos_origin;
+    double lon_per_m;
+    double lat_per_m;
+
+    static double tolerance;
+    static double max_dist2;        // squared distance at the tolerance
+};
+
+#endif // _TG_LOCAL_FRAME_HXX
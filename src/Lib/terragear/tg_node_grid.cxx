@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cmath>
+
+#include <simgear/debug/logstream.hxx>
+
+#include "tg_nodes.hxx"
+#include "tg_node_grid.hxx"
+
+// average number of nodes we aim for in each grid cell
+#define TG_NODE_GRID_DENSITY    (4.0)
+#define TG_NODE_GRID_MAX_DIM    (4096)
+
+// slack added to the bounds, as TGNodes::get_nodes_inside does
+#define TG_NODE_GRID_BOUNDS_EPS (0.000001)
+
+tgNodeGrid::tgNodeGrid( TGNodes& n ) : nodes(n)
+{
+    unsigned int num_nodes = nodes.size();
+
+    min_lon   = 0.0;
+    min_lat   = 0.0;
+    cell_size = 1.0;
+    cols      = 1;
+    rows      = 1;
+
+    if ( num_nodes ) {
+        double max_lon, max_lat;
+
+        min_lon = max_lon = nodes[0].GetPosition().getLongitudeDeg();
+        min_lat = max_lat = nodes[0].GetPosition().getLatitudeDeg();
+        for ( unsigned int i = 1; i < num_nodes; i++ ) {
+            SGGeod const& pos = nodes[i].GetPosition();
+
+            min_lon = std::min( min_lon, pos.getLongitudeDeg() );
+            max_lon = std::max( max_lon, pos.getLongitudeDeg() );
+            min_lat = std::min( min_lat, pos.getLatitudeDeg() );
+            max_lat = std::max( max_lat, pos.getLatitudeDeg() );
+        }
+
+        int    dim    = (int)sqrt( num_nodes / TG_NODE_GRID_DENSITY );
+        double extent = std::max( max_lon - min_lon, max_lat - min_lat );
+
+        dim = std::max( 1, std::min( dim, TG_NODE_GRID_MAX_DIM ) );
+        if ( extent > 0.0 ) {
+            cell_size = extent / dim;
+        }
+
+        cols = std::min( (int)( (max_lon - min_lon) / cell_size ) + 1, TG_NODE_GRID_MAX_DIM );
+        rows = std::min( (int)( (max_lat - min_lat) / cell_size ) + 1, TG_NODE_GRID_MAX_DIM );
+    }
+
+    // counting sort of the node indices by cell
+    std::vector<unsigned int> node_cell( num_nodes );
+    cell_start.assign( cols * rows + 1, 0 );
+    for ( unsigned int i = 0; i < num_nodes; i++ ) {
+        SGGeod const& pos = nodes[i].GetPosition();
+
+        node_cell[i] = RowOf( pos.getLatitudeDeg() ) * cols + ColumnOf( pos.getLongitudeDeg() );
+        cell_start[node_cell[i] + 1]++;
+    }
+    for ( unsigned int c = 0; c < cell_start.size() - 1; c++ ) {
+        cell_start[c + 1] += cell_start[c];
+    }
+
+    std::vector<unsigned int> fill( cell_start.begin(), cell_start.end() - 1 );
+    cell_nodes.resize( num_nodes );
+    cell_pos.resize( num_nodes );
+    for ( unsigned int i = 0; i < num_nodes; i++ ) {
+        unsigned int slot = fill[node_cell[i]]++;
+
+        cell_nodes[slot] = i;
+        cell_pos[slot]   = nodes[i].GetPosition();
+    }
+
+    SG_LOG(SG_GENERAL, SG_DEBUG, "tgNodeGrid: " << num_nodes << " nodes in " << cols << " x " << rows << " cells" );
+}
+
+int tgNodeGrid::ColumnOf( double lon ) const
+{
+    int c = (int)floor( (lon - min_lon) / cell_size );
+    return std::max( 0, std::min( c, cols - 1 ) );
+}
+
+int tgNodeGrid::RowOf( double lat ) const
+{
+    int r = (int)floor( (lat - min_lat) / cell_size );
+    return std::max( 0, std::min( r, rows - 1 ) );
+}
+
+void tgNodeGrid::FindCandidates( const SGGeod& p0, const SGGeod& p1, double margin, const tgRectangle& bounds, std::vector<unsigned int>& candidates ) const
+{
+    double x0 = p0.getLongitudeDeg();
+    double y0 = p0.getLatitudeDeg();
+    double dx = p1.getLongitudeDeg() - x0;
+    double dy = p1.getLatitudeDeg()  - y0;
+
+    double min_x = bounds.getMin().getLongitudeDeg() - TG_NODE_GRID_BOUNDS_EPS;
+    double min_y = bounds.getMin().getLatitudeDeg()  - TG_NODE_GRID_BOUNDS_EPS;
+    double max_x = bounds.getMax().getLongitudeDeg() + TG_NODE_GRID_BOUNDS_EPS;
+    double max_y = bounds.getMax().getLatitudeDeg()  + TG_NODE_GRID_BOUNDS_EPS;
+
+    candidates.clear();
+    if ( nodes.size() == 0 ) {
+        return;
+    }
+
+    double seg_min_x = std::min( x0, x0 + dx );
+    double seg_max_x = std::max( x0, x0 + dx );
+    double seg_min_y = std::min( y0, y0 + dy );
+    double seg_max_y = std::max( y0, y0 + dy );
+
+    // walk the columns the segment crosses, and only visit the rows the
+    // segment covers within each column (plus the margin)
+    int c0 = ColumnOf( seg_min_x - margin );
+    int c1 = ColumnOf( seg_max_x + margin );
+
+    for ( int c = c0; c <= c1; c++ ) {
+        double cx0 = std::max( min_lon + c * cell_size, seg_min_x ) - margin;
+        double cx1 = std::min( min_lon + (c+1) * cell_size, seg_max_x ) + margin;
+        double ylo = seg_min_y;
+        double yhi = seg_max_y;
+
+        if ( dx != 0.0 ) {
+            double ya = y0 + (cx0 - x0) * dy / dx;
+            double yb = y0 + (cx1 - x0) * dy / dx;
+
+            ylo = std::max( std::min( ya, yb ), seg_min_y );
+            yhi = std::min( std::max( ya, yb ), seg_max_y );
+        }
+
+        int r0 = RowOf( ylo - margin );
+        int r1 = RowOf( yhi + margin );
+
+        for ( int r = r0; r <= r1; r++ ) {
+            unsigned int cell = r * cols + c;
+
+            for ( unsigned int i = cell_start[cell]; i < cell_start[cell+1]; i++ ) {
+                SGGeod const& pos = cell_pos[i];
+
+                if ( pos.getLongitudeDeg() >= min_x && pos.getLongitudeDeg() <= max_x &&
+                     pos.getLatitudeDeg()  >= min_y && pos.getLatitudeDeg()  <= max_y ) {
+                    candidates.push_back( cell_nodes[i] );
+                }
+            }
+        }
+    }
+
+    // in node order, as a scan of the node list would find them
+    std::sort( candidates.begin(), candidates.end() );
+}
@@ -0,0 +1,55 @@
+#ifndef _TG_NODE_GRID_HXX
+#define _TG_NODE_GRID_HXX
+
+#ifndef __cplusplus
+# error This library requires C++
+#endif
+
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/math/SGMath.hxx>
+
+#include "tg_rectangle.hxx"
+
+class TGNodes;
+
+// Uniform grid over all of the nodes in a tile, used to find the nodes lying
+// on a polygon edge (T-Junctions).  Unlike a bounding box query, the search
+// only visits the cells in a narrow corridor along the segment, so long thin
+// polygons (roads, streams) don't end up testing every node in the tile.
+// The grid holds node indices, so it must be rebuilt if nodes are added.
+class tgNodeGrid
+{
+public:
+    tgNodeGrid( TGNodes& n );
+
+    // Find the nodes in the cells within margin of the segment p0 -> p1,
+    // which were inside bounds when the grid was built (with the same slack
+    // as the TGNodes range queries).  Candidates are returned as node
+    // indices in ascending order - the caller makes the exact test.
+    void FindCandidates( const SGGeod& p0, const SGGeod& p1, double margin, const tgRectangle& bounds, std::vector<unsigned int>& candidates ) const;
+
+    TGNodes& GetNodes( void ) const { return nodes; }
+
+private:
+    int ColumnOf( double lon ) const;
+    int RowOf( double lat ) const;
+
+    TGNodes&                    nodes;
+
+    double                      min_lon;
+    double                      min_lat;
+    double                      cell_size;
+    int                         cols;
+    int                         rows;
+
+    // nodes sorted by cell - cell c holds cell_nodes[cell_start[c]] to cell_nodes[cell_start[c+1]-1]
+    std::vector<unsigned int>   cell_start;
+    std::vector<unsigned int>   cell_nodes;
+
+    // and their positions when the grid was built
+    std::vector<SGGeod>         cell_pos;
+};
+
+#endif // _TG_NODE_GRID_HXX
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
 #include <simgear/debug/logstream.hxx>
 
 #include "tg_nodes.hxx"
@@ -10,6 +14,22 @@ const double fgPoint3_Epsilon = 0.000001;
 // the second element of the tuple is the elevation of this point
 // Three dimensional queries is a bit overkill, but the code, although faster, is slightly more cumbersome
 
+// When more than one node lies within the query radius, the k-d tree
+// reports them in no particular order.  Always use the oldest one, so the
+// result doesn't depend on the shape of the tree, and unique_add_batch()
+// can assign the same indices.
+static unsigned int LowestIndex( const std::list<TGNodeData>& searchResults )
+{
+    std::list<TGNodeData>::const_iterator it = searchResults.begin();
+    unsigned int index = boost::get<2>(*it);
+
+    for ( ++it; it != searchResults.end(); ++it ) {
+        index = std::min( index, (unsigned int)boost::get<2>(*it) );
+    }
+
+    return index;
+}
+
 unsigned int TGNodes::unique_add( SGGeod& p, tgNodeType t ) {
     //static unsigned int calls = 0;
     
@@ -37,8 +57,7 @@ unsigned int TGNodes::unique_add( SGGeod& p, tgNodeType t ) {
         tg_kd_tree.insert(data);            
     } else {
         // we found a node - use it
-        std::list<TGNodeData>::const_iterator it = searchResults.begin();
-        index = boost::get<2>(*it);
+        index = LowestIndex( searchResults );
         p = tg_node_list[index].GetPosition();
     }
     
@@ -52,6 +71,164 @@ unsigned int TGNodes::unique_add( SGGeod& p, tgNodeType t ) {
     return index;
 }
 
+// Batch insertion support.  Points are binned into a grid with a cell size
+// equal to the unique_add query radius, so any duplicate of a point lies in
+// the same or one of the 8 neighbouring cells.  The cells are ordered by morton
+// code, which keeps spatially close cells close in memory, and each cell is
+// found with a binary search.
+static const double tgNodeBatchRadius = 0.0000001;     // approx 1 cm - same as unique_add
+
+struct TGNodeCellEntry {
+    uint64_t        code;
+    unsigned int    idx;
+
+    bool operator<( const TGNodeCellEntry& other ) const {
+        if ( code != other.code ) {
+            return code < other.code;
+        }
+        return idx < other.idx;
+    }
+};
+
+struct TGNodeCellCodeLess {
+    bool operator()( const TGNodeCellEntry& e, uint64_t c ) const { return e.code < c; }
+    bool operator()( uint64_t c, const TGNodeCellEntry& e ) const { return c < e.code; }
+};
+
+// spread the 32 bits of v into the even bits of a 64 bit word
+static inline uint64_t MortonSpread( uint64_t v )
+{
+    v &= 0x00000000FFFFFFFFULL;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v <<  8)) & 0x00FF00FF00FF00FFULL;
+    v = (v | (v <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v <<  2)) & 0x3333333333333333ULL;
+    v = (v | (v <<  1)) & 0x5555555555555555ULL;
+    return v;
+}
+
+static inline uint64_t MortonCode( int64_t cx, int64_t cy )
+{
+    return MortonSpread( (uint64_t)cx ) | ( MortonSpread( (uint64_t)cy ) << 1 );
+}
+
+static inline void NodeCell( double lon, double lat, int64_t& cx, int64_t& cy )
+{
+    cx = (int64_t)floor( (lon + 180.0) / tgNodeBatchRadius );
+    cy = (int64_t)floor( (lat +  90.0) / tgNodeBatchRadius );
+}
+
+static inline bool NodeWithinRadius( const SGGeod& a, const SGGeod& b )
+{
+    double dx = a.getLongitudeDeg() - b.getLongitudeDeg();
+    double dy = a.getLatitudeDeg()  - b.getLatitudeDeg();
+
+    return ( dx*dx + dy*dy <= tgNodeBatchRadius * tgNodeBatchRadius );
+}
+
+void TGNodes::unique_add_batch( std::vector<SGGeod>& points, std::vector<unsigned int>& indices, tgNodeType t )
+{
+    const unsigned int num_points = points.size();
+    const unsigned int first_new  = tg_node_list.size();
+    int64_t cx, cy;
+
+    indices.resize( num_points );
+    if ( num_points == 0 ) {
+        return;
+    }
+
+    // bin the nodes we already have
+    std::vector<TGNodeCellEntry> existing( first_new );
+    for ( unsigned int i = 0; i < first_new; i++ ) {
+        NodeCell( tg_node_list[i].GetPosition().getLongitudeDeg(), tg_node_list[i].GetPosition().getLatitudeDeg(), cx, cy );
+        existing[i].code = MortonCode( cx, cy );
+        existing[i].idx  = i;
+    }
+    std::sort( existing.begin(), existing.end() );
+
+    // and the new points - entries in a cell stay in insertion order
+    std::vector<TGNodeCellEntry> batch( num_points );
+    for ( unsigned int i = 0; i < num_points; i++ ) {
+        NodeCell( points[i].getLongitudeDeg(), points[i].getLatitudeDeg(), cx, cy );
+        batch[i].code = MortonCode( cx, cy );
+        batch[i].idx  = i;
+    }
+    std::sort( batch.begin(), batch.end() );
+
+    // node index created by each point, or -1 if it was merged into another node
+    std::vector<int> created( num_points, -1 );
+
+    // if the node list has to grow, the node pointers already in the tree go
+    // stale - in that case the whole tree is rebuilt below.
+    bool relocated = ( tg_node_list.capacity() < first_new + num_points );
+    tg_node_list.reserve( first_new + num_points );
+
+    // walk the points in their original order, so node indices are assigned
+    // exactly as sequential unique_add() calls would assign them
+    for ( unsigned int i = 0; i < num_points; i++ ) {
+        int match = -1;
+
+        NodeCell( points[i].getLongitudeDeg(), points[i].getLatitudeDeg(), cx, cy );
+        for ( int64_t dx = -1; dx <= 1; dx++ ) {
+            for ( int64_t dy = -1; dy <= 1; dy++ ) {
+                if ( cx + dx < 0 || cy + dy < 0 ) {
+                    continue;
+                }
+                uint64_t code = MortonCode( cx + dx, cy + dy );
+
+                std::pair<std::vector<TGNodeCellEntry>::const_iterator, std::vector<TGNodeCellEntry>::const_iterator> range;
+
+                range = std::equal_range( existing.begin(), existing.end(), code, TGNodeCellCodeLess() );
+                for ( std::vector<TGNodeCellEntry>::const_iterator it = range.first; it != range.second; ++it ) {
+                    if ( ( match < 0 || (int)it->idx < match ) &&
+                         NodeWithinRadius( points[i], tg_node_list[it->idx].GetPosition() ) ) {
+                        match = it->idx;
+                    }
+                }
+
+                // only points earlier in the list can have created a node
+                range = std::equal_range( batch.begin(), batch.end(), code, TGNodeCellCodeLess() );
+                for ( std::vector<TGNodeCellEntry>::const_iterator it = range.first; it != range.second && it->idx < i; ++it ) {
+                    int node = created[it->idx];
+                    if ( node >= 0 && ( match < 0 || node < match ) &&
+                         NodeWithinRadius( points[i], tg_node_list[node].GetPosition() ) ) {
+                        match = node;
+                    }
+                }
+            }
+        }
+
+        if ( match < 0 ) {
+            // no node here - add a new one
+            created[i] = tg_node_list.size();
+            indices[i] = created[i];
+            tg_node_list.push_back( TGNode( points[i], t ) );
+        } else {
+            // we found a node - use it
+            indices[i] = match;
+            points[i]  = tg_node_list[match].GetPosition();
+        }
+    }
+
+    // now insert all of the new nodes into the k-d tree at once - the node
+    // list doesn't grow anymore, so the node pointers are stable
+    unsigned int first_insert = first_new;
+    if ( relocated ) {
+        tg_kd_tree.clear();
+        first_insert = 0;
+    }
+
+    std::vector<TGNodeData> added;
+    added.reserve( tg_node_list.size() - first_insert );
+    for ( unsigned int i = first_insert; i < tg_node_list.size(); i++ ) {
+        SGGeod const& pos = tg_node_list[i].GetPosition();
+        TGNodePoint   pt( pos.getLongitudeDeg(), pos.getLatitudeDeg() );
+
+        added.push_back( TGNodeData( pt, pos.getElevationM(), i, &tg_node_list[i] ) );
+    }
+    tg_kd_tree.insert( added.begin(), added.end() );
+}
+
 int TGNodes::find(  const SGGeod& p ) const {
     std::list<TGNodeData>   searchResults;
     int index = -1;
@@ -67,8 +244,7 @@ int TGNodes::find(  const SGGeod& p ) const {
     
     if ( !searchResults.empty() ) {
         // we found a node - use it
-        std::list<TGNodeData>::const_iterator it = searchResults.begin();
-        index = (int)boost::get<2>(*it);
+        index = (int)LowestIndex( searchResults );
     }
     
 #if 0        
@@ -243,6 +419,41 @@ bool TGNodes::get_geod_edge( const SGBucket& b, std::vector<SGGeod>& north, std:
     return true;
 }
 
+// Same as above, but returns node indices - so the current node position
+// ( not the one at insertion time ) can be used
+bool TGNodes::get_nodes_edge( const SGBucket& b, std::vector<unsigned int>& north, std::vector<unsigned int>& south, std::vector<unsigned int>& east, std::vector<unsigned int>& west ) const {
+    double north_compare = b.get_center_lat() + 0.5 * b.get_height();
+    double south_compare = b.get_center_lat() - 0.5 * b.get_height();
+    double east_compare  = b.get_center_lon() + 0.5 * b.get_width();
+    double west_compare  = b.get_center_lon() - 0.5 * b.get_width();
+
+    TGNodePoint     ll[4], ur[4];
+    std::vector<unsigned int>* lists[4] = { &north, &south, &east, &west };
+
+    ll[0] = TGNodePoint( west_compare - fgPoint3_Epsilon, north_compare - fgPoint3_Epsilon );
+    ur[0] = TGNodePoint( east_compare + fgPoint3_Epsilon, north_compare + fgPoint3_Epsilon );
+    ll[1] = TGNodePoint( west_compare - fgPoint3_Epsilon, south_compare - fgPoint3_Epsilon );
+    ur[1] = TGNodePoint( east_compare + fgPoint3_Epsilon, south_compare + fgPoint3_Epsilon );
+    ll[2] = TGNodePoint( east_compare - fgPoint3_Epsilon, south_compare - fgPoint3_Epsilon );
+    ur[2] = TGNodePoint( east_compare + fgPoint3_Epsilon, north_compare + fgPoint3_Epsilon );
+    ll[3] = TGNodePoint( west_compare - fgPoint3_Epsilon, south_compare - fgPoint3_Epsilon );
+    ur[3] = TGNodePoint( west_compare + fgPoint3_Epsilon, north_compare + fgPoint3_Epsilon );
+
+    for ( unsigned int e = 0; e < 4; e++ ) {
+        std::list<TGNodeData> result;
+        std::list<TGNodeData>::iterator it;
+        TGNodeFuzzyBox exact_bb( ll[e], ur[e] );
+
+        lists[e]->clear();
+        tg_kd_tree.search(std::back_inserter( result ), exact_bb);
+        for ( it = result.begin(); it != result.end(); it++ ) {
+            lists[e]->push_back( boost::get<2>(*it) );
+        }
+    }
+
+    return true;
+}
+
 void TGNodes::get_geod_nodes( std::vector<SGGeod>& points  ) const {
     points.clear();
     for ( unsigned int i = 0; i < tg_node_list.size(); i++ ) {
@@ -313,10 +524,12 @@ void TGNodes::CalcElevations( tgNodeType type ) {
 }
     
 void TGNodes::CalcElevations( tgNodeType type, const tgSurface& surf ) {
+    std::vector<SGGeod>       positions;
+    std::vector<unsigned int> indices;
+    std::vector<double>       elevations;
+
     for(unsigned int i = 0; i < tg_node_list.size(); i++) {
         if ( tg_node_list[i].GetType() == type ) {
-            SGGeod pos = tg_node_list[i].GetPosition();
-
             switch (type)
             {
                 case TG_NODE_FIXED_ELEVATION:
@@ -325,13 +538,20 @@ void TGNodes::CalcElevations( tgNodeType type, const tgSurface& surf ) {
                     break;
 
                 case TG_NODE_SMOOTHED:
-                    SetElevation( i, surf.query( pos ) );
+                    positions.push_back( tg_node_list[i].GetPosition() );
+                    indices.push_back( i );
                     break;
             }
         } else {
             SG_LOG(SG_GENERAL, SG_ALERT, "CalcElevations smoothed Ignore pos " << tg_node_list[i].GetPosition() << " with type " << tg_node_list[i].GetType() );
         }        
     }
+
+    // evaluate the surface for all the smoothed nodes at once
+    surf.query( positions, elevations );
+    for (unsigned int i = 0; i < indices.size(); i++) {
+        SetElevation( indices[i], elevations[i] );
+    }
 }
 
 void TGNodes::CalcElevations( tgNodeType type, const tgtriangle_list& mesh ) {
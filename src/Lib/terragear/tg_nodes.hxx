@@ -195,6 +195,12 @@ public:
     // Add a point to the point list if it doesn't already exist.
     // Returns the index (starting at zero) of the point in the list.
     unsigned int unique_add( SGGeod& p, tgNodeType t = TG_NODE_INTERPOLATED );
+
+    // Add a whole list of points at once.  Same result as calling unique_add()
+    // on each point in order, but the points are sorted by morton code and
+    // deduplicated in one pass, and the k-d tree is only built once.
+    // indices receives the node index of each point
+    void unique_add_batch( std::vector<SGGeod>& points, std::vector<unsigned int>& indices, tgNodeType t = TG_NODE_INTERPOLATED );
     
     // Find the index of the specified point (compair to the same
     // tolerance as unique_add().  Returns -1 if not found.
@@ -235,6 +241,9 @@ public:
     // Find a;; the nodes on the tile edges
     bool get_geod_edge( const SGBucket& b, std::vector<SGGeod>& north, std::vector<SGGeod>& south, std::vector<SGGeod>& east, std::vector<SGGeod>& west ) const;
 
+    // Find the indices of all the nodes on the tile edges
+    bool get_nodes_edge( const SGBucket& b, std::vector<unsigned int>& north, std::vector<unsigned int>& south, std::vector<unsigned int>& east, std::vector<unsigned int>& west ) const;
+
     // return a point list of wgs84 nodes
     void get_wgs84_nodes( std::vector<SGVec3d>& points ) const;
 
@@ -0,0 +1,80 @@
+#include <math.h>
+
+#include <simgear/constants.h>
+
+#include "tg_normals.hxx"
+#include "tg_polygon.hxx"
+
+tgNormalNodeArrays::tgNormalNodeArrays( const TGNodes& nodes )
+{
+    unsigned int num_nodes = nodes.size();
+
+    x.resize( num_nodes );
+    y.resize( num_nodes );
+    z.resize( num_nodes );
+    lon.resize( num_nodes );
+    lat.resize( num_nodes );
+
+    for ( unsigned int i = 0; i < num_nodes; i++ ) {
+        TGNode const& node = nodes.get_node( i );
+        SGVec3d const& wgs84 = node.GetWgs84();
+
+        x[i]   = wgs84.x();
+        y[i]   = wgs84.y();
+        z[i]   = wgs84.z();
+        lon[i] = node.GetPosition().getLongitudeDeg();
+        lat[i] = node.GetPosition().getLatitudeDeg();
+    }
+}
+
+void tgCalcFaceNormals( const tgNormalNodeArrays& n, tgPolygon& poly )
+{
+    unsigned int num_tris = poly.Triangles();
+    if ( !num_tris ) {
+        return;
+    }
+
+    std::vector<int>    i0( num_tris ), i1( num_tris ), i2( num_tris );
+    std::vector<double> areas( num_tris );
+    std::vector<float>  cx( num_tris ), cy( num_tris ), cz( num_tris );
+
+    for ( unsigned int tri = 0; tri < num_tris; tri++ ) {
+        i0[tri] = poly.GetTriIdx( tri, 0 );
+        i1[tri] = poly.GetTriIdx( tri, 1 );
+        i2[tri] = poly.GetTriIdx( tri, 2 );
+    }
+
+    for ( unsigned int tri = 0; tri < num_tris; tri++ ) {
+        int a = i0[tri], b = i1[tri], c = i2[tri];
+
+        areas[tri] = fabs( 0.5 * ( n.lon[a] * n.lat[b] - n.lon[b] * n.lat[a] +
+                                   n.lon[b] * n.lat[c] - n.lon[c] * n.lat[b] +
+                                   n.lon[c] * n.lat[a] - n.lon[a] * n.lat[c] ) );
+
+        // edge vectors are single precision, as in calc_normal()
+        float v1x = n.x[b] - n.x[a], v1y = n.y[b] - n.y[a], v1z = n.z[b] - n.z[a];
+        float v2x = n.x[c] - n.x[a], v2y = n.y[c] - n.y[a], v2z = n.z[c] - n.z[a];
+
+        cx[tri] = v1y * v2z - v1z * v2y;
+        cy[tri] = v1z * v2x - v1x * v2z;
+        cz[tri] = v1x * v2y - v1y * v2x;
+    }
+
+    const double area_eps = 1.0e-12;
+    for ( unsigned int tri = 0; tri < num_tris; tri++ ) {
+        int a = i0[tri], b = i1[tri], c = i2[tri];
+        SGVec3f normal;
+
+        if ( ( areas[tri] < area_eps ) ||
+             ( fabs(n.x[a] - n.x[b]) < SG_EPSILON && fabs(n.x[a] - n.x[c]) < SG_EPSILON ) ||
+             ( fabs(n.y[a] - n.y[b]) < SG_EPSILON && fabs(n.y[a] - n.y[c]) < SG_EPSILON ) ||
+             ( fabs(n.z[a] - n.z[b]) < SG_EPSILON && fabs(n.z[a] - n.z[c]) < SG_EPSILON ) ) {
+            normal = normalize( SGVec3f( n.x[a], n.y[a], n.z[a] ) );
+        } else {
+            normal = normalize( SGVec3f( cx[tri], cy[tri], cz[tri] ) );
+        }
+
+        poly.SetTriFaceArea( tri, areas[tri] );
+        poly.SetTriFaceNormal( tri, normal );
+    }
+}
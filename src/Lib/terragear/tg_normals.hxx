@@ -0,0 +1,32 @@
+#ifndef _TG_NORMALS_HXX
+#define _TG_NORMALS_HXX
+
+#ifndef __cplusplus
+# error This library requires C++
+#endif
+
+#include <vector>
+
+#include "tg_nodes.hxx"
+
+class tgPolygon;
+
+// node positions as separate arrays, so the per triangle loops of
+// tgCalcFaceNormals() are straight arithmetic over contiguous data the
+// compiler can vectorize
+class tgNormalNodeArrays
+{
+public:
+    tgNormalNodeArrays( const TGNodes& nodes );
+
+    std::vector<double> x, y, z;
+    std::vector<double> lon, lat;
+};
+
+// Set the face area and normal of every triangle of poly, with the same
+// result as tg-construct's calc_normal() : the areas and unnormalized
+// cross products are computed in one branch free pass, then the
+// degenerate triangles are patched up and the rest normalized.
+void tgCalcFaceNormals( const tgNormalNodeArrays& n, tgPolygon& poly );
+
+#endif // _TG_NORMALS_HXX
@@ -32,6 +32,7 @@
 #include <simgear/debug/logstream.hxx>
 #include <simgear/bucket/newbucket.hxx>
 
+#include "tg_local_frame.hxx"
 #include "tg_misc.hxx"
 #include "tg_polygon.hxx"
 
@@ -174,6 +175,19 @@ void tgPolygon::AddColinearNodes( const std::vector<SGGeod>& nodes )
     for ( unsigned int c = 0; c < Contours(); c++ ) {
         contours[c] = tgContour::AddColinearNodes( contours[c], nodes );
     }
+    cgal.reset();
+}
+
+void tgPolygon::AddColinearNodes( const tgNodeGrid& grid )
+{
+    // only the nodes inside the polygon's bounding box, as the range query
+    // FixTJunctions used to make
+    tgRectangle bounds = GetBoundingBox();
+
+    for ( unsigned int c = 0; c < Contours(); c++ ) {
+        contours[c].AddColinearNodes( grid, bounds, preserve3d );
+    }
+    cgal.reset();
 }
 
 tgPolygon tgPolygon::AddColinearNodes( const tgPolygon& subject, UniqueSGGeodSet& nodes )
@@ -295,6 +309,13 @@ void tgPolygon::Texture( void )
     SGVec2f t;
     double  x, y;
     float   tx, ty;
+
+    // every node is measured from the texture reference.  The TPS
+    // coordinates below move by up to the frame tolerance ( 1 mm by
+    // default ) against SGGeodesy, so u and v by that over the texture
+    // width or length - far below a texel.  Refs more than the tolerance
+    // allows from a node fall back to SGGeodesy, as before.
+    tgLocalFrame frame( tp.ref );
     
     switch( tp.method ) {
         case TG_TEX_BY_GEODE:
@@ -338,7 +359,7 @@ void tgPolygon::Texture( void )
                     // and ending az1, az2 and distance (s).  Lat, lon, and
                     // azimuth are in degrees.  distance in meters
                     double az1, az2, dist;
-                    SGGeodesy::inverse( tp.ref, p, az1, az2, dist );
+                    frame.Inverse( tp.ref, p, az1, az2, dist );
                     SG_LOG(SG_GENERAL, SG_DEBUG, "\tbasic course = " << az2 << " dist is " << dist );
 
                     //
@@ -417,7 +438,7 @@ void tgPolygon::Texture( void )
                     // and ending az1, az2 and distance (s).  Lat, lon, and
                     // azimuth are in degrees.  distance in meters
                     double az1, az2, dist;
-                    SGGeodesy::inverse( tp.ref, p, az1, az2, dist );
+                    frame.Inverse( tp.ref, p, az1, az2, dist );
                     SG_LOG(SG_GENERAL, SG_DEBUG, "\tbasic course = " << az1 << " dist is " << dist );
                     
                     //
@@ -490,7 +511,7 @@ void tgPolygon::Texture( void )
                     // and ending az1, az2 and distance (s).  Lat, lon, and
                     // azimuth are in degrees.  distance in meters
                     double az1, az2, dist;
-                    SGGeodesy::inverse( tp.ref, p, az1, az2, dist );
+                    frame.Inverse( tp.ref, p, az1, az2, dist );
                     SG_LOG(SG_GENERAL, SG_DEBUG, "\tbasic course = " << az1 << " dist is " << dist );
                     
                     //
@@ -629,6 +650,10 @@ void tgPolygon::TextureSecondary( void )
             case TG_TEX_BY_TPS_CLIPUV:
             {             
                 SG_LOG(SG_GENERAL, SG_DEBUG, "stp ref is " << stp.ref << " width " << stp.width << " Length " << stp.length );
+
+                // as in Texture, u and v move by the tolerance over the
+                // width or length at most
+                tgLocalFrame frame( stp.ref );
             
                 for ( unsigned int j = 0; j < 3; j++ ) {
                     p = triangles[i].GetNode( j );
@@ -643,7 +668,7 @@ void tgPolygon::TextureSecondary( void )
                     // and ending az1, az2 and distance (s).  Lat, lon, and
                     // azimuth are in degrees.  distance in meters
                     double az1, az2, dist;
-                    SGGeodesy::inverse( stp.ref, p, az1, az2, dist );
+                    frame.Inverse( stp.ref, p, az1, az2, dist );
                     SG_LOG(SG_GENERAL, SG_DEBUG, "\tbasic course = " << az2 << " dist is " << dist );
                     
                     //
@@ -35,6 +35,7 @@
 #include <zlib.h> 
 
 #include <boost/array.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <simgear/compiler.h>
 #include <simgear/math/sg_types.hxx>
@@ -97,6 +98,10 @@ typedef std::vector <tgPolygon>  tgpolygon_list;
 typedef tgpolygon_list::iterator tgpolygon_list_iterator;
 typedef tgpolygon_list::const_iterator const_tgpolygon_list_iterator;
 
+// the CGAL form of a tgPolygon - see tg_arrangement.hxx
+class tgCgalPolygon;
+typedef boost::shared_ptr<const tgCgalPolygon> tgCgalPolygonPtr;
+
 class tgPolygon
 {
 public:
@@ -125,6 +130,7 @@ public:
     void Erase( void ) {
         contours.clear();
         triangles.clear();
+        cgal.reset();
     }
 
     unsigned int Contours( void ) const {
@@ -135,6 +141,7 @@ public:
     }
     void AddContour( tgContour const& contour ) {
         contours.push_back(contour);
+        cgal.reset();
     }
     tgContour GetContour( unsigned int c ) const {
         return contours[c];
@@ -142,20 +149,23 @@ public:
     void DeleteContourAt( unsigned int idx ) {
         if ( idx < contours.size() ) {
             contours.erase( contours.begin() + idx );
+            cgal.reset();
         }
     }
     void SetContours( tgcontour_list& clist ) {
         contours.clear();
         contours = clist;
+        cgal.reset();
     }
 
     unsigned int TotalNodes( void ) const;
 
-    SGGeod const& GetNode( unsigned int c, unsigned int i ) const {
+    SGGeod GetNode( unsigned int c, unsigned int i ) const {
         return contours[c][i];
     }
     void SetNode( unsigned int c, unsigned int i, const SGGeod& n ) {
         contours[c].SetNode( i, n );
+        cgal.reset();
     }
 
     void AddNode( unsigned int c, const SGGeod& n ) {
@@ -167,9 +177,11 @@ public:
         }
 
         contours[c].AddNode( n );
+        cgal.reset();
     }
     void DelNode( unsigned int c, unsigned int n ) {
         contours[c].DelNode( n );
+        cgal.reset();
     }
     
     tgRectangle GetBoundingBox( void ) const;
@@ -353,6 +365,11 @@ public:
     // Tesselation
     void Tesselate( bool debug );
     void Tesselate( const std::vector<SGGeod>& extra, bool debug );
+    void Tesselate( const TGNodes& nodes, const std::vector<SGGeod>& extra, bool debug );
+
+    // polys tesselated so far with inexact constructions, and those that
+    // needed exact constructions for their constraint intersections
+    static void GetTesselationStats( unsigned int& fast, unsigned int& exact );
 
     // Straight Skeleton
     tgpolygon_list StraightSkeleton(void);
@@ -363,6 +380,11 @@ public:
     static tgPolygon Union_cgal( const tgPolygon& subject, tgPolygon& clip );
     static tgPolygon Union( const tgpolygon_list& polys );
     static tgPolygon Union_cgal( const tgpolygon_list& polys );
+    // Union of many polys - they are ordered spatially, and when they
+    // overlap heavily, unioned in small groups of neighbours, then the groups
+    // in pairs, the pairs in pairs, etc.  use_cgal joins them in one
+    // Polygon_set_2 instead.
+    static tgPolygon UnionAll( const tgpolygon_list& polys, bool use_cgal = false );
     static tgPolygon Diff( const tgPolygon& subject, tgPolygon& clip );
     static tgPolygon Intersect( const tgPolygon& subject, const tgPolygon& clip );
 
@@ -400,6 +422,7 @@ public:
     unsigned int RemoveDups( void );
     unsigned int RemoveBadContours( void );
     void         AddColinearNodes( const std::vector<SGGeod>& nodes );
+    void         AddColinearNodes( const tgNodeGrid& grid );
     
     
     // IO
@@ -407,6 +430,7 @@ public:
     void LoadFromGzFile( gzFile& fp );
 
     friend std::ostream& operator<< ( std::ostream&, const tgPolygon& );
+    friend tgCgalPolygonPtr tgGetCgalPolygon( const tgPolygon& subject );
 
 public:
     int_va_list     int_vas;
@@ -424,6 +448,10 @@ private:
     bool            preserve3d;
     unsigned int    id;         // unique polygon id for debug
     tgTexParams     tp;
+
+    // CGAL conversion of the contours, made on first use - every change to
+    // the contours drops it.  Copies share it, as it is never modified.
+    mutable tgCgalPolygonPtr cgal;
 };
 
 #endif // _POLYGON_HXX
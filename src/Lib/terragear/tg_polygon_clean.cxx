@@ -1,3 +1,7 @@
+#include <math.h>
+#include <algorithm>
+
+#include <simgear/constants.h>
 #include <simgear/debug/logstream.hxx>
 
 #include "tg_polygon.hxx"
@@ -31,6 +35,7 @@ void tgPolygon::Snap( double snap )
     for (unsigned int c = 0; c < contours.size(); c++) {
         contours[c].Snap( snap );
     }
+    cgal.reset();
 }
 
 #if 0
@@ -62,6 +67,9 @@ unsigned int tgPolygon::RemoveDups( void )
     for ( unsigned int c = 0; c < Contours(); c++ ) {
         total_removed += contours[c].RemoveDups();
     }
+    if ( total_removed ) {
+        cgal.reset();
+    }
     
     return total_removed;
 }
@@ -106,6 +114,7 @@ unsigned int tgPolygon::RemoveBadContours( void )
     }
     
     if ( before != contours.size() ) {
+        cgal.reset();
         SG_LOG(SG_GENERAL, DEBUG_POLY_CLEAN, "RemoveBadContours before: " << before << " after: " << contours.size() );
     }
     
@@ -359,27 +368,107 @@ void tgPolygon::RemoveSlivers( tgPolygon& subject, tgcontour_list& slivers )
     }
 }
 
+// slivers are matched against the polys through a grid over their bounding
+// boxes, and only merged into the polys they touch
+#define MERGE_SLIVERS_GRID_CELLS    (32)
+
 tgcontour_list tgPolygon::MergeSlivers( tgpolygon_list& polys, tgcontour_list& sliver_list ) {
-    tgPolygon poly, result;
+    tgPolygon result;
     tgContour sliver;
-    tgContour contour;
     tgcontour_list unmerged;
     unsigned int original_contours, result_contours;
     bool done;
 
+    if ( sliver_list.empty() || polys.empty() ) {
+        return sliver_list;
+    }
+
+    // grid over the poly bounding boxes
+    std::vector<tgRectangle> boxes;
+    tgRectangle              extent = polys[0].GetBoundingBox();
+
+    for ( unsigned int j = 0; j < polys.size(); j++ ) {
+        boxes.push_back( polys[j].GetBoundingBox() );
+        extent.expandBy( boxes[j] );
+    }
+
+    double min_lon   = extent.getMin().getLongitudeDeg();
+    double min_lat   = extent.getMin().getLatitudeDeg();
+    double cell_size = std::max( extent.getMax().getLongitudeDeg() - min_lon,
+                                 extent.getMax().getLatitudeDeg()  - min_lat ) / MERGE_SLIVERS_GRID_CELLS;
+    if ( cell_size <= 0.0 ) {
+        cell_size = 1.0;
+    }
+
+    std::vector< std::vector<unsigned int> > cells( MERGE_SLIVERS_GRID_CELLS * MERGE_SLIVERS_GRID_CELLS );
+
+    for ( unsigned int j = 0; j < polys.size(); j++ ) {
+        int col0 = std::min( (int)( ( boxes[j].getMin().getLongitudeDeg() - min_lon ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+        int col1 = std::min( (int)( ( boxes[j].getMax().getLongitudeDeg() - min_lon ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+        int row0 = std::min( (int)( ( boxes[j].getMin().getLatitudeDeg()  - min_lat ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+        int row1 = std::min( (int)( ( boxes[j].getMax().getLatitudeDeg()  - min_lat ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+
+        for ( int row = row0; row <= row1; row++ ) {
+            for ( int col = col0; col <= col1; col++ ) {
+                cells[row * MERGE_SLIVERS_GRID_CELLS + col].push_back( j );
+            }
+        }
+    }
+
+    // the last sliver each poly was a candidate for - to visit it once
+    std::vector<unsigned int> visited( polys.size(), (unsigned int)-1 );
+
     for ( unsigned int i = 0; i < sliver_list.size(); i++ ) {
         sliver = sliver_list[i];
         SG_LOG(SG_GENERAL, SG_DEBUG, "Merging sliver = " << i );
 
         sliver.SetHole( false );
 
+        // the slivers come back from clipper, so they may be off the poly
+        // edges by the rounding
+        tgRectangle sliver_box = sliver.GetBoundingBox();
+        sliver_box.expandBy( SGGeod::fromDeg( sliver_box.getMin().getLongitudeDeg() - SG_EPSILON, sliver_box.getMin().getLatitudeDeg() - SG_EPSILON ) );
+        sliver_box.expandBy( SGGeod::fromDeg( sliver_box.getMax().getLongitudeDeg() + SG_EPSILON, sliver_box.getMax().getLatitudeDeg() + SG_EPSILON ) );
+
+        int col0 = std::max( (int)floor( ( sliver_box.getMin().getLongitudeDeg() - min_lon ) / cell_size ), 0 );
+        int col1 = std::min( (int)floor( ( sliver_box.getMax().getLongitudeDeg() - min_lon ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+        int row0 = std::max( (int)floor( ( sliver_box.getMin().getLatitudeDeg()  - min_lat ) / cell_size ), 0 );
+        int row1 = std::min( (int)floor( ( sliver_box.getMax().getLatitudeDeg()  - min_lat ) / cell_size ), MERGE_SLIVERS_GRID_CELLS - 1 );
+
+        // a union with a poly the sliver doesn't touch adds a contour, so
+        // only the polys around it can absorb it.  Except a sliver with no
+        // area at all : clipper drops it, so it went to the first poly of
+        // all before, and now to the first one around it, or stays.
+        std::vector<unsigned int> candidates;
+
+        for ( int row = row0; row <= row1; row++ ) {
+            for ( int col = col0; col <= col1; col++ ) {
+                const std::vector<unsigned int>& cell = cells[row * MERGE_SLIVERS_GRID_CELLS + col];
+
+                for ( unsigned int k = 0; k < cell.size(); k++ ) {
+                    unsigned int j = cell[k];
+
+                    if ( visited[j] == i || !boxes[j].intersects( sliver_box ) ) {
+                        continue;
+                    }
+                    visited[j] = i;
+                    candidates.push_back( j );
+                }
+            }
+        }
+
+        // in poly order, as when every poly was tried, so the sliver goes
+        // to the same one
+        std::sort( candidates.begin(), candidates.end() );
+
         done = false;
 
-        // try to merge the slivers with the list of clipped polys
-        for ( unsigned int j = 0; j < polys.size() && !done; j++ ) {
-            poly = polys[j];
-            original_contours = poly.Contours();
-            result = tgContour::Union( sliver, poly );
+        // try to merge the sliver with the clipped polys around it
+        for ( unsigned int k = 0; k < candidates.size() && !done; k++ ) {
+            unsigned int j = candidates[k];
+
+            original_contours = polys[j].Contours();
+            result = tgContour::Union( sliver, polys[j] );
             result_contours = result.Contours();
 
             if ( original_contours == result_contours ) {
@@ -394,6 +483,14 @@ tgcontour_list tgPolygon::MergeSlivers( tgpolygon_list& polys, tgcontour_list& s
                 result.flt_vas = polys[j].flt_vas;
                 polys[j] = result;
                 done = true;
+
+                // the poly now covers the sliver too
+                boxes[j].expandBy( sliver_box );
+                for ( int row = row0; row <= row1; row++ ) {
+                    for ( int col = col0; col <= col1; col++ ) {
+                        cells[row * MERGE_SLIVERS_GRID_CELLS + col].push_back( j );
+                    }
+                }
             }
         }
 
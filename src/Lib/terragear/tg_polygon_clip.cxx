@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <stdint.h>
 
 #include <simgear/debug/logstream.hxx>
 
@@ -18,6 +20,28 @@ static CGAL::Bbox_2 GetBoundingBox( const Polygon_set& subject )
     return CGAL::bbox_2( pwh_list.begin(), pwh_list.end() );
 }
 
+// A contour that doesn't touch itself is its own single face, so it
+// doesn't need an arrangement to find it.  Returns false for the ones that do.
+static bool ToSimplePolygon( const tgContour& contour, Polygon& poly )
+{
+    if ( contour.GetSize() < 3 ) {
+        return false;
+    }
+
+    for ( unsigned int i = 0; i < contour.GetSize(); i++ ) {
+        poly.push_back( arrPoint( contour.GetNode(i).getLongitudeDeg(), contour.GetNode(i).getLatitudeDeg() ) );
+    }
+
+    if ( !poly.is_simple() ) {
+        return false;
+    }
+    if ( poly.is_clockwise_oriented() ) {
+        poly.reverse_orientation();
+    }
+
+    return true;
+}
+
 static bool ToCgalPolyWithHoles( const tgPolygon& subject, Polygon_set& cgSubject, CGAL::Bbox_2& bb )
 {
     tgArrangement   arr;
@@ -46,19 +70,26 @@ static bool ToCgalPolyWithHoles( const tgPolygon& subject, Polygon_set& cgSubjec
         //sprintf( layer, "%04u_original_contour_%d", subject.GetId(), i );
         //tgShapefile::FromContour( subject.GetContour(i), false, true, "./clip_dbg", layer, "cont" );
         
-        arr.Clear();
-        arr.Add( subject.GetContour(i) );
+        Polygon_set face;
+        Polygon     simple;
 
-        // retreive the new Contour(s) from traversing the outermost face first
-        // any holes in this face are individual polygons
-        // any holes in those faces are holes, etc...
-        
-        // dump the arrangement to see what we have.
-        //sprintf( layer, "%04u_Arrangement_contour_%d", subject.GetId(), i );
-        //arr.ToShapefiles( "./clip_dbg", layer );
+        if ( ToSimplePolygon( subject.GetContour(i), simple ) ) {
+            face.insert( simple );
+        } else {
+            arr.Clear();
+            arr.Add( subject.GetContour(i) );
+
+            // retreive the new Contour(s) from traversing the outermost face first
+            // any holes in this face are individual polygons
+            // any holes in those faces are holes, etc...
 
-        // Combine boundaries and holes into their sets
-        Polygon_set face = arr.ToPolygonSet( i );
+            // dump the arrangement to see what we have.
+            //sprintf( layer, "%04u_Arrangement_contour_%d", subject.GetId(), i );
+            //arr.ToShapefiles( "./clip_dbg", layer );
+
+            // Combine boundaries and holes into their sets
+            face = arr.ToPolygonSet( i );
+        }
         //sprintf( layer, "%04u_face_contour_%d", subject.GetId(), i );
         //ToShapefile( face, layer );
         
@@ -93,6 +124,18 @@ static bool ToCgalPolyWithHoles( const tgPolygon& subject, Polygon_set& cgSubjec
     }
 }
 
+tgCgalPolygonPtr tgGetCgalPolygon( const tgPolygon& subject )
+{
+    if ( !subject.cgal ) {
+        tgCgalPolygon* converted = new tgCgalPolygon;
+
+        converted->valid = ToCgalPolyWithHoles( subject, converted->ps, converted->bbox );
+        subject.cgal = tgCgalPolygonPtr( converted );
+    }
+
+    return subject.cgal;
+}
+
 static tgContour ToTgContour( const Polygon& p, bool isHole )
 {
     tgContour contour;
@@ -141,22 +184,17 @@ static tgcontour_list ToTgPolygon( const Polygon_set& ps )
 
 tgPolygon tgPolygon::Union_cgal( const tgPolygon& subject, tgPolygon& clip )
 {
-    Polygon_set  cgalSubject;
-    Polygon_set  cgalClip;
-    CGAL::Bbox_2 cgalBbox;
     tgPolygon    result;
     
     // add clip to subject
-    ToCgalPolyWithHoles( subject, cgalSubject, cgalBbox );
-    ToCgalPolyWithHoles( clip, cgalClip, cgalBbox );
+    tgCgalPolygonPtr cgalSubject = tgGetCgalPolygon( subject );
+    tgCgalPolygonPtr cgalClip    = tgGetCgalPolygon( clip );
     
     return result;
 }
 
 tgPolygon tgPolygon::Union_cgal( const tgpolygon_list& polys )
 {
-    Polygon_set                     cgSubject;
-    CGAL::Bbox_2                    cgBbox;
     std::list<Polygon_with_holes>   accum;
     Polygon_set                     cgResult;
     tgPolygon                       result;
@@ -164,10 +202,12 @@ tgPolygon tgPolygon::Union_cgal( const tgpolygon_list& polys )
     SG_LOG(SG_GENERAL, SG_ALERT, "Union_cgal : have " << polys.size() << " polys" );
     
     for (unsigned int i=0; i<polys.size(); i++) {    
-        if ( ToCgalPolyWithHoles( polys[i], cgSubject, cgBbox ) ) {
+        tgCgalPolygonPtr cgSubject = tgGetCgalPolygon( polys[i] );
+
+        if ( cgSubject->valid ) {
             // add all PWHs to accum
             std::list<Polygon_with_holes> pwh_list;
-            cgSubject.polygons_with_holes( std::back_inserter(pwh_list) );
+            cgSubject->ps.polygons_with_holes( std::back_inserter(pwh_list) );
     
             accum.insert( accum.end(), pwh_list.begin(), pwh_list.end() );
         }
@@ -186,6 +226,194 @@ tgPolygon tgPolygon::Union_cgal( const tgpolygon_list& polys )
     return result;
 }
 
+// UnionAll sweeps all polys at once, unless their bounding boxes cover each
+// point more than UNION_ALL_MAX_DEPTH times on average
+#define UNION_ALL_MAX_DEPTH     (4.0)
+#define UNION_ALL_GROUP_SIZE    (8)
+
+// position of cell x,y along a hilbert curve filling a 2^16 x 2^16 grid
+static uint64_t HilbertIndex( uint32_t x, uint32_t y )
+{
+    const uint32_t n = 1 << 16;
+    uint64_t d = 0;
+
+    for ( uint32_t s = n / 2; s > 0; s /= 2 ) {
+        uint32_t rx = ( x & s ) ? 1 : 0;
+        uint32_t ry = ( y & s ) ? 1 : 0;
+
+        d += (uint64_t)s * s * ( ( 3 * rx ) ^ ry );
+
+        // rotate the quadrant
+        if ( ry == 0 ) {
+            if ( rx == 1 ) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap( x, y );
+        }
+    }
+
+    return d;
+}
+
+// indices of the non empty polys, ordered along a hilbert curve through the
+// centers of their bounding boxes - neighbours in the list are neighbours on
+// the ground.  depth is how many bounding boxes cover a point on average.
+static std::vector<unsigned int> HilbertOrder( const tgpolygon_list& polys, double& depth )
+{
+    std::vector< std::pair<uint64_t, unsigned int> > keys;
+    std::vector<SGGeod> centers;
+    std::vector<unsigned int> order;
+    double minx = 0.0, miny = 0.0, maxx = 0.0, maxy = 0.0;
+    double bbminx = 0.0, bbminy = 0.0, bbmaxx = 0.0, bbmaxy = 0.0;
+    double bbarea = 0.0;
+
+    for ( unsigned int i = 0; i < polys.size(); i++ ) {
+        if ( !polys[i].Contours() ) {
+            continue;
+        }
+
+        tgRectangle bb = polys[i].GetBoundingBox();
+        SGGeod center = SGGeod::fromDeg( ( bb.getMin().getLongitudeDeg() + bb.getMax().getLongitudeDeg() ) / 2.0,
+                                         ( bb.getMin().getLatitudeDeg()  + bb.getMax().getLatitudeDeg() )  / 2.0 );
+
+        if ( order.empty() ) {
+            minx = maxx = center.getLongitudeDeg();
+            miny = maxy = center.getLatitudeDeg();
+            bbminx = bb.getMin().getLongitudeDeg();
+            bbminy = bb.getMin().getLatitudeDeg();
+            bbmaxx = bb.getMax().getLongitudeDeg();
+            bbmaxy = bb.getMax().getLatitudeDeg();
+        } else {
+            minx = std::min( minx, center.getLongitudeDeg() );
+            maxx = std::max( maxx, center.getLongitudeDeg() );
+            miny = std::min( miny, center.getLatitudeDeg() );
+            maxy = std::max( maxy, center.getLatitudeDeg() );
+            bbminx = std::min( bbminx, bb.getMin().getLongitudeDeg() );
+            bbminy = std::min( bbminy, bb.getMin().getLatitudeDeg() );
+            bbmaxx = std::max( bbmaxx, bb.getMax().getLongitudeDeg() );
+            bbmaxy = std::max( bbmaxy, bb.getMax().getLatitudeDeg() );
+        }
+        bbarea += ( bb.getMax().getLongitudeDeg() - bb.getMin().getLongitudeDeg() ) *
+                  ( bb.getMax().getLatitudeDeg()  - bb.getMin().getLatitudeDeg() );
+
+        centers.push_back( center );
+        order.push_back( i );
+    }
+
+    double total = ( bbmaxx - bbminx ) * ( bbmaxy - bbminy );
+    depth = ( total > 0.0 ) ? bbarea / total : 0.0;
+
+    double sx = ( maxx > minx ) ? 65535.0 / ( maxx - minx ) : 0.0;
+    double sy = ( maxy > miny ) ? 65535.0 / ( maxy - miny ) : 0.0;
+
+    for ( unsigned int i = 0; i < order.size(); i++ ) {
+        uint32_t x = (uint32_t)( ( centers[i].getLongitudeDeg() - minx ) * sx );
+        uint32_t y = (uint32_t)( ( centers[i].getLatitudeDeg()  - miny ) * sy );
+
+        keys.push_back( std::make_pair( HilbertIndex( x, y ), order[i] ) );
+    }
+    std::sort( keys.begin(), keys.end() );
+
+    for ( unsigned int i = 0; i < keys.size(); i++ ) {
+        order[i] = keys[i].second;
+    }
+
+    return order;
+}
+
+static ClipperLib::Paths UnionPaths( const ClipperLib::Paths& subject, const ClipperLib::Paths& clip )
+{
+    ClipperLib::Paths   result;
+    ClipperLib::Clipper c;
+
+    c.AddPaths( subject, ClipperLib::ptSubject, true );
+    c.AddPaths( clip, ClipperLib::ptClip, true );
+    c.Execute( ClipperLib::ctUnion, result, ClipperLib::pftNonZero, ClipperLib::pftNonZero );
+
+    return result;
+}
+
+tgPolygon tgPolygon::UnionAll( const tgpolygon_list& polys, bool use_cgal )
+{
+    double depth;
+    std::vector<unsigned int> order = HilbertOrder( polys, depth );
+    tgPolygon result;
+
+    if ( use_cgal ) {
+        // Polygon_set_2 joins a range divide and conquer itself - it just
+        // needs neighbours close together
+        std::list<Polygon_with_holes> accum;
+        Polygon_set                   cgResult;
+
+        for ( unsigned int i = 0; i < order.size(); i++ ) {
+            tgCgalPolygonPtr cgSubject = tgGetCgalPolygon( polys[order[i]] );
+
+            if ( cgSubject->valid ) {
+                cgSubject->ps.polygons_with_holes( std::back_inserter(accum) );
+            }
+        }
+
+        cgResult.join( accum.begin(), accum.end() );
+        tgcontour_list contours = ToTgPolygon( cgResult );
+        result.SetContours( contours );
+
+        return result;
+    }
+
+    UniqueSGGeodSet all_nodes;
+    std::vector<ClipperLib::Paths> level;
+
+    // A single sweep is fastest while few polys overlap.  Deep stacks of
+    // overlapping polys fill the sweep with edges that never reach the
+    // result, so those are swept in small groups of neighbours, and the
+    // groups unioned pairwise.
+    unsigned int group = ( depth > UNION_ALL_MAX_DEPTH ) ? UNION_ALL_GROUP_SIZE : order.size();
+
+    /* before union - gather all nodes */
+    for ( unsigned int i = 0; i < order.size(); i += group ) {
+        ClipperLib::Clipper c;
+        ClipperLib::Paths   clipper_result;
+
+        for ( unsigned int l = i; l < order.size() && l < i + group; l++ ) {
+            const tgPolygon& poly = polys[order[l]];
+
+            for ( unsigned int j = 0; j < poly.Contours(); ++j ) {
+                for ( unsigned int k = 0; k < poly.ContourSize( j ); ++k ) {
+                    all_nodes.add( poly.GetNode(j, k) );
+                }
+            }
+            c.AddPaths( tgPolygon::ToClipper( poly ), ClipperLib::ptSubject, true );
+        }
+        c.Execute( ClipperLib::ctUnion, clipper_result, ClipperLib::pftNonZero, ClipperLib::pftNonZero );
+        level.push_back( clipper_result );
+    }
+
+    if ( level.empty() ) {
+        return result;
+    }
+
+    // union neighbouring pairs until one is left, so every union is
+    // between two results of about the same size
+    while ( level.size() > 1 ) {
+        std::vector<ClipperLib::Paths> next;
+
+        next.reserve( ( level.size() + 1 ) / 2 );
+        for ( unsigned int i = 0; i + 1 < level.size(); i += 2 ) {
+            next.push_back( UnionPaths( level[i], level[i+1] ) );
+        }
+        if ( level.size() % 2 ) {
+            next.push_back( level.back() );
+        }
+        level.swap( next );
+    }
+
+    result = tgPolygon::FromClipper( level[0] );
+    result = tgPolygon::AddColinearNodes( result, all_nodes );
+
+    return result;
+}
+
 static bool clipper_dump = false;
 void tgPolygon::SetClipperDump( bool dmp )
 {
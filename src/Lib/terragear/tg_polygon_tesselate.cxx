@@ -1,14 +1,19 @@
 #include <iostream>
 #include <cassert>
+#include <iterator>
 
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 #include <CGAL/Triangulation_face_base_with_info_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
 #include <CGAL/Constrained_triangulation_plus_2.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/Triangle_2.h>
 
 #include <simgear/debug/logstream.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include "tg_polygon.hxx"
 #include "tg_misc.hxx"
@@ -25,35 +30,78 @@ struct FaceInfo2
   }
 };
 
-typedef CGAL::Exact_predicates_exact_constructions_kernel         K;
-typedef CGAL::Triangulation_vertex_base_2<K>                      Vb;
-typedef CGAL::Triangulation_face_base_with_info_2<FaceInfo2,K>    Fbb;
-typedef CGAL::Constrained_triangulation_face_base_2<K,Fbb>        Fb;
-typedef CGAL::Triangulation_data_structure_2<Vb,Fb>               TDS;
-typedef CGAL::Exact_intersections_tag                             Itag;
-typedef CGAL::Constrained_Delaunay_triangulation_2<K, TDS, Itag>  CDT;
-typedef CGAL::Constrained_triangulation_plus_2<CDT>               CDTPlus;
-typedef CDTPlus::Point                                            Point;
-typedef CGAL::Polygon_2<K>                                        Polygon_2;
-typedef CGAL::Triangle_2<K>                                       Triangle_2;
-
-static void tg_mark_domains(CDT& ct, CDT::Face_handle start, int index, std::list<CDT::Edge>& border )
+/* node index of each vertex, looked up when a triangle first uses it - -1 if not in the node list */
+struct VertexInfo2
+{
+  VertexInfo2() : index(-1), looked_up(false) {}
+  int  index;
+  bool looked_up;
+};
+
+// The triangulation types for a kernel.  Polygons are first tesselated with
+// exact predicates but inexact constructions.  As long as no constraints
+// intersect, nothing is constructed, and the triangulation is the same as
+// the exact one.  If a constraint intersection adds a vertex, the polygon
+// is tesselated again with exact constructions.
+template <class K, class Itag>
+struct tgTessKernel
+{
+    typedef CGAL::Triangulation_vertex_base_with_info_2<VertexInfo2,K> Vb;
+    typedef CGAL::Triangulation_face_base_with_info_2<FaceInfo2,K>    Fbb;
+    typedef CGAL::Constrained_triangulation_face_base_2<K,Fbb>        Fb;
+    typedef CGAL::Triangulation_data_structure_2<Vb,Fb>               TDS;
+    typedef CGAL::Constrained_Delaunay_triangulation_2<K, TDS, Itag>  CDT;
+    typedef CGAL::Constrained_triangulation_plus_2<CDT>               CDTPlus;
+    typedef typename CDTPlus::Point                                   Point;
+    typedef CGAL::Polygon_2<K>                                        Polygon_2;
+    typedef CGAL::Triangle_2<K>                                       Triangle_2;
+};
+
+typedef tgTessKernel<CGAL::Exact_predicates_inexact_constructions_kernel, CGAL::Exact_predicates_tag>  FastTess;
+typedef tgTessKernel<CGAL::Exact_predicates_exact_constructions_kernel,   CGAL::Exact_intersections_tag> ExactTess;
+
+// polys tesselated by each tier - for all threads
+static SGMutex      tess_stats_lock;
+static unsigned int tess_fast  = 0;
+static unsigned int tess_exact = 0;
+
+static void tg_count_tesselation( bool exact )
+{
+    SGGuard<SGMutex> g( tess_stats_lock );
+
+    if ( exact ) {
+        tess_exact++;
+    } else {
+        tess_fast++;
+    }
+}
+
+void tgPolygon::GetTesselationStats( unsigned int& fast, unsigned int& exact )
+{
+    SGGuard<SGMutex> g( tess_stats_lock );
+
+    fast  = tess_fast;
+    exact = tess_exact;
+}
+
+template <class CDTPlus>
+static void tg_mark_domains(CDTPlus& ct, typename CDTPlus::Face_handle start, int index, std::list<typename CDTPlus::Edge>& border )
 {
     if(start->info().nesting_level != -1) {
         return;
     }
 
-    std::list<CDTPlus::Face_handle> queue;
+    std::list<typename CDTPlus::Face_handle> queue;
     queue.push_back(start);
 
     while( !queue.empty() ){
-        CDTPlus::Face_handle fh = queue.front();
+        typename CDTPlus::Face_handle fh = queue.front();
         queue.pop_front();
         if(fh->info().nesting_level == -1) {
             fh->info().nesting_level = index;
             for(int i = 0; i < 3; i++) {
-                CDTPlus::Edge e(fh,i);
-                CDTPlus::Face_handle n = fh->neighbor(i);
+                typename CDTPlus::Edge e(fh,i);
+                typename CDTPlus::Face_handle n = fh->neighbor(i);
                 if(n->info().nesting_level == -1) {
                     if(ct.is_constrained(e)) border.push_back(e);
                     else queue.push_back(n);
@@ -69,207 +117,271 @@ static void tg_mark_domains(CDT& ct, CDT::Face_handle start, int index, std::lis
 //level of 0. Then we recursively consider the non-explored facets incident
 //to constrained edges bounding the former set and increase the nesting level by 1.
 //Facets in the domain are those with an odd nesting level.
+template <class CDTPlus>
 static void tg_mark_domains(CDTPlus& cdt)
 {
-    for(CDTPlus::All_faces_iterator it = cdt.all_faces_begin(); it != cdt.all_faces_end(); ++it){
+    for(typename CDTPlus::All_faces_iterator it = cdt.all_faces_begin(); it != cdt.all_faces_end(); ++it){
         it->info().nesting_level = -1;
     }
 
     int index = 0;
-    std::list<CDTPlus::Edge> border;
+    std::list<typename CDTPlus::Edge> border;
     tg_mark_domains(cdt, cdt.infinite_face(), index++, border);
     while(! border.empty()) {
-        CDTPlus::Edge e = border.front();
+        typename CDTPlus::Edge e = border.front();
         border.pop_front();
-        CDTPlus::Face_handle n = e.first->neighbor(e.second);
+        typename CDTPlus::Face_handle n = e.first->neighbor(e.second);
         if(n->info().nesting_level == -1) {
             tg_mark_domains(cdt, n, e.first->info().nesting_level+1, border);
         }
     }
 }
 
-static void tg_insert_polygon(CDTPlus& cdt,const Polygon_2& polygon)
+// insert the constraint va - vb.  returns false if it crossed another
+// constraint.  An intersection constructed with inexact constructions may
+// round onto an existing vertex, so the vertex count alone can't tell : the
+// crossing also splits the new constraint into more than one subconstraint.
+// ( So does running through an existing vertex - that is only reported
+// needlessly )
+template <class CDTPlus>
+static bool tg_insert_constraint(CDTPlus& cdt, typename CDTPlus::Vertex_handle va, typename CDTPlus::Vertex_handle vb)
+{
+    typedef typename CDTPlus::Constraint_id Constraint_id;
+
+    unsigned int  vertices = cdt.number_of_vertices();
+    Constraint_id cid      = cdt.insert_constraint( va, vb );
+
+    if ( cdt.number_of_vertices() != vertices ) {
+        return false;
+    }
+
+    // no id for a zero length or an already inserted constraint
+    if ( cid != Constraint_id( NULL ) &&
+         std::distance( cdt.vertices_in_constraint_begin( cid ), cdt.vertices_in_constraint_end( cid ) ) != 2 ) {
+        return false;
+    }
+
+    return true;
+}
+
+// insert a polygon as constraints.  returns false if a constraint crossed
+// another
+template <class CDTPlus, class Polygon_2>
+static bool tg_insert_polygon(CDTPlus& cdt,const Polygon_2& polygon)
 {
-    if ( polygon.is_empty() ) return;
+    bool no_intersections = true;
+
+    if ( polygon.is_empty() ) return no_intersections;
 
-    CDTPlus::Vertex_handle v_prev=cdt.insert(*CGAL::cpp0x::prev(polygon.vertices_end()));
-    for (Polygon_2::Vertex_iterator vit=polygon.vertices_begin(); vit!=polygon.vertices_end();++vit) {
-        CDTPlus::Vertex_handle vh=cdt.insert(*vit);
-        cdt.insert_constraint(vh,v_prev);
+    typename CDTPlus::Vertex_handle v_prev=cdt.insert(*CGAL::cpp0x::prev(polygon.vertices_end()));
+    for (typename Polygon_2::Vertex_iterator vit=polygon.vertices_begin(); vit!=polygon.vertices_end();++vit) {
+        typename CDTPlus::Vertex_handle vh=cdt.insert(*vit);
+        if ( !tg_insert_constraint( cdt, vh, v_prev ) ) {
+            no_intersections = false;
+        }
         v_prev=vh;
     }
+
+    return no_intersections;
 }
 
-void tgPolygon::Tesselate( const std::vector<SGGeod>& extra, bool debug )
+// Tesselate the contours of subject with extra points, and add the
+// triangles - false, without adding any, if constraints intersect and exact
+// isn't set.  Zero area triangles are kept unless drop_zat is set.  With
+// validate set, the triangulation is checked before use.  With nodes, each
+// triangle vertex gets the index of its node, as LookupNodesPerVertex would
+// find it - the lookup is done once per vertex, and only when the triangles
+// are kept.
+template <class Tess>
+static bool tg_tesselate( tgPolygon& subject, const std::vector<SGGeod>& extra, bool exact, bool drop_zat, bool validate, std::vector<SGGeod>* tri_nodes, const TGNodes* nodes )
 {
+    typedef typename Tess::CDTPlus    CDTPlus;
+    typedef typename Tess::Point      Point;
+    typedef typename Tess::Polygon_2  Polygon_2;
+    typedef typename Tess::Triangle_2 Triangle_2;
+
     CDTPlus cdt;
 
-    static unsigned int trinum = 1;
+    // insert each polygon as a constraint into the triangulation
+    for ( unsigned int c = 0; c < subject.Contours(); c++ ) {
+        Polygon_2 poly;
+
+        for (unsigned int n = 0; n < subject.ContourSize( c ); n++ ) {
+            SGGeod node = subject.GetNode( c, n );
+            poly.push_back( Point( node.getLongitudeDeg(), node.getLatitudeDeg() ) );
+        }
+        if ( !tg_insert_polygon(cdt, poly) && !exact ) {
+            return false;
+        }
+    }
+
+    // then insert the extra points - must be done AFTER polygons are added, as there may be duplicated
+    // points, and we want the vertex handle to point to the correct node
+    std::vector<Point> points;
+    points.reserve(extra.size());
+    for (unsigned int n = 0; n < extra.size(); n++) {
+        points.push_back( Point(extra[n].getLongitudeDeg(), extra[n].getLatitudeDeg() ) );
+    }
+    if ( !points.empty() ) {
+        cdt.insert(points.begin(), points.end());
+    }
+
+    /* make conforming - still has an issue, and can't be compiled with exact_construction kernel */
+    // CGAL::make_conforming_Delaunay_2( cdt );
+
+    if ( validate ) {
+        assert(cdt.is_valid());
+    }
+    tg_mark_domains( cdt );
+
+    for (typename CDTPlus::Finite_faces_iterator fit=cdt.finite_faces_begin(); fit!=cdt.finite_faces_end(); ++fit) {
+        if ( fit->info().in_domain() ) {
+            Triangle_2 tri = cdt.triangle(fit);
+
+            SGGeod p0 = SGGeod::fromDeg( CGAL::to_double(tri.vertex(0).x()), CGAL::to_double(tri.vertex(0).y()) );
+            SGGeod p1 = SGGeod::fromDeg( CGAL::to_double(tri.vertex(1).x()), CGAL::to_double(tri.vertex(1).y()) );
+            SGGeod p2 = SGGeod::fromDeg( CGAL::to_double(tri.vertex(2).x()), CGAL::to_double(tri.vertex(2).y()) );
+
+            if ( tri_nodes ) {
+                tri_nodes->push_back( p0 );
+                tri_nodes->push_back( p1 );
+                tri_nodes->push_back( p2 );
+            }
+
+            /* Check for Zero Area before inserting */
+            if ( !drop_zat || ( !SGGeod_isEqual2D( p0, p1 ) && !SGGeod_isEqual2D( p1, p2 ) && !SGGeod_isEqual2D( p0, p2 ) ) ) {
+                subject.AddTriangle( p0, p1, p2 );
+
+                if ( nodes ) {
+                    SGGeod p[3] = { p0, p1, p2 };
+
+                    for ( unsigned int i = 0; i < 3; i++ ) {
+                        VertexInfo2& info = fit->vertex(i)->info();
+
+                        if ( !info.looked_up ) {
+                            info.index     = nodes->find( p[i] );
+                            info.looked_up = true;
+                        }
+                        subject.SetTriIdx( subject.Triangles()-1, i, info.index );
+                    }
+                }
+            } else {
+                SG_LOG( SG_GENERAL, SG_BULK, "tesselation dropping ZAT" );
+            }
+        }
+    }
+
+    return true;
+}
+
+// numbers the debug layers of Tesselate( extra, debug ) across all threads
+static SGMutex      trinum_lock;
+static unsigned int trinum_count = 0;
+
+// Tesselate subject with extra points, and with nodes, set the node index of
+// each triangle vertex
+static void tg_tesselate_extra( tgPolygon& subject, const std::vector<SGGeod>& extra, const TGNodes* nodes, bool debug )
+{
+    unsigned int trinum;
     char layer[256];
+
+    {
+        SGGuard<SGMutex> g( trinum_lock );
+        trinum = ++trinum_count;
+    }
     std::vector<SGGeod> polynodes;
-    
+
     // gather all nodes in the poly
-    if ( contours.size() != 0 ) {
-        for ( unsigned int c = 0; c < contours.size(); c++ ) {
-            tgContour contour = contours[c];
-            for (unsigned int n = 0; n < contour.GetSize(); n++ ) {
-                SGGeod node = contour.GetNode(n);
+    if ( subject.Contours() != 0 ) {
+        for ( unsigned int c = 0; c < subject.Contours(); c++ ) {
+            for (unsigned int n = 0; n < subject.ContourSize( c ); n++ ) {
+                SGGeod node = subject.GetNode( c, n );
                 polynodes.push_back( node );
             }
         }
-    }        
-    
+    }
+
     if ( debug ) {
         sprintf( layer, "poly_%06u", trinum );
-        tgShapefile::FromPolygon(*this, false, false, "./tridbg", layer, "polygon" );
+        tgShapefile::FromPolygon( subject, false, false, "./tridbg", layer, "polygon" );
         sprintf( layer, "extra_%06u", trinum );
         tgShapefile::FromGeodList( extra, false, "./tridbg", layer, "extra" );
         sprintf( layer, "polynodes_%06u", trinum );
         tgShapefile::FromGeodList( polynodes, false, "./tridbg", layer, "extra" );
     }
-    
-    SG_LOG( SG_GENERAL, SG_INFO, "Tess with extra " << id );
-    
-    // first - dump the poly we are tesselating, along with all of its vertices_begin
-    // Bail right away if polygon is empty
-    if ( contours.size() != 0 ) {
-        // First, convert the extra points to cgal Points
-        std::vector<Point> points;
-        points.reserve(extra.size());
-        for (unsigned int n = 0; n < extra.size(); n++) {
-            points.push_back( Point(extra[n].getLongitudeDeg(), extra[n].getLatitudeDeg() ) );            
-        }
 
-        if ( debug ) {
-            SG_LOG( SG_GENERAL, SG_INFO, "num extra is " << points.size() );            
-        }
+    SG_LOG( SG_GENERAL, SG_INFO, "Tess with extra " << subject.GetId() );
 
+    // Bail right away if polygon is empty
+    if ( subject.Contours() != 0 ) {
         if ( debug ) {
-            SG_LOG( SG_GENERAL, SG_INFO, "num contours is " << contours.size() );            
-        }
-        
-        // then insert each polygon as a constraint into the triangulation
-        for ( unsigned int c = 0; c < contours.size(); c++ ) {
-            tgContour contour = contours[c];
-            Polygon_2 poly;
-
-            for (unsigned int n = 0; n < contour.GetSize(); n++ ) {
-                SGGeod node = contour.GetNode(n);
-                poly.push_back( Point( node.getLongitudeDeg(), node.getLatitudeDeg() ) );
-            }
-            tg_insert_polygon(cdt, poly);
+            SG_LOG( SG_GENERAL, SG_INFO, "num extra is " << extra.size() );
+            SG_LOG( SG_GENERAL, SG_INFO, "num contours is " << subject.Contours() );
         }
 
-        // then insert the extra points - must be done AFTER polygons are added, as there may be duplicated
-        // points, and we want the vertex handle to point to the correct node
-        if ( !points.empty() ) {
-            cdt.insert(points.begin(), points.end());
+        bool exact = !tg_tesselate<FastTess>( subject, extra, false, true, false, NULL, nodes );
+        if ( exact ) {
+            SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : constraints intersect - exact constructions for " << subject.GetId() );
+            tg_tesselate<ExactTess>( subject, extra, true, true, false, NULL, nodes );
         }
-        
-        /* make conforming - still has an issue, and can't be compiled with exact_construction kernel */
-        // CGAL::make_conforming_Delaunay_2( cdt );
-
-        tg_mark_domains( cdt );
-
-        int count=0;
-        for (CDTPlus::Finite_faces_iterator fit=cdt.finite_faces_begin(); fit!=cdt.finite_faces_end(); ++fit) {
-            if ( fit->info().in_domain() ) {
-                Triangle_2 tri = cdt.triangle(fit);
-
-                SGGeod p0 = SGGeod::fromDeg( to_double(tri.vertex(0).x()), to_double(tri.vertex(0).y()) );
-                SGGeod p1 = SGGeod::fromDeg( to_double(tri.vertex(1).x()), to_double(tri.vertex(1).y()) );
-                SGGeod p2 = SGGeod::fromDeg( to_double(tri.vertex(2).x()), to_double(tri.vertex(2).y()) );
-
-                /* Check for Zero Area before inserting */
-                if ( !SGGeod_isEqual2D( p0, p1 ) && !SGGeod_isEqual2D( p1, p2 ) && !SGGeod_isEqual2D( p0, p2 ) ) {
-                    AddTriangle( p0, p1, p2 );
-                } else {
-                    SG_LOG( SG_GENERAL, SG_BULK, "tesselation dropping ZAT" );
-                }
-                
-                ++count;
-            }
-        }        
+        tg_count_tesselation( exact );
     }
-    
-    trinum++;
+}
+
+void tgPolygon::Tesselate( const std::vector<SGGeod>& extra, bool debug )
+{
+    tg_tesselate_extra( *this, extra, NULL, debug );
+}
+
+// As above, and set the index of each triangle vertex in nodes, which isn't
+// changed.  LookupNodesPerVertex is left with the vertices not in nodes yet
+// ( made at constraint intersections, or by SplitLongEdges ), once SyncNodes
+// has added them.
+void tgPolygon::Tesselate( const TGNodes& nodes, const std::vector<SGGeod>& extra, bool debug )
+{
+    tg_tesselate_extra( *this, extra, &nodes, debug );
 }
 
 void tgPolygon::Tesselate(bool debug)
 {
-    CDTPlus cdt;
     std::vector<SGGeod> geods;
     char layer[256];
-    
+
     SG_LOG( SG_GENERAL, SG_DEBUG, "Tess " << id );
-    
+
     // first - dump the poly we are tesselating, along with all of its vertices_begin
     if ( debug ) {
         sprintf( layer, "poly_%03d", id );
         tgShapefile::FromPolygon(*this, false, false, "./tridbg", layer, "polygon" );
-    }
-    
-    // Bail right away if polygon is empty
-    if ( contours.size() != 0 ) {
-        // insert each polygon as a constraint into the triangulation
-        for ( unsigned int c = 0; c < contours.size(); c++ ) {
-            tgContour contour = contours[c];
-            Polygon_2 poly;
-
-            for (unsigned int n = 0; n < contour.GetSize(); n++ ) {
-                SGGeod node = contour.GetNode(n);
-                SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : Adding GEOD " << node);
-                poly.push_back( Point( node.getLongitudeDeg(), node.getLatitudeDeg() ) );
 
-                geods.push_back( node );                
+        for ( unsigned int c = 0; c < contours.size(); c++ ) {
+            for (unsigned int n = 0; n < contours[c].GetSize(); n++ ) {
+                geods.push_back( contours[c].GetNode(n) );
             }
-
-            tg_insert_polygon(cdt, poly);
         }
+        sprintf( layer, "nodes_%03d", id );
+        tgShapefile::FromGeodList( geods, false, "./tridbg", layer, "nodes" );
+        geods.clear();
+    }
 
-        if ( debug ) {
-            sprintf( layer, "nodes_%03d", id );
-            tgShapefile::FromGeodList( geods, false, "./tridbg", layer, "nodes" );
-        }
-        
-        assert(cdt.is_valid());
-        tg_mark_domains( cdt );
+    // Bail right away if polygon is empty
+    if ( contours.size() != 0 ) {
+        std::vector<SGGeod> none;
 
-        int count=0;
-        geods.clear();
-        for (CDTPlus::Finite_faces_iterator fit=cdt.finite_faces_begin(); fit!=cdt.finite_faces_end(); ++fit) {
-            if ( fit->info().in_domain() ) {
-                SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : face   in domain");
-
-                Triangle_2 tri = cdt.triangle(fit);
-
-                SGGeod p0 = SGGeod::fromDeg( to_double(tri.vertex(0).x()), to_double(tri.vertex(0).y()) );
-                SGGeod p1 = SGGeod::fromDeg( to_double(tri.vertex(1).x()), to_double(tri.vertex(1).y()) );
-                SGGeod p2 = SGGeod::fromDeg( to_double(tri.vertex(2).x()), to_double(tri.vertex(2).y()) );
-
-                geods.push_back( p0 );
-                geods.push_back( p1 );
-                geods.push_back( p2 );
-                
-                /* Check for Zero Area before inserting */
-                //if ( !SGGeod_isEqual2D( p0, p1 ) && !SGGeod_isEqual2D( p1, p2 ) && !SGGeod_isEqual2D( p0, p2 ) ) {
-                    AddTriangle( p0, p1, p2 );
-                //} else {
-                //    SG_LOG( SG_GENERAL, SG_BULK, "tesselation dropping ZAT" );
-                //}
-
-                ++count;
-            } else {
-                SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : face not in domain");
-            }
+        bool exact = !tg_tesselate<FastTess>( *this, none, false, false, true, &geods, NULL );
+        if ( exact ) {
+            SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : constraints intersect - exact constructions for " << id );
+            geods.clear();
+            tg_tesselate<ExactTess>( *this, none, true, false, true, &geods, NULL );
         }
-        
+        tg_count_tesselation( exact );
+
         if ( debug ) {
             sprintf( layer, "tris_%03d", id );
             tgShapefile::FromPolygon(*this, false, true, "./tridbg", layer, "tris" );
-        
+
             sprintf( layer, "tri_nodes_%03d", id );
-            tgShapefile::FromGeodList( geods, false, "./tridbg", layer, "after_tri" );                
+            tgShapefile::FromGeodList( geods, false, "./tridbg", layer, "after_tri" );
         }
     } else {
         SG_LOG( SG_GENERAL, SG_DEBUG, "Tess : no contours" );
@@ -11,6 +11,7 @@
 
 #include "tg_segmentnetwork.hxx"
 #include "tg_cluster.hxx"
+#include "tg_debug_sink.hxx"
 #include "tg_shapefile.hxx"
 #include "tg_cgal.hxx"
 
@@ -24,6 +25,8 @@
 tgSegmentNetwork::tgSegmentNetwork( unsigned int cf, const std::string debugRoot ) : invalid_vh()
 {
     clean_flags = cf;
+    incremental_insert = false;
+    debug_scope = debugRoot;
     
     sprintf( datasource, "./edge_dbg/%s", debugRoot.c_str() );
 }
@@ -47,7 +50,8 @@ void tgSegmentNetwork::Add( const SGGeod& source, const SGGeod& target, double w
         segnetCurve curve(snSource, snTarget);
         CurveData   data( width, type, zorder, heading );
     
-        CGAL::insert( arr, segnetCurveWithData(curve, data) );
+        // inserted all at once in Execute
+        input.push_back( segnetCurveWithData(curve, data) );
     } else {
         output.push_back( segnetEdge( source, target, width, zorder, type ) );
     }
@@ -55,32 +59,36 @@ void tgSegmentNetwork::Add( const SGGeod& source, const SGGeod& target, double w
             
 void tgSegmentNetwork::Execute( void )
 {    
-    ToShapefiles( "input" );
+    if ( clean_flags ) {
+        BuildArrangement( input );
+    }
+
+    TG_DEBUG_SINK( "segnet_input", debug_scope, ToShapefiles( "input" ) );
     
     if ( clean_flags ) {
         // first, cluster the nodes
         SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::Cluster" );    
         Cluster();    
-        ToShapefiles( "clustered" );
+        TG_DEBUG_SINK( "segnet_clustered", debug_scope, ToShapefiles( "clustered" ) );
     
         // then remove very short fingers, or fingers that end close to their neighbors
         SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::RemoveFingers" );    
         //RemoveFingers();
-        ToShapefiles( "removed_fingers" );
+        TG_DEBUG_SINK( "segnet_removed_fingers", debug_scope, ToShapefiles( "removed_fingers" ) );
     
         // then try to extend existing fingers to nearby lines or vertices
         SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::ExtendFingers" );    
         ExtendFingers();    
-        ToShapefiles( "extended_fingers" );
+        TG_DEBUG_SINK( "segnet_extended_fingers", debug_scope, ToShapefiles( "extended_fingers" ) );
 
         SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::FixShortSegments" );        
         FixShortSegments();
-        ToShapefiles( "fixed_short_segments" );
+        TG_DEBUG_SINK( "segnet_fixed_short_segments", debug_scope, ToShapefiles( "fixed_short_segments" ) );
     
         // really small snapround?  fix for Paris?
         SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::RemoveColinearSegments" );        
         //RemoveColinearSegments();
-        ToShapefiles( "removed_colinear_segments" );
+        TG_DEBUG_SINK( "segnet_removed_colinear_segments", debug_scope, ToShapefiles( "removed_colinear_segments" ) );
 
         GenerateOutput();
     }
@@ -282,7 +290,7 @@ void tgSegmentNetwork::Cluster( void )
 {
     // create the point list
     std::list<EPECPoint_2> nodes;
-    segnetArrangement      tmp;
+    std::vector<segnetCurveWithData> clustered;
     
     segnetArrangement::Vertex_const_iterator vit;
     for ( vit = arr.vertices_begin(); vit != arr.vertices_end(); ++vit ) {        
@@ -291,7 +299,7 @@ void tgSegmentNetwork::Cluster( void )
     
     tgCluster cluster( nodes, 0.0000025 );
     
-    // traverse all edges in arr, and add as new clusterd edges in tmp;
+    // traverse all edges in arr, and collect the clustered edges
     segnetArrangement::Edge_const_iterator eit;
     for ( eit = arr.edges_begin(); eit != arr.edges_end(); ++eit ) {
         // look up edge source and target
@@ -307,16 +315,15 @@ void tgSegmentNetwork::Cluster( void )
             if ( clust_source != clust_target ) {
                 segnetCurve curve( clust_source, clust_target );
             
-                CGAL::insert( tmp, segnetCurveWithData(curve, data) );
+                clustered.push_back( segnetCurveWithData(curve, data) );
             }
         } else {
             SG_LOG(SG_GENERAL, SG_ALERT, "tgSegmentNetwork::Cluster - curve data size != 1 (" << eit->curve().data().size() << ")" );
         }
     }
     
-    // then assign back to arr
-    arr.clear();
-    arr = tmp;    
+    // then rebuild arr from them
+    BuildArrangement( clustered );
 }
                 
 void tgSegmentNetwork::RemoveFingers( void )
@@ -724,11 +731,8 @@ void tgSegmentNetwork::RemoveColinearSegments( void )
         eit++;
     }
     
-    arr.clear();
-    
-    for ( std::list<segnetCurveWithData>::const_iterator it = snapRounded.begin(); it != snapRounded.end(); it++ ) {
-        CGAL::insert( arr, *it );
-    }
+    std::vector<segnetCurveWithData> curves( snapRounded.begin(), snapRounded.end() );
+    BuildArrangement( curves );
 }
 
 void tgSegmentNetwork::GenerateOutput( void ) 
@@ -801,18 +805,42 @@ void tgSegmentNetwork::GenerateOutput( void )
     }
 }
 
+// Replace arr with the arrangement of curves, built in one aggregated
+// sweep - much faster than inserting them one at a time, as each insert has
+// to locate the curve in the arrangement first.  Overlapping curves merge
+// their data the same way.  curves is emptied.
+void tgSegmentNetwork::BuildArrangement( std::vector<segnetCurveWithData>& curves )
+{
+    arr.clear();
+
+    if ( incremental_insert ) {
+        for ( unsigned int i = 0; i < curves.size(); i++ ) {
+            CGAL::insert( arr, curves[i] );
+        }
+    } else if ( !curves.empty() ) {
+        CGAL::insert( arr, curves.begin(), curves.end() );
+    }
+
+    SG_LOG(SG_GENERAL, LOG_STAGES, "tgSegmentNetwork::BuildArrangement from " << curves.size() << " curves : " << arr.number_of_vertices() << " vertices, " << arr.number_of_edges() << " edges" );
+
+    std::vector<segnetCurveWithData>().swap( curves );
+}
+
 void tgSegmentNetwork::BuildTree( void )
 {
-    tree.clear();
-    
+    std::vector<nodesPointHandle> nodes;
     segnetPoint none(0,0);
-    
+
+    tree.clear();
+
+    nodes.reserve( arr.number_of_vertices() );
     typename segnetArrangement::Vertex_const_iterator vit;
     for ( vit = arr.vertices_begin(); vit != arr.vertices_end(); ++vit ) {
-        nodesPointHandle nh( vit->point(), vit, none );
-    
-        tree.insert( nh );
+        nodes.push_back( nodesPointHandle( vit->point(), vit, none ) );
     }
+
+    // the tree is built once, on the first query
+    tree.insert( nodes.begin(), nodes.end() );
     
     SG_LOG(SG_GENERAL, SG_INFO, "tgSegmentNetwork::Built kd-tree with " << tree.size() << " nodes" );    
 }
@@ -143,19 +143,24 @@ public:
     void      DumpPolys( void );
     void      ToShapefiles( const char* prefix );
     
+    // insert the curves one at a time, as before the aggregated sweep -
+    // only for checking the sweep against
+    void      SetIncrementalInsert( bool inc ) { incremental_insert = inc; }
+    
     segnetedge_it output_begin( void ) { return output.begin(); }
     segnetedge_it output_end( void )   { return output.end();   }
     
     bool empty( void ) const 
     { 
         if ( clean_flags ) {
-            return (arr.number_of_edges() == 0); 
+            return (arr.number_of_edges() == 0 && input.empty()); 
         } else {
             return output.empty();
         }
     }
     
 private:
+    void      BuildArrangement( std::vector<segnetCurveWithData>& curves );
     void      BuildTree( void );
     void      Cluster( void );
     void      RemoveFingers( void );
@@ -190,13 +195,16 @@ private:
 #endif
     
     unsigned int       clean_flags;
+    bool               incremental_insert;
     segnetArrangement  arr;
+    std::vector<segnetCurveWithData> input;     // added curves, not yet in arr
     nodesTree          tree;
     segnetedge_list    output;
     segnetVertexHandle invalid_vh;
     
     
     char               datasource[128];
+    std::string        debug_scope;
 };
 
 #if 0
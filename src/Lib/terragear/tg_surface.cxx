@@ -41,6 +41,10 @@ const double coarse_grid = 300.0;
 // this many meters of the average
 const double max_clamp = 100.0;
 
+// the surface fit falls back from the normal equations to QR when the
+// normal matrix condition number looks worse than this
+const double max_normal_condition = 1.0e10;
+
 static bool limit_slope( tgMatrix* Pts, int i1, int j1, int i2, int j2,
                          double average_elev_m, double slope_max, double slope_eps )
 {
@@ -347,6 +351,16 @@ void tgSurface::Create( const std::string& path,
 
 tgSurface::tgSurface() {
     Pts = NULL;
+
+    // until Create(), the surface is flat at the ( zero ) area center
+    for ( int i = 0; i < 4; i++ ) {
+        for ( int j = 0; j < 4; j++ ) {
+            coefficients[i][j] = 0.0;
+        }
+    }
+    u_scale = 0.0;
+    v_scale = 0.0;
+    _average_elev_m = 0.0;
 }
 
 tgSurface::~tgSurface() {
@@ -354,19 +368,100 @@ tgSurface::~tgSurface() {
 }
 
 
+// Solve the least squares problem mat * c = z through the normal equations
+// and a Cholesky factorization - much cheaper than QR of the whole
+// observation matrix, but it squares the condition number.  Returns false
+// if the normal matrix is not positive definite or too poorly conditioned.
+static bool tgSolveNormalEquations( const TNT::Array2D<double>& mat,
+                                    const TNT::Array1D<double>& z,
+                                    double c[16] )
+{
+    double ata[16][16], atz[16], l[16][16], y[16];
+    int    nobs = mat.dim1();
+
+    // lower half of mat^T * mat, and mat^T * z
+    for ( int i = 0; i < 16; i++ ) {
+        atz[i] = 0.0;
+        for ( int j = 0; j <= i; j++ ) {
+            ata[i][j] = 0.0;
+        }
+    }
+    for ( int n = 0; n < nobs; n++ ) {
+        const double* row = mat[n];
+        for ( int i = 0; i < 16; i++ ) {
+            atz[i] += row[i] * z[n];
+            for ( int j = 0; j <= i; j++ ) {
+                ata[i][j] += row[i] * row[j];
+            }
+        }
+    }
+
+    // ata = l * l^T
+    double dmin = 0.0, dmax = 0.0;
+    for ( int j = 0; j < 16; j++ ) {
+        double d = ata[j][j];
+        for ( int k = 0; k < j; k++ ) {
+            d -= l[j][k] * l[j][k];
+        }
+        if ( d <= 0.0 ) {
+            return false;
+        }
+        l[j][j] = sqrt( d );
+
+        if ( j == 0 || l[j][j] < dmin ) { dmin = l[j][j]; }
+        if ( j == 0 || l[j][j] > dmax ) { dmax = l[j][j]; }
+
+        for ( int i = j + 1; i < 16; i++ ) {
+            double s = ata[i][j];
+            for ( int k = 0; k < j; k++ ) {
+                s -= l[i][k] * l[j][k];
+            }
+            l[i][j] = s / l[j][j];
+        }
+    }
+
+    // the spread of the diagonal of l is a lower bound on the condition
+    // number of ata
+    if ( (dmax / dmin) * (dmax / dmin) > max_normal_condition ) {
+        return false;
+    }
+
+    // l * y = atz, then l^T * c = y
+    for ( int i = 0; i < 16; i++ ) {
+        double s = atz[i];
+        for ( int k = 0; k < i; k++ ) {
+            s -= l[i][k] * y[k];
+        }
+        y[i] = s / l[i][i];
+    }
+    for ( int i = 15; i >= 0; i-- ) {
+        double s = y[i];
+        for ( int k = i + 1; k < 16; k++ ) {
+            s -= l[k][i] * c[k];
+        }
+        c[i] = s / l[i][i];
+    }
+
+    return true;
+}
+
 // Use a linear least squares method to fit a 3d polynomial to the
 // sampled surface data
 void tgSurface::fit() {
 
-    // the fit function is:
-    // f(x,y) = A1*x + A2*x*y + A3*y +
-    //          A4*x*x + A5+x*x*y + A6*x*x*y*y + A7*y*y + A8*x*y*y +
-    //          A9*x*x*x + A10*x*x*x*y + A11*x*x*x*y*y + A12*x*x*x*y*y*y +
-    //            A13*y*y*y + A14*x*y*y*y + A15*x*x*y*y*y
+    // the fit function is the bicubic:
+    // f(u,v) = sum(i=0..3) sum(j=0..3) A[i][j] * u^i * v^j
+    // with u,v the lon/lat offsets from the area center, scaled to [-1,1]
+    // over the area - unscaled, the higher order terms of a small airport
+    // are down around 1e-12, and the fit is badly conditioned
 
     int nobs = Pts->cols() * Pts->rows();	// number of observations
 
-    SG_LOG(SG_GENERAL, SG_DEBUG, "QR triangularisation" );
+    double width  = _max_deg.getLongitudeDeg() - _min_deg.getLongitudeDeg();
+    double height = _max_deg.getLatitudeDeg() - _min_deg.getLatitudeDeg();
+
+    u_scale = ( width  > 0.0 ) ? 2.0 / width  : 1.0;
+    v_scale = ( height > 0.0 ) ? 2.0 / height : 1.0;
 
     // Create an array (matrix) with 16 columns (predictor values) A[n]
     TNT::Array2D<double> mat(nobs,16);
@@ -379,37 +474,58 @@ void tgSurface::fit() {
         for ( int i = 0; i < Pts->cols(); i++ ) {
             SGGeod p = Pts->element( i, j );
             int index = ( j * Pts->cols() ) + i;
-            double x = p.getLongitudeDeg() - area_center.getLongitudeDeg();
-            double y = p.getLatitudeDeg() - area_center.getLatitudeDeg();
+            double u = (p.getLongitudeDeg() - area_center.getLongitudeDeg()) * u_scale;
+            double v = (p.getLatitudeDeg() - area_center.getLatitudeDeg()) * v_scale;
             double z = p.getElevationM() - area_center.getElevationM();
 
             zmat[index] = z;
 
-            mat[index][0] = 1.0;
-            mat[index][1] = x;
-            mat[index][2] = x*y;
-            mat[index][3] = y;
-            mat[index][4] = x*x;
-            mat[index][5] = x*x*y;
-            mat[index][6] = x*x*y*y;
-            mat[index][7] = y*y;
-            mat[index][8] = x*y*y;
-            mat[index][9] = x*x*x;
-            mat[index][10] = x*x*x*y;
-            mat[index][11] = x*x*x*y*y;
-            mat[index][12] = x*x*x*y*y*y;
-            mat[index][13] = y*y*y;
-            mat[index][14] = x*y*y*y;
-            mat[index][15] = x*x*y*y*y;
+            // column 4*i+j is u^i * v^j
+            double ui = 1.0;
+            for ( int pu = 0; pu < 4; pu++ ) {
+                double uv = ui;
+                for ( int pv = 0; pv < 4; pv++ ) {
+                    mat[index][4*pu + pv] = uv;
+                    uv *= v;
+                }
+                ui *= u;
+            }
         }
     }
 
-    // Do QR decompostion
-    JAMA::QR<double> qr( mat );
-    // find the least squares solution using the QR factors
-    surface_coefficients = qr.solve(zmat);
+    double c[16];
+    if ( tgSolveNormalEquations( mat, zmat, c ) ) {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "Cholesky solution of the normal equations" );
+    } else {
+        SG_LOG(SG_GENERAL, SG_DEBUG, "normal equations poorly conditioned - QR triangularisation" );
+
+        // Do QR decompostion
+        JAMA::QR<double> qr( mat );
+        // find the least squares solution using the QR factors
+        TNT::Array1D<double> solution = qr.solve(zmat);
+
+        for ( int i = 0; i < 16; i++ ) {
+            c[i] = ( solution.dim() == 16 ) ? solution[i] : 0.0;
+        }
+    }
+
+    for ( int i = 0; i < 4; i++ ) {
+        for ( int j = 0; j < 4; j++ ) {
+            coefficients[i][j] = c[4*i + j];
+        }
+    }
 }
 
+// evaluate the bicubic at u,v with Horner's rule, in both directions
+static inline double tgEvalBicubic( const double c[4][4], double u, double v )
+{
+    double p0 = ((c[0][3]*v + c[0][2])*v + c[0][1])*v + c[0][0];
+    double p1 = ((c[1][3]*v + c[1][2])*v + c[1][1])*v + c[1][0];
+    double p2 = ((c[2][3]*v + c[2][2])*v + c[2][1])*v + c[2][0];
+    double p3 = ((c[3][3]*v + c[3][2])*v + c[3][1])*v + c[3][0];
+
+    return ((p3*u + p2)*u + p1)*u + p0;
+}
 
 // Query the elevation of a point, return -9999 if out of range
 double tgSurface::query( SGGeod query ) const {
@@ -422,22 +538,56 @@ double tgSurface::query( SGGeod query ) const {
     }
 
     // compute the function with solved coefficients
+    double u = (query.getLongitudeDeg() - area_center.getLongitudeDeg()) * u_scale;
+    double v = (query.getLatitudeDeg() - area_center.getLatitudeDeg()) * v_scale;
+
+    return tgEvalBicubic( coefficients, u, v ) + area_center.getElevationM();
+}
+
+// Query the elevations of a list of points, -9999 for those out of range
+void tgSurface::query( const std::vector<SGGeod>& points, std::vector<double>& elevations ) const {
+    unsigned int num = points.size();
+    unsigned int num_outside = 0;
 
-    // the fit function is:
-    // f(x,y) = A1*x + A2*x*y + A3*y +
-    //          A4*x*x + A5+x*x*y + A6*x*x*y*y + A7*y*y + A8*x*y*y +
-    //          A9*x*x*x + A10*x*x*x*y + A11*x*x*x*y*y + A12*x*x*x*y*y*y +
-    //            A13*y*y*y + A14*x*y*y*y + A15*x*x*y*y*y
+    elevations.resize( num );
+    if ( !num ) {
+        return;
+    }
 
-    double x = query.getLongitudeDeg() - area_center.getLongitudeDeg();
-    double y = query.getLatitudeDeg() - area_center.getLatitudeDeg();
-    TNT::Array1D<double> A = surface_coefficients;
+    // hoist everything out of the loop - local copies of the coefficients
+    // can't alias the output, so the body is branch free straight line
+    // code the compiler can vectorize
+    double c[4][4];
+    for ( int i = 0; i < 4; i++ ) {
+        for ( int j = 0; j < 4; j++ ) {
+            c[i][j] = coefficients[i][j];
+        }
+    }
 
-    double result = A[0] + A[1]*x + A[2]*x*y + A[3]*y + A[4]*x*x + A[5]*x*x*y
-    + A[6]*x*x*y*y + A[7]*y*y + A[8]*x*y*y + A[9]*x*x*x + A[10]*x*x*x*y
-    + A[11]*x*x*x*y*y + A[12]*x*x*x*y*y*y + A[13]*y*y*y + A[14]*x*y*y*y
-    + A[15]*x*x*y*y*y;
-    result += area_center.getElevationM();
+    const double clon   = area_center.getLongitudeDeg();
+    const double clat   = area_center.getLatitudeDeg();
+    const double celev  = area_center.getElevationM();
+    const double minlon = _aptBounds.getMin().getLongitudeDeg();
+    const double minlat = _aptBounds.getMin().getLatitudeDeg();
+    const double maxlon = _aptBounds.getMax().getLongitudeDeg();
+    const double maxlat = _aptBounds.getMax().getLatitudeDeg();
+    const double us     = u_scale;
+    const double vs     = v_scale;
+
+    double* pe = &elevations[0];
+    for ( unsigned int i = 0; i < num; i++ ) {
+        double lon = points[i].getLongitudeDeg();
+        double lat = points[i].getLatitudeDeg();
+        double elev = tgEvalBicubic( c, (lon - clon) * us, (lat - clat) * vs ) + celev;
+
+        // same test as tgRectangle::isInside
+        bool inside = ( lon >= minlon ) & ( lon <= maxlon ) & ( lat >= minlat ) & ( lat <= maxlat );
+
+        pe[i] = inside ? elev : -9999.0;
+        num_outside += !inside;
+    }
 
-    return result;
-}
\ No newline at end of file
+    if ( num_outside ) {
+        SG_LOG(SG_GENERAL, SG_WARN, "Warning: " << num_outside << " queries out of bounds for fitted surface!");
+    }
+}
@@ -25,6 +25,7 @@
 #define _SURFACE_HXX
 
 #include <string>
+#include <vector>
 #include <simgear/debug/logstream.hxx>
 
 #include "TNT/tnt_array2d.h"
@@ -122,10 +123,18 @@ public:
     // proportional to u,v space on the nurbs surface which it isn't.
     double query( SGGeod query ) const;
 
+    // Query the elevations of a list of points at once, -9999 for the
+    // ones out of range, with a single warning for all of those.
+    void query( const std::vector<SGGeod>& points, std::vector<double>& elevations ) const;
+
 private:
     // The actual nurbs surface approximation for the airport
     tgMatrix* Pts;
-    TNT::Array1D<double> surface_coefficients;
+
+    // The fitted bicubic f(u,v) = sum coefficients[i][j] * u^i * v^j, with
+    // u,v the offsets from area_center scaled to [-1,1] over the area
+    double coefficients[4][4];
+    double u_scale, v_scale;
 
     tgRectangle _aptBounds;
     SGGeod _min_deg, _max_deg;
@@ -56,6 +56,9 @@ string area_type="Default";
 string area_type_col;
 int continue_on_errors=0;
 bool texture_lines = false;
+bool clipper_lines = false;
+ClipperLib::JoinType line_joins = ClipperLib::jtMiter;
+ClipperLib::EndType line_caps = ClipperLib::etOpenButt;
 int seperate_segments = 0;
 int max_segment_length=0; // ==0 => don't split
 int start_record=0;
@@ -182,6 +185,17 @@ void Decoder::processLineString(OGRLineString* poGeometry, const string& area_ty
     heading = SGGeodesy::courseDeg( p0, p1 );
     line.AddNode( SGGeodesy::direct(p1, heading, EP_STRETCH) );
 
+    // untextured lines can be buffered as one polygon
+    if ( clipper_lines && !with_texture ) {
+        tgPolygon shape = tgContour::BufferLine( line, width, line_joins, line_caps );
+
+        shape.SetPreserve3D( false );
+        shape.SetTexMethod( TG_TEX_BY_GEODE );
+
+        chopper.Add( shape, area_type );
+        return;
+    }
+
     // make a plygons from the line segments
     segments = tgContour::ExpandToPolygons( line, width );
     for ( unsigned int i=0; i<segments.size(); i++ ) {
@@ -494,6 +508,12 @@ void usage(char* progname) {
     SG_LOG( SG_GENERAL, SG_ALERT, "        spatial query extents" );
     SG_LOG( SG_GENERAL, SG_ALERT, "--texture-lines" );
     SG_LOG( SG_GENERAL, SG_ALERT, "        Enable textured lines" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "--clipper-lines" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "        Buffer untextured lines as one polygon with clipper, instead of a quad per segment" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "--line-joins miter|square" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "        Joins of the clipper lines (default miter)" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "--line-caps butt|square|round" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "        End caps of the clipper lines (default butt)" );
     SG_LOG( SG_GENERAL, SG_ALERT, "--threads" );
     SG_LOG( SG_GENERAL, SG_ALERT, "        Enable multithreading with user specified number of threads" );
     SG_LOG( SG_GENERAL, SG_ALERT, "--all-threads" );
@@ -562,6 +582,38 @@ int main( int argc, char **argv ) {
             argv++;
             argc--;
             texture_lines=true;
+        } else if (!strcmp(argv[1],"--clipper-lines")) {
+            argv++;
+            argc--;
+            clipper_lines=true;
+        } else if (!strcmp(argv[1],"--line-joins")) {
+            if (argc<3) {
+                usage(progname);
+            }
+            if (!strcmp(argv[2],"miter")) {
+                line_joins=ClipperLib::jtMiter;
+            } else if (!strcmp(argv[2],"square")) {
+                line_joins=ClipperLib::jtSquare;
+            } else {
+                usage(progname);
+            }
+            argv+=2;
+            argc-=2;
+        } else if (!strcmp(argv[1],"--line-caps")) {
+            if (argc<3) {
+                usage(progname);
+            }
+            if (!strcmp(argv[2],"butt")) {
+                line_caps=ClipperLib::etOpenButt;
+            } else if (!strcmp(argv[2],"square")) {
+                line_caps=ClipperLib::etOpenSquare;
+            } else if (!strcmp(argv[2],"round")) {
+                line_caps=ClipperLib::etOpenRound;
+            } else {
+                usage(progname);
+            }
+            argv+=2;
+            argc-=2;
         } else if (!strcmp(argv[1],"--seperate-segments")) {
             argv++;
             argc--;
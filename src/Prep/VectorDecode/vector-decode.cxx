@@ -36,6 +36,7 @@
 #include <terragear/tg_accumulator.hxx>
 #include <terragear/tg_intersection_generator.hxx>
 #include <terragear/tg_chopper.hxx>
+#include <terragear/tg_debug_sink.hxx>
 #include <terragear/tg_shapefile.hxx>
 
 using std::string;
@@ -273,6 +274,8 @@ void usage(char* progname) {
     SG_LOG( SG_GENERAL, SG_ALERT, "        Use an attribute query (like SQL WHERE)" );
     SG_LOG( SG_GENERAL, SG_ALERT, "--spat xmin ymin xmax ymax" );
     SG_LOG( SG_GENERAL, SG_ALERT, "        spatial query extents" );
+    SG_LOG( SG_GENERAL, SG_ALERT, "--debug-sink=checkpoint,..." );
+    SG_LOG( SG_GENERAL, SG_ALERT, "        Write the named debug shapefiles (eg segnet_input, clip_16_7), or all of them" );
     SG_LOG( SG_GENERAL, SG_ALERT, "--texture-lines" );
     SG_LOG( SG_GENERAL, SG_ALERT, "        Enable textured lines" );
     SG_LOG( SG_GENERAL, SG_ALERT, "" );
@@ -332,6 +335,8 @@ int main( int argc, char **argv ) {
             work_dir = arg.substr(11);
         } else if (arg.find("--config=") == 0) {
             config = arg.substr(9);
+        } else if (arg.find("--debug-sink=") == 0) {
+            tgDebugSink::EnableCheckpoints( arg.substr(13) );
         }
     }
 
@@ -460,7 +465,7 @@ int main( int argc, char **argv ) {
             
             std::cout << " clipping poly " << p << " of " << num_polys << std::endl;
             
-            if ( ((*pmap_it).first == 16) && (p == 7) ) {
+            if ( ((*pmap_it).first == 16) && (p == 7) && tgDebugSink::IsEnabled( "clip_16_7", "" ) ) {
                 tgShapefile::FromPolygon( current, false, false, "./clip_dbg", "clip_16_7", "poly" );
                 
                 std::vector<SGGeod> geods;